@@ -42,6 +42,18 @@ namespace ferrit {
         return *m_returnType;
     }
 
+    GenericType::GenericType(Token name, std::vector<DeclaredType> arguments) noexcept :
+        m_name(std::move(name)), m_arguments(std::move(arguments)) {
+    }
+
+    const Token &GenericType::name() const noexcept {
+        return m_name;
+    }
+
+    const std::vector<DeclaredType> &GenericType::arguments() const noexcept {
+        return m_arguments;
+    }
+
     DeclaredType::DeclaredType(Token simpleName) noexcept :
         m_data(SimpleType(std::move(simpleName))) {
     }
@@ -56,6 +68,10 @@ namespace ferrit {
             std::make_unique<DeclaredType>(std::move(returnType)))) {
     }
 
+    DeclaredType::DeclaredType(Token name, std::vector<DeclaredType> arguments) noexcept :
+        m_data(GenericType(std::move(name), std::move(arguments))) {
+    }
+
     bool DeclaredType::isSimple() const noexcept {
         return std::holds_alternative<SimpleType>(m_data);
     }
@@ -64,6 +80,10 @@ namespace ferrit {
         return std::holds_alternative<FunctionType>(m_data);
     }
 
+    bool DeclaredType::isGeneric() const noexcept {
+        return std::holds_alternative<GenericType>(m_data);
+    }
+
     const SimpleType &DeclaredType::simple() const {
         return std::get<SimpleType>(m_data);
     }
@@ -72,9 +92,15 @@ namespace ferrit {
         return std::get<FunctionType>(m_data);
     }
 
+    const GenericType &DeclaredType::generic() const {
+        return std::get<GenericType>(m_data);
+    }
+
     const Token &DeclaredType::errorToken() const noexcept {
         if (isSimple()) {
             return simple().name();
+        } else if (isGeneric()) {
+            return generic().name();
         } else {
             return function().errorToken();
         }
@@ -86,6 +112,9 @@ namespace ferrit {
         }
         if (isSimple()) {
             return simple().name().lexeme == other.simple().name().lexeme;
+        } else if (isGeneric()) {
+            return generic().name().lexeme == other.generic().name().lexeme &&
+                generic().arguments() == other.generic().arguments();
         } else {
             const auto &thisFunc = function();
             const auto &otherFunc = other.function();
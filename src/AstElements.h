@@ -2,6 +2,7 @@
 
 #include "Token.h"
 
+#include <cstddef>
 #include <format>
 #include <ostream>
 #include <variant>
@@ -84,6 +85,37 @@ namespace ferrit {
         std::unique_ptr<DeclaredType> m_returnType;
     };
 
+    /**
+     * Represents a generic type applied to type arguments (e.g. Array<Int>).
+     */
+    class GenericType final {
+    public:
+        /**
+         * Constructs a new generic type.
+         *
+         * @note This constructor is an implementation detail of \c DeclaredType
+         * and should not be directly called.
+         *
+         * @param name the generic type's name
+         * @param arguments the type arguments
+         */
+        explicit GenericType(Token name, std::vector<DeclaredType> arguments) noexcept;
+
+        /**
+         * Returns the token naming the generic type.
+         */
+        [[nodiscard]] const Token &name() const noexcept;
+
+        /**
+         * Returns the type arguments.
+         */
+        [[nodiscard]] const std::vector<DeclaredType> &arguments() const noexcept;
+
+    private:
+        Token m_name;
+        std::vector<DeclaredType> m_arguments;
+    };
+
     /**
      * Represents a type as defined by the user (as opposed to an <tt>llvm::Type</tt> for instance).
      */
@@ -109,6 +141,14 @@ namespace ferrit {
             std::vector<DeclaredType> parameters,
             DeclaredType returnType) noexcept;
 
+        /**
+         * Construct a generic type.
+         *
+         * @param name the generic type's name
+         * @param arguments the type arguments
+         */
+        explicit DeclaredType(Token name, std::vector<DeclaredType> arguments) noexcept;
+
         /**
          * Checks if the type refers to a simple unannotated type (e.g. Int, String, MyCustomClass).
          */
@@ -119,6 +159,11 @@ namespace ferrit {
          */
         [[nodiscard]] bool isFunction() const noexcept;
 
+        /**
+         * Checks if the type refers to a generic type with type arguments (e.g. Array<Int>).
+         */
+        [[nodiscard]] bool isGeneric() const noexcept;
+
         /**
          * Returns the type as a SimpleType.
          */
@@ -129,6 +174,11 @@ namespace ferrit {
          */
         [[nodiscard]] const FunctionType &function() const;
 
+        /**
+         * Returns the type as a GenericType.
+         */
+        [[nodiscard]] const GenericType &generic() const;
+
         /**
          * Returns a token to be used for error reporting.
          */
@@ -140,7 +190,7 @@ namespace ferrit {
         [[nodiscard]] bool operator==(const DeclaredType &other) const noexcept;
 
     private:
-        std::variant<SimpleType, FunctionType> m_data;
+        std::variant<SimpleType, FunctionType, GenericType> m_data;
     };
 
     /**
@@ -196,6 +246,18 @@ struct std::formatter<ferrit::DeclaredType> : std::formatter<std::string> {
             }
             result += std::format(") -> {}", func.returnType());
 
+            return super::format(result, ctx);
+        } else if (declaredType.isGeneric()) {
+            const auto &generic = declaredType.generic();
+            std::string result = generic.name().lexeme + "<";
+            for (std::size_t i = 0; i < generic.arguments().size(); i++) {
+                result += std::format("{}", generic.arguments()[i]);
+                if (i + 1 < generic.arguments().size()) {
+                    result += ", ";
+                }
+            }
+            result += ">";
+
             return super::format(result, ctx);
         } else {
             throw std::format_error("unknown DeclaredType variant");
@@ -44,6 +44,22 @@ namespace ferrit {
         return {};
     }
 
+    VisitResult AstPrinter::visitVariableDecl(const VariableDeclaration &varDecl) {
+        printLine("VariableDeclaration:");
+        indent([&] {
+            printLine(std::format("-Keyword={}", varDecl.keyword().lexeme));
+            printLine(std::format("-Name={}", varDecl.name().lexeme));
+            if (varDecl.type()) {
+                printLine(std::format("-Type={}", *varDecl.type()));
+            }
+            printLine("-Initializer:");
+            indent([&] {
+                varDecl.initializer().accept(*this);
+            });
+        });
+        return {};
+    }
+
     VisitResult AstPrinter::visitConditionalStmt(const ConditionalStatement &conditionalStmt) {
         printLine("ConditionalStatement:");
         indent([&] {
@@ -61,6 +77,37 @@ namespace ferrit {
         return {};
     }
 
+    VisitResult AstPrinter::visitWhileStmt(const WhileStatement &whileStmt) {
+        printLine(whileStmt.isDoWhile() ? "DoWhileStatement:" : "WhileStatement:");
+        indent([&] {
+            printLine("-Condition:");
+            indent([&] {
+                whileStmt.condition().accept(*this);
+            });
+            printLine("-Body:");
+            indent([&] {
+                whileStmt.body().accept(*this);
+            });
+        });
+        return {};
+    }
+
+    VisitResult AstPrinter::visitForStmt(const ForStatement &forStmt) {
+        printLine("ForStatement:");
+        indent([&] {
+            printLine(std::format("-Variable={}", forStmt.variable().lexeme));
+            printLine("-Iterable:");
+            indent([&] {
+                forStmt.iterable().accept(*this);
+            });
+            printLine("-Body:");
+            indent([&] {
+                forStmt.body().accept(*this);
+            });
+        });
+        return {};
+    }
+
     VisitResult AstPrinter::visitBlockStmt(const BlockStatement &blockStmt) {
         printLine("BlockStatement:");
         indent([&] {
@@ -71,6 +118,16 @@ namespace ferrit {
         return {};
     }
 
+    VisitResult AstPrinter::visitReturnStmt(const ReturnStatement &returnStmt) {
+        printLine("ReturnStatement:");
+        if (returnStmt.value()) {
+            indent([&] {
+                returnStmt.value()->accept(*this);
+            });
+        }
+        return {};
+    }
+
     VisitResult AstPrinter::visitExpressionStmt(const ExpressionStatement &exprStmt) {
         printLine("ExpressionStatement:");
         indent([&] {
@@ -79,6 +136,35 @@ namespace ferrit {
         return {};
     }
 
+    VisitResult AstPrinter::visitAssignmentExpr(const AssignmentExpression &assignExpr) {
+        printLine("AssignmentExpression:");
+        indent([&] {
+            printLine(std::format("-Op={}", assignExpr.op().lexeme));
+            printLine(std::format("-Name={}", assignExpr.name().lexeme));
+            printLine("-Value:");
+            indent([&] {
+                assignExpr.value().accept(*this);
+            });
+        });
+        return {};
+    }
+
+    VisitResult AstPrinter::visitIndexAssignmentExpr(const IndexAssignmentExpression &assignExpr) {
+        printLine("IndexAssignmentExpression:");
+        indent([&] {
+            printLine(std::format("-Op={}", assignExpr.op().lexeme));
+            printLine("-Target:");
+            indent([&] {
+                assignExpr.target().accept(*this);
+            });
+            printLine("-Value:");
+            indent([&] {
+                assignExpr.value().accept(*this);
+            });
+        });
+        return {};
+    }
+
     VisitResult AstPrinter::visitBinaryExpr(const BinaryExpression &binExpr) {
         printLine("BinaryExpression:");
         indent([&] {
@@ -111,6 +197,22 @@ namespace ferrit {
         return {};
     }
 
+    VisitResult AstPrinter::visitRangeExpr(const RangeExpression &rangeExpr) {
+        printLine("RangeExpression:");
+        indent([&] {
+            printLine(std::format("-Op={}", rangeExpr.op().lexeme));
+            printLine("-Start:");
+            indent([&] {
+                rangeExpr.start().accept(*this);
+            });
+            printLine("-End:");
+            indent([&] {
+                rangeExpr.end().accept(*this);
+            });
+        });
+        return {};
+    }
+
     VisitResult AstPrinter::visitUnaryExpr(const UnaryExpression &unaryExpr) {
         printLine(std::format("UnaryExpression: {}", unaryExpr.op().lexeme));
         indent([&] {
@@ -137,6 +239,29 @@ namespace ferrit {
         return {};
     }
 
+    VisitResult AstPrinter::visitIndexExpr(const IndexExpression &indexExpr) {
+        printLine("IndexExpression:");
+        indent([&] {
+            printLine("-Array:");
+            indent([&] {
+                indexExpr.array().accept(*this);
+            });
+            printLine("-Index:");
+            indent([&] {
+                indexExpr.index().accept(*this);
+            });
+        });
+        return {};
+    }
+
+    VisitResult AstPrinter::visitPropertyExpr(const PropertyExpression &propertyExpr) {
+        printLine(std::format("PropertyExpression: {}", propertyExpr.name().lexeme));
+        indent([&] {
+            propertyExpr.object().accept(*this);
+        });
+        return {};
+    }
+
     VisitResult AstPrinter::visitVariableExpr(const VariableExpression &varExpr) {
         printLine(std::format("VariableExpression: {}", varExpr.name().lexeme));
         return {};
@@ -154,6 +279,21 @@ namespace ferrit {
         return {};
     }
 
+    VisitResult AstPrinter::visitStringExpr(const StringExpression &stringExpr) {
+        printLine(std::format("StringExpression: {}", stringExpr.value().lexeme));
+        return {};
+    }
+
+    VisitResult AstPrinter::visitArrayExpr(const ArrayExpression &arrayExpr) {
+        printLine("ArrayExpression:");
+        indent([&] {
+            for (const auto &element : arrayExpr.elements()) {
+                element->accept(*this);
+            }
+        });
+        return {};
+    }
+
     void AstPrinter::printLine(const std::string &line) {
         *m_out << std::format("{:{}} {}\n", ' ', m_depth * INDENTATION_LEVEL, line);
     }
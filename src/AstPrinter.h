@@ -19,17 +19,28 @@ namespace ferrit {
 
     public:
         VisitResult visitFunctionDecl(const FunctionDeclaration &funDecl) override;
+        VisitResult visitVariableDecl(const VariableDeclaration &varDecl) override;
         VisitResult visitConditionalStmt(const ConditionalStatement &conditionalStmt) override;
+        VisitResult visitWhileStmt(const WhileStatement &whileStmt) override;
+        VisitResult visitForStmt(const ForStatement &forStmt) override;
         VisitResult visitBlockStmt(const BlockStatement &blockStmt) override;
+        VisitResult visitReturnStmt(const ReturnStatement &returnStmt) override;
         VisitResult visitExpressionStmt(const ExpressionStatement &exprStmt) override;
 
+        VisitResult visitAssignmentExpr(const AssignmentExpression &assignExpr) override;
+        VisitResult visitIndexAssignmentExpr(const IndexAssignmentExpression &assignExpr) override;
         VisitResult visitBinaryExpr(const BinaryExpression &binExpr) override;
         VisitResult visitComparisonExpr(const ComparisonExpression &cmpExpr) override;
+        VisitResult visitRangeExpr(const RangeExpression &rangeExpr) override;
         VisitResult visitUnaryExpr(const UnaryExpression &unaryExpr) override;
         VisitResult visitCallExpr(const CallExpression &callExpr) override;
+        VisitResult visitIndexExpr(const IndexExpression &indexExpr) override;
+        VisitResult visitPropertyExpr(const PropertyExpression &propertyExpr) override;
         VisitResult visitVariableExpr(const VariableExpression &varExpr) override;
         VisitResult visitNumberExpr(const NumberExpression &numExpr) override;
         VisitResult visitBoolExpr(const BooleanExpression &boolExpr) override;
+        VisitResult visitStringExpr(const StringExpression &stringExpr) override;
+        VisitResult visitArrayExpr(const ArrayExpression &arrayExpr) override;
 
     private:
         void printLine(const std::string &line);
@@ -12,6 +12,61 @@ namespace ferrit {
         }
     }
 
+    AssignmentExpression::AssignmentExpression(Token op, Token name, ExpressionPtr value) noexcept :
+        m_op(std::move(op)), m_name(std::move(name)), m_value(std::move(value)) {
+    }
+
+    const Token &AssignmentExpression::op() const noexcept {
+        return m_op;
+    }
+
+    const Token &AssignmentExpression::name() const noexcept {
+        return m_name;
+    }
+
+    const Expression &AssignmentExpression::value() const noexcept {
+        return *m_value;
+    }
+
+    const Token &AssignmentExpression::errorToken() const noexcept {
+        return op();
+    }
+
+    bool AssignmentExpression::equals(const Expression &other) const noexcept {
+        const auto &assignOther = static_cast<const AssignmentExpression &>(other); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+        return op() == assignOther.op() &&
+            name() == assignOther.name() &&
+            value() == assignOther.value();
+    }
+
+    IndexAssignmentExpression::IndexAssignmentExpression(
+        Token op, std::unique_ptr<IndexExpression> target, ExpressionPtr value) noexcept :
+        m_op(std::move(op)), m_target(std::move(target)), m_value(std::move(value)) {
+    }
+
+    const Token &IndexAssignmentExpression::op() const noexcept {
+        return m_op;
+    }
+
+    const IndexExpression &IndexAssignmentExpression::target() const noexcept {
+        return *m_target;
+    }
+
+    const Expression &IndexAssignmentExpression::value() const noexcept {
+        return *m_value;
+    }
+
+    const Token &IndexAssignmentExpression::errorToken() const noexcept {
+        return op();
+    }
+
+    bool IndexAssignmentExpression::equals(const Expression &other) const noexcept {
+        const auto &assignOther = static_cast<const IndexAssignmentExpression &>(other); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+        return op() == assignOther.op() &&
+            static_cast<const Expression &>(target()) == assignOther.target() &&
+            value() == assignOther.value();
+    }
+
     BinaryExpression::BinaryExpression(Token op, ExpressionPtr left, ExpressionPtr right) noexcept :
         m_op(std::move(op)), m_left(std::move(left)), m_right(std::move(right)) {
     }
@@ -66,6 +121,37 @@ namespace ferrit {
             right() == cmpOther.right();
     }
 
+    RangeExpression::RangeExpression(Token op, ExpressionPtr start, ExpressionPtr end) noexcept :
+        m_op(std::move(op)), m_start(std::move(start)), m_end(std::move(end)) {
+    }
+
+    const Token &RangeExpression::op() const noexcept {
+        return m_op;
+    }
+
+    const Expression &RangeExpression::start() const noexcept {
+        return *m_start;
+    }
+
+    const Expression &RangeExpression::end() const noexcept {
+        return *m_end;
+    }
+
+    bool RangeExpression::isInclusive() const noexcept {
+        return op().type == TokenType::DotDotDot;
+    }
+
+    const Token &RangeExpression::errorToken() const noexcept {
+        return op();
+    }
+
+    bool RangeExpression::equals(const Expression &other) const noexcept {
+        const auto &rangeOther = static_cast<const RangeExpression &>(other); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+        return op() == rangeOther.op() &&
+            start() == rangeOther.start() &&
+            end() == rangeOther.end();
+    }
+
     UnaryExpression::UnaryExpression(Token op, ExpressionPtr operand, bool isPrefix) noexcept :
         m_op(std::move(op)), m_operand(std::move(operand)), m_isPrefix(isPrefix) {
     }
@@ -127,6 +213,54 @@ namespace ferrit {
         return true;
     }
 
+    IndexExpression::IndexExpression(Token bracket, ExpressionPtr array, ExpressionPtr index) noexcept :
+        m_bracket(std::move(bracket)), m_array(std::move(array)), m_index(std::move(index)) {
+    }
+
+    const Token &IndexExpression::bracket() const noexcept {
+        return m_bracket;
+    }
+
+    const Expression &IndexExpression::array() const noexcept {
+        return *m_array;
+    }
+
+    const Expression &IndexExpression::index() const noexcept {
+        return *m_index;
+    }
+
+    const Token &IndexExpression::errorToken() const noexcept {
+        return bracket();
+    }
+
+    bool IndexExpression::equals(const Expression &other) const noexcept {
+        const auto &indexOther = static_cast<const IndexExpression &>(other); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+        return bracket() == indexOther.bracket() &&
+            array() == indexOther.array() &&
+            index() == indexOther.index();
+    }
+
+    PropertyExpression::PropertyExpression(ExpressionPtr object, Token name) noexcept :
+        m_object(std::move(object)), m_name(std::move(name)) {
+    }
+
+    const Expression &PropertyExpression::object() const noexcept {
+        return *m_object;
+    }
+
+    const Token &PropertyExpression::name() const noexcept {
+        return m_name;
+    }
+
+    const Token &PropertyExpression::errorToken() const noexcept {
+        return name();
+    }
+
+    bool PropertyExpression::equals(const Expression &other) const noexcept {
+        const auto &propertyOther = static_cast<const PropertyExpression &>(other); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+        return object() == propertyOther.object() && name() == propertyOther.name();
+    }
+
     VariableExpression::VariableExpression(Token name) noexcept :
         m_name(std::move(name)) {
     }
@@ -181,4 +315,50 @@ namespace ferrit {
         const auto &boolOther = static_cast<const BooleanExpression &>(other); //NOLINT
         return value() == boolOther.value();
     }
+
+    StringExpression::StringExpression(Token value) noexcept :
+        m_value(std::move(value)) {
+    }
+
+    const Token &StringExpression::value() const noexcept {
+        return m_value;
+    }
+
+    const Token &StringExpression::errorToken() const noexcept {
+        return value();
+    }
+
+    bool StringExpression::equals(const Expression &other) const noexcept {
+        const auto &stringOther = static_cast<const StringExpression &>(other); //NOLINT
+        return value() == stringOther.value();
+    }
+
+    ArrayExpression::ArrayExpression(Token bracket, std::vector<ExpressionPtr> elements) noexcept :
+        m_bracket(std::move(bracket)), m_elements(std::move(elements)) {
+    }
+
+    const Token &ArrayExpression::bracket() const noexcept {
+        return m_bracket;
+    }
+
+    const std::vector<ExpressionPtr> &ArrayExpression::elements() const noexcept {
+        return m_elements;
+    }
+
+    const Token &ArrayExpression::errorToken() const noexcept {
+        return bracket();
+    }
+
+    bool ArrayExpression::equals(const Expression &other) const noexcept {
+        const auto &arrayOther = static_cast<const ArrayExpression &>(other); //NOLINT
+        if (bracket() != arrayOther.bracket()) return false;
+
+        if (elements().size() != arrayOther.elements().size()) return false;
+        for (std::size_t i = 0; i < elements().size(); i++) {
+            if (*elements()[i] != *arrayOther.elements()[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
 }
@@ -8,13 +8,20 @@
 
 namespace ferrit {
     class Expression;
+    class AssignmentExpression;
+    class IndexAssignmentExpression;
     class BinaryExpression;
     class ComparisonExpression;
+    class RangeExpression;
     class UnaryExpression;
     class CallExpression;
+    class IndexExpression;
+    class PropertyExpression;
     class VariableExpression;
     class NumberExpression;
     class BooleanExpression;
+    class StringExpression;
+    class ArrayExpression;
 
     using ExpressionPtr = std::unique_ptr<Expression>;
 
@@ -27,13 +34,20 @@ namespace ferrit {
     public:
         virtual ~ExpressionVisitor() noexcept = default;
 
+        virtual VisitResult visitAssignmentExpr(const AssignmentExpression &assignExpr) = 0;
+        virtual VisitResult visitIndexAssignmentExpr(const IndexAssignmentExpression &assignExpr) = 0;
         virtual VisitResult visitBinaryExpr(const BinaryExpression &binExpr) = 0;
         virtual VisitResult visitComparisonExpr(const ComparisonExpression &cmpExpr) = 0;
+        virtual VisitResult visitRangeExpr(const RangeExpression &rangeExpr) = 0;
         virtual VisitResult visitUnaryExpr(const UnaryExpression &unaryExpr) = 0;
         virtual VisitResult visitCallExpr(const CallExpression &callExpr) = 0;
+        virtual VisitResult visitIndexExpr(const IndexExpression &indexExpr) = 0;
+        virtual VisitResult visitPropertyExpr(const PropertyExpression &propertyExpr) = 0;
         virtual VisitResult visitVariableExpr(const VariableExpression &varExpr) = 0;
         virtual VisitResult visitNumberExpr(const NumberExpression &numExpr) = 0;
         virtual VisitResult visitBoolExpr(const BooleanExpression &boolExpr) = 0;
+        virtual VisitResult visitStringExpr(const StringExpression &stringExpr) = 0;
+        virtual VisitResult visitArrayExpr(const ArrayExpression &arrayExpr) = 0;
     };
 
     /**
@@ -56,6 +70,52 @@ namespace ferrit {
         [[nodiscard]] virtual bool equals(const Expression &other) const noexcept = 0;
     };
 
+    /**
+     * Represents assigning a new value to a variable, with either '=' or a compound assignment operator.
+     */
+    class AssignmentExpression final : public Expression {
+    public:
+        explicit AssignmentExpression(Token op, Token name, ExpressionPtr value) noexcept;
+
+        [[nodiscard]] const Token &op() const noexcept;
+        [[nodiscard]] const Token &name() const noexcept;
+        [[nodiscard]] const Expression &value() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(ExpressionVisitor, AssignmentExpr);
+
+    protected:
+        [[nodiscard]] bool equals(const Expression &other) const noexcept override;
+
+    private:
+        Token m_op;
+        Token m_name;
+        ExpressionPtr m_value;
+    };
+
+    /**
+     * Represents assigning a new value to an element of an array, with either '=' or a compound assignment operator.
+     */
+    class IndexAssignmentExpression final : public Expression {
+    public:
+        explicit IndexAssignmentExpression(Token op, std::unique_ptr<IndexExpression> target, ExpressionPtr value) noexcept;
+
+        [[nodiscard]] const Token &op() const noexcept;
+        [[nodiscard]] const IndexExpression &target() const noexcept;
+        [[nodiscard]] const Expression &value() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(ExpressionVisitor, IndexAssignmentExpr);
+
+    protected:
+        [[nodiscard]] bool equals(const Expression &other) const noexcept override;
+
+    private:
+        Token m_op;
+        std::unique_ptr<IndexExpression> m_target;
+        ExpressionPtr m_value;
+    };
+
     /**
     * Represents logical operators, arithmetic operators and the concatenate operator.
     */
@@ -102,6 +162,34 @@ namespace ferrit {
         ExpressionPtr m_right;
     };
 
+    /**
+     * Represents the exclusive ('..') and inclusive ('...') range operators.
+     */
+    class RangeExpression final : public Expression {
+    public:
+        explicit RangeExpression(Token op, ExpressionPtr start, ExpressionPtr end) noexcept;
+
+        [[nodiscard]] const Token &op() const noexcept;
+        [[nodiscard]] const Expression &start() const noexcept;
+        [[nodiscard]] const Expression &end() const noexcept;
+
+        /**
+         * Returns true if the range includes its end value.
+         */
+        [[nodiscard]] bool isInclusive() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(ExpressionVisitor, RangeExpr);
+
+    protected:
+        [[nodiscard]] bool equals(const Expression &other) const noexcept override;
+
+    private:
+        Token m_op;
+        ExpressionPtr m_start;
+        ExpressionPtr m_end;
+    };
+
     /**
      * Represents the unary operators.
      */
@@ -148,6 +236,50 @@ namespace ferrit {
         std::vector<ExpressionPtr> m_arguments;
     };
 
+    /**
+     * Represents accessing an element of an array (e.g. 'array[index]').
+     */
+    class IndexExpression final : public Expression {
+    public:
+        explicit IndexExpression(Token bracket, ExpressionPtr array, ExpressionPtr index) noexcept;
+
+        [[nodiscard]] const Token &bracket() const noexcept;
+        [[nodiscard]] const Expression &array() const noexcept;
+        [[nodiscard]] const Expression &index() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(ExpressionVisitor, IndexExpr);
+
+    protected:
+        [[nodiscard]] bool equals(const Expression &other) const noexcept override;
+
+    private:
+        Token m_bracket;
+        ExpressionPtr m_array;
+        ExpressionPtr m_index;
+    };
+
+    /**
+     * Represents reading a property of an object (e.g. 'array.size').
+     */
+    class PropertyExpression final : public Expression {
+    public:
+        explicit PropertyExpression(ExpressionPtr object, Token name) noexcept;
+
+        [[nodiscard]] const Expression &object() const noexcept;
+        [[nodiscard]] const Token &name() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(ExpressionVisitor, PropertyExpr);
+
+    protected:
+        [[nodiscard]] bool equals(const Expression &other) const noexcept override;
+
+    private:
+        ExpressionPtr m_object;
+        Token m_name;
+    };
+
     /**
      * Represents a direct variable access (ie just writing the variable's name in an expression).
      */
@@ -206,4 +338,44 @@ namespace ferrit {
     private:
         Token m_value;
     };
+
+    /**
+     * Represents a literal string. The token's lexeme still contains the quotes and escape sequences.
+     */
+    class StringExpression final : public Expression {
+    public:
+        explicit StringExpression(Token value) noexcept;
+
+        [[nodiscard]] const Token &value() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(ExpressionVisitor, StringExpr);
+
+    protected:
+        [[nodiscard]] bool equals(const Expression &other) const noexcept override;
+
+    private:
+        Token m_value;
+    };
+
+    /**
+     * Represents an array literal (e.g. '[1, 2, 3]').
+     */
+    class ArrayExpression final : public Expression {
+    public:
+        explicit ArrayExpression(Token bracket, std::vector<ExpressionPtr> elements) noexcept;
+
+        [[nodiscard]] const Token &bracket() const noexcept;
+        [[nodiscard]] const std::vector<ExpressionPtr> &elements() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(ExpressionVisitor, ArrayExpr);
+
+    protected:
+        [[nodiscard]] bool equals(const Expression &other) const noexcept override;
+
+    private:
+        Token m_bracket;
+        std::vector<ExpressionPtr> m_elements;
+    };
 }
@@ -18,6 +18,8 @@ namespace ferrit {
         bool silent{false};           ///< Do not print compile errors to the errors stream.
         bool plain{false};            ///< Do not use color codes in output.
         bool traceVm{false};          ///< Trace virtual machine execution
+        bool reportVectorization{false}; ///< Report which loops were vectorized to the errors stream.
+        bool emitNativeHeaders{false}; ///< Print a header declaring the native functions, instead of running the program.
     };
 
     /**
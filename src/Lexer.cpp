@@ -1,5 +1,6 @@
 #include "Lexer.h"
 
+#include <string_view>
 #include <unordered_map>
 
 
@@ -279,20 +280,61 @@ namespace ferrit {
 
     Token Lexer::lexNumber() {
         TokenType numberType = TokenType::IntegerLiteral;
-        while (peek() && isDigit(*peek())) {
+
+        // a base prefix only counts as one if a digit follows it, so that "0b" on its own is still
+        // the Byte 0. digits that the base does not allow are left for the compiler to report
+        bool isPrefixed = false;
+        bool isHex = false;
+        if (m_code[m_start] == '0' && peek() && peekNext()) {
+            char prefix = *peek();
+            if ((prefix == 'x' && isHexDigit(*peekNext())) || ((prefix == 'b' || prefix == 'o') && isDigit(*peekNext()))) {
+                isPrefixed = true;
+                isHex = prefix == 'x';
+                advance();
+            }
+        }
+
+        // underscores only separate digits, and may appear anywhere after the first one
+        auto isDigitOrSeparator = [isHex](char ch) {
+            return (isHex ? isHexDigit(ch) : isDigit(ch)) || ch == '_';
+        };
+        while (peek() && isDigitOrSeparator(*peek())) {
             advance();
         }
 
         bool currentIsPeriod = peek() && *peek() == '.';
         bool nextIsDigit = peekNext() && isDigit(*peekNext());
-        if (currentIsPeriod && nextIsDigit) {
+        if (!isPrefixed && currentIsPeriod && nextIsDigit) {
             numberType = TokenType::FloatLiteral;
             // consume the '.'
             advance();
-            while (peek() && isDigit(*peek())) {
+            while (peek() && isDigitOrSeparator(*peek())) {
                 advance();
             }
+
+            // an exponent, whose sign is optional
+            if (peek() && *peek() == 'e') {
+                bool isSigned = peekNext() && (*peekNext() == '-' || *peekNext() == '+');
+                auto firstDigit = peekN(isSigned ? 2 : 1);
+                if (firstDigit && isDigit(*firstDigit)) {
+                    advance();
+                    if (isSigned) {
+                        advance();
+                    }
+                    while (peek() && isDigitOrSeparator(*peek())) {
+                        advance();
+                    }
+                }
+            }
+        }
+
+        // a single letter after the digits gives the literal's exact type
+        std::string_view suffixes = numberType == TokenType::IntegerLiteral ? "bsiL" : "fd";
+        bool nextIsIdentifier = peekNext() && isIdentifier(*peekNext());
+        if (peek() && suffixes.find(*peek()) != std::string_view::npos && !nextIsIdentifier) {
+            advance();
         }
+
         // prevent numbers from being immediately followed by an identifier
         if (peek() && isIdentifier(*peek())) {
             int start = m_current;
@@ -440,6 +482,10 @@ namespace ferrit {
         return ch >= '0' && ch <= '9';
     }
 
+    bool Lexer::isHexDigit(char ch) noexcept {
+        return isDigit(ch) || (ch >= 'A' && ch <= 'F');
+    }
+
     bool Lexer::isIdentifier(char ch) noexcept {
         return isDigit(ch) || isIdentifierStart(ch);
     }
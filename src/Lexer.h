@@ -94,7 +94,8 @@ namespace ferrit {
         void advanceStringChar(const std::string &literalType);
 
         /**
-         * Scans an integer or float literal.
+         * Scans an integer or float literal, including its base prefix, digit separators,
+         * exponent and type suffix.
          *
          * @return the literal
          * @throws ParseError if the literal is ill-formed
@@ -190,6 +191,11 @@ namespace ferrit {
          */
         [[nodiscard]] static bool isDigit(char ch) noexcept;
 
+        /**
+         * Returns true if the given character is an ASCII digit or an uppercase hexadecimal digit.
+         */
+        [[nodiscard]] static bool isHexDigit(char ch) noexcept;
+
         /**
          * Returns true if the given character can appear in the middle of an identifier.
          */
@@ -87,10 +87,25 @@ namespace ferrit {
             modifiers, keyword, name, std::move(params), returnType, std::move(body));
     }
 
+    StatementPtr Parser::parseVariableDeclaration() {
+        const Token &keyword = previous();
+        const Token &name = consume(TokenType::Identifier, "expected variable name");
+
+        std::optional<DeclaredType> type{};
+        if (match(TokenType::Colon)) {
+            type = parseType();
+        }
+
+        consume(TokenType::Equal, "expected '=' after variable name");
+        auto initializer = parseExpression();
+
+        return std::make_unique<VariableDeclaration>(keyword, name, std::move(type), std::move(initializer));
+    }
+
     std::vector<Token> Parser::parseModifiers() {
         std::vector<Token> result;
         while (true) {
-            if (match(TokenType::Native)) {
+            if (match(TokenType::Native) || match(TokenType::Open)) {
                 result.push_back(previous());
             } else {
                 break;
@@ -136,15 +151,35 @@ namespace ferrit {
 
     DeclaredType Parser::parseType() {
         if (match(TokenType::Identifier)) {
-            return DeclaredType(previous());
+            Token name = previous();
+            if (!match(TokenType::Less)) {
+                return DeclaredType(name);
+            }
+
+            std::vector<DeclaredType> arguments;
+            do {
+                arguments.push_back(parseType());
+            } while (match(TokenType::Comma));
+            consume(TokenType::Greater, "expected '>' after type arguments");
+            return DeclaredType(name, std::move(arguments));
         } else {
             throw makeError("expected type name");
         }
     }
 
     StatementPtr Parser::parseStatement() {
-        if (match(TokenType::If)) {
+        if (match(TokenType::Val) || match(TokenType::Var)) {
+            return parseVariableDeclaration();
+        } else if (match(TokenType::If)) {
             return parseConditional();
+        } else if (match(TokenType::While)) {
+            return parseWhile();
+        } else if (match(TokenType::Do)) {
+            return parseDoWhile();
+        } else if (match(TokenType::For)) {
+            return parseFor();
+        } else if (match(TokenType::Return)) {
+            return parseReturn();
         } else {
             auto expr = parseExpression();
             return std::make_unique<ExpressionStatement>(std::move(expr));
@@ -159,8 +194,9 @@ namespace ferrit {
             auto statement = parseStatement();
             body.push_back(std::move(statement));
 
+            // check() may already have skipped the newline after the statement
             auto foundTerms = skipTerminators(true);
-            if (!foundTerms.any()) break;
+            if (!foundTerms.any() && previous().type != TokenType::Newline) break;
         }
         consume(TokenType::RightBrace, "expected '}' after block");
 
@@ -197,8 +233,95 @@ namespace ferrit {
             std::move(elseKeyword), std::move(elseBody));
     }
 
+    StatementPtr Parser::parseWhile() {
+        const auto &whileToken = previous();
+
+        consume(TokenType::LeftParen, "expected '(' after 'while'");
+        auto condition = parseExpression();
+        consume(TokenType::RightParen, "expected ')' after while condition");
+
+        auto body = parseLoopBody();
+        return std::make_unique<WhileStatement>(whileToken, std::move(condition), std::move(body), false);
+    }
+
+    StatementPtr Parser::parseDoWhile() {
+        const auto &doToken = previous();
+
+        auto body = parseLoopBody();
+
+        consume(TokenType::While, "expected 'while' after do-while body");
+        consume(TokenType::LeftParen, "expected '(' after 'while'");
+        auto condition = parseExpression();
+        consume(TokenType::RightParen, "expected ')' after while condition");
+
+        return std::make_unique<WhileStatement>(doToken, std::move(condition), std::move(body), true);
+    }
+
+    StatementPtr Parser::parseFor() {
+        const auto &forToken = previous();
+
+        consume(TokenType::LeftParen, "expected '(' after 'for'");
+        const auto &variable = consume(TokenType::Identifier, "expected loop variable name");
+        consume(TokenType::In, "expected 'in' after loop variable");
+        auto iterable = parseExpression();
+        consume(TokenType::RightParen, "expected ')' after for loop iterable");
+
+        auto body = parseLoopBody();
+        return std::make_unique<ForStatement>(forToken, variable, std::move(iterable), std::move(body));
+    }
+
+    StatementPtr Parser::parseLoopBody() {
+        if (match(TokenType::LeftBrace)) {
+            return parseBlock();
+        } else {
+            return parseStatement();
+        }
+    }
+
+    StatementPtr Parser::parseReturn() {
+        const auto &returnToken = previous();
+
+        // don't use check() here, since it would skip past the end of the line
+        switch (current().type) {
+        case TokenType::Newline:
+        case TokenType::Semicolon:
+        case TokenType::RightBrace:
+        case TokenType::EndOfFile:
+            return std::make_unique<ReturnStatement>(returnToken);
+        default:
+            return std::make_unique<ReturnStatement>(returnToken, parseExpression());
+        }
+    }
+
     ExpressionPtr Parser::parseExpression() {
-        return parseDisjunction();
+        return parseAssignment();
+    }
+
+    ExpressionPtr Parser::parseAssignment() {
+        auto target = parseDisjunction();
+        if (match(TokenType::Equal) ||
+            match(TokenType::PlusEqual) || match(TokenType::MinusEqual) ||
+            match(TokenType::AsteriskEqual) || match(TokenType::SlashEqual) ||
+            match(TokenType::PercentEqual) || match(TokenType::TildeEqual) ||
+            match(TokenType::AndAndEqual) || match(TokenType::OrOrEqual))
+        {
+            Token op = previous();
+            if (dynamic_cast<const IndexExpression *>(target.get())) {
+                auto value = parseAssignment();
+                std::unique_ptr<IndexExpression> element{static_cast<IndexExpression *>(target.release())};
+                return std::make_unique<IndexAssignmentExpression>(op, std::move(element), std::move(value));
+            }
+
+            const auto *variable = dynamic_cast<const VariableExpression *>(target.get());
+            if (!variable) {
+                throw makeError("expected variable name or array element before assignment operator");
+            }
+
+            // assignment is right associative, so 'a = b = c' assigns c to both a and b
+            auto value = parseAssignment();
+            return std::make_unique<AssignmentExpression>(op, variable->name(), std::move(value));
+        }
+        return target;
     }
 
     ExpressionPtr Parser::parseDisjunction() {
@@ -232,21 +355,32 @@ namespace ferrit {
     }
 
     ExpressionPtr Parser::parseComparison() {
-        auto left = parseAdditive();
+        auto left = parseRange();
         while (
             match(TokenType::Greater) || match(TokenType::GreaterEqual) ||
             match(TokenType::Less) || match(TokenType::LessEqual))
         {
             Token op = previous();
-            auto right = parseAdditive();
+            auto right = parseRange();
             left = std::make_unique<ComparisonExpression>(op, std::move(left), std::move(right));
         }
         return left;
     }
 
+    ExpressionPtr Parser::parseRange() {
+        auto start = parseAdditive();
+        // ranges do not chain, so 'a..b..c' is a syntax error
+        if (match(TokenType::DotDot) || match(TokenType::DotDotDot)) {
+            Token op = previous();
+            auto end = parseAdditive();
+            return std::make_unique<RangeExpression>(op, std::move(start), std::move(end));
+        }
+        return start;
+    }
+
     ExpressionPtr Parser::parseAdditive() {
         auto left = parseMultiplicative();
-        while (match(TokenType::Plus) || match(TokenType::Minus)) {
+        while (match(TokenType::Plus) || match(TokenType::Minus) || match(TokenType::Tilde)) {
             Token op = previous();
             auto right = parseMultiplicative();
             left = std::make_unique<BinaryExpression>(op, std::move(left), std::move(right));
@@ -286,6 +420,14 @@ namespace ferrit {
                 const Token &paren = previous();
                 auto args = parseArguments();
                 operand = std::make_unique<CallExpression>(paren, std::move(operand), std::move(args));
+            } else if (match(TokenType::LeftBracket)) {
+                const Token &bracket = previous();
+                auto index = parseExpression();
+                consume(TokenType::RightBracket, "expected ']' after index");
+                operand = std::make_unique<IndexExpression>(bracket, std::move(operand), std::move(index));
+            } else if (match(TokenType::Dot)) {
+                const Token &name = consume(TokenType::Identifier, "expected property name after '.'");
+                operand = std::make_unique<PropertyExpression>(std::move(operand), name);
             } else {
                 break;
             }
@@ -320,6 +462,10 @@ namespace ferrit {
             return parseNumber();
         } else if (match(TokenType::True) || match(TokenType::False)) {
             return parseBoolean();
+        } else if (match(TokenType::StringLiteral)) {
+            return parseString();
+        } else if (match(TokenType::LeftBracket)) {
+            return parseArray();
         } else {
             throw makeError("expected primary expression");
         }
@@ -346,6 +492,29 @@ namespace ferrit {
         return std::make_unique<BooleanExpression>(boolean);
     }
 
+    ExpressionPtr Parser::parseString() {
+        const Token &string = previous();
+        return std::make_unique<StringExpression>(string);
+    }
+
+    ExpressionPtr Parser::parseArray() {
+        const Token &bracket = previous();
+        std::vector<ExpressionPtr> elements;
+        if (!check(TokenType::RightBracket)) {
+            elements.push_back(parseExpression());
+            while (match(TokenType::Comma)) {
+                if (check(TokenType::RightBracket)) {
+                    // trailing comma
+                    break;
+                } else {
+                    elements.push_back(parseExpression());
+                }
+            }
+        }
+        consume(TokenType::RightBracket, "expected ']' after array elements");
+        return std::make_unique<ArrayExpression>(bracket, std::move(elements));
+    }
+
     void Parser::synchronize() noexcept {
         advance();
 
@@ -355,8 +524,12 @@ namespace ferrit {
             switch (current().type) {
             // Return on tokens that are likely to start a new line
             case TokenType::Native:
+            case TokenType::Val:
             case TokenType::Var:
             case TokenType::Fun:
+            case TokenType::While:
+            case TokenType::Do:
+            case TokenType::For:
             case TokenType::Return:
                 return;
             // no possible statement ending tokens were found
@@ -43,6 +43,7 @@ namespace ferrit {
         // Declarations
         [[nodiscard]] StatementPtr parseDeclaration();
         [[nodiscard]] StatementPtr parseFunctionDeclaration(const std::vector<Token>& modifiers);
+        [[nodiscard]] StatementPtr parseVariableDeclaration();
 
         // Supporting AST elements
         [[nodiscard]] std::vector<Token> parseModifiers();
@@ -53,14 +54,21 @@ namespace ferrit {
         // Other statements
         [[nodiscard]] StatementPtr parseStatement();
         [[nodiscard]] StatementPtr parseConditional();
+        [[nodiscard]] StatementPtr parseWhile();
+        [[nodiscard]] StatementPtr parseDoWhile();
+        [[nodiscard]] StatementPtr parseFor();
+        [[nodiscard]] StatementPtr parseLoopBody();
+        [[nodiscard]] StatementPtr parseReturn();
         [[nodiscard]] StatementPtr parseBlock();
 
         // Operators
         [[nodiscard]] ExpressionPtr parseExpression();
+        [[nodiscard]] ExpressionPtr parseAssignment();
         [[nodiscard]] ExpressionPtr parseDisjunction();
         [[nodiscard]] ExpressionPtr parseConjunction();
         [[nodiscard]] ExpressionPtr parseEquality();
         [[nodiscard]] ExpressionPtr parseComparison();
+        [[nodiscard]] ExpressionPtr parseRange();
         [[nodiscard]] ExpressionPtr parseAdditive();
         [[nodiscard]] ExpressionPtr parseMultiplicative();
         [[nodiscard]] ExpressionPtr parseUnaryPrefix();
@@ -73,6 +81,8 @@ namespace ferrit {
         [[nodiscard]] ExpressionPtr parseVariable();
         [[nodiscard]] ExpressionPtr parseNumber();
         [[nodiscard]] ExpressionPtr parseBoolean();
+        [[nodiscard]] ExpressionPtr parseString();
+        [[nodiscard]] ExpressionPtr parseArray();
 
         /**
          * Attempts to recover from an error by skipping tokens until finding
@@ -68,6 +68,44 @@ namespace ferrit {
                 (*body() == *otherFun.body()));
     }
 
+    VariableDeclaration::VariableDeclaration(
+        Token keyword, Token name, std::optional<DeclaredType> type, ExpressionPtr initializer) noexcept :
+        m_keyword{std::move(keyword)}, m_name{std::move(name)},
+        m_type{std::move(type)}, m_initializer{std::move(initializer)} {
+    }
+
+    const Token &VariableDeclaration::keyword() const noexcept {
+        return m_keyword;
+    }
+
+    const Token &VariableDeclaration::name() const noexcept {
+        return m_name;
+    }
+
+    const std::optional<DeclaredType> &VariableDeclaration::type() const noexcept {
+        return m_type;
+    }
+
+    const Expression &VariableDeclaration::initializer() const noexcept {
+        return *m_initializer;
+    }
+
+    bool VariableDeclaration::isMutable() const noexcept {
+        return keyword().type == TokenType::Var;
+    }
+
+    const Token &VariableDeclaration::errorToken() const noexcept {
+        return name();
+    }
+
+    bool VariableDeclaration::equals(const Statement &other) const noexcept {
+        const auto &otherVar = static_cast<const VariableDeclaration &>(other); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+        return keyword() == otherVar.keyword() &&
+            name() == otherVar.name() &&
+            type() == otherVar.type() &&
+            initializer() == otherVar.initializer();
+    }
+
     ConditionalStatement::ConditionalStatement(
         Token ifKeyword, ExpressionPtr condition, StatementPtr ifBody,
         std::optional<Token> elseKeyword, std::optional<StatementPtr> elseBody) :
@@ -109,6 +147,71 @@ namespace ferrit {
                 (*elseBody() == *otherCond.elseBody()));
     }
 
+    WhileStatement::WhileStatement(Token keyword, ExpressionPtr condition, StatementPtr body, bool isDoWhile) noexcept :
+        m_keyword{std::move(keyword)}, m_condition{std::move(condition)}, m_body{std::move(body)}, m_isDoWhile{isDoWhile} {
+    }
+
+    const Token &WhileStatement::keyword() const noexcept {
+        return m_keyword;
+    }
+
+    const Expression &WhileStatement::condition() const noexcept {
+        return *m_condition;
+    }
+
+    const Statement &WhileStatement::body() const noexcept {
+        return *m_body;
+    }
+
+    bool WhileStatement::isDoWhile() const noexcept {
+        return m_isDoWhile;
+    }
+
+    const Token &WhileStatement::errorToken() const noexcept {
+        return keyword();
+    }
+
+    bool WhileStatement::equals(const Statement &other) const noexcept {
+        const auto &otherWhile = static_cast<const WhileStatement &>(other); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+        return keyword() == otherWhile.keyword() &&
+            condition() == otherWhile.condition() &&
+            body() == otherWhile.body() &&
+            isDoWhile() == otherWhile.isDoWhile();
+    }
+
+    ForStatement::ForStatement(Token keyword, Token variable, ExpressionPtr iterable, StatementPtr body) noexcept :
+        m_keyword{std::move(keyword)}, m_variable{std::move(variable)},
+        m_iterable{std::move(iterable)}, m_body{std::move(body)} {
+    }
+
+    const Token &ForStatement::keyword() const noexcept {
+        return m_keyword;
+    }
+
+    const Token &ForStatement::variable() const noexcept {
+        return m_variable;
+    }
+
+    const Expression &ForStatement::iterable() const noexcept {
+        return *m_iterable;
+    }
+
+    const Statement &ForStatement::body() const noexcept {
+        return *m_body;
+    }
+
+    const Token &ForStatement::errorToken() const noexcept {
+        return keyword();
+    }
+
+    bool ForStatement::equals(const Statement &other) const noexcept {
+        const auto &otherFor = static_cast<const ForStatement &>(other); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+        return keyword() == otherFor.keyword() &&
+            variable() == otherFor.variable() &&
+            iterable() == otherFor.iterable() &&
+            body() == otherFor.body();
+    }
+
     BlockStatement::BlockStatement(Token brace, std::vector<StatementPtr> body) noexcept :
         m_brace(std::move(brace)), m_body(std::move(body)) {
     }
@@ -130,6 +233,30 @@ namespace ferrit {
         return body() == otherBlock.body();
     }
 
+    ReturnStatement::ReturnStatement(Token keyword, std::optional<ExpressionPtr> value) noexcept :
+        m_keyword{std::move(keyword)}, m_value{value.has_value() ? std::move(value.value()) : nullptr} {
+    }
+
+    const Token &ReturnStatement::keyword() const noexcept {
+        return m_keyword;
+    }
+
+    const Expression *ReturnStatement::value() const noexcept {
+        return m_value.get();
+    }
+
+    const Token &ReturnStatement::errorToken() const noexcept {
+        return keyword();
+    }
+
+    bool ReturnStatement::equals(const Statement &other) const noexcept {
+        const auto &otherReturn = static_cast<const ReturnStatement &>(other); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+        if (value() == nullptr || otherReturn.value() == nullptr) {
+            return keyword() == otherReturn.keyword() && value() == otherReturn.value();
+        }
+        return keyword() == otherReturn.keyword() && *value() == *otherReturn.value();
+    }
+
     ExpressionStatement::ExpressionStatement(ExpressionPtr expr) noexcept :
         m_expr(std::move(expr)) {
     }
@@ -13,8 +13,12 @@
 namespace ferrit {
     class Statement;
     class FunctionDeclaration;
+    class VariableDeclaration;
     class ConditionalStatement;
+    class WhileStatement;
+    class ForStatement;
     class BlockStatement;
+    class ReturnStatement;
     class ExpressionStatement;
 
     using StatementPtr = std::unique_ptr<Statement>;
@@ -29,8 +33,12 @@ namespace ferrit {
         virtual ~StatementVisitor() noexcept = default;
 
         virtual VisitResult visitFunctionDecl(const FunctionDeclaration &funDecl) = 0;
+        virtual VisitResult visitVariableDecl(const VariableDeclaration &varDecl) = 0;
         virtual VisitResult visitConditionalStmt(const ConditionalStatement &conditionalStmt) = 0;
+        virtual VisitResult visitWhileStmt(const WhileStatement &whileStmt) = 0;
+        virtual VisitResult visitForStmt(const ForStatement &forStmt) = 0;
         virtual VisitResult visitBlockStmt(const BlockStatement &blockStmt) = 0;
+        virtual VisitResult visitReturnStmt(const ReturnStatement &returnStmt) = 0;
         virtual VisitResult visitExpressionStmt(const ExpressionStatement &exprStmt) = 0;
     };
 
@@ -89,6 +97,37 @@ namespace ferrit {
         StatementPtr m_body;
     };
 
+    /**
+     * Represents a local variable declaration, either immutable ('val') or mutable ('var').
+     */
+    class VariableDeclaration final : public Statement {
+    public:
+        explicit VariableDeclaration(
+            Token keyword, Token name, std::optional<DeclaredType> type, ExpressionPtr initializer) noexcept;
+
+        [[nodiscard]] const Token &keyword() const noexcept;
+        [[nodiscard]] const Token &name() const noexcept;
+        [[nodiscard]] const std::optional<DeclaredType> &type() const noexcept;
+        [[nodiscard]] const Expression &initializer() const noexcept;
+
+        /**
+         * Returns true if the variable was declared with 'var' and may be reassigned.
+         */
+        [[nodiscard]] bool isMutable() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(StatementVisitor, VariableDecl);
+
+    protected:
+        [[nodiscard]] bool equals(const Statement &other) const noexcept override;
+
+    private:
+        Token m_keyword;
+        Token m_name;
+        std::optional<DeclaredType> m_type;
+        ExpressionPtr m_initializer;
+    };
+
     /**
      * Represents an if/else statement.
      */
@@ -120,6 +159,63 @@ namespace ferrit {
         StatementPtr m_elseBody;
     };
 
+    /**
+     * Represents a while loop or a do-while loop.
+     */
+    class WhileStatement final : public Statement {
+    public:
+        explicit WhileStatement(Token keyword, ExpressionPtr condition, StatementPtr body, bool isDoWhile) noexcept;
+
+        /**
+         * Returns the keyword that begins the loop ('while' or 'do').
+         */
+        [[nodiscard]] const Token &keyword() const noexcept;
+        [[nodiscard]] const Expression &condition() const noexcept;
+        [[nodiscard]] const Statement &body() const noexcept;
+
+        /**
+         * Returns true if the condition is checked after the body instead of before it.
+         */
+        [[nodiscard]] bool isDoWhile() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(StatementVisitor, WhileStmt);
+
+    protected:
+        [[nodiscard]] bool equals(const Statement &other) const noexcept override;
+
+    private:
+        Token m_keyword;
+        ExpressionPtr m_condition;
+        StatementPtr m_body;
+        bool m_isDoWhile;
+    };
+
+    /**
+     * Represents a for loop, which binds each element of an iterable to a variable.
+     */
+    class ForStatement final : public Statement {
+    public:
+        explicit ForStatement(Token keyword, Token variable, ExpressionPtr iterable, StatementPtr body) noexcept;
+
+        [[nodiscard]] const Token &keyword() const noexcept;
+        [[nodiscard]] const Token &variable() const noexcept;
+        [[nodiscard]] const Expression &iterable() const noexcept;
+        [[nodiscard]] const Statement &body() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(StatementVisitor, ForStmt);
+
+    protected:
+        [[nodiscard]] bool equals(const Statement &other) const noexcept override;
+
+    private:
+        Token m_keyword;
+        Token m_variable;
+        ExpressionPtr m_iterable;
+        StatementPtr m_body;
+    };
+
     /**
      * Represents a group of statements.
      */
@@ -141,6 +237,31 @@ namespace ferrit {
         std::vector<StatementPtr> m_body;
     };
 
+    /**
+     * Represents returning from a function, with or without a value.
+     */
+    class ReturnStatement final : public Statement {
+    public:
+        explicit ReturnStatement(Token keyword, std::optional<ExpressionPtr> value = {}) noexcept;
+
+        [[nodiscard]] const Token &keyword() const noexcept;
+
+        /**
+         * Returns the value being returned, or nullptr if there is none.
+         */
+        [[nodiscard]] const Expression *value() const noexcept;
+        [[nodiscard]] const Token &errorToken() const noexcept override;
+
+        MAKE_VISITABLE(StatementVisitor, ReturnStmt);
+
+    protected:
+        [[nodiscard]] bool equals(const Statement &other) const noexcept override;
+
+    private:
+        Token m_keyword;
+        ExpressionPtr m_value;
+    };
+
     /**
      * Represents an expression whose value is unused (for instance, a function call in a block).
      */
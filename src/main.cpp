@@ -16,6 +16,9 @@ cxxopts::Options makeOptions() {
         ("silent", "disable error logging", cxxopts::value<bool>()->default_value("false"))
         ("plain", "disable colors in output", cxxopts::value<bool>()->default_value("false"))
         ("trace-vm", "trace virtual machine execution", cxxopts::value<bool>()->default_value("false"))
+        ("report-vectorization", "report which loops were vectorized", cxxopts::value<bool>()->default_value("false"))
+        ("emit-native-headers", "print a C++ header declaring the native functions instead of running the program",
+            cxxopts::value<bool>()->default_value("false"))
         ("file", "file to interpret", cxxopts::value<std::string>());
 
     options.parse_positional("file");
@@ -87,7 +90,9 @@ int main(int argc, char *argv[]) {
                 .printAst = flags["print-ast"].as<bool>(),
                 .silent = flags["silent"].as<bool>(),
                 .plain = flags["plain"].as<bool>(),
-                .traceVm = flags["trace-vm"].as<bool>()
+                .traceVm = flags["trace-vm"].as<bool>(),
+                .reportVectorization = flags["report-vectorization"].as<bool>(),
+                .emitNativeHeaders = flags["emit-native-headers"].as<bool>()
             });
 
         if (flags.count("file")) {
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Object.h"
+#include "Value.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+
+namespace ferrit {
+    /**
+     * Base class for Ferrit arrays, which holds what does not depend on the element type.
+     */
+    class Array : public Object {
+    public:
+        [[nodiscard]] std::size_t length() const noexcept {
+            return m_length;
+        }
+
+        /**
+         * Checks if the index refers to an element of this array.
+         */
+        [[nodiscard]] bool isInBounds(std::int64_t index) const noexcept {
+            // negative indices wrap around to huge unsigned values, so one comparison covers both ends
+            return static_cast<std::uint64_t>(index) < m_length;
+        }
+
+    protected:
+        explicit Array(std::size_t length) noexcept : m_length{length} {
+        }
+
+    protected:
+        std::size_t m_length;
+    };
+
+    /**
+     * A fixed-length Ferrit array of a primitive element type.
+     *
+     * The elements are stored unboxed in one contiguous buffer, rather than as an array of
+     * <tt>Value</tt>s, so an <tt>Array&lt;Int&gt;</tt> of a million elements takes eight megabytes
+     * and a loop over it touches memory in order. Since the elements are never references, the
+     * garbage collector does not need to look inside the array at all.
+     *
+     * @tparam T the type that the elements are stored as
+     */
+    template <typename T>
+    class PackedArray final : public Array {
+    public:
+        /**
+         * Creates an array with every element set to the same value.
+         *
+         * @param length the number of elements
+         * @param fill the initial value of each element
+         */
+        explicit PackedArray(std::size_t length, T fill) :
+            Array{length},
+            m_elements{std::make_unique_for_overwrite<T[]>(length)} {
+            std::fill_n(m_elements.get(), length, fill);
+        }
+
+        void trace(Heap &) override {
+            // the elements are primitives, so there is nothing to trace
+        }
+
+        [[nodiscard]] std::size_t externalSize() const noexcept override {
+            return m_length * sizeof(T);
+        }
+
+        [[nodiscard]] RuntimeType runtimeType() const override {
+            if constexpr (std::is_same_v<T, std::int64_t>) {
+                return RuntimeType::IntArrayType;
+            } else if constexpr (std::is_same_v<T, double>) {
+                return RuntimeType::RealArrayType;
+            } else {
+                return RuntimeType::BoolArrayType;
+            }
+        }
+
+        [[nodiscard]] std::string toString() const override {
+            std::string result = "[";
+            for (std::size_t i = 0; i < m_length; i++) {
+                if (i > 0) {
+                    result += ", ";
+                }
+                std::format_to(std::back_inserter(result), "{}", Value{m_elements[i]});
+            }
+            result += "]";
+            return result;
+        }
+
+        /**
+         * Returns the element at the given index, which must be in bounds.
+         */
+        [[nodiscard]] T get(std::int64_t index) const noexcept {
+            return m_elements[static_cast<std::size_t>(index)];
+        }
+
+        /**
+         * Replaces the element at the given index, which must be in bounds. Unlike stores into
+         * other objects, this needs no write barrier, since the elements are not references.
+         */
+        void set(std::int64_t index, T value) noexcept {
+            m_elements[static_cast<std::size_t>(index)] = value;
+        }
+
+        [[nodiscard]] T *data() noexcept {
+            return m_elements.get();
+        }
+
+        [[nodiscard]] const T *data() const noexcept {
+            return m_elements.get();
+        }
+
+    private:
+        std::unique_ptr<T[]> m_elements;
+    };
+
+    /**
+     * Returns the value as the type that array elements of that kind are stored as. The compiler
+     * has already checked that the value has that type.
+     */
+    template <typename T>
+    T unbox(const Value &value) {
+        if constexpr (std::is_same_v<T, std::int64_t>) {
+            return value.asIntegerUnchecked();
+        } else if constexpr (std::is_same_v<T, double>) {
+            return value.asRealUnchecked();
+        } else {
+            return value.asBooleanUnchecked();
+        }
+    }
+
+    using IntArray = PackedArray<std::int64_t>;
+    using RealArray = PackedArray<double>;
+    using BoolArray = PackedArray<bool>;
+}
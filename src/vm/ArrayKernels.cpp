@@ -0,0 +1,680 @@
+#include "ArrayKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FERRIT_X86_64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define FERRIT_AARCH64
+#include <arm_neon.h>
+#endif
+
+// MSVC lets any function use AVX2 intrinsics, while GCC and Clang need to be told which ones may
+#if defined(FERRIT_X86_64) && !defined(_MSC_VER)
+#define FERRIT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define FERRIT_TARGET_AVX2
+#endif
+
+
+namespace ferrit {
+    namespace {
+        enum class Arithmetic {
+            Add,
+            Subtract,
+            Multiply,
+            Divide,
+        };
+
+        template <Arithmetic op, typename T>
+        T apply(T left, T right) {
+            if constexpr (op == Arithmetic::Add) {
+                return left + right;
+            } else if constexpr (op == Arithmetic::Subtract) {
+                return left - right;
+            } else if constexpr (op == Arithmetic::Multiply) {
+                return left * right;
+            } else {
+                return left / right;
+            }
+        }
+
+        // The scalar kernels are used on every platform, and also finish the elements that are
+        // left over when an array's size is not a multiple of the vector width.
+
+        template <typename T>
+        T scalarSum(const T *data, std::size_t size, T result = T{}) {
+            for (std::size_t i = 0; i < size; i++) {
+                result += data[i];
+            }
+            return result;
+        }
+
+        template <bool isMin, typename T>
+        T scalarExtreme(const T *data, std::size_t size, T result) {
+            for (std::size_t i = 0; i < size; i++) {
+                if (isMin ? data[i] < result : data[i] > result) {
+                    result = data[i];
+                }
+            }
+            return result;
+        }
+
+        template <typename T>
+        T scalarMin(const T *data, std::size_t size) {
+            return scalarExtreme<true>(data + 1, size - 1, data[0]);
+        }
+
+        template <typename T>
+        T scalarMax(const T *data, std::size_t size) {
+            return scalarExtreme<false>(data + 1, size - 1, data[0]);
+        }
+
+        template <typename T>
+        T scalarDot(const T *left, const T *right, std::size_t size, T result = T{}) {
+            for (std::size_t i = 0; i < size; i++) {
+                result += left[i] * right[i];
+            }
+            return result;
+        }
+
+        template <Arithmetic op, typename T>
+        void scalarArithmetic(const T *left, const T *right, T *result, std::size_t size) {
+            for (std::size_t i = 0; i < size; i++) {
+                result[i] = apply<op>(left[i], right[i]);
+            }
+        }
+
+        template <typename T>
+        std::int64_t scalarIndexOf(const T *data, std::size_t size, T value, std::size_t start = 0) {
+            for (std::size_t i = start; i < size; i++) {
+                if (data[i] == value) {
+                    return static_cast<std::int64_t>(i);
+                }
+            }
+            return -1;
+        }
+
+        template <typename T>
+        constexpr ArrayKernels<T> SCALAR_KERNELS{
+            InstructionSet::Scalar,
+            [](const T *data, std::size_t size) { return scalarSum(data, size); },
+            scalarMin<T>,
+            scalarMax<T>,
+            [](const T *left, const T *right, std::size_t size) { return scalarDot(left, right, size); },
+            scalarArithmetic<Arithmetic::Add, T>,
+            scalarArithmetic<Arithmetic::Subtract, T>,
+            scalarArithmetic<Arithmetic::Multiply, T>,
+            scalarArithmetic<Arithmetic::Divide, T>,
+            [](const T *data, std::size_t size, T value) { return scalarIndexOf(data, size, value); },
+        };
+
+#ifdef FERRIT_X86_64
+        // SSE2 is part of x86-64 itself, so these kernels need no check before they are used.
+
+        double sse2SumReal(const double *data, std::size_t size) {
+            // two accumulators hide the latency of the additions
+            __m128d first = _mm_setzero_pd();
+            __m128d second = _mm_setzero_pd();
+            std::size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                first = _mm_add_pd(first, _mm_loadu_pd(data + i));
+                second = _mm_add_pd(second, _mm_loadu_pd(data + i + 2));
+            }
+            __m128d total = _mm_add_pd(first, second);
+            double result = _mm_cvtsd_f64(_mm_add_sd(total, _mm_unpackhi_pd(total, total)));
+            return scalarSum(data + i, size - i, result);
+        }
+
+        template <bool isMin>
+        double sse2ExtremeReal(const double *data, std::size_t size) {
+            if (size < 2) {
+                return data[0];
+            }
+            __m128d extreme = _mm_loadu_pd(data);
+            std::size_t i = 2;
+            for (; i + 2 <= size; i += 2) {
+                __m128d next = _mm_loadu_pd(data + i);
+                extreme = isMin ? _mm_min_pd(extreme, next) : _mm_max_pd(extreme, next);
+            }
+            __m128d high = _mm_unpackhi_pd(extreme, extreme);
+            extreme = isMin ? _mm_min_sd(extreme, high) : _mm_max_sd(extreme, high);
+            return scalarExtreme<isMin>(data + i, size - i, _mm_cvtsd_f64(extreme));
+        }
+
+        double sse2DotReal(const double *left, const double *right, std::size_t size) {
+            __m128d first = _mm_setzero_pd();
+            __m128d second = _mm_setzero_pd();
+            std::size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                first = _mm_add_pd(first, _mm_mul_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+                second = _mm_add_pd(second, _mm_mul_pd(_mm_loadu_pd(left + i + 2), _mm_loadu_pd(right + i + 2)));
+            }
+            __m128d total = _mm_add_pd(first, second);
+            double result = _mm_cvtsd_f64(_mm_add_sd(total, _mm_unpackhi_pd(total, total)));
+            return scalarDot(left + i, right + i, size - i, result);
+        }
+
+        template <Arithmetic op>
+        void sse2ArithmeticReal(const double *left, const double *right, double *result, std::size_t size) {
+            std::size_t i = 0;
+            for (; i + 2 <= size; i += 2) {
+                __m128d a = _mm_loadu_pd(left + i);
+                __m128d b = _mm_loadu_pd(right + i);
+                __m128d c;
+                if constexpr (op == Arithmetic::Add) {
+                    c = _mm_add_pd(a, b);
+                } else if constexpr (op == Arithmetic::Subtract) {
+                    c = _mm_sub_pd(a, b);
+                } else if constexpr (op == Arithmetic::Multiply) {
+                    c = _mm_mul_pd(a, b);
+                } else {
+                    c = _mm_div_pd(a, b);
+                }
+                _mm_storeu_pd(result + i, c);
+            }
+            scalarArithmetic<op>(left + i, right + i, result + i, size - i);
+        }
+
+        std::int64_t sse2IndexOfReal(const double *data, std::size_t size, double value) {
+            __m128d needle = _mm_set1_pd(value);
+            std::size_t i = 0;
+            for (; i + 2 <= size; i += 2) {
+                int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(data + i), needle));
+                if (mask != 0) {
+                    return static_cast<std::int64_t>(i) + (mask & 1 ? 0 : 1);
+                }
+            }
+            return scalarIndexOf(data, size, value, i);
+        }
+
+        std::int64_t sse2SumInt(const std::int64_t *data, std::size_t size) {
+            __m128i first = _mm_setzero_si128();
+            __m128i second = _mm_setzero_si128();
+            std::size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                first = _mm_add_epi64(first, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+                second = _mm_add_epi64(second, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 2)));
+            }
+            __m128i total = _mm_add_epi64(first, second);
+            total = _mm_add_epi64(total, _mm_unpackhi_epi64(total, total));
+            return scalarSum(data + i, size - i, static_cast<std::int64_t>(_mm_cvtsi128_si64(total)));
+        }
+
+        template <Arithmetic op>
+        void sse2ArithmeticInt(const std::int64_t *left, const std::int64_t *right, std::int64_t *result, std::size_t size) {
+            std::size_t i = 0;
+            for (; i + 2 <= size; i += 2) {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(left + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(right + i));
+                __m128i c = op == Arithmetic::Add ? _mm_add_epi64(a, b) : _mm_sub_epi64(a, b);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i), c);
+            }
+            scalarArithmetic<op>(left + i, right + i, result + i, size - i);
+        }
+
+        std::int64_t sse2IndexOfInt(const std::int64_t *data, std::size_t size, std::int64_t value) {
+            // SSE2 only compares 32-bit lanes, so a 64-bit lane is equal if both of its halves are
+            __m128i needle = _mm_set1_epi64x(value);
+            std::size_t i = 0;
+            for (; i + 2 <= size; i += 2) {
+                __m128i halves = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), needle);
+                __m128i swapped = _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1));
+                int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_and_si128(halves, swapped)));
+                if (mask != 0) {
+                    return static_cast<std::int64_t>(i) + (mask & 1 ? 0 : 1);
+                }
+            }
+            return scalarIndexOf(data, size, value, i);
+        }
+
+        constexpr ArrayKernels<double> SSE2_REAL_KERNELS{
+            InstructionSet::Sse2,
+            sse2SumReal,
+            sse2ExtremeReal<true>,
+            sse2ExtremeReal<false>,
+            sse2DotReal,
+            sse2ArithmeticReal<Arithmetic::Add>,
+            sse2ArithmeticReal<Arithmetic::Subtract>,
+            sse2ArithmeticReal<Arithmetic::Multiply>,
+            sse2ArithmeticReal<Arithmetic::Divide>,
+            sse2IndexOfReal,
+        };
+
+        // SSE2 has no 64-bit multiplication, division or comparison, so those kernels stay scalar
+        constexpr ArrayKernels<std::int64_t> SSE2_INT_KERNELS{
+            InstructionSet::Sse2,
+            sse2SumInt,
+            scalarMin<std::int64_t>,
+            scalarMax<std::int64_t>,
+            SCALAR_KERNELS<std::int64_t>.dot,
+            sse2ArithmeticInt<Arithmetic::Add>,
+            sse2ArithmeticInt<Arithmetic::Subtract>,
+            scalarArithmetic<Arithmetic::Multiply, std::int64_t>,
+            scalarArithmetic<Arithmetic::Divide, std::int64_t>,
+            sse2IndexOfInt,
+        };
+
+        FERRIT_TARGET_AVX2 double avx2Horizontal(__m256d vector) {
+            __m128d total = _mm_add_pd(_mm256_castpd256_pd128(vector), _mm256_extractf128_pd(vector, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(total, _mm_unpackhi_pd(total, total)));
+        }
+
+        FERRIT_TARGET_AVX2 double avx2SumReal(const double *data, std::size_t size) {
+            __m256d first = _mm256_setzero_pd();
+            __m256d second = _mm256_setzero_pd();
+            std::size_t i = 0;
+            for (; i + 8 <= size; i += 8) {
+                first = _mm256_add_pd(first, _mm256_loadu_pd(data + i));
+                second = _mm256_add_pd(second, _mm256_loadu_pd(data + i + 4));
+            }
+            double result = avx2Horizontal(_mm256_add_pd(first, second));
+            return scalarSum(data + i, size - i, result);
+        }
+
+        template <bool isMin>
+        FERRIT_TARGET_AVX2 double avx2ExtremeReal(const double *data, std::size_t size) {
+            if (size < 4) {
+                return scalarExtreme<isMin>(data + 1, size - 1, data[0]);
+            }
+            __m256d extreme = _mm256_loadu_pd(data);
+            std::size_t i = 4;
+            for (; i + 4 <= size; i += 4) {
+                __m256d next = _mm256_loadu_pd(data + i);
+                extreme = isMin ? _mm256_min_pd(extreme, next) : _mm256_max_pd(extreme, next);
+            }
+            alignas(32) double lanes[4];
+            _mm256_store_pd(lanes, extreme);
+            double result = scalarExtreme<isMin>(lanes + 1, 3, lanes[0]);
+            return scalarExtreme<isMin>(data + i, size - i, result);
+        }
+
+        FERRIT_TARGET_AVX2 double avx2DotReal(const double *left, const double *right, std::size_t size) {
+            __m256d first = _mm256_setzero_pd();
+            __m256d second = _mm256_setzero_pd();
+            std::size_t i = 0;
+            for (; i + 8 <= size; i += 8) {
+                first = _mm256_add_pd(first, _mm256_mul_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i)));
+                second = _mm256_add_pd(second, _mm256_mul_pd(_mm256_loadu_pd(left + i + 4), _mm256_loadu_pd(right + i + 4)));
+            }
+            double result = avx2Horizontal(_mm256_add_pd(first, second));
+            return scalarDot(left + i, right + i, size - i, result);
+        }
+
+        template <Arithmetic op>
+        FERRIT_TARGET_AVX2 void avx2ArithmeticReal(const double *left, const double *right, double *result, std::size_t size) {
+            std::size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                __m256d a = _mm256_loadu_pd(left + i);
+                __m256d b = _mm256_loadu_pd(right + i);
+                __m256d c;
+                if constexpr (op == Arithmetic::Add) {
+                    c = _mm256_add_pd(a, b);
+                } else if constexpr (op == Arithmetic::Subtract) {
+                    c = _mm256_sub_pd(a, b);
+                } else if constexpr (op == Arithmetic::Multiply) {
+                    c = _mm256_mul_pd(a, b);
+                } else {
+                    c = _mm256_div_pd(a, b);
+                }
+                _mm256_storeu_pd(result + i, c);
+            }
+            scalarArithmetic<op>(left + i, right + i, result + i, size - i);
+        }
+
+        /**
+         * Returns the index of the lowest lane set in a non-zero lane mask.
+         */
+        std::int64_t lowestLane(int mask) {
+            std::int64_t lane = 0;
+            while ((mask & 1) == 0) {
+                mask >>= 1;
+                lane++;
+            }
+            return lane;
+        }
+
+        FERRIT_TARGET_AVX2 std::int64_t avx2IndexOfReal(const double *data, std::size_t size, double value) {
+            __m256d needle = _mm256_set1_pd(value);
+            std::size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(data + i), needle, _CMP_EQ_OQ));
+                if (mask != 0) {
+                    return static_cast<std::int64_t>(i) + lowestLane(mask);
+                }
+            }
+            return scalarIndexOf(data, size, value, i);
+        }
+
+        FERRIT_TARGET_AVX2 std::int64_t avx2SumInt(const std::int64_t *data, std::size_t size) {
+            __m256i first = _mm256_setzero_si256();
+            __m256i second = _mm256_setzero_si256();
+            std::size_t i = 0;
+            for (; i + 8 <= size; i += 8) {
+                first = _mm256_add_epi64(first, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)));
+                second = _mm256_add_epi64(second, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 4)));
+            }
+            __m256i total256 = _mm256_add_epi64(first, second);
+            __m128i total = _mm_add_epi64(_mm256_castsi256_si128(total256), _mm256_extracti128_si256(total256, 1));
+            total = _mm_add_epi64(total, _mm_unpackhi_epi64(total, total));
+            return scalarSum(data + i, size - i, static_cast<std::int64_t>(_mm_cvtsi128_si64(total)));
+        }
+
+        template <bool isMin>
+        FERRIT_TARGET_AVX2 std::int64_t avx2ExtremeInt(const std::int64_t *data, std::size_t size) {
+            if (size < 4) {
+                return scalarExtreme<isMin>(data + 1, size - 1, data[0]);
+            }
+            // AVX2 has a 64-bit comparison but no 64-bit minimum, so lanes are picked with a blend
+            __m256i extreme = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+            std::size_t i = 4;
+            for (; i + 4 <= size; i += 4) {
+                __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                __m256i takeNext = isMin ? _mm256_cmpgt_epi64(extreme, next) : _mm256_cmpgt_epi64(next, extreme);
+                extreme = _mm256_blendv_epi8(extreme, next, takeNext);
+            }
+            alignas(32) std::int64_t lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), extreme);
+            std::int64_t result = scalarExtreme<isMin>(lanes + 1, 3, lanes[0]);
+            return scalarExtreme<isMin>(data + i, size - i, result);
+        }
+
+        template <Arithmetic op>
+        FERRIT_TARGET_AVX2 void avx2ArithmeticInt(const std::int64_t *left, const std::int64_t *right, std::int64_t *result, std::size_t size) {
+            std::size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(left + i));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(right + i));
+                __m256i c = op == Arithmetic::Add ? _mm256_add_epi64(a, b) : _mm256_sub_epi64(a, b);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + i), c);
+            }
+            scalarArithmetic<op>(left + i, right + i, result + i, size - i);
+        }
+
+        FERRIT_TARGET_AVX2 std::int64_t avx2IndexOfInt(const std::int64_t *data, std::size_t size, std::int64_t value) {
+            __m256i needle = _mm256_set1_epi64x(value);
+            std::size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                __m256i equal = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)), needle);
+                int mask = _mm256_movemask_pd(_mm256_castsi256_pd(equal));
+                if (mask != 0) {
+                    return static_cast<std::int64_t>(i) + lowestLane(mask);
+                }
+            }
+            return scalarIndexOf(data, size, value, i);
+        }
+
+        constexpr ArrayKernels<double> AVX2_REAL_KERNELS{
+            InstructionSet::Avx2,
+            avx2SumReal,
+            avx2ExtremeReal<true>,
+            avx2ExtremeReal<false>,
+            avx2DotReal,
+            avx2ArithmeticReal<Arithmetic::Add>,
+            avx2ArithmeticReal<Arithmetic::Subtract>,
+            avx2ArithmeticReal<Arithmetic::Multiply>,
+            avx2ArithmeticReal<Arithmetic::Divide>,
+            avx2IndexOfReal,
+        };
+
+        // AVX2 still has no 64-bit multiplication or division
+        constexpr ArrayKernels<std::int64_t> AVX2_INT_KERNELS{
+            InstructionSet::Avx2,
+            avx2SumInt,
+            avx2ExtremeInt<true>,
+            avx2ExtremeInt<false>,
+            SCALAR_KERNELS<std::int64_t>.dot,
+            avx2ArithmeticInt<Arithmetic::Add>,
+            avx2ArithmeticInt<Arithmetic::Subtract>,
+            scalarArithmetic<Arithmetic::Multiply, std::int64_t>,
+            scalarArithmetic<Arithmetic::Divide, std::int64_t>,
+            avx2IndexOfInt,
+        };
+
+        bool supportsAvx2() noexcept {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) {
+                return false;
+            }
+            // the operating system must also save the upper halves of the registers on context switches
+            __cpuid(info, 1);
+            bool hasAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+            if (!hasAvx || (_xgetbv(0) & 6) != 6) {
+                return false;
+            }
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+#ifdef FERRIT_AARCH64
+        // NEON is part of AArch64 itself, so these kernels need no check before they are used.
+
+        double neonSumReal(const double *data, std::size_t size) {
+            float64x2_t first = vdupq_n_f64(0.0);
+            float64x2_t second = vdupq_n_f64(0.0);
+            std::size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                first = vaddq_f64(first, vld1q_f64(data + i));
+                second = vaddq_f64(second, vld1q_f64(data + i + 2));
+            }
+            return scalarSum(data + i, size - i, vaddvq_f64(vaddq_f64(first, second)));
+        }
+
+        template <bool isMin>
+        double neonExtremeReal(const double *data, std::size_t size) {
+            if (size < 2) {
+                return data[0];
+            }
+            float64x2_t extreme = vld1q_f64(data);
+            std::size_t i = 2;
+            for (; i + 2 <= size; i += 2) {
+                float64x2_t next = vld1q_f64(data + i);
+                extreme = isMin ? vminq_f64(extreme, next) : vmaxq_f64(extreme, next);
+            }
+            double result = isMin ? vminvq_f64(extreme) : vmaxvq_f64(extreme);
+            return scalarExtreme<isMin>(data + i, size - i, result);
+        }
+
+        double neonDotReal(const double *left, const double *right, std::size_t size) {
+            float64x2_t first = vdupq_n_f64(0.0);
+            float64x2_t second = vdupq_n_f64(0.0);
+            std::size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                first = vaddq_f64(first, vmulq_f64(vld1q_f64(left + i), vld1q_f64(right + i)));
+                second = vaddq_f64(second, vmulq_f64(vld1q_f64(left + i + 2), vld1q_f64(right + i + 2)));
+            }
+            return scalarDot(left + i, right + i, size - i, vaddvq_f64(vaddq_f64(first, second)));
+        }
+
+        template <Arithmetic op>
+        void neonArithmeticReal(const double *left, const double *right, double *result, std::size_t size) {
+            std::size_t i = 0;
+            for (; i + 2 <= size; i += 2) {
+                float64x2_t a = vld1q_f64(left + i);
+                float64x2_t b = vld1q_f64(right + i);
+                float64x2_t c;
+                if constexpr (op == Arithmetic::Add) {
+                    c = vaddq_f64(a, b);
+                } else if constexpr (op == Arithmetic::Subtract) {
+                    c = vsubq_f64(a, b);
+                } else if constexpr (op == Arithmetic::Multiply) {
+                    c = vmulq_f64(a, b);
+                } else {
+                    c = vdivq_f64(a, b);
+                }
+                vst1q_f64(result + i, c);
+            }
+            scalarArithmetic<op>(left + i, right + i, result + i, size - i);
+        }
+
+        std::int64_t neonIndexOfReal(const double *data, std::size_t size, double value) {
+            float64x2_t needle = vdupq_n_f64(value);
+            std::size_t i = 0;
+            for (; i + 2 <= size; i += 2) {
+                uint64x2_t equal = vceqq_f64(vld1q_f64(data + i), needle);
+                if (vgetq_lane_u64(equal, 0) != 0) {
+                    return static_cast<std::int64_t>(i);
+                } else if (vgetq_lane_u64(equal, 1) != 0) {
+                    return static_cast<std::int64_t>(i) + 1;
+                }
+            }
+            return scalarIndexOf(data, size, value, i);
+        }
+
+        std::int64_t neonSumInt(const std::int64_t *data, std::size_t size) {
+            int64x2_t first = vdupq_n_s64(0);
+            int64x2_t second = vdupq_n_s64(0);
+            std::size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                first = vaddq_s64(first, vld1q_s64(data + i));
+                second = vaddq_s64(second, vld1q_s64(data + i + 2));
+            }
+            return scalarSum(data + i, size - i, static_cast<std::int64_t>(vaddvq_s64(vaddq_s64(first, second))));
+        }
+
+        template <bool isMin>
+        std::int64_t neonExtremeInt(const std::int64_t *data, std::size_t size) {
+            if (size < 2) {
+                return data[0];
+            }
+            int64x2_t extreme = vld1q_s64(data);
+            std::size_t i = 2;
+            for (; i + 2 <= size; i += 2) {
+                int64x2_t next = vld1q_s64(data + i);
+                uint64x2_t takeNext = isMin ? vcgtq_s64(extreme, next) : vcgtq_s64(next, extreme);
+                extreme = vbslq_s64(takeNext, next, extreme);
+            }
+            std::int64_t result = scalarExtreme<isMin>(data + i, size - i, vgetq_lane_s64(extreme, 0));
+            std::int64_t other = vgetq_lane_s64(extreme, 1);
+            return (isMin ? other < result : other > result) ? other : result;
+        }
+
+        template <Arithmetic op>
+        void neonArithmeticInt(const std::int64_t *left, const std::int64_t *right, std::int64_t *result, std::size_t size) {
+            std::size_t i = 0;
+            for (; i + 2 <= size; i += 2) {
+                int64x2_t a = vld1q_s64(left + i);
+                int64x2_t b = vld1q_s64(right + i);
+                vst1q_s64(result + i, op == Arithmetic::Add ? vaddq_s64(a, b) : vsubq_s64(a, b));
+            }
+            scalarArithmetic<op>(left + i, right + i, result + i, size - i);
+        }
+
+        std::int64_t neonIndexOfInt(const std::int64_t *data, std::size_t size, std::int64_t value) {
+            int64x2_t needle = vdupq_n_s64(value);
+            std::size_t i = 0;
+            for (; i + 2 <= size; i += 2) {
+                uint64x2_t equal = vceqq_s64(vld1q_s64(data + i), needle);
+                if (vgetq_lane_u64(equal, 0) != 0) {
+                    return static_cast<std::int64_t>(i);
+                } else if (vgetq_lane_u64(equal, 1) != 0) {
+                    return static_cast<std::int64_t>(i) + 1;
+                }
+            }
+            return scalarIndexOf(data, size, value, i);
+        }
+
+        constexpr ArrayKernels<double> NEON_REAL_KERNELS{
+            InstructionSet::Neon,
+            neonSumReal,
+            neonExtremeReal<true>,
+            neonExtremeReal<false>,
+            neonDotReal,
+            neonArithmeticReal<Arithmetic::Add>,
+            neonArithmeticReal<Arithmetic::Subtract>,
+            neonArithmeticReal<Arithmetic::Multiply>,
+            neonArithmeticReal<Arithmetic::Divide>,
+            neonIndexOfReal,
+        };
+
+        // NEON has no 64-bit multiplication or division
+        constexpr ArrayKernels<std::int64_t> NEON_INT_KERNELS{
+            InstructionSet::Neon,
+            neonSumInt,
+            neonExtremeInt<true>,
+            neonExtremeInt<false>,
+            SCALAR_KERNELS<std::int64_t>.dot,
+            neonArithmeticInt<Arithmetic::Add>,
+            neonArithmeticInt<Arithmetic::Subtract>,
+            scalarArithmetic<Arithmetic::Multiply, std::int64_t>,
+            scalarArithmetic<Arithmetic::Divide, std::int64_t>,
+            neonIndexOfInt,
+        };
+#endif
+
+        template <typename T>
+        const ArrayKernels<T> *findKernels(InstructionSet instructionSet,
+                                           [[maybe_unused]] const ArrayKernels<T> &sse2,
+                                           [[maybe_unused]] const ArrayKernels<T> &avx2,
+                                           [[maybe_unused]] const ArrayKernels<T> &neon) {
+            switch (instructionSet) {
+            case InstructionSet::Scalar:
+                return &SCALAR_KERNELS<T>;
+#ifdef FERRIT_X86_64
+            case InstructionSet::Sse2:
+                return &sse2;
+            case InstructionSet::Avx2:
+                return &avx2;
+#endif
+#ifdef FERRIT_AARCH64
+            case InstructionSet::Neon:
+                return &neon;
+#endif
+            default:
+                return nullptr;
+            }
+        }
+    }
+
+    InstructionSet detectInstructionSet() noexcept {
+#if defined(FERRIT_X86_64)
+        return supportsAvx2() ? InstructionSet::Avx2 : InstructionSet::Sse2;
+#elif defined(FERRIT_AARCH64)
+        return InstructionSet::Neon;
+#else
+        return InstructionSet::Scalar;
+#endif
+    }
+
+    template <>
+    const ArrayKernels<std::int64_t> *arrayKernels<std::int64_t>(InstructionSet instructionSet) {
+#if defined(FERRIT_X86_64)
+        return findKernels(instructionSet, SSE2_INT_KERNELS, AVX2_INT_KERNELS, SCALAR_KERNELS<std::int64_t>);
+#elif defined(FERRIT_AARCH64)
+        return findKernels(instructionSet, SCALAR_KERNELS<std::int64_t>, SCALAR_KERNELS<std::int64_t>, NEON_INT_KERNELS);
+#else
+        return findKernels(instructionSet, SCALAR_KERNELS<std::int64_t>, SCALAR_KERNELS<std::int64_t>, SCALAR_KERNELS<std::int64_t>);
+#endif
+    }
+
+    template <>
+    const ArrayKernels<double> *arrayKernels<double>(InstructionSet instructionSet) {
+#if defined(FERRIT_X86_64)
+        return findKernels(instructionSet, SSE2_REAL_KERNELS, AVX2_REAL_KERNELS, SCALAR_KERNELS<double>);
+#elif defined(FERRIT_AARCH64)
+        return findKernels(instructionSet, SCALAR_KERNELS<double>, SCALAR_KERNELS<double>, NEON_REAL_KERNELS);
+#else
+        return findKernels(instructionSet, SCALAR_KERNELS<double>, SCALAR_KERNELS<double>, SCALAR_KERNELS<double>);
+#endif
+    }
+
+    template <>
+    const ArrayKernels<std::int64_t> &arrayKernels<std::int64_t>() {
+        static const ArrayKernels<std::int64_t> &kernels = *arrayKernels<std::int64_t>(detectInstructionSet());
+        return kernels;
+    }
+
+    template <>
+    const ArrayKernels<double> &arrayKernels<double>() {
+        static const ArrayKernels<double> &kernels = *arrayKernels<double>(detectInstructionSet());
+        return kernels;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace ferrit {
+    /**
+     * The instruction sets that the array kernels have implementations for.
+     */
+    enum class InstructionSet {
+        Scalar,
+        Sse2,
+        Avx2,
+        Neon,
+    };
+
+    /**
+     * Bulk operations on packed arrays of one element type.
+     *
+     * Every kernel is implemented once per instruction set, and the best implementation that the
+     * CPU supports is chosen the first time the kernels are used. Sums and dot products of reals
+     * are accumulated in several lanes at once, so they may round differently than adding up the
+     * elements one by one. The minimum and maximum of an array containing NaN are unspecified.
+     *
+     * @tparam T the type that the elements are stored as
+     */
+    template <typename T>
+    struct ArrayKernels final {
+        InstructionSet instructionSet;
+
+        T (*sum)(const T *data, std::size_t size);
+        /** Returns the smallest element. The array must not be empty. */
+        T (*min)(const T *data, std::size_t size);
+        /** Returns the largest element. The array must not be empty. */
+        T (*max)(const T *data, std::size_t size);
+        T (*dot)(const T *left, const T *right, std::size_t size);
+
+        /**
+         * Element-wise arithmetic: <tt>result[i] = left[i] op right[i]</tt>. The result may be
+         * one of the operands. Integer division does not check for a zero divisor.
+         */
+        void (*add)(const T *left, const T *right, T *result, std::size_t size);
+        void (*subtract)(const T *left, const T *right, T *result, std::size_t size);
+        void (*multiply)(const T *left, const T *right, T *result, std::size_t size);
+        void (*divide)(const T *left, const T *right, T *result, std::size_t size);
+
+        /** Returns the index of the first element equal to the value, or -1 if there is none. */
+        std::int64_t (*indexOf)(const T *data, std::size_t size, T value);
+    };
+
+    /**
+     * Returns the best instruction set that the kernels support on this CPU.
+     */
+    [[nodiscard]] InstructionSet detectInstructionSet() noexcept;
+
+    /**
+     * Returns the kernels for the best instruction set that this CPU supports.
+     */
+    template <typename T>
+    [[nodiscard]] const ArrayKernels<T> &arrayKernels();
+
+    /**
+     * Returns the kernels for the given instruction set, or null if they were not compiled
+     * for this platform. The CPU must support the instruction set before they are called.
+     */
+    template <typename T>
+    [[nodiscard]] const ArrayKernels<T> *arrayKernels(InstructionSet instructionSet);
+
+    template <>
+    const ArrayKernels<std::int64_t> &arrayKernels<std::int64_t>();
+    template <>
+    const ArrayKernels<double> &arrayKernels<double>();
+    template <>
+    const ArrayKernels<std::int64_t> *arrayKernels<std::int64_t>(InstructionSet instructionSet);
+    template <>
+    const ArrayKernels<double> *arrayKernels<double>(InstructionSet instructionSet);
+}
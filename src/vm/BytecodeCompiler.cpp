@@ -1,13 +1,18 @@
 #include "BytecodeCompiler.h"
+#include "Task.h"
 
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <utility>
 
 namespace ferrit {
-    BytecodeCompiler::BytecodeCompiler(std::shared_ptr<const ErrorReporter> errorReporter) :
-        m_errorReporter{std::move(errorReporter)} {
+    BytecodeCompiler::BytecodeCompiler(std::shared_ptr<const ErrorReporter> errorReporter,
+        const NativeRegistry *nativeRegistry) :
+        m_errorReporter{std::move(errorReporter)}, m_nativeRegistry{nativeRegistry} {
     }
 
-    std::optional<Chunk> BytecodeCompiler::compile(const std::vector<StatementPtr> &ast) {
+    std::optional<Program> BytecodeCompiler::compile(const std::vector<StatementPtr> &ast) {
         try {
             return tryCompile(ast);
         } catch (const Error &) {
@@ -15,59 +20,452 @@ namespace ferrit {
         }
     }
 
-    Chunk BytecodeCompiler::tryCompile(const std::vector<StatementPtr> &ast) {
+    std::optional<std::string> BytecodeCompiler::emitNativeHeader(const std::vector<StatementPtr> &ast) {
+        std::string header =
+            "// The native functions of a Ferrit program. Each one is registered with\n"
+            "// ferrit::NativeRegistry::add under its own name.\n"
+            "#pragma once\n"
+            "\n"
+            "#include <cstdint>\n"
+            "#include <span>\n"
+            "#include <string>\n"
+            "#include <string_view>\n"
+            "\n";
+        try {
+            for (const auto &stmt : ast) {
+                const auto *funDecl = dynamic_cast<const FunctionDeclaration *>(stmt.get());
+                bool isNative = funDecl && std::ranges::any_of(funDecl->modifiers(), [](const Token &modifier) {
+                    return modifier.type == TokenType::Native;
+                });
+                if (isNative) {
+                    header += nativeDeclaration(*funDecl);
+                }
+            }
+        } catch (const Error &) {
+            return {};
+        }
+        return header;
+    }
+
+    const std::vector<BytecodeCompiler::VectorizationRemark> &BytecodeCompiler::vectorizationRemarks() const noexcept {
+        return m_vectorizationRemarks;
+    }
+
+    Program BytecodeCompiler::tryCompile(const std::vector<StatementPtr> &ast) {
+        m_functions.clear();
+        m_functions.push_back(Function{.name = "<main>", .arity = 0});
+        m_nativeFunctions.clear();
+        m_signatures.clear();
+        m_returnType.reset();
+
         m_chunk = Chunk{};
+        m_branches.clear();
+        m_locals.clear();
+        m_scopeDepth = 0;
+        m_boundedIndices.clear();
+        m_firstVisibleLocal = 0;
+        m_stackDepth = 0;
+        m_vectorizationRemarks.clear();
 
+        // declare every top-level function up front, so that they can be called before their declaration
+        for (const auto &stmt : ast) {
+            if (const auto *funDecl = dynamic_cast<const FunctionDeclaration *>(stmt.get())) {
+                declareFunction(*funDecl);
+            }
+        }
+
+        beginScope();
         for (const auto &stmt : ast) {
             stmt->accept(*this);
         }
 
         const Statement &lastStmt = *ast.back();
+        endScope(lastStmt.errorToken().location.line);
         emit(OpCode::Return, lastStmt.errorToken().location.line);
-        return m_chunk;
+        relaxBranches();
+
+        m_functions[Program::SCRIPT_INDEX].chunk = std::move(m_chunk);
+        return Program{std::move(m_functions), std::move(m_nativeFunctions)};
     }
 
-    VisitResult BytecodeCompiler::visitFunctionDecl(const FunctionDeclaration &funDecl) {
-        throw makeError<CompileError::NotImplemented>(
-            funDecl.errorToken(), "functions");
+    void BytecodeCompiler::declareFunction(const FunctionDeclaration &funDecl) {
+        const std::string &name = funDecl.name().lexeme;
+        if (m_signatures.contains(name)) {
+            throw makeError<CompileError::Redeclaration>(funDecl.name());
+        }
+
+        FunctionSignature signature{
+            .index = -1,
+            .nativeIndex = -1,
+            .parameters = {},
+            .returnType = resolveDeclaredType(funDecl.returnType()),
+            .declaration = &funDecl,
+            .inlineBody = nullptr};
+        for (const auto &param : funDecl.params()) {
+            signature.parameters.push_back(resolveDeclaredType(param.type()));
+        }
+
+        bool isNative = std::ranges::any_of(funDecl.modifiers(), [](const Token &modifier) {
+            return modifier.type == TokenType::Native;
+        });
+        if (!isNative) {
+            if (!funDecl.body()) {
+                throw makeError<CompileError::NotImplemented>(
+                    funDecl.errorToken(), "functions without a body");
+            } else if (m_functions.size() > std::numeric_limits<std::uint16_t>::max()) {
+                throw CompileException("Too many functions in one program.");
+            }
+
+            signature.index = static_cast<int>(m_functions.size());
+            signature.inlineBody = findInlineBody(funDecl);
+            m_functions.push_back(Function{
+                .name = name,
+                .arity = static_cast<int>(funDecl.params().size()),
+                .parameterTypes = signature.parameters,
+                .returnType = signature.returnType});
+        } else {
+            signature.nativeIndex = declareNativeFunction(funDecl, signature);
+        }
+
+        m_signatures.emplace(name, std::move(signature));
     }
 
-    VisitResult BytecodeCompiler::visitConditionalStmt(const ConditionalStatement &conditionalStmt) {
-        auto conditionType = std::any_cast<RuntimeType>(conditionalStmt.condition().accept(*this));
-        if (conditionType != RuntimeType::BoolType) {
+    int BytecodeCompiler::declareNativeFunction(const FunctionDeclaration &funDecl, const FunctionSignature &signature) {
+        // the call is resolved now, so that running the program never looks a native function up by name
+        const NativeFunction *native = m_nativeRegistry ? m_nativeRegistry->find(funDecl.name().lexeme) : nullptr;
+        if (!native) {
+            throw makeError<CompileError::UndefinedFunction>(funDecl.name());
+        } else if (native->parameterTypes != signature.parameters || native->returnType != signature.returnType) {
             throw makeError<CompileError::IncompatibleTypes>(
-                conditionalStmt.condition().errorToken(), "if statement", std::vector{conditionType.name()});
+                funDecl.name(), std::format("native function '{}'", funDecl.name().lexeme),
+                std::vector{
+                    functionTypeName(signature.parameters, signature.returnType),
+                    functionTypeName(native->parameterTypes, native->returnType)});
+        } else if (m_nativeFunctions.size() > std::numeric_limits<std::uint16_t>::max()) {
+            throw CompileException("Too many native functions in one program.");
+        }
+
+        m_nativeFunctions.push_back(*native);
+        return static_cast<int>(m_nativeFunctions.size()) - 1;
+    }
+
+    std::string BytecodeCompiler::nativeDeclaration(const FunctionDeclaration &funDecl) const {
+        // arrays are passed as spans over their elements, so native code works on them in place
+        auto cppType = [this](const DeclaredType &declaredType, bool isResult) {
+            RuntimeType type = resolveDeclaredType(declaredType);
+            std::optional<std::string_view> cppType = NativeRegistry::cppTypeOf(type, isResult);
+            if (!cppType) {
+                throw makeError<CompileError::NotImplemented>(
+                    declaredType.errorToken(), std::format("passing '{}' to native functions", type.name()));
+            }
+            return std::string{*cppType};
+        };
+
+        std::string declaration = std::format("{} {}(", cppType(funDecl.returnType(), true), funDecl.name().lexeme);
+        for (std::size_t i = 0; i < funDecl.params().size(); i++) {
+            const Parameter &param = funDecl.params()[i];
+            declaration += std::format("{}{} {}", i > 0 ? ", " : "", cppType(param.type(), false), param.name().lexeme);
+        }
+        return declaration + ");\n";
+    }
+
+    std::string BytecodeCompiler::functionTypeName(const std::vector<RuntimeType> &parameters, const RuntimeType &returnType) {
+        std::string name = "(";
+        for (std::size_t i = 0; i < parameters.size(); i++) {
+            name += (i > 0 ? ", " : "") + parameters[i].name();
+        }
+        return name + ") -> " + returnType.name();
+    }
+
+    void BytecodeCompiler::compileFunctionBody(const FunctionDeclaration &funDecl, const RuntimeType &returnType) {
+        int line = funDecl.keyword().location.line;
+
+        // the arguments are already on the stack when the function is called, so they
+        // become the first locals of the function's frame without being copied
+        beginScope();
+        const FunctionSignature &signature = m_signatures.at(funDecl.name().lexeme);
+        for (std::size_t i = 0; i < funDecl.params().size(); i++) {
+            declareLocal(funDecl.params()[i].name(), signature.parameters[i], false);
+        }
+        m_stackDepth = static_cast<int>(funDecl.params().size());
+
+        const Statement &body = *funDecl.body();
+        if (const auto *exprBody = dynamic_cast<const ExpressionStatement *>(&body)) {
+            // 'fun f() = expr' returns the value of expr
+            compileReturnValue(exprBody->expr(), exprBody->errorToken(), exprBody->errorToken().location.line);
+        } else {
+            body.accept(*this);
+            if (returnType == RuntimeType::NothingType) {
+                emitConstant(Value{}, line);
+                emit(OpCode::Return, line);
+            } else if (!alwaysReturns(body)) {
+                throw makeError<CompileError::MissingReturn>(funDecl.name());
+            }
+        }
+
+        relaxBranches();
+    }
+
+    bool BytecodeCompiler::alwaysReturns(const Statement &stmt) {
+        // conservative: loops are never assumed to return, even if their condition is always true
+        if (dynamic_cast<const ReturnStatement *>(&stmt)) {
+            return true;
+        } else if (const auto *block = dynamic_cast<const BlockStatement *>(&stmt)) {
+            return std::ranges::any_of(block->body(), [](const StatementPtr &child) {
+                return alwaysReturns(*child);
+            });
+        } else if (const auto *conditional = dynamic_cast<const ConditionalStatement *>(&stmt)) {
+            return conditional->elseBody() &&
+                alwaysReturns(conditional->ifBody()) &&
+                alwaysReturns(*conditional->elseBody());
+        }
+        return false;
+    }
+
+    VisitResult BytecodeCompiler::visitFunctionDecl(const FunctionDeclaration &funDecl) {
+        if (m_returnType || m_scopeDepth != 1) {
+            throw makeError<CompileError::NotImplemented>(
+                funDecl.errorToken(), "nested functions");
+        }
+
+        const FunctionSignature &signature = m_signatures.at(funDecl.name().lexeme);
+        if (signature.index < 0) {
+            // native functions have no bytecode
+            return RuntimeType::NothingType;
+        }
+
+        // each function gets its own chunk, so set aside the script's state while compiling it
+        Chunk scriptChunk = std::exchange(m_chunk, Chunk{});
+        auto scriptBranches = std::exchange(m_branches, {});
+        auto scriptLocals = std::exchange(m_locals, {});
+        int scriptScopeDepth = std::exchange(m_scopeDepth, 0);
+        int scriptStackDepth = std::exchange(m_stackDepth, 0);
+        m_returnType = signature.returnType;
+
+        compileFunctionBody(funDecl, signature.returnType);
+        m_functions[signature.index].chunk = std::move(m_chunk);
+
+        m_chunk = std::move(scriptChunk);
+        m_branches = std::move(scriptBranches);
+        m_locals = std::move(scriptLocals);
+        m_scopeDepth = scriptScopeDepth;
+        m_stackDepth = scriptStackDepth;
+        m_returnType.reset();
+
+        return RuntimeType::NothingType;
+    }
+
+    VisitResult BytecodeCompiler::visitVariableDecl(const VariableDeclaration &varDecl) {
+        // the initializer's value is left on the stack, where it becomes the variable's slot
+        auto type = std::any_cast<RuntimeType>(varDecl.initializer().accept(*this));
+        if (varDecl.type()) {
+            RuntimeType declaredType = resolveDeclaredType(*varDecl.type());
+            if (declaredType != type) {
+                throw makeError<CompileError::IncompatibleTypes>(
+                    varDecl.errorToken(), "variable declaration", std::vector{declaredType.name(), type.name()});
+            }
         }
-        int conditionPos = emitJump(true, conditionalStmt.ifKeyword().location.line);
 
-        conditionalStmt.ifBody().accept(*this);
+        declareLocal(varDecl.name(), type, varDecl.isMutable());
+        return RuntimeType::NothingType;
+    }
+
+    VisitResult BytecodeCompiler::visitConditionalStmt(const ConditionalStatement &conditionalStmt) {
+        int conditionPos = emitConditionalJump(
+            conditionalStmt.condition(), "if statement", conditionalStmt.ifKeyword().location.line);
+
+        compileScoped(conditionalStmt.ifBody(), conditionalStmt.ifKeyword().location.line);
         int elsePos = -1;
         if (conditionalStmt.elseBody()) {
-            elsePos = emitJump(false, conditionalStmt.elseKeyword()->location.line);
+            elsePos = emitJump(OpCode::Jump, conditionalStmt.elseKeyword()->location.line);
         }
 
         patchJump(conditionPos);
         if (conditionalStmt.elseBody()) {
-            conditionalStmt.elseBody()->accept(*this);
+            compileScoped(*conditionalStmt.elseBody(), conditionalStmt.elseKeyword()->location.line);
             patchJump(elsePos);
         }
 
         return RuntimeType::NothingType;
     }
 
+    VisitResult BytecodeCompiler::visitWhileStmt(const WhileStatement &whileStmt) {
+        int line = whileStmt.keyword().location.line;
+        int loopStart = m_chunk.size();
+
+        if (whileStmt.isDoWhile()) {
+            compileScoped(whileStmt.body(), line);
+            int exitPos = emitConditionalJump(whileStmt.condition(), "do-while loop", line);
+            emitLoop(OpCode::Loop, loopStart, line);
+            patchJump(exitPos);
+        } else {
+            int exitPos = emitConditionalJump(whileStmt.condition(), "while loop", line);
+            compileScoped(whileStmt.body(), line);
+            emitLoop(OpCode::Loop, loopStart, line);
+            patchJump(exitPos);
+        }
+
+        return RuntimeType::NothingType;
+    }
+
+    VisitResult BytecodeCompiler::visitForStmt(const ForStatement &forStmt) {
+        const auto *range = dynamic_cast<const RangeExpression *>(&forStmt.iterable());
+        if (!range) {
+            throw makeError<CompileError::NotImplemented>(
+                forStmt.iterable().errorToken(), "for loops over non-range iterables");
+        }
+
+        auto startType = std::any_cast<RuntimeType>(range->start().accept(*this));
+        auto endType = std::any_cast<RuntimeType>(range->end().accept(*this));
+        if (startType != RuntimeType::IntType || endType != RuntimeType::IntType) {
+            throw makeError<CompileError::IncompatibleTypes>(
+                range->errorToken(), "for loop range", std::vector{startType.name(), endType.name()});
+        }
+
+        // resolved before the loop variable is declared, since it may shadow the array
+        auto arraySlot = findBoundingArray(*range);
+        VectorLoop vectorLoop{.isReal = false, .isInclusive = range->isInclusive(), .targetSlot = 0, .code = {}};
+        auto missedReason = vectorizeLoop(forStmt, vectorLoop);
+
+        // The range is never materialized. Instead, the loop variable and the number of
+        // remaining iterations are kept in two adjacent slots, and ForRangeInt updates both at once.
+        int line = forStmt.keyword().location.line;
+        beginScope();
+        int indexSlot = declareLocal(forStmt.variable(), RuntimeType::IntType, false);
+        declareLocal(Token{TokenType::Identifier, "", forStmt.keyword().location}, RuntimeType::IntType, false);
+
+        // a vectorized loop still keeps its compiled form, which runs whenever the vector loop cannot
+        m_vectorizationRemarks.push_back(VectorizationRemark{.line = line, .missedReason = missedReason});
+        if (!missedReason) {
+            std::uint16_t vectorLoopIndex = m_chunk.addVectorLoop(std::move(vectorLoop));
+            emit(OpCode::VectorLoop, vectorLoopIndex, line);
+        }
+
+        OpCode prepOp = range->isInclusive() ? OpCode::ForRangeIntInclusivePrep : OpCode::ForRangeIntPrep;
+        int exitPos = emitJump(prepOp, line);
+
+        // the loop's own exit test already checks the index against the array's size,
+        // so indexing the array with the loop variable does not need to check it again
+        if (arraySlot) {
+            m_boundedIndices.push_back(BoundedIndex{.indexSlot = indexSlot, .arraySlot = *arraySlot});
+        }
+        int bodyStart = m_chunk.size();
+        compileScoped(forStmt.body(), line);
+        emitLoop(OpCode::ForRangeInt, bodyStart, line);
+        if (arraySlot) {
+            m_boundedIndices.pop_back();
+        }
+
+        patchJump(exitPos);
+        endScope(line);
+
+        return RuntimeType::NothingType;
+    }
+
     VisitResult BytecodeCompiler::visitBlockStmt(const BlockStatement &blockStmt) {
+        beginScope();
         for (const auto &stmt: blockStmt.body()) {
             stmt->accept(*this);
         }
+        endScope(blockStmt.brace().location.line);
+        return RuntimeType::NothingType;
+    }
+
+    VisitResult BytecodeCompiler::visitReturnStmt(const ReturnStatement &returnStmt) {
+        if (!m_returnType) {
+            throw makeError<CompileError::ReturnOutsideFunction>(returnStmt.errorToken());
+        }
+
+        int line = returnStmt.keyword().location.line;
+        if (returnStmt.value()) {
+            compileReturnValue(*returnStmt.value(), returnStmt.errorToken(), line);
+            return RuntimeType::NothingType;
+        }
+        if (*m_returnType != RuntimeType::NothingType) {
+            throw makeError<CompileError::IncompatibleTypes>(
+                returnStmt.errorToken(), "return value",
+                std::vector{m_returnType->name(), RuntimeType::NothingType.name()});
+        }
+
+        // there is no need to pop the function's locals, since Return discards its whole frame
+        emitConstant(Value{}, line);
+        emit(OpCode::Return, line);
         return RuntimeType::NothingType;
     }
 
+    void BytecodeCompiler::compileReturnValue(const Expression &value, const Token &errorToken, int line) {
+        // a call whose result is returned immediately is compiled as a tail call, which
+        // reuses the current frame instead of returning through it
+        const auto *callExpr = dynamic_cast<const CallExpression *>(&value);
+        const FunctionSignature *callee = callExpr ? findSignature(*callExpr) : nullptr;
+        bool isTailCall = callee && !callee->inlineBody;
+        auto type = isTailCall ? compileCall(*callExpr, true) : std::any_cast<RuntimeType>(value.accept(*this));
+
+        if (type != *m_returnType) {
+            throw makeError<CompileError::IncompatibleTypes>(
+                errorToken, "return value", std::vector{m_returnType->name(), type.name()});
+        }
+        if (!isTailCall) {
+            emit(OpCode::Return, line);
+        }
+    }
+
     VisitResult BytecodeCompiler::visitExpressionStmt(const ExpressionStatement &exprStmt) {
         exprStmt.expr().accept(*this);
         emit(OpCode::Pop, exprStmt.errorToken().location.line);
         return RuntimeType::NothingType;
     }
 
+    VisitResult BytecodeCompiler::visitAssignmentExpr(const AssignmentExpression &assignExpr) {
+        if (assignExpr.op().type != TokenType::Equal) {
+            throw makeError<CompileError::NotImplemented>(
+                assignExpr.errorToken(), "compound assignment");
+        }
+
+        int slot = resolveLocal(assignExpr.name());
+        const Local &local = m_locals[slot];
+        if (!local.isMutable) {
+            throw makeError<CompileError::ImmutableAssignment>(
+                assignExpr.errorToken(), assignExpr.name().lexeme);
+        }
+
+        auto valueType = std::any_cast<RuntimeType>(assignExpr.value().accept(*this));
+        if (valueType != local.type) {
+            throw makeError<CompileError::IncompatibleTypes>(
+                assignExpr.errorToken(), "'='", std::vector{local.type.name(), valueType.name()});
+        }
+
+        // the assigned value is left on the stack as the result of the expression
+        emit(OpCode::SetLocal, static_cast<std::uint8_t>(slot), assignExpr.op().location.line);
+        return local.type;
+    }
+
+    VisitResult BytecodeCompiler::visitIndexAssignmentExpr(const IndexAssignmentExpression &assignExpr) {
+        if (assignExpr.op().type != TokenType::Equal) {
+            throw makeError<CompileError::NotImplemented>(
+                assignExpr.errorToken(), "compound assignment");
+        }
+
+        const IndexExpression &target = assignExpr.target();
+        auto arrayType = std::any_cast<RuntimeType>(target.array().accept(*this));
+        auto indexType = std::any_cast<RuntimeType>(target.index().accept(*this));
+        const ArrayKind *kind = findArrayKind(arrayType);
+        if (!kind || indexType != RuntimeType::IntType) {
+            throw makeError<CompileError::IncompatibleTypes>(
+                target.errorToken(), "'[]'", std::vector{arrayType.name(), indexType.name()});
+        }
+
+        auto valueType = std::any_cast<RuntimeType>(assignExpr.value().accept(*this));
+        if (valueType != kind->elementType) {
+            throw makeError<CompileError::IncompatibleTypes>(
+                assignExpr.errorToken(), "'='", std::vector{kind->elementType.name(), valueType.name()});
+        }
+
+        // the assigned value is left on the stack as the result of the expression
+        emit(isProvenInBounds(target) ? kind->setUnchecked : kind->set, assignExpr.op().location.line);
+        return kind->elementType;
+    }
+
     VisitResult BytecodeCompiler::visitBinaryExpr(const BinaryExpression &binExpr) {
         auto leftType = std::any_cast<RuntimeType>(binExpr.left().accept(*this));
         auto rightType = std::any_cast<RuntimeType>(binExpr.right().accept(*this));
@@ -119,14 +517,19 @@ namespace ferrit {
                     binExpr.errorToken(), "'/'", std::vector{leftType.name(), rightType.name()});
             }
         case TokenType::Tilde:
-            throw makeError<CompileError::NotImplemented>(
-                binExpr.errorToken(), "concatenation operator");
+            if (leftType == RuntimeType::StringType && rightType == RuntimeType::StringType) {
+                emit(OpCode::SConcat, line);
+                return RuntimeType::StringType;
+            } else {
+                throw makeError<CompileError::IncompatibleTypes>(
+                    binExpr.errorToken(), "'~'", std::vector{leftType.name(), rightType.name()});
+            }
         case TokenType::Percent:
             if (leftType == RuntimeType::IntType && rightType == RuntimeType::IntType) {
-                emit(OpCode::IAdd, line);
+                emit(OpCode::IModulus, line);
                 return RuntimeType::IntType;
             } else if (leftType == RuntimeType::RealType && rightType == RuntimeType::RealType) {
-                emit(OpCode::FAdd, line);
+                emit(OpCode::FModulus, line);
                 return RuntimeType::RealType;
             } else {
                 throw makeError<CompileError::IncompatibleTypes>(
@@ -160,36 +563,13 @@ namespace ferrit {
         auto leftType = std::any_cast<RuntimeType>(cmpExpr.left().accept(*this));
         auto rightType = std::any_cast<RuntimeType>(cmpExpr.right().accept(*this));
 
-        int line = cmpExpr.op().location.line;
-        switch (cmpExpr.op().type) {
-        case TokenType::EqualEqual:
-            if (leftType == RuntimeType::BoolType && rightType == RuntimeType::BoolType) {
-                emit(OpCode::BEqual, line);
-                return RuntimeType::BoolType;
-            } else {
-                throw makeError<CompileError::IncompatibleTypes>(
-                    cmpExpr.errorToken(), "'=='", std::vector{leftType.name(), rightType.name()});
-            }
-        case TokenType::BangEqual:
-            if (leftType == RuntimeType::BoolType && rightType == RuntimeType::BoolType) {
-                emit(OpCode::BNotEqual, line);
-                return RuntimeType::BoolType;
-            } else {
-                throw makeError<CompileError::IncompatibleTypes>(
-                    cmpExpr.errorToken(), "'!='", std::vector{leftType.name(), rightType.name()});
-            }
-        case TokenType::GreaterEqual:
-        case TokenType::Greater:
-        case TokenType::LessEqual:
-        case TokenType::Less:
-            throw makeError<CompileError::NotImplemented>(
-                cmpExpr.errorToken(), "comparisons");
-        default:
-            throw CompileException(
-                std::format("unknown operator '{}' ({})",
-                    cmpExpr.op().lexeme,
-                    cmpExpr.op().type));
-        }
+        emit(getComparisonOpCode(cmpExpr, leftType, rightType), cmpExpr.op().location.line);
+        return RuntimeType::BoolType;
+    }
+
+    VisitResult BytecodeCompiler::visitRangeExpr(const RangeExpression &rangeExpr) {
+        throw makeError<CompileError::NotImplemented>(
+            rangeExpr.errorToken(), "range objects");
     }
 
     VisitResult BytecodeCompiler::visitUnaryExpr(const UnaryExpression &unaryExpr) {
@@ -241,13 +621,573 @@ namespace ferrit {
     }
 
     VisitResult BytecodeCompiler::visitCallExpr(const CallExpression &callExpr) {
+        return compileCall(callExpr, false);
+    }
+
+    const BytecodeCompiler::FunctionSignature *BytecodeCompiler::findSignature(const CallExpression &callExpr) const {
+        const auto *callee = dynamic_cast<const VariableExpression *>(&callExpr.callee());
+        if (!callee) {
+            return nullptr;
+        }
+        auto signatureIt = m_signatures.find(callee->name().lexeme);
+        if (signatureIt == m_signatures.end() || signatureIt->second.index < 0) {
+            return nullptr;
+        }
+        return &signatureIt->second;
+    }
+
+    RuntimeType BytecodeCompiler::compileCall(const CallExpression &callExpr, bool isTailCall) {
+        const auto *callee = dynamic_cast<const VariableExpression *>(&callExpr.callee());
+        if (!callee) {
+            throw makeError<CompileError::NotImplemented>(
+                callExpr.errorToken(), "calling the result of an expression");
+        }
+
+        const Token &name = callee->name();
+        int line = callExpr.paren().location.line;
+        auto signatureIt = m_signatures.find(name.lexeme);
+        if (signatureIt == m_signatures.end()) {
+            // println, the array constructor, the bulk array operations, the fiber and task
+            // operations, and file I/O are built in, since they work on the VM's own state
+            if (name.lexeme == "println" && callExpr.arguments().size() == 1) {
+                callExpr.arguments()[0]->accept(*this);
+                emit(OpCode::Print, line);
+                return RuntimeType::NothingType;
+            } else if (name.lexeme == "Array" && callExpr.arguments().size() == 2) {
+                // 'Array(size, value)' creates an array of the value's type
+                auto sizeType = std::any_cast<RuntimeType>(callExpr.arguments()[0]->accept(*this));
+                auto valueType = std::any_cast<RuntimeType>(callExpr.arguments()[1]->accept(*this));
+                const ArrayKind *kind = findArrayKindForElement(valueType);
+                if (sizeType != RuntimeType::IntType || !kind) {
+                    throw makeError<CompileError::IncompatibleTypes>(
+                        callExpr.errorToken(), "'Array'", std::vector{sizeType.name(), valueType.name()});
+                }
+                emit(kind->newArray, line);
+                return kind->arrayType;
+            } else if (auto intrinsic = findArrayIntrinsic(name.lexeme)) {
+                return compileArrayIntrinsic(callExpr, *intrinsic, line);
+            } else if (name.lexeme == "spawn" && callExpr.arguments().size() == 1) {
+                return compileSpawn(*callExpr.arguments()[0], line);
+            } else if (name.lexeme == "yield" && callExpr.arguments().empty()) {
+                emit(OpCode::Yield, line);
+                return RuntimeType::NothingType;
+            } else if (name.lexeme == "resume" && callExpr.arguments().size() == 1) {
+                auto fiberType = std::any_cast<RuntimeType>(callExpr.arguments()[0]->accept(*this));
+                if (fiberType != RuntimeType::FiberType) {
+                    throw makeError<CompileError::IncompatibleTypes>(
+                        callExpr.errorToken(), "'resume'", std::vector{fiberType.name()});
+                }
+                emit(OpCode::Resume, line);
+                return RuntimeType::BoolType;
+            } else if (name.lexeme == "fork" && callExpr.arguments().size() == 1) {
+                return compileFork(*callExpr.arguments()[0], line);
+            } else if (name.lexeme == "join" && callExpr.arguments().size() == 1) {
+                auto taskType = std::any_cast<RuntimeType>(callExpr.arguments()[0]->accept(*this));
+                const RuntimeType *resultType = Task::resultTypeOf(taskType);
+                if (!resultType) {
+                    throw makeError<CompileError::IncompatibleTypes>(
+                        callExpr.errorToken(), "'join'", std::vector{taskType.name()});
+                }
+                emit(OpCode::Join, line);
+                return *resultType;
+            } else if (name.lexeme == "parallelMap") {
+                return compileParallelMap(callExpr, line);
+            } else if (const IoBuiltin *builtin = findIoBuiltin(name.lexeme)) {
+                return compileIo(callExpr, *builtin, line);
+            }
+            throw makeError<CompileError::UndefinedFunction>(name);
+        }
+
+        const FunctionSignature &signature = signatureIt->second;
+        compileArguments(callExpr, signature);
+        if (signature.nativeIndex >= 0) {
+            emit(OpCode::CallNative, static_cast<std::uint16_t>(signature.nativeIndex), line);
+            return signature.returnType;
+        }
+        if (signature.inlineBody) {
+            return compileInlineCall(signature, line);
+        }
+        OpCode callOp = isTailCall ? OpCode::TailCall : OpCode::Call;
+        emit(callOp, static_cast<std::uint16_t>(signature.index), line);
+        return signature.returnType;
+    }
+
+    void BytecodeCompiler::compileArguments(const CallExpression &callExpr, const FunctionSignature &signature) {
+        const std::string &name = dynamic_cast<const VariableExpression &>(callExpr.callee()).name().lexeme;
+        const auto &arguments = callExpr.arguments();
+        if (arguments.size() != signature.parameters.size()) {
+            throw makeError<CompileError::ArgumentCount>(
+                callExpr.errorToken(), name,
+                static_cast<int>(signature.parameters.size()), static_cast<int>(arguments.size()));
+        }
+
+        // the arguments are left on the stack, where they become the callee's parameters
+        for (std::size_t i = 0; i < arguments.size(); i++) {
+            auto type = std::any_cast<RuntimeType>(arguments[i]->accept(*this));
+            if (type != signature.parameters[i]) {
+                throw makeError<CompileError::IncompatibleTypes>(
+                    arguments[i]->errorToken(), std::format("argument {} of '{}'", i + 1, name),
+                    std::vector{signature.parameters[i].name(), type.name()});
+            }
+        }
+    }
+
+    RuntimeType BytecodeCompiler::compileSpawn(const Expression &entry, int line) {
+        // 'spawn(f(x))' evaluates the arguments now, but makes the call in the new fiber
+        const auto *callExpr = dynamic_cast<const CallExpression *>(&entry);
+        const FunctionSignature *signature = callExpr ? findSignature(*callExpr) : nullptr;
+        if (!signature) {
+            throw makeError<CompileError::NotImplemented>(
+                entry.errorToken(), "spawning anything but a call to a declared function");
+        }
+
+        compileArguments(*callExpr, *signature);
+        emit(OpCode::Spawn, static_cast<std::uint16_t>(signature->index), line);
+        return RuntimeType::FiberType;
+    }
+
+    RuntimeType BytecodeCompiler::compileFork(const Expression &entry, int line) {
+        // 'fork(f(x))' evaluates the arguments now, but makes the call in another VM, which has a
+        // heap of its own. only primitives can be copied between heaps, so they are all a task can
+        // be passed and return
+        const auto *callExpr = dynamic_cast<const CallExpression *>(&entry);
+        const FunctionSignature *signature = callExpr ? findSignature(*callExpr) : nullptr;
+        if (!signature) {
+            throw makeError<CompileError::NotImplemented>(
+                entry.errorToken(), "forking anything but a call to a declared function");
+        }
+        const RuntimeType *taskType = Task::typeOf(signature->returnType);
+        bool isPrimitive = std::ranges::all_of(signature->parameters, [](const RuntimeType &type) {
+            return findArrayKindForElement(type) != nullptr;
+        });
+        if (!taskType || !isPrimitive) {
+            throw makeError<CompileError::NotImplemented>(
+                entry.errorToken(), "forking a function that takes or returns objects");
+        }
+
+        compileArguments(*callExpr, *signature);
+        emit(OpCode::Fork, static_cast<std::uint16_t>(signature->index), line);
+        return *taskType;
+    }
+
+    RuntimeType BytecodeCompiler::compileParallelMap(const CallExpression &callExpr, int line) {
+        // 'parallelMap(array, f)' names the function rather than calling it, since there are no
+        // function values yet. like a forked function, it must take and return primitives
+        const auto &arguments = callExpr.arguments();
+        if (arguments.size() != 2) {
+            throw makeError<CompileError::ArgumentCount>(
+                callExpr.errorToken(), "parallelMap", 2, static_cast<int>(arguments.size()));
+        }
+        auto arrayType = std::any_cast<RuntimeType>(arguments[0]->accept(*this));
+        const auto *function = dynamic_cast<const VariableExpression *>(arguments[1].get());
+        auto signatureIt = function ? m_signatures.find(function->name().lexeme) : m_signatures.end();
+        if (signatureIt == m_signatures.end() || signatureIt->second.index < 0) {
+            throw makeError<CompileError::NotImplemented>(
+                arguments[1]->errorToken(), "mapping anything but a declared function over an array");
+        }
+
+        const FunctionSignature &signature = signatureIt->second;
+        const ArrayKind *kind = findArrayKind(arrayType);
+        const ArrayKind *resultKind = findArrayKindForElement(signature.returnType);
+        if (!kind || !resultKind || signature.parameters != std::vector{kind->elementType}) {
+            throw makeError<CompileError::IncompatibleTypes>(
+                callExpr.errorToken(), "'parallelMap'",
+                std::vector{arrayType.name(), functionTypeName(signature.parameters, signature.returnType)});
+        }
+
+        emit(OpCode::ParallelMap, static_cast<std::uint16_t>(signature.index), line);
+        return resultKind->arrayType;
+    }
+
+    RuntimeType BytecodeCompiler::compileArrayIntrinsic(const CallExpression &callExpr, ArrayIntrinsic intrinsic, int line) {
+        const std::string &name = dynamic_cast<const VariableExpression &>(callExpr.callee()).name().lexeme;
+        const auto &arguments = callExpr.arguments();
+        bool isReduction = intrinsic == ArrayIntrinsic::Sum || intrinsic == ArrayIntrinsic::Min || intrinsic == ArrayIntrinsic::Max;
+        std::size_t arity = isReduction ? 1 : 2;
+        if (arguments.size() != arity) {
+            throw makeError<CompileError::ArgumentCount>(
+                callExpr.errorToken(), name, static_cast<int>(arity), static_cast<int>(arguments.size()));
+        }
+
+        std::vector<RuntimeType> types;
+        for (const auto &argument : arguments) {
+            types.push_back(std::any_cast<RuntimeType>(argument->accept(*this)));
+        }
+
+        // the first argument is always an Int or Real array, and the second is either another
+        // array of the same type, or a value of its element type
+        const ArrayKind *kind = findArrayKind(types[0]);
+        bool isValid = kind && kind->intrinsic;
+        if (isValid && !isReduction) {
+            bool takesElement = intrinsic == ArrayIntrinsic::Fill || intrinsic == ArrayIntrinsic::IndexOf;
+            isValid = types[1] == (takesElement ? kind->elementType : kind->arrayType);
+        }
+        if (!isValid) {
+            std::vector<std::string> typeNames;
+            for (const auto &type : types) {
+                typeNames.push_back(type.name());
+            }
+            throw makeError<CompileError::IncompatibleTypes>(callExpr.errorToken(), std::format("'{}'", name), typeNames);
+        }
+
+        emit(*kind->intrinsic, static_cast<std::uint8_t>(intrinsic), line);
+        switch (intrinsic) {
+        case ArrayIntrinsic::Add:
+        case ArrayIntrinsic::Subtract:
+        case ArrayIntrinsic::Multiply:
+        case ArrayIntrinsic::Divide:
+            return kind->arrayType;
+        case ArrayIntrinsic::Fill:
+        case ArrayIntrinsic::Copy:
+            return RuntimeType::NothingType;
+        case ArrayIntrinsic::IndexOf:
+            return RuntimeType::IntType;
+        default:
+            return kind->elementType;
+        }
+    }
+
+    std::optional<ArrayIntrinsic> BytecodeCompiler::findArrayIntrinsic(const std::string &name) {
+        static const std::unordered_map<std::string, ArrayIntrinsic> intrinsics{
+            {"sum", ArrayIntrinsic::Sum},
+            {"min", ArrayIntrinsic::Min},
+            {"max", ArrayIntrinsic::Max},
+            {"dot", ArrayIntrinsic::Dot},
+            {"add", ArrayIntrinsic::Add},
+            {"subtract", ArrayIntrinsic::Subtract},
+            {"multiply", ArrayIntrinsic::Multiply},
+            {"divide", ArrayIntrinsic::Divide},
+            {"fill", ArrayIntrinsic::Fill},
+            {"copy", ArrayIntrinsic::Copy},
+            {"indexOf", ArrayIntrinsic::IndexOf},
+        };
+        auto it = intrinsics.find(name);
+        if (it == intrinsics.end()) {
+            return {};
+        }
+        return it->second;
+    }
+
+    const BytecodeCompiler::IoBuiltin *BytecodeCompiler::findIoBuiltin(const std::string &name) {
+        static const std::unordered_map<std::string, IoBuiltin> builtins{
+            {"readln", {IoOperation::ReadStandardInput, {}, RuntimeType::StringType}},
+            {"openFile", {IoOperation::OpenFile, {RuntimeType::StringType}, RuntimeType::FileType}},
+            {"createFile", {IoOperation::CreateFile, {RuntimeType::StringType}, RuntimeType::FileType}},
+            {"readLine", {IoOperation::ReadLine, {RuntimeType::FileType}, RuntimeType::StringType}},
+            {"isAtEnd", {IoOperation::IsAtEnd, {RuntimeType::FileType}, RuntimeType::BoolType}},
+            {"write", {IoOperation::Write, {RuntimeType::FileType, RuntimeType::StringType}, RuntimeType::NothingType}},
+            {"close", {IoOperation::Close, {RuntimeType::FileType}, RuntimeType::NothingType}},
+            {"sleep", {IoOperation::Sleep, {RuntimeType::IntType}, RuntimeType::NothingType}},
+            {"mapFile", {IoOperation::MapFile, {RuntimeType::StringType}, RuntimeType::MappedFileType}},
+            {"hasNextLine", {IoOperation::HasNextLine, {RuntimeType::MappedFileType}, RuntimeType::BoolType}},
+            {"nextLine", {IoOperation::NextLine, {RuntimeType::MappedFileType}, RuntimeType::StringType}},
+        };
+        auto it = builtins.find(name);
+        if (it == builtins.end()) {
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    RuntimeType BytecodeCompiler::compileIo(const CallExpression &callExpr, const IoBuiltin &builtin, int line) {
+        const std::string &name = dynamic_cast<const VariableExpression &>(callExpr.callee()).name().lexeme;
+        const auto &arguments = callExpr.arguments();
+        if (arguments.size() != builtin.parameters.size()) {
+            throw makeError<CompileError::ArgumentCount>(
+                callExpr.errorToken(), name,
+                static_cast<int>(builtin.parameters.size()), static_cast<int>(arguments.size()));
+        }
+        for (std::size_t i = 0; i < arguments.size(); i++) {
+            auto type = std::any_cast<RuntimeType>(arguments[i]->accept(*this));
+            if (type != builtin.parameters[i]) {
+                throw makeError<CompileError::IncompatibleTypes>(
+                    arguments[i]->errorToken(), std::format("argument {} of '{}'", i + 1, name),
+                    std::vector{builtin.parameters[i].name(), type.name()});
+            }
+        }
+        emit(OpCode::Io, static_cast<std::uint8_t>(builtin.operation), line);
+        return builtin.returnType;
+    }
+
+    RuntimeType BytecodeCompiler::compileInlineCall(const FunctionSignature &signature, int line) {
+        // the arguments are already on the stack, so they become the parameters' slots, just
+        // as they would in a real call. the body keeps its own line numbers, so errors raised
+        // while running it still point at the function's source
+        const auto &params = signature.declaration->params();
+        beginScope();
+        std::size_t callerLocals = std::exchange(m_firstVisibleLocal, m_locals.size());
+
+        // any values that the caller has pushed but not used yet, such as the left operand of a
+        // binary expression, lie between its locals and the arguments, so they become hidden locals
+        int pendingValues = m_stackDepth - static_cast<int>(m_locals.size() + params.size());
+        if (pendingValues < 0) {
+            throw CompileException("Stack depth is below the number of locals.");
+        }
+        for (int i = 0; i < pendingValues; i++) {
+            declareLocal(Token{TokenType::Identifier, "", signature.declaration->name().location},
+                RuntimeType::NothingType, false);
+        }
+        for (std::size_t i = 0; i < params.size(); i++) {
+            declareLocal(params[i].name(), signature.parameters[i], false);
+        }
+
+        signature.inlineBody->accept(*this);
+        m_firstVisibleLocal = callerLocals;
+
+        // move the result into the first argument's slot, then discard the copy and the other arguments
+        if (!params.empty()) {
+            int resultSlot = static_cast<int>(m_locals.size() - params.size());
+            emit(OpCode::SetLocal, static_cast<std::uint8_t>(resultSlot), line);
+            for (std::size_t i = 0; i < params.size(); i++) {
+                emit(OpCode::Pop, line);
+            }
+        }
+        m_locals.erase(m_locals.end() - static_cast<std::ptrdiff_t>(pendingValues + params.size()), m_locals.end());
+        m_scopeDepth--;
+
+        return signature.returnType;
+    }
+
+    const Expression *BytecodeCompiler::findInlineBody(const FunctionDeclaration &funDecl) {
+        // open functions may be overridden, so calls to them cannot be bound to their body
+        bool isOpen = std::ranges::any_of(funDecl.modifiers(), [](const Token &modifier) {
+            return modifier.type == TokenType::Open;
+        });
+        if (isOpen || !funDecl.body()) {
+            return nullptr;
+        }
+
+        // only 'fun f() = expr' and 'fun f() { return expr }' can be replaced by an expression
+        const Expression *body = nullptr;
+        if (const auto *exprBody = dynamic_cast<const ExpressionStatement *>(funDecl.body())) {
+            body = &exprBody->expr();
+        } else if (const auto *blockBody = dynamic_cast<const BlockStatement *>(funDecl.body())) {
+            if (blockBody->body().size() == 1) {
+                if (const auto *returnStmt = dynamic_cast<const ReturnStatement *>(blockBody->body()[0].get())) {
+                    body = returnStmt->value();
+                }
+            }
+        }
+
+        if (!body) {
+            return nullptr;
+        }
+        auto cost = inlineCost(*body);
+        return cost && *cost <= INLINE_BUDGET ? body : nullptr;
+    }
+
+    std::optional<int> BytecodeCompiler::inlineCost(const Expression &expr) {
+        // returns the number of nodes in the expression, or nothing if it cannot be inlined.
+        // calls are never inlined, so only leaf functions are, and recursion is not a concern
+        if (const auto *binExpr = dynamic_cast<const BinaryExpression *>(&expr)) {
+            auto left = inlineCost(binExpr->left());
+            auto right = inlineCost(binExpr->right());
+            if (!left || !right) return {};
+            return 1 + *left + *right;
+        } else if (const auto *cmpExpr = dynamic_cast<const ComparisonExpression *>(&expr)) {
+            auto left = inlineCost(cmpExpr->left());
+            auto right = inlineCost(cmpExpr->right());
+            if (!left || !right) return {};
+            return 1 + *left + *right;
+        } else if (const auto *unaryExpr = dynamic_cast<const UnaryExpression *>(&expr)) {
+            auto operand = inlineCost(unaryExpr->operand());
+            if (!operand) return {};
+            return 1 + *operand;
+        } else if (const auto *indexExpr = dynamic_cast<const IndexExpression *>(&expr)) {
+            auto array = inlineCost(indexExpr->array());
+            auto index = inlineCost(indexExpr->index());
+            if (!array || !index) return {};
+            return 1 + *array + *index;
+        } else if (const auto *propertyExpr = dynamic_cast<const PropertyExpression *>(&expr)) {
+            auto object = inlineCost(propertyExpr->object());
+            if (!object) return {};
+            return 1 + *object;
+        } else if (dynamic_cast<const VariableExpression *>(&expr) ||
+            dynamic_cast<const NumberExpression *>(&expr) ||
+            dynamic_cast<const BooleanExpression *>(&expr)) {
+            return 1;
+        }
+        return {};
+    }
+
+    std::optional<int> BytecodeCompiler::findBoundingArray(const RangeExpression &range) const {
+        // only 'start..array.size' is recognized, where start is an integer literal and so
+        // cannot be negative, and array is an immutable local
+        const auto *start = dynamic_cast<const NumberExpression *>(&range.start());
+        const auto *end = dynamic_cast<const PropertyExpression *>(&range.end());
+        if (range.isInclusive() || !start || !start->isIntLiteral() || !end || end->name().lexeme != "size") {
+            return {};
+        }
+        const auto *array = dynamic_cast<const VariableExpression *>(&end->object());
+        if (!array) {
+            return {};
+        }
+
+        int slot = resolveLocal(array->name());
+        const Local &local = m_locals[slot];
+        if (local.isMutable || !findArrayKind(local.type)) {
+            return {};
+        }
+        return slot;
+    }
+
+    bool BytecodeCompiler::isProvenInBounds(const IndexExpression &indexExpr) const {
+        const auto *array = dynamic_cast<const VariableExpression *>(&indexExpr.array());
+        const auto *index = dynamic_cast<const VariableExpression *>(&indexExpr.index());
+        if (!array || !index) {
+            return false;
+        }
+
+        // resolving by slot rather than by name means that shadowing either variable in the loop body is harmless
+        int arraySlot = resolveLocal(array->name());
+        int indexSlot = resolveLocal(index->name());
+        return std::ranges::any_of(m_boundedIndices, [&](const BoundedIndex &bounded) {
+            return bounded.arraySlot == arraySlot && bounded.indexSlot == indexSlot;
+        });
+    }
+
+    std::optional<std::string> BytecodeCompiler::vectorizeLoop(const ForStatement &forStmt, VectorLoop &loop) const {
+        // only loops whose body is a single 'array[i] = ...' are vectorized
+        const Statement *body = &forStmt.body();
+        if (const auto *block = dynamic_cast<const BlockStatement *>(body); block && block->body().size() == 1) {
+            body = block->body()[0].get();
+        }
+        const auto *exprStmt = dynamic_cast<const ExpressionStatement *>(body);
+        const auto *assignExpr = exprStmt ? dynamic_cast<const IndexAssignmentExpression *>(&exprStmt->expr()) : nullptr;
+        if (!assignExpr || assignExpr->op().type != TokenType::Equal) {
+            return "the body is not a single assignment to an array element";
+        }
+
+        const Token &index = forStmt.variable();
+        const auto *target = dynamic_cast<const VariableExpression *>(&assignExpr->target().array());
+        const auto *targetIndex = dynamic_cast<const VariableExpression *>(&assignExpr->target().index());
+        if (!target || !targetIndex || targetIndex->name().lexeme != index.lexeme || target->name().lexeme == index.lexeme) {
+            return "the assigned element is not indexed by the loop variable";
+        }
+
+        int targetSlot = resolveLocal(target->name());
+        const ArrayKind *kind = findArrayKind(m_locals[targetSlot].type);
+        if (!kind || !kind->intrinsic) {
+            return "the assigned array is not an Int or Real array";
+        }
+
+        loop.isReal = kind->elementType == RuntimeType::RealType;
+        loop.targetSlot = static_cast<std::uint8_t>(targetSlot);
+        if (auto missedReason = vectorizeOperand(assignExpr->value(), index, *kind, loop.code)) {
+            return missedReason;
+        } else if (loop.code.size() > VectorLoop::MAX_OPERATIONS) {
+            return "the assigned expression is too large";
+        }
+        return {};
+    }
+
+    std::optional<std::string> BytecodeCompiler::vectorizeOperand(
+        const Expression &expr, const Token &index, const ArrayKind &kind, std::vector<VectorInstruction> &code) const {
+        // the loop variable is not declared yet, so any use of its name refers to it
+        bool isInt = kind.elementType == RuntimeType::IntType;
+        if (const auto *binExpr = dynamic_cast<const BinaryExpression *>(&expr)) {
+            VectorOp op;
+            switch (binExpr->op().type) {
+            case TokenType::Plus:
+                op = VectorOp::Add;
+                break;
+            case TokenType::Minus:
+                op = VectorOp::Subtract;
+                break;
+            case TokenType::Asterisk:
+                op = VectorOp::Multiply;
+                break;
+            case TokenType::Slash:
+                if (isInt) {
+                    // dividing by zero must panic at the right iteration
+                    return "integer division";
+                }
+                op = VectorOp::Divide;
+                break;
+            default:
+                return std::format("the '{}' operator", binExpr->op().lexeme);
+            }
+            if (auto missedReason = vectorizeOperand(binExpr->left(), index, kind, code)) {
+                return missedReason;
+            } else if (auto missedReason = vectorizeOperand(binExpr->right(), index, kind, code)) {
+                return missedReason;
+            }
+            code.push_back(VectorInstruction{.op = op});
+            return {};
+        } else if (const auto *unaryExpr = dynamic_cast<const UnaryExpression *>(&expr)) {
+            if (unaryExpr->op().type != TokenType::Minus && unaryExpr->op().type != TokenType::Plus) {
+                return std::format("the '{}' operator", unaryExpr->op().lexeme);
+            } else if (auto missedReason = vectorizeOperand(unaryExpr->operand(), index, kind, code)) {
+                return missedReason;
+            }
+            if (unaryExpr->op().type == TokenType::Minus) {
+                code.push_back(VectorInstruction{.op = VectorOp::Negate});
+            }
+            return {};
+        } else if (const auto *indexExpr = dynamic_cast<const IndexExpression *>(&expr)) {
+            const auto *array = dynamic_cast<const VariableExpression *>(&indexExpr->array());
+            const auto *element = dynamic_cast<const VariableExpression *>(&indexExpr->index());
+            if (!array || !element || element->name().lexeme != index.lexeme || array->name().lexeme == index.lexeme) {
+                return "an array element that is not indexed by the loop variable";
+            }
+            int slot = resolveLocal(array->name());
+            if (m_locals[slot].type != kind.arrayType) {
+                return std::format("an element of a {}", m_locals[slot].type.name());
+            }
+            code.push_back(VectorInstruction{.op = VectorOp::LoadElement, .slot = static_cast<std::uint8_t>(slot)});
+            return {};
+        } else if (const auto *varExpr = dynamic_cast<const VariableExpression *>(&expr)) {
+            if (varExpr->name().lexeme == index.lexeme) {
+                if (!isInt) {
+                    return "the loop variable in a Real expression";
+                }
+                code.push_back(VectorInstruction{.op = VectorOp::LoadIndex});
+                return {};
+            }
+            // nothing in the body can assign to a local, so its value is the same in every iteration
+            int slot = resolveLocal(varExpr->name());
+            if (m_locals[slot].type != kind.elementType) {
+                return std::format("a {} variable", m_locals[slot].type.name());
+            }
+            code.push_back(VectorInstruction{.op = VectorOp::LoadLocal, .slot = static_cast<std::uint8_t>(slot)});
+            return {};
+        } else if (const auto *numExpr = dynamic_cast<const NumberExpression *>(&expr)) {
+            if (numExpr->isIntLiteral() != isInt) {
+                return "a literal of the wrong type";
+            }
+            code.push_back(VectorInstruction{.op = VectorOp::LoadConstant, .constant = parseNumericLiteral(*numExpr)});
+            return {};
+        }
+        return "an expression other than arithmetic on elements, locals and literals";
+    }
+
+    VisitResult BytecodeCompiler::visitIndexExpr(const IndexExpression &indexExpr) {
+        auto arrayType = std::any_cast<RuntimeType>(indexExpr.array().accept(*this));
+        auto indexType = std::any_cast<RuntimeType>(indexExpr.index().accept(*this));
+        const ArrayKind *kind = findArrayKind(arrayType);
+        if (!kind || indexType != RuntimeType::IntType) {
+            throw makeError<CompileError::IncompatibleTypes>(
+                indexExpr.errorToken(), "'[]'", std::vector{arrayType.name(), indexType.name()});
+        }
+
+        emit(isProvenInBounds(indexExpr) ? kind->getUnchecked : kind->get, indexExpr.bracket().location.line);
+        return kind->elementType;
+    }
+
+    VisitResult BytecodeCompiler::visitPropertyExpr(const PropertyExpression &propertyExpr) {
+        auto type = std::any_cast<RuntimeType>(propertyExpr.object().accept(*this));
+        if (propertyExpr.name().lexeme == "size" && findArrayKind(type)) {
+            emit(OpCode::ArrayLength, propertyExpr.name().location.line);
+            return RuntimeType::IntType;
+        }
         throw makeError<CompileError::NotImplemented>(
-            callExpr.errorToken(), "function calls");
+            propertyExpr.errorToken(), std::format("property '{}' of type '{}'", propertyExpr.name().lexeme, type.name()));
     }
 
     VisitResult BytecodeCompiler::visitVariableExpr(const VariableExpression &varExpr) {
-        throw makeError<CompileError::NotImplemented>(
-            varExpr.errorToken(), "variable expressions");
+        int slot = resolveLocal(varExpr.name());
+        emit(OpCode::GetLocal, static_cast<std::uint8_t>(slot), varExpr.name().location.line);
+        return m_locals[slot].type;
     }
 
     VisitResult BytecodeCompiler::visitNumberExpr(const NumberExpression &numExpr) {
@@ -271,67 +1211,701 @@ namespace ferrit {
         return value.runtimeType();
     }
 
+    VisitResult BytecodeCompiler::visitStringExpr(const StringExpression &stringExpr) {
+        int index = m_chunk.addString(parseStringLiteral(stringExpr));
+        if (index > std::numeric_limits<std::uint16_t>::max()) {
+            throw CompileException("Too many string literals in one chunk.");
+        }
+        emit(OpCode::String, static_cast<std::uint16_t>(index), stringExpr.value().location.line);
+        return RuntimeType::StringType;
+    }
+
+    VisitResult BytecodeCompiler::visitArrayExpr(const ArrayExpression &arrayExpr) {
+        const auto &elements = arrayExpr.elements();
+        if (elements.empty()) {
+            throw makeError<CompileError::NotImplemented>(
+                arrayExpr.errorToken(), "empty array literals");
+        } else if (elements.size() > std::numeric_limits<std::uint16_t>::max()) {
+            throw CompileException("Too many elements in one array literal.");
+        }
+
+        // the array's element type is the type of its first element, which every other element must match
+        auto elementType = std::any_cast<RuntimeType>(elements[0]->accept(*this));
+        const ArrayKind *kind = findArrayKindForElement(elementType);
+        if (!kind) {
+            throw makeError<CompileError::NotImplemented>(
+                arrayExpr.errorToken(), std::format("arrays of type '{}'", elementType.name()));
+        }
+        for (std::size_t i = 1; i < elements.size(); i++) {
+            auto type = std::any_cast<RuntimeType>(elements[i]->accept(*this));
+            if (type != elementType) {
+                throw makeError<CompileError::IncompatibleTypes>(
+                    elements[i]->errorToken(), "array literal", std::vector{elementType.name(), type.name()});
+            }
+        }
+
+        emit(kind->literal, static_cast<std::uint16_t>(elements.size()), arrayExpr.bracket().location.line);
+        return kind->arrayType;
+    }
+
     void BytecodeCompiler::emit(OpCode opCode, int line) {
         m_chunk.writeInstruction(opCode, line);
+        m_stackDepth += stackEffect(opCode, 0);
     }
 
     void BytecodeCompiler::emit(OpCode opCode, std::uint8_t arg, int line) {
         m_chunk.writeInstruction(opCode, arg, line);
+        m_stackDepth += stackEffect(opCode, arg);
+    }
+
+    void BytecodeCompiler::emit(OpCode opCode, std::uint16_t arg, int line) {
+        m_chunk.writeInstruction(opCode, arg, line);
+        m_stackDepth += stackEffect(opCode, arg);
+    }
+
+    void BytecodeCompiler::emit(OpCode opCode, std::uint16_t arg1, std::uint16_t arg2, int line) {
+        m_chunk.writeInstruction(opCode, arg1, arg2, line);
+        m_stackDepth += stackEffect(opCode, arg1);
+    }
+
+    int BytecodeCompiler::stackEffect(OpCode opCode, int arg) const {
+        // the number of values that an instruction pushes minus the number that it pops. there is
+        // deliberately no default, so that an instruction cannot be added without its effect
+        switch (opCode) {
+        case OpCode::NoOp:
+        case OpCode::SetLocal:
+        case OpCode::INegate:
+        case OpCode::FNegate:
+        case OpCode::BNot:
+        case OpCode::ArrayLength:
+        case OpCode::Resume:
+        case OpCode::Join:
+        case OpCode::ParallelMap:
+        case OpCode::Print:
+        case OpCode::Jump:
+        case OpCode::JumpLong:
+        case OpCode::Loop:
+        case OpCode::LoopLong:
+        case OpCode::ForRangeIntPrep:
+        case OpCode::ForRangeIntInclusivePrep:
+        case OpCode::ForRangeInt:
+        case OpCode::VectorLoop:
+        case OpCode::ForRangeIntPrepLong:
+        case OpCode::ForRangeIntInclusivePrepLong:
+        case OpCode::ForRangeIntLong:
+            return 0;
+        case OpCode::Constant:
+        case OpCode::ConstantLong:
+        case OpCode::GetLocal:
+        case OpCode::String:
+        case OpCode::Yield:
+            return 1;
+        case OpCode::Pop:
+        case OpCode::IAdd:
+        case OpCode::ISubtract:
+        case OpCode::IMultiply:
+        case OpCode::IDivide:
+        case OpCode::IModulus:
+        case OpCode::IEqual:
+        case OpCode::INotEqual:
+        case OpCode::ILess:
+        case OpCode::ILessEqual:
+        case OpCode::IGreater:
+        case OpCode::IGreaterEqual:
+        case OpCode::FAdd:
+        case OpCode::FSubtract:
+        case OpCode::FMultiply:
+        case OpCode::FDivide:
+        case OpCode::FModulus:
+        case OpCode::FEqual:
+        case OpCode::FNotEqual:
+        case OpCode::FLess:
+        case OpCode::FLessEqual:
+        case OpCode::FGreater:
+        case OpCode::FGreaterEqual:
+        case OpCode::BAnd:
+        case OpCode::BOr:
+        case OpCode::BEqual:
+        case OpCode::BNotEqual:
+        case OpCode::SConcat:
+        case OpCode::SEqual:
+        case OpCode::SNotEqual:
+        case OpCode::INewArray:
+        case OpCode::FNewArray:
+        case OpCode::BNewArray:
+        case OpCode::IIndexGet:
+        case OpCode::FIndexGet:
+        case OpCode::BIndexGet:
+        case OpCode::IIndexGetUnchecked:
+        case OpCode::FIndexGetUnchecked:
+        case OpCode::BIndexGetUnchecked:
+        case OpCode::JumpIfFalse:
+        case OpCode::JumpIfFalseLong:
+        case OpCode::Return:
+            return -1;
+        case OpCode::IJumpIfEqual:
+        case OpCode::IJumpIfNotEqual:
+        case OpCode::IJumpIfLess:
+        case OpCode::IJumpIfLessEqual:
+        case OpCode::IJumpIfGreater:
+        case OpCode::IJumpIfGreaterEqual:
+        case OpCode::IIndexSet:
+        case OpCode::FIndexSet:
+        case OpCode::BIndexSet:
+        case OpCode::IIndexSetUnchecked:
+        case OpCode::FIndexSetUnchecked:
+        case OpCode::BIndexSetUnchecked:
+            return -2;
+        case OpCode::IArrayLiteral:
+        case OpCode::FArrayLiteral:
+        case OpCode::BArrayLiteral:
+            return 1 - arg;
+        case OpCode::IArrayIntrinsic:
+        case OpCode::FArrayIntrinsic:
+            // every intrinsic pushes its result, but only the reductions take a single array
+            switch (static_cast<ArrayIntrinsic>(arg)) {
+            case ArrayIntrinsic::Sum:
+            case ArrayIntrinsic::Min:
+            case ArrayIntrinsic::Max:
+                return 0;
+            case ArrayIntrinsic::Dot:
+            case ArrayIntrinsic::Add:
+            case ArrayIntrinsic::Subtract:
+            case ArrayIntrinsic::Multiply:
+            case ArrayIntrinsic::Divide:
+            case ArrayIntrinsic::Fill:
+            case ArrayIntrinsic::Copy:
+            case ArrayIntrinsic::IndexOf:
+                return -1;
+            }
+            break;
+        case OpCode::Io:
+            // every operation pushes its result in place of its operands
+            switch (static_cast<IoOperation>(arg)) {
+            case IoOperation::OpenFile:
+            case IoOperation::CreateFile:
+            case IoOperation::ReadLine:
+            case IoOperation::IsAtEnd:
+            case IoOperation::Close:
+            case IoOperation::Sleep:
+            case IoOperation::MapFile:
+            case IoOperation::HasNextLine:
+            case IoOperation::NextLine:
+                return 0;
+            case IoOperation::Write:
+                return -1;
+            case IoOperation::ReadStandardInput:
+                return 1;
+            }
+            break;
+        case OpCode::Call:
+            return 1 - m_functions[arg].arity;
+        case OpCode::Spawn:
+            // the arguments are moved into the new fiber, which takes their place
+            return 1 - m_functions[arg].arity;
+        case OpCode::Fork:
+            // as with a fiber, the task takes the place of the arguments
+            return 1 - m_functions[arg].arity;
+        case OpCode::CallNative:
+            return 1 - static_cast<int>(m_nativeFunctions[arg].parameterTypes.size());
+        case OpCode::TailCall:
+            // the callee's result is returned straight to the caller's caller
+            return -m_functions[arg].arity;
+        }
+        throw CompileException(std::format("unknown opcode ({})", static_cast<int>(opCode)));
     }
 
-    int BytecodeCompiler::emitJump(bool isConditionalJump, int line) {
-        OpCode opCode = isConditionalJump ? OpCode::JumpIfFalse : OpCode::Jump;
-        m_chunk.writeInstruction(opCode, static_cast<std::uint16_t>(0xDEAD), line);
+    int BytecodeCompiler::emitJump(OpCode jumpOp, int line) {
+        // the offset is filled in by relaxBranches() once the whole chunk is known
+        emit(jumpOp, static_cast<std::uint16_t>(0xDEAD), line);
+        m_branches.push_back(Branch{
+            .offset = m_chunk.size() - 3,
+            .target = -1,
+            .isBackward = false,
+            .isLong = false});
 
-        return m_chunk.size() - 2;
+        return static_cast<int>(m_branches.size() - 1);
     }
 
-    void BytecodeCompiler::patchJump(int jumpOpOffset) {
-        // subtract 2 to account for the instruction's parameter
-        int offset = m_chunk.size() - jumpOpOffset - 2;
-        if (offset < 0) {
-            throw CompileException("Negative offset in jump instruction.");
-        } else if (offset > std::numeric_limits<std::uint16_t>::max()) {
-            throw CompileException(std::format("Jump of {} bytes too big.", offset));
+    int BytecodeCompiler::emitConditionalJump(const Expression &condition, const std::string &context, int line) {
+        // Integer comparisons are fused with the branch, so that a condition such as
+        // `a < b` is a single instruction instead of a compare followed by a JumpIfFalse.
+        if (const auto *cmpExpr = dynamic_cast<const ComparisonExpression *>(&condition)) {
+            auto leftType = std::any_cast<RuntimeType>(cmpExpr->left().accept(*this));
+            auto rightType = std::any_cast<RuntimeType>(cmpExpr->right().accept(*this));
+
+            if (leftType == RuntimeType::IntType && rightType == RuntimeType::IntType) {
+                return emitJump(getInvertedIntJumpOpCode(cmpExpr->op().type), line);
+            }
+            emit(getComparisonOpCode(*cmpExpr, leftType, rightType), cmpExpr->op().location.line);
+            return emitJump(OpCode::JumpIfFalse, line);
+        }
+
+        auto conditionType = std::any_cast<RuntimeType>(condition.accept(*this));
+        if (conditionType != RuntimeType::BoolType) {
+            throw makeError<CompileError::IncompatibleTypes>(
+                condition.errorToken(), context, std::vector{conditionType.name()});
         }
+        return emitJump(OpCode::JumpIfFalse, line);
+    }
 
-        m_chunk.patchShort(jumpOpOffset, static_cast<std::uint16_t>(offset));
+    void BytecodeCompiler::patchJump(int jump) {
+        Branch &branch = m_branches.at(jump);
+        if (branch.target >= 0) {
+            throw CompileException("Jump instruction patched twice.");
+        }
+        branch.target = m_chunk.size();
+    }
+
+    void BytecodeCompiler::emitLoop(OpCode loopOp, int loopStart, int line) {
+        if (m_chunk.loopHeaders().size() > std::numeric_limits<std::uint16_t>::max()) {
+            throw CompileException("Too many loops in one chunk.");
+        }
+
+        std::uint16_t loopIndex = m_chunk.addLoopHeader(loopStart);
+        emit(loopOp, static_cast<std::uint16_t>(0xDEAD), loopIndex, line);
+        m_branches.push_back(Branch{
+            .offset = m_chunk.size() - 5,
+            .target = loopStart,
+            .isBackward = true,
+            .isLong = false});
+    }
+
+    void BytecodeCompiler::beginScope() {
+        m_scopeDepth++;
+    }
+
+    void BytecodeCompiler::endScope(int line) {
+        m_scopeDepth--;
+        // discarding the scope's locals frees their slots for the next sibling scope
+        while (!m_locals.empty() && m_locals.back().depth > m_scopeDepth) {
+            emit(OpCode::Pop, line);
+            m_locals.pop_back();
+        }
+    }
+
+    void BytecodeCompiler::compileScoped(const Statement &body, int line) {
+        // bodies are always scoped, so that 'if (a) val b = c' cannot leave b on the stack
+        beginScope();
+        body.accept(*this);
+        endScope(line);
+    }
+
+    int BytecodeCompiler::declareLocal(const Token &name, const RuntimeType &type, bool isMutable) {
+        for (auto it = m_locals.crbegin(); it != m_locals.crend() && it->depth == m_scopeDepth; ++it) {
+            if (!name.lexeme.empty() && it->name.lexeme == name.lexeme) {
+                throw makeError<CompileError::Redeclaration>(name);
+            }
+        }
+
+        constexpr int maxLocals = std::numeric_limits<std::uint8_t>::max() + 1;
+        if (m_locals.size() >= maxLocals) {
+            throw makeError<CompileError::TooManyLocals>(name, maxLocals);
+        }
+
+        m_locals.push_back(Local{
+            .name = name,
+            .type = type,
+            .isMutable = isMutable,
+            .depth = m_scopeDepth});
+        return static_cast<int>(m_locals.size() - 1);
+    }
+
+    int BytecodeCompiler::resolveLocal(const Token &name) const {
+        // search innermost scopes first, so that inner declarations shadow outer ones
+        for (int slot = static_cast<int>(m_locals.size()) - 1; slot >= static_cast<int>(m_firstVisibleLocal); slot--) {
+            if (m_locals[slot].name.lexeme == name.lexeme) {
+                return slot;
+            }
+        }
+        throw makeError<CompileError::UndefinedVariable>(name);
+    }
+
+    RuntimeType BytecodeCompiler::resolveDeclaredType(const DeclaredType &declaredType) const {
+        if (declaredType.isSimple()) {
+            const std::string &name = declaredType.simple().name().lexeme;
+            if (name == "Int") return RuntimeType::IntType;
+            if (name == "Real") return RuntimeType::RealType;
+            if (name == "Bool") return RuntimeType::BoolType;
+            if (name == "String") return RuntimeType::StringType;
+            if (name == "Fiber") return RuntimeType::FiberType;
+            if (name == "File") return RuntimeType::FileType;
+            if (name == "MappedFile") return RuntimeType::MappedFileType;
+            if (name == "Unit") return RuntimeType::NothingType;
+        } else if (declaredType.isGeneric()) {
+            const GenericType &generic = declaredType.generic();
+            if (generic.name().lexeme == "Array" && generic.arguments().size() == 1) {
+                // only arrays of primitives are supported, which are all packed
+                if (const ArrayKind *kind = findArrayKindForElement(resolveDeclaredType(generic.arguments()[0]))) {
+                    return kind->arrayType;
+                }
+            }
+            if (generic.name().lexeme == "Task" && generic.arguments().size() == 1) {
+                if (const RuntimeType *taskType = Task::typeOf(resolveDeclaredType(generic.arguments()[0]))) {
+                    return *taskType;
+                }
+            }
+        }
+        throw makeError<CompileError::NotImplemented>(
+            declaredType.errorToken(), std::format("type '{}'", declaredType));
+    }
+
+    void BytecodeCompiler::relaxBranches() {
+        // Widening a branch moves the code after it, which can push other branches out
+        // of range in turn, so keep going until every branch fits. Branches only ever
+        // grow, so this is guaranteed to terminate.
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (std::size_t i = 0; i < m_branches.size(); i++) {
+                const Branch &branch = m_branches[i];
+                if (branch.target < 0) {
+                    throw CompileException("Unpatched jump instruction.");
+                }
+                if (!branch.isLong && branch.distance() > std::numeric_limits<std::uint16_t>::max()) {
+                    widenBranch(i);
+                    changed = true;
+                }
+            }
+        }
+
+        for (const Branch &branch : m_branches) {
+            int distance = branch.distance();
+            if (distance < 0) {
+                throw CompileException("Negative offset in jump instruction.");
+            }
+
+            if (branch.isLong) {
+                m_chunk.patchInt(branch.offset + 1, static_cast<std::uint32_t>(distance));
+            } else {
+                m_chunk.patchShort(branch.offset + 1, static_cast<std::uint16_t>(distance));
+            }
+        }
+    }
+
+    void BytecodeCompiler::widenBranch(std::size_t index) {
+        int offset = m_branches[index].offset;
+        auto jumpOp = static_cast<OpCode>(m_chunk.byteAt(offset));
+
+        if (auto longOp = getLongJumpOpCode(jumpOp)) {
+            m_chunk.patchByte(offset, static_cast<std::uint8_t>(*longOp));
+            insertBytes(offset + 1, 2);
+        } else {
+            // Fused comparisons have no long form. Instead, invert the comparison so that
+            // it skips over a long jump to the original target:
+            //     jmpige far    =>    jmpilt +5; jmp.l far
+            m_chunk.patchByte(offset, static_cast<std::uint8_t>(invertIntJumpOpCode(jumpOp)));
+            m_chunk.patchShort(offset + 1, 5);
+            insertBytes(offset + 3, 5);
+            m_chunk.patchByte(offset + 3, static_cast<std::uint8_t>(OpCode::JumpLong));
+            m_branches[index].offset = offset + 3;
+        }
+        m_branches[index].isLong = true;
+    }
+
+    void BytecodeCompiler::insertBytes(int offset, int count) {
+        m_chunk.insertBytes(offset, count);
+        for (Branch &branch : m_branches) {
+            if (branch.offset >= offset) {
+                branch.offset += count;
+            }
+            if (branch.target >= offset) {
+                branch.target += count;
+            }
+        }
+    }
+
+    std::optional<OpCode> BytecodeCompiler::getLongJumpOpCode(OpCode jumpOp) {
+        switch (jumpOp) {
+        case OpCode::Jump:
+            return OpCode::JumpLong;
+        case OpCode::JumpIfFalse:
+            return OpCode::JumpIfFalseLong;
+        case OpCode::Loop:
+            return OpCode::LoopLong;
+        case OpCode::ForRangeIntPrep:
+            return OpCode::ForRangeIntPrepLong;
+        case OpCode::ForRangeIntInclusivePrep:
+            return OpCode::ForRangeIntInclusivePrepLong;
+        case OpCode::ForRangeInt:
+            return OpCode::ForRangeIntLong;
+        default:
+            return {};
+        }
+    }
+
+    OpCode BytecodeCompiler::invertIntJumpOpCode(OpCode jumpOp) {
+        switch (jumpOp) {
+        case OpCode::IJumpIfEqual:
+            return OpCode::IJumpIfNotEqual;
+        case OpCode::IJumpIfNotEqual:
+            return OpCode::IJumpIfEqual;
+        case OpCode::IJumpIfLess:
+            return OpCode::IJumpIfGreaterEqual;
+        case OpCode::IJumpIfLessEqual:
+            return OpCode::IJumpIfGreater;
+        case OpCode::IJumpIfGreater:
+            return OpCode::IJumpIfLessEqual;
+        case OpCode::IJumpIfGreaterEqual:
+            return OpCode::IJumpIfLess;
+        default:
+            throw CompileException(std::format("not a fused integer jump opcode ({})", static_cast<int>(jumpOp)));
+        }
+    }
+
+    int BytecodeCompiler::Branch::size() const noexcept {
+        int size = isBackward ? 5 : 3;
+        return isLong ? size + 2 : size;
+    }
+
+    int BytecodeCompiler::Branch::distance() const noexcept {
+        // forward jumps are relative to the end of the instruction, loops jump backwards from it
+        int end = offset + size();
+        return isBackward ? end - target : target - end;
+    }
+
+    OpCode BytecodeCompiler::getComparisonOpCode(
+        const ComparisonExpression &cmpExpr, const RuntimeType &leftType, const RuntimeType &rightType) const {
+
+        bool isInt = leftType == RuntimeType::IntType && rightType == RuntimeType::IntType;
+        bool isReal = leftType == RuntimeType::RealType && rightType == RuntimeType::RealType;
+        bool isBool = leftType == RuntimeType::BoolType && rightType == RuntimeType::BoolType;
+        bool isString = leftType == RuntimeType::StringType && rightType == RuntimeType::StringType;
+
+        switch (cmpExpr.op().type) {
+        case TokenType::EqualEqual:
+            if (isInt) return OpCode::IEqual;
+            if (isReal) return OpCode::FEqual;
+            if (isBool) return OpCode::BEqual;
+            if (isString) return OpCode::SEqual;
+            break;
+        case TokenType::BangEqual:
+            if (isInt) return OpCode::INotEqual;
+            if (isReal) return OpCode::FNotEqual;
+            if (isBool) return OpCode::BNotEqual;
+            if (isString) return OpCode::SNotEqual;
+            break;
+        case TokenType::Less:
+            if (isInt) return OpCode::ILess;
+            if (isReal) return OpCode::FLess;
+            break;
+        case TokenType::LessEqual:
+            if (isInt) return OpCode::ILessEqual;
+            if (isReal) return OpCode::FLessEqual;
+            break;
+        case TokenType::Greater:
+            if (isInt) return OpCode::IGreater;
+            if (isReal) return OpCode::FGreater;
+            break;
+        case TokenType::GreaterEqual:
+            if (isInt) return OpCode::IGreaterEqual;
+            if (isReal) return OpCode::FGreaterEqual;
+            break;
+        default:
+            throw CompileException(
+                std::format("unknown operator '{}' ({})",
+                    cmpExpr.op().lexeme,
+                    cmpExpr.op().type));
+        }
+
+        throw makeError<CompileError::IncompatibleTypes>(
+            cmpExpr.errorToken(), std::format("'{}'", cmpExpr.op().lexeme),
+            std::vector{leftType.name(), rightType.name()});
+    }
+
+    OpCode BytecodeCompiler::getInvertedIntJumpOpCode(TokenType comparison) {
+        // the jump skips the guarded code, so it must be taken when the comparison is false.
+        switch (comparison) {
+        case TokenType::EqualEqual:
+            return OpCode::IJumpIfNotEqual;
+        case TokenType::BangEqual:
+            return OpCode::IJumpIfEqual;
+        case TokenType::Less:
+            return OpCode::IJumpIfGreaterEqual;
+        case TokenType::LessEqual:
+            return OpCode::IJumpIfGreater;
+        case TokenType::Greater:
+            return OpCode::IJumpIfLessEqual;
+        case TokenType::GreaterEqual:
+            return OpCode::IJumpIfLess;
+        default:
+            throw CompileException(std::format("unknown comparison operator ({})", comparison));
+        }
+    }
+
+    const std::vector<BytecodeCompiler::ArrayKind> &BytecodeCompiler::arrayKinds() {
+        static const std::vector<ArrayKind> kinds{
+            ArrayKind{
+                .arrayType = RuntimeType::IntArrayType,
+                .elementType = RuntimeType::IntType,
+                .newArray = OpCode::INewArray,
+                .literal = OpCode::IArrayLiteral,
+                .get = OpCode::IIndexGet,
+                .set = OpCode::IIndexSet,
+                .getUnchecked = OpCode::IIndexGetUnchecked,
+                .setUnchecked = OpCode::IIndexSetUnchecked,
+                .intrinsic = OpCode::IArrayIntrinsic},
+            ArrayKind{
+                .arrayType = RuntimeType::RealArrayType,
+                .elementType = RuntimeType::RealType,
+                .newArray = OpCode::FNewArray,
+                .literal = OpCode::FArrayLiteral,
+                .get = OpCode::FIndexGet,
+                .set = OpCode::FIndexSet,
+                .getUnchecked = OpCode::FIndexGetUnchecked,
+                .setUnchecked = OpCode::FIndexSetUnchecked,
+                .intrinsic = OpCode::FArrayIntrinsic},
+            ArrayKind{
+                .arrayType = RuntimeType::BoolArrayType,
+                .elementType = RuntimeType::BoolType,
+                .newArray = OpCode::BNewArray,
+                .literal = OpCode::BArrayLiteral,
+                .get = OpCode::BIndexGet,
+                .set = OpCode::BIndexSet,
+                .getUnchecked = OpCode::BIndexGetUnchecked,
+                .setUnchecked = OpCode::BIndexSetUnchecked,
+                .intrinsic = {}},
+        };
+        return kinds;
+    }
+
+    const BytecodeCompiler::ArrayKind *BytecodeCompiler::findArrayKind(const RuntimeType &arrayType) {
+        auto it = std::ranges::find(arrayKinds(), arrayType, &ArrayKind::arrayType);
+        return it != arrayKinds().end() ? &*it : nullptr;
+    }
+
+    const BytecodeCompiler::ArrayKind *BytecodeCompiler::findArrayKindForElement(const RuntimeType &elementType) {
+        auto it = std::ranges::find(arrayKinds(), elementType, &ArrayKind::elementType);
+        return it != arrayKinds().end() ? &*it : nullptr;
     }
 
     void BytecodeCompiler::emitConstant(const Value &value, int line) {
-        emit(OpCode::Constant, makeConstant(value), line);
+        int constant = makeConstant(value);
+        if (constant <= std::numeric_limits<std::uint8_t>::max()) {
+            emit(OpCode::Constant, static_cast<std::uint8_t>(constant), line);
+        } else {
+            emit(OpCode::ConstantLong, static_cast<std::uint16_t>(constant), line);
+        }
     }
 
-    std::uint8_t BytecodeCompiler::makeConstant(const Value &value) {
-        std::uint8_t constant = m_chunk.addConstant(value);
-        if (m_chunk.constantPool().size() > std::numeric_limits<std::uint8_t>::max()) {
+    int BytecodeCompiler::makeConstant(const Value &value) {
+        int constant = m_chunk.addConstant(value);
+        if (constant > std::numeric_limits<std::uint16_t>::max()) {
             throw CompileException("Too many constants in one chunk.");
         }
         return constant;
     }
 
-    Value BytecodeCompiler::parseNumericLiteral(const NumberExpression &numExpr) {
-        std::string lexeme{numExpr.value().lexeme};
-        std::erase(lexeme, '_');
+    std::string BytecodeCompiler::parseStringLiteral(const StringExpression &stringExpr) {
+        // the lexer has already checked that the literal is quoted and that its escape sequences are valid
+        const std::string &lexeme = stringExpr.value().lexeme;
+        std::string result;
+        for (std::size_t i = 1; i + 1 < lexeme.size(); i++) {
+            if (lexeme[i] != '\\') {
+                result += lexeme[i];
+                continue;
+            }
+            switch (lexeme[++i]) {
+            case '0': result += '\0'; break;
+            case 't': result += '\t'; break;
+            case 'n': result += '\n'; break;
+            case 'r': result += '\r'; break;
+            default: result += lexeme[i]; break;
+            }
+        }
+        return result;
+    }
+
+    Value BytecodeCompiler::parseNumericLiteral(const NumberExpression &numExpr) const {
+        // underscores only separate digits, so the lexeme is only copied if there are any to remove
+        const Token &token = numExpr.value();
+        std::string_view literal = token.lexeme;
+        std::string withoutUnderscores;
+        if (literal.find('_') != std::string_view::npos) {
+            withoutUnderscores = literal;
+            std::erase(withoutUnderscores, '_');
+            literal = withoutUnderscores;
+        }
+        return numExpr.isIntLiteral() ? parseIntegerLiteral(token, literal) : parseRealLiteral(token, literal);
+    }
 
-        std::istringstream stream{lexeme};
-        if (numExpr.isIntLiteral()) {
-            std::int64_t result;
-            if (stream >> result && stream.eof()) {
-                return Value{result};
+    Value BytecodeCompiler::parseIntegerLiteral(const Token &token, std::string_view literal) const {
+        // "0b" on its own is the Byte 0 rather than a binary prefix without any digits
+        int base = 10;
+        if (literal.size() > 2) {
+            if (literal.starts_with("0x")) {
+                base = 16;
+            } else if (literal.starts_with("0b")) {
+                base = 2;
+            } else if (literal.starts_with("0o")) {
+                base = 8;
             }
-        } else {
-            double result;
-            if (stream >> result && stream.eof()) {
-                return Value{result};
+        }
+        if (base != 10) {
+            literal.remove_prefix(2);
+        }
+
+        // Int is 64 bits wide, just like Long, so only the narrower suffixes limit the range
+        std::int64_t min = std::numeric_limits<std::int64_t>::min();
+        std::int64_t max = std::numeric_limits<std::int64_t>::max();
+        if (literal.ends_with('b')) {
+            min = std::numeric_limits<std::int8_t>::min();
+            max = std::numeric_limits<std::int8_t>::max();
+        } else if (literal.ends_with('s')) {
+            min = std::numeric_limits<std::int16_t>::min();
+            max = std::numeric_limits<std::int16_t>::max();
+        }
+        if (literal.ends_with('b') || literal.ends_with('s') || literal.ends_with('i') || literal.ends_with('L')) {
+            literal.remove_suffix(1);
+        }
+
+        // from_chars accepts a sign and lowercase hexadecimal digits, neither of which a literal may contain,
+        // and stops at the first digit that is too large for the base instead of rejecting it
+        auto isDigit = [base](char ch) {
+            if (base == 16) {
+                return (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'F');
             }
+            return ch >= '0' && ch < '0' + base;
+        };
+        if (literal.empty() || !std::ranges::all_of(literal, isDigit)) {
+            throw makeError<CompileError::InvalidLiteral>(token, "integer literal");
         }
 
-        std::string literalType = numExpr.isIntLiteral() ? "integer" : "real";
-        if (!stream.eof()) {
-            throw CompileException(std::format("could not parse {} literal: unexpected suffix", literalType));
+        const char *last = literal.data() + literal.size();
+        std::int64_t result;
+        auto [end, error] = std::from_chars(literal.data(), last, result, base);
+        if (error == std::errc::result_out_of_range || (error == std::errc{} && (result < min || result > max))) {
+            throw makeError<CompileError::LiteralOutOfRange>(token, "integer literal");
+        } else if (error != std::errc{} || end != last) {
+            throw makeError<CompileError::InvalidLiteral>(token, "integer literal");
+        }
+        return Value{result};
+    }
+
+    Value BytecodeCompiler::parseRealLiteral(const Token &token, std::string_view literal) const {
+        bool isFloat = literal.ends_with('f');
+        if (isFloat || literal.ends_with('d')) {
+            literal.remove_suffix(1);
+        }
+
+        const char *first = literal.data();
+        const char *last = literal.data() + literal.size();
+        double result;
+        std::from_chars_result parsed;
+        if (isFloat) {
+            // a Float literal is rounded to single precision, just as it would be when stored in a Float
+            float single;
+            parsed = std::from_chars(first, last, single, std::chars_format::fixed | std::chars_format::scientific);
+            result = single;
         } else {
-            throw CompileException(std::format("could not parse {} literal", literalType));
+            parsed = std::from_chars(first, last, result, std::chars_format::fixed | std::chars_format::scientific);
+        }
+
+        if (parsed.ec == std::errc::result_out_of_range) {
+            throw makeError<CompileError::LiteralOutOfRange>(token, "real literal");
+        } else if (parsed.ec != std::errc{} || parsed.ptr != last) {
+            throw makeError<CompileError::InvalidLiteral>(token, "real literal");
         }
+        return Value{result};
     }
 }
@@ -5,53 +5,263 @@
 #include "../Statement.h"
 #include "Chunk.h"
 #include "CompileError.h"
+#include "NativeRegistry.h"
+#include "Program.h"
 
 #include <memory>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 
 namespace ferrit {
     class BytecodeCompiler final : private StatementVisitor, private ExpressionVisitor {
     public:
-        explicit BytecodeCompiler(std::shared_ptr<const ErrorReporter> errorReporter);
+        /**
+         * Constructs a compiler.
+         *
+         * @param errorReporter reports errors in the code, or null to not report them
+         * @param nativeRegistry the functions that <tt>native fun</tt> declarations refer to, or
+         *        null if programs cannot call any. It must outlive the compiler.
+         */
+        explicit BytecodeCompiler(std::shared_ptr<const ErrorReporter> errorReporter,
+            const NativeRegistry *nativeRegistry = nullptr);
 
-        std::optional<Chunk> compile(const std::vector<StatementPtr> &ast);
+        std::optional<Program> compile(const std::vector<StatementPtr> &ast);
+
+        /**
+         * Writes a C++ header that declares every native function of a program, with the types that
+         * its implementation takes and returns. The functions need not have been registered yet.
+         *
+         * @return the header, or nothing if a native function has a type that native code cannot use
+         */
+        std::optional<std::string> emitNativeHeader(const std::vector<StatementPtr> &ast);
+
+        /**
+         * Whether a range loop was turned into a vector loop, and if not, why.
+         */
+        struct VectorizationRemark {
+            int line;
+            /** The reason that the loop was not vectorized, or nothing if it was. */
+            std::optional<std::string> missedReason;
+        };
+
+        /**
+         * Returns a remark for every range loop in the last program compiled, in source order.
+         */
+        [[nodiscard]] const std::vector<VectorizationRemark> &vectorizationRemarks() const noexcept;
 
     private:
-        Chunk tryCompile(const std::vector<StatementPtr> &ast);
+        struct FunctionSignature;
+        struct ArrayKind;
+        struct IoBuiltin;
+
+        Program tryCompile(const std::vector<StatementPtr> &ast);
+        void declareFunction(const FunctionDeclaration &funDecl);
+        int declareNativeFunction(const FunctionDeclaration &funDecl, const FunctionSignature &signature);
+        std::string nativeDeclaration(const FunctionDeclaration &funDecl) const;
+        static std::string functionTypeName(const std::vector<RuntimeType> &parameters, const RuntimeType &returnType);
+        void compileFunctionBody(const FunctionDeclaration &funDecl, const RuntimeType &returnType);
+        static bool alwaysReturns(const Statement &stmt);
+        void compileReturnValue(const Expression &value, const Token &errorToken, int line);
+        RuntimeType compileCall(const CallExpression &callExpr, bool isTailCall);
+        void compileArguments(const CallExpression &callExpr, const FunctionSignature &signature);
+        RuntimeType compileSpawn(const Expression &entry, int line);
+        RuntimeType compileFork(const Expression &entry, int line);
+        RuntimeType compileParallelMap(const CallExpression &callExpr, int line);
+        RuntimeType compileArrayIntrinsic(const CallExpression &callExpr, ArrayIntrinsic intrinsic, int line);
+        static std::optional<ArrayIntrinsic> findArrayIntrinsic(const std::string &name);
+        RuntimeType compileIo(const CallExpression &callExpr, const IoBuiltin &builtin, int line);
+        static const IoBuiltin *findIoBuiltin(const std::string &name);
+        [[nodiscard]] const FunctionSignature *findSignature(const CallExpression &callExpr) const;
+        RuntimeType compileInlineCall(const FunctionSignature &signature, int line);
+        static const Expression *findInlineBody(const FunctionDeclaration &funDecl);
+        static std::optional<int> inlineCost(const Expression &expr);
+        [[nodiscard]] std::optional<int> findBoundingArray(const RangeExpression &range) const;
+        [[nodiscard]] bool isProvenInBounds(const IndexExpression &indexExpr) const;
+        std::optional<std::string> vectorizeLoop(const ForStatement &forStmt, VectorLoop &loop) const;
+        std::optional<std::string> vectorizeOperand(
+            const Expression &expr, const Token &index, const ArrayKind &kind, std::vector<VectorInstruction> &code) const;
 
         VisitResult visitFunctionDecl(const FunctionDeclaration &funDecl) override;
+        VisitResult visitVariableDecl(const VariableDeclaration &varDecl) override;
         VisitResult visitConditionalStmt(const ConditionalStatement &conditionalStmt) override;
+        VisitResult visitWhileStmt(const WhileStatement &whileStmt) override;
+        VisitResult visitForStmt(const ForStatement &forStmt) override;
         VisitResult visitBlockStmt(const BlockStatement &blockStmt) override;
+        VisitResult visitReturnStmt(const ReturnStatement &returnStmt) override;
         VisitResult visitExpressionStmt(const ExpressionStatement &exprStmt) override;
 
+        VisitResult visitAssignmentExpr(const AssignmentExpression &assignExpr) override;
+        VisitResult visitIndexAssignmentExpr(const IndexAssignmentExpression &assignExpr) override;
         VisitResult visitBinaryExpr(const BinaryExpression &binExpr) override;
         VisitResult visitComparisonExpr(const ComparisonExpression &cmpExpr) override;
+        VisitResult visitRangeExpr(const RangeExpression &rangeExpr) override;
         VisitResult visitUnaryExpr(const UnaryExpression &unaryExpr) override;
         VisitResult visitCallExpr(const CallExpression &callExpr) override;
+        VisitResult visitIndexExpr(const IndexExpression &indexExpr) override;
+        VisitResult visitPropertyExpr(const PropertyExpression &propertyExpr) override;
         VisitResult visitVariableExpr(const VariableExpression &varExpr) override;
         VisitResult visitNumberExpr(const NumberExpression &numExpr) override;
         VisitResult visitBoolExpr(const BooleanExpression &boolExpr) override;
+        VisitResult visitStringExpr(const StringExpression &stringExpr) override;
+        VisitResult visitArrayExpr(const ArrayExpression &arrayExpr) override;
 
     private:
         void emit(OpCode opCode, int line);
         void emit(OpCode opCode, std::uint8_t arg, int line);
+        void emit(OpCode opCode, std::uint16_t arg, int line);
+        void emit(OpCode opCode, std::uint16_t arg1, std::uint16_t arg2, int line);
+        [[nodiscard]] int stackEffect(OpCode opCode, int arg) const;
+
+        [[nodiscard]] int emitJump(OpCode jumpOp, int line);
+        [[nodiscard]] int emitConditionalJump(const Expression &condition, const std::string &context, int line);
+        void patchJump(int jump);
+        void emitLoop(OpCode loopOp, int loopStart, int line);
 
-        [[nodiscard]] int emitJump(bool isConditionalJump, int line);
-        void patchJump(int jumpOpOffset);
+        void beginScope();
+        void endScope(int line);
+        void compileScoped(const Statement &body, int line);
+        int declareLocal(const Token &name, const RuntimeType &type, bool isMutable);
+        int resolveLocal(const Token &name) const;
+        RuntimeType resolveDeclaredType(const DeclaredType &declaredType) const;
+
+        void relaxBranches();
+        void widenBranch(std::size_t index);
+        void insertBytes(int offset, int count);
+        static std::optional<OpCode> getLongJumpOpCode(OpCode jumpOp);
+        static OpCode invertIntJumpOpCode(OpCode jumpOp);
+
+        OpCode getComparisonOpCode(
+            const ComparisonExpression &cmpExpr, const RuntimeType &leftType, const RuntimeType &rightType) const;
+        static OpCode getInvertedIntJumpOpCode(TokenType comparison);
+        static const std::vector<ArrayKind> &arrayKinds();
+        static const ArrayKind *findArrayKind(const RuntimeType &arrayType);
+        static const ArrayKind *findArrayKindForElement(const RuntimeType &elementType);
 
         void emitConstant(const Value &value, int line);
-        std::uint8_t makeConstant(const Value &value);
+        int makeConstant(const Value &value);
 
         template <typename Err, typename... Args>
         requires std::derived_from<Err, Error> && std::constructible_from<Err, Token, Args...>
         Err makeError(const Token &cause, Args&&... args) const;
 
-        static Value parseNumericLiteral(const NumberExpression &numExpr);
+        Value parseNumericLiteral(const NumberExpression &numExpr) const;
+        Value parseIntegerLiteral(const Token &token, std::string_view literal) const;
+        Value parseRealLiteral(const Token &token, std::string_view literal) const;
+        static std::string parseStringLiteral(const StringExpression &stringExpr);
 
     private:
+        /**
+         * A jump or loop instruction whose offset is not known until the whole chunk
+         * has been emitted. Every branch starts out in its short form and is only
+         * widened to its long form if its target turns out to be out of range.
+         */
+        struct Branch {
+            /** Offset of the branch instruction in the chunk. */
+            int offset;
+            /** Absolute offset of the branch target, or -1 if not yet patched. */
+            int target;
+            bool isBackward;
+            bool isLong;
+
+            [[nodiscard]] int size() const noexcept;
+            [[nodiscard]] int distance() const noexcept;
+        };
+
+        /**
+         * A local variable. Locals are resolved to stack slots at compile time:
+         * the local at index n of <tt>m_locals</tt> always lives in slot n.
+         */
+        struct Local {
+            Token name;
+            RuntimeType type;
+            bool isMutable;
+            int depth;
+        };
+
+        /**
+         * The signature of a function, which is known before any function bodies are compiled
+         * so that functions may be called before they are declared.
+         */
+        struct FunctionSignature {
+            /** Index of the function in the program, or -1 for native functions. */
+            int index;
+            /** Index of the native function in the program, or -1 for functions with bytecode. */
+            int nativeIndex;
+            std::vector<RuntimeType> parameters;
+            RuntimeType returnType;
+            /** The function's declaration, which must outlive the compiler. */
+            const FunctionDeclaration *declaration;
+            /** The expression that calls to this function are replaced with, or null if it is not inlined. */
+            const Expression *inlineBody;
+        };
+
+        /**
+         * The operation and signature of a built-in function that reads, writes or waits.
+         */
+        struct IoBuiltin {
+            IoOperation operation;
+            std::vector<RuntimeType> parameters;
+            RuntimeType returnType;
+        };
+
+        /**
+         * The runtime type and instructions for arrays of one element type.
+         */
+        struct ArrayKind {
+            RuntimeType arrayType;
+            RuntimeType elementType;
+            OpCode newArray;
+            OpCode literal;
+            OpCode get;
+            OpCode set;
+            OpCode getUnchecked;
+            OpCode setUnchecked;
+            /** The instruction that runs bulk operations on these arrays, or nothing if they have none. */
+            std::optional<OpCode> intrinsic;
+        };
+
+        /**
+         * A loop variable that is always a valid index into an array, because the loop counts
+         * up from a non-negative constant to the array's size. The array's local is immutable
+         * and arrays never change size, so this holds for the whole body of the loop.
+         */
+        struct BoundedIndex {
+            int indexSlot;
+            int arraySlot;
+        };
+
+        /**
+         * The maximum number of AST nodes in the body of a function that is inlined at its call sites.
+         */
+        static constexpr int INLINE_BUDGET = 16;
+
         std::shared_ptr<const ErrorReporter> m_errorReporter;
+        const NativeRegistry *m_nativeRegistry;
+        std::vector<Function> m_functions{};
+        std::vector<NativeFunction> m_nativeFunctions{};
+        std::unordered_map<std::string, FunctionSignature> m_signatures{};
+        /** Return type of the function being compiled, or empty while compiling the top-level script. */
+        std::optional<RuntimeType> m_returnType{};
+
+        // state of the function currently being compiled
         Chunk m_chunk{};
+        std::vector<Branch> m_branches{};
+        std::vector<Local> m_locals{};
+        int m_scopeDepth{0};
+        /** Loop variables of the enclosing loops whose array accesses need no bounds check. */
+        std::vector<BoundedIndex> m_boundedIndices{};
+        /** Locals below this slot belong to the caller of an inlined function, and are not visible to it. */
+        std::size_t m_firstVisibleLocal{0};
+        /**
+         * The number of values on the stack of the function being compiled, including its locals.
+         * Every instruction goes through emit(), which keeps this up to date.
+         */
+        int m_stackDepth{0};
+
+        std::vector<VectorizationRemark> m_vectorizationRemarks{};
     };
 
     template <typename Err, typename... Args>
@@ -1,6 +1,8 @@
 #include "BytecodeInterpreter.h"
 #include "Disassembler.h"
 
+#include <format>
+
 namespace ferrit {
     BytecodeInterpreter::BytecodeInterpreter() noexcept :
         Interpreter() {
@@ -21,15 +23,34 @@ namespace ferrit {
             return InterpretResult::ParseError;
         }
 
-        auto chunk = m_compiler.compile(ast.value());
-        if (!chunk.has_value()) {
+        if (m_options.emitNativeHeaders) {
+            auto header = m_compiler.emitNativeHeader(ast.value());
+            if (!header.has_value()) {
+                return InterpretResult::CompileError;
+            }
+            *m_output << *header;
+            return InterpretResult::Ok;
+        }
+
+        auto program = m_compiler.compile(ast.value());
+        if (!program.has_value()) {
             return InterpretResult::CompileError;
         }
 
+        if (m_options.reportVectorization) {
+            for (const auto &remark : m_compiler.vectorizationRemarks()) {
+                if (remark.missedReason) {
+                    *m_errors << std::format("line {}: loop not vectorized: {}\n", remark.line, *remark.missedReason);
+                } else {
+                    *m_errors << std::format("line {}: loop vectorized\n", remark.line);
+                }
+            }
+        }
+
         //TODO: add a compiler flag for disassembly only
         if (m_options.traceVm) {
             Disassembler debug{*m_output};
-            debug.disassembleChunk(*chunk, "<main>");
+            debug.disassembleProgram(*program);
             *m_output << "\n";
         }
 
@@ -37,7 +58,7 @@ namespace ferrit {
         // none of them are caught since it indicates a bug
         // in the compiler. Therefore, the program should crash
         // with an "internal compiler error".
-        m_vm.interpret(chunk.value());
+        m_vm.interpret(program.value());
 
         // TODO: add a way for ferrit programs to return a value and check for runtime errors
         return InterpretResult::Ok;
@@ -1,6 +1,8 @@
 #include "Chunk.h"
 
+#include <algorithm>
 #include <stdexcept>
+#include <utility>
 
 namespace ferrit {
     void Chunk::writeInstruction(OpCode opCode, int line) {
@@ -28,8 +30,20 @@ namespace ferrit {
         addLineInfo(line);
     }
 
+    void Chunk::writeInstruction(OpCode opCode, std::uint16_t arg1, std::uint16_t arg2, int line) {
+        writeInstruction(opCode, arg1, line);
+
+        writeRaw(static_cast<std::uint8_t>((arg2 >> 8) & 0xFF));
+        addLineInfo(line);
+
+        writeRaw(static_cast<std::uint8_t>(arg2 & 0xFF));
+        addLineInfo(line);
+    }
+
     void Chunk::patchByte(int offset, std::uint8_t arg) {
-        if (offset > m_bytecode.size())
+        if (offset < 0 || offset >= size()) {
+            throw std::out_of_range("attempted to patch byte outside of chunk");
+        }
         m_bytecode[offset] = arg;
     }
 
@@ -38,6 +52,35 @@ namespace ferrit {
         m_bytecode[offset + 1] = arg & 0xFF;
     }
 
+    void Chunk::patchInt(int offset, std::uint32_t arg) {
+        m_bytecode[offset] = (arg >> 24) & 0xFF;
+        m_bytecode[offset + 1] = (arg >> 16) & 0xFF;
+        m_bytecode[offset + 2] = (arg >> 8) & 0xFF;
+        m_bytecode[offset + 3] = arg & 0xFF;
+    }
+
+    void Chunk::insertBytes(int offset, int count) {
+        if (offset <= 0 || offset > size()) {
+            throw std::out_of_range("attempted to insert bytes outside of chunk");
+        }
+        m_bytecode.insert(m_bytecode.begin() + offset, count, 0);
+
+        int onePastCurrentOffset = 0;
+        for (auto &lineInfo : m_lines) {
+            onePastCurrentOffset += lineInfo.run;
+            if (offset - 1 < onePastCurrentOffset) {
+                lineInfo.run += count;
+                break;
+            }
+        }
+
+        for (int &loopHeader : m_loopHeaders) {
+            if (loopHeader >= offset) {
+                loopHeader += count;
+            }
+        }
+    }
+
     std::uint8_t Chunk::byteAt(int offset) const {
         return m_bytecode[offset];
     }
@@ -48,19 +91,57 @@ namespace ferrit {
         return (hiByte << 8) | loByte;
     }
 
+    std::uint32_t Chunk::intAt(int offset) const {
+        return (static_cast<std::uint32_t>(m_bytecode[offset]) << 24) |
+            (static_cast<std::uint32_t>(m_bytecode[offset + 1]) << 16) |
+            (static_cast<std::uint32_t>(m_bytecode[offset + 2]) << 8) |
+            static_cast<std::uint32_t>(m_bytecode[offset + 3]);
+    }
+
     int Chunk::size() const noexcept {
         return static_cast<int>(m_bytecode.size());
     }
 
-    std::uint8_t Chunk::addConstant(Value value) {
+    int Chunk::addConstant(Value value) {
         m_constantPool.push_back(value);
-        return static_cast<std::uint8_t>(m_constantPool.size() - 1);
+        return static_cast<int>(m_constantPool.size() - 1);
     }
 
     const std::vector<Value> &Chunk::constantPool() const noexcept {
         return m_constantPool;
     }
 
+    int Chunk::addString(const std::string &string) {
+        auto it = std::ranges::find(m_stringPool, string);
+        if (it != m_stringPool.end()) {
+            return static_cast<int>(it - m_stringPool.begin());
+        }
+        m_stringPool.push_back(string);
+        return static_cast<int>(m_stringPool.size() - 1);
+    }
+
+    const std::vector<std::string> &Chunk::stringPool() const noexcept {
+        return m_stringPool;
+    }
+
+    std::uint16_t Chunk::addLoopHeader(int offset) {
+        m_loopHeaders.push_back(offset);
+        return static_cast<std::uint16_t>(m_loopHeaders.size() - 1);
+    }
+
+    const std::vector<int> &Chunk::loopHeaders() const noexcept {
+        return m_loopHeaders;
+    }
+
+    std::uint16_t Chunk::addVectorLoop(VectorLoop loop) {
+        m_vectorLoops.push_back(std::move(loop));
+        return static_cast<std::uint16_t>(m_vectorLoops.size() - 1);
+    }
+
+    const std::vector<VectorLoop> &Chunk::vectorLoops() const noexcept {
+        return m_vectorLoops;
+    }
+
     void Chunk::writeRaw(std::uint8_t byte) {
         m_bytecode.push_back(byte);
     }
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "Value.h"
+#include "VectorLoop.h"
 
 
 namespace ferrit {
@@ -13,27 +15,168 @@ namespace ferrit {
     enum class OpCode {
         NoOp,
         Constant,
+        ConstantLong,
+        // Pushes an interned string literal from the chunk's string pool (u16 index).
+        String,
         Pop,
+        GetLocal,
+        SetLocal,
         IAdd,
         ISubtract,
         IMultiply,
         IDivide,
         IModulus,
         INegate,
+        IEqual,
+        INotEqual,
+        ILess,
+        ILessEqual,
+        IGreater,
+        IGreaterEqual,
         FAdd,
         FSubtract,
         FMultiply,
         FDivide,
         FModulus,
         FNegate,
+        FEqual,
+        FNotEqual,
+        FLess,
+        FLessEqual,
+        FGreater,
+        FGreaterEqual,
         BAnd,
         BOr,
         BNot,
         BEqual,
         BNotEqual,
+        SConcat,
+        SEqual,
+        SNotEqual,
+        // Pops a length and a fill value, and pushes a new array of that length with every element set to the value.
+        INewArray,
+        FNewArray,
+        BNewArray,
+        // Pops the given number of values (u16 count) and pushes a new array holding them, in order.
+        IArrayLiteral,
+        FArrayLiteral,
+        BArrayLiteral,
+        ArrayLength,
+        // Typed element access: get pops an array and an index, set pops an array, an index and a value
+        // but leaves the value on the stack. Both panic if the index is out of bounds.
+        IIndexGet,
+        IIndexSet,
+        FIndexGet,
+        FIndexSet,
+        BIndexGet,
+        BIndexSet,
+        // Element access whose bounds check the compiler has proven redundant.
+        IIndexGetUnchecked,
+        IIndexSetUnchecked,
+        FIndexGetUnchecked,
+        FIndexSetUnchecked,
+        BIndexGetUnchecked,
+        BIndexSetUnchecked,
+        // Runs a bulk operation on Int or Real arrays (u8 ArrayIntrinsic), popping its arguments and pushing its result.
+        IArrayIntrinsic,
+        FArrayIntrinsic,
         Return,
+        Call,
+        // Calls a function by reusing the current frame. Only emitted in tail position.
+        TailCall,
+        // Calls a native function (u16 native function index), replacing its arguments with its result.
+        CallNative,
+        Print,
+        // Pops the arguments of a function (u16 function index), and pushes a new fiber that calls it with them.
+        Spawn,
+        // Suspends the current fiber, which pushes null once it continues.
+        Yield,
+        // Pops a fiber and runs it until it yields or finishes, then pushes whether it can be resumed again.
+        Resume,
+        // Pops the arguments of a function (u16 function index), and pushes a task that calls it on another thread.
+        Fork,
+        // Pops a task and pushes its result once it has finished.
+        Join,
+        // Pops an array and pushes the result of calling a function (u16 function index) on each element, in parallel.
+        ParallelMap,
+        // Runs an operation on a file or timer (u8 IoOperation), which may suspend the fiber until it finishes.
+        Io,
         Jump,
         JumpIfFalse,
+        JumpLong,
+        JumpIfFalseLong,
+        // Fused integer compare-and-branch: pops two integers and jumps if the comparison holds.
+        IJumpIfEqual,
+        IJumpIfNotEqual,
+        IJumpIfLess,
+        IJumpIfLessEqual,
+        IJumpIfGreater,
+        IJumpIfGreaterEqual,
+        // Backward jumps: the first operand is the distance to jump back, the second is the loop's index.
+        Loop,
+        ForRangeIntPrep,
+        ForRangeIntInclusivePrep,
+        ForRangeInt,
+        // Runs a whole range loop at once (u16 vector loop index), with the range's start and end on
+        // top of the stack. If it ran, the start is moved past the end, so that the prep skips the
+        // compiled loop that follows; otherwise that loop runs as usual.
+        VectorLoop,
+        // Long variants of the above, with a 32-bit offset instead of a 16-bit one.
+        LoopLong,
+        ForRangeIntPrepLong,
+        ForRangeIntInclusivePrepLong,
+        ForRangeIntLong,
+    };
+
+    /**
+     * The bulk array operations that the array intrinsic instructions can run, which is their operand.
+     */
+    enum class ArrayIntrinsic : std::uint8_t {
+        // Pop an array and push one of its elements.
+        Sum,
+        Min,
+        Max,
+        // Pop two arrays and push their dot product.
+        Dot,
+        // Pop two arrays and push a new array holding the element-wise result.
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        // Pop an array and a value, and set every element to the value.
+        Fill,
+        // Pop a source and a destination array, and copy the source into the start of the destination.
+        Copy,
+        // Pop an array and a value, and push the index of the first element equal to it, or -1.
+        IndexOf,
+    };
+
+    /**
+     * The operations on files and timers that the I/O instruction runs, which is its operand.
+     * Operations that wait for the event loop run the instruction again once it has made progress.
+     */
+    enum class IoOperation : std::uint8_t {
+        // Pop a path, and push the file it names, opened for reading or created for writing.
+        OpenFile,
+        CreateFile,
+        // Pop a file and push its next line, without the line break.
+        ReadLine,
+        // Pop a file and push whether all of it has been read.
+        IsAtEnd,
+        // Pop a file and a string, write the string to the file, and push null.
+        Write,
+        // Pop a file, close it, and push null.
+        Close,
+        // Pop a number of milliseconds, and push null once they have passed.
+        Sleep,
+        // Push the next line of standard input.
+        ReadStandardInput,
+        // Pop a path, and push the file it names, mapped into memory.
+        MapFile,
+        // Pop a mapped file and push whether it has a line left to read.
+        HasNextLine,
+        // Pop a mapped file and push its next line, as a slice of the mapping.
+        NextLine,
     };
 
     /**
@@ -69,6 +212,16 @@ namespace ferrit {
          */
         void writeInstruction(OpCode opCode, std::uint16_t arg, int line);
 
+        /**
+         * Write the given instruction and its two arguments to the chunk.
+         *
+         * @param opCode the instruction's opcode
+         * @param arg1 the first argument
+         * @param arg2 the second argument
+         * @param line the line that the instruction was generated on
+         */
+        void writeInstruction(OpCode opCode, std::uint16_t arg1, std::uint16_t arg2, int line);
+
         /**
          * This function is deleted to prevent unintentional coercion of a
          * byte argument to a line number.
@@ -85,6 +238,20 @@ namespace ferrit {
          */
         void patchShort(int offset, std::uint16_t arg);
 
+        /**
+         * Overwrites the 32-bit integer at the specified index.
+         */
+        void patchInt(int offset, std::uint32_t arg);
+
+        /**
+         * Inserts zeroed bytes before the specified index. The new bytes share the
+         * line of the preceding byte, and loop headers at or after the index are moved.
+         *
+         * @param offset index at which to insert the bytes
+         * @param count number of bytes to insert
+         */
+        void insertBytes(int offset, int count);
+
         /**
          * Returns the byte at the specified offset.
          */
@@ -96,6 +263,11 @@ namespace ferrit {
          */
         [[nodiscard]] std::uint16_t shortAt(int offset) const;
 
+        /**
+         * Returns the 32-bit integer at the specified offset.
+         */
+        [[nodiscard]] std::uint32_t intAt(int offset) const;
+
         /**
          * Returns the number of bytes in this chunk's bytecode.
          */
@@ -107,10 +279,46 @@ namespace ferrit {
          * @param value the value to add
          * @return index of the newly added constant
          */
-        std::uint8_t addConstant(Value value);
+        int addConstant(Value value);
 
         [[nodiscard]] const std::vector<Value> &constantPool() const noexcept;
 
+        /**
+         * Adds the given string literal to the string pool, unless it is already there. Strings are
+         * kept apart from other constants because they are only turned into heap objects when the
+         * program is loaded, at which point every literal is interned.
+         *
+         * @param string the contents of the literal
+         * @return index of the string in the pool
+         */
+        int addString(const std::string &string);
+
+        [[nodiscard]] const std::vector<std::string> &stringPool() const noexcept;
+
+        /**
+         * Registers a loop whose header (the first instruction of each iteration)
+         * is located at the given offset.
+         *
+         * @param offset the byte offset of the loop header
+         * @return index of the newly added loop
+         */
+        std::uint16_t addLoopHeader(int offset);
+
+        /**
+         * Returns the offset of every loop header in this chunk, indexed by loop index.
+         */
+        [[nodiscard]] const std::vector<int> &loopHeaders() const noexcept;
+
+        /**
+         * Adds a loop that the VectorLoop instruction can run.
+         *
+         * @param loop the loop to add
+         * @return index of the newly added loop
+         */
+        std::uint16_t addVectorLoop(VectorLoop loop);
+
+        [[nodiscard]] const std::vector<VectorLoop> &vectorLoops() const noexcept;
+
         /**
          * Retrieves the line information for the given offset.
          *
@@ -149,5 +357,8 @@ namespace ferrit {
         std::vector<std::uint8_t> m_bytecode{};
         std::vector<LineInfo> m_lines{};
         std::vector<Value> m_constantPool{};
+        std::vector<std::string> m_stringPool{};
+        std::vector<int> m_loopHeaders{};
+        std::vector<VectorLoop> m_vectorLoops{};
     };
 }
\ No newline at end of file
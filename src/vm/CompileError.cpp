@@ -11,6 +11,10 @@ namespace ferrit {
         CompileError{std::move(cause), std::format("{} out of range", literalType)} {
     }
 
+    CompileError::InvalidLiteral::InvalidLiteral(Token cause, const std::string &literalType) :
+        CompileError{cause, std::format("invalid {} '{}'", literalType, cause.lexeme)} {
+    }
+
     CompileError::IncompatibleTypes::IncompatibleTypes(
         Token cause, const std::string &operation, const std::vector<std::string> &types) :
         CompileError{std::move(cause), std::format("incompatible type(s) for {}: {}", operation, formatTypes(types))} { }
@@ -27,4 +31,38 @@ namespace ferrit {
         }
         return result;
     }
+
+    CompileError::UndefinedVariable::UndefinedVariable(Token cause) :
+        CompileError{cause, std::format("undefined variable '{}'", cause.lexeme)} {
+    }
+
+    CompileError::Redeclaration::Redeclaration(Token cause) :
+        CompileError{cause, std::format("variable '{}' is already declared in this scope", cause.lexeme)} {
+    }
+
+    CompileError::ImmutableAssignment::ImmutableAssignment(Token cause, const std::string &name) :
+        CompileError{std::move(cause), std::format("cannot assign to immutable variable '{}'", name)} {
+    }
+
+    CompileError::TooManyLocals::TooManyLocals(Token cause, int limit) :
+        CompileError{std::move(cause), std::format("more than {} local variables in scope", limit)} {
+    }
+
+    CompileError::UndefinedFunction::UndefinedFunction(Token cause) :
+        CompileError{cause, std::format("undefined function '{}'", cause.lexeme)} {
+    }
+
+    CompileError::ArgumentCount::ArgumentCount(
+        Token cause, const std::string &function, int expected, int actual) :
+        CompileError{std::move(cause),
+            std::format("function '{}' expects {} argument(s), but {} were given", function, expected, actual)} {
+    }
+
+    CompileError::MissingReturn::MissingReturn(Token cause) :
+        CompileError{cause, std::format("function '{}' does not return a value on every path", cause.lexeme)} {
+    }
+
+    CompileError::ReturnOutsideFunction::ReturnOutsideFunction(Token cause) :
+        CompileError{std::move(cause), "'return' outside of a function"} {
+    }
 }
\ No newline at end of file
@@ -25,7 +25,16 @@ namespace ferrit {
     public:
         class NotImplemented;
         class LiteralOutOfRange;
+        class InvalidLiteral;
         class IncompatibleTypes;
+        class UndefinedVariable;
+        class Redeclaration;
+        class ImmutableAssignment;
+        class TooManyLocals;
+        class UndefinedFunction;
+        class ArgumentCount;
+        class MissingReturn;
+        class ReturnOutsideFunction;
 
     protected:
         using Error::Error;
@@ -49,6 +58,15 @@ namespace ferrit {
         FERRIT_ERROR_PRETTY_NAME("literal-out-of-range");
     };
 
+    /**
+     * Indicates that the given literal is malformed, such as a digit that its base does not allow.
+     */
+    class CompileError::InvalidLiteral final : public CompileError {
+    public:
+        explicit InvalidLiteral(Token cause, const std::string &literalType);
+        FERRIT_ERROR_PRETTY_NAME("invalid-literal");
+    };
+
     class CompileError::IncompatibleTypes final : public CompileError {
     public:
         explicit IncompatibleTypes(Token cause, const std::string &operation, const std::vector<std::string>& types);
@@ -57,4 +75,76 @@ namespace ferrit {
     private:
         static std::string formatTypes(const std::vector<std::string>& types) noexcept;
     };
+
+    /**
+     * Indicates that a variable was used without being declared in any enclosing scope.
+     */
+    class CompileError::UndefinedVariable final : public CompileError {
+    public:
+        explicit UndefinedVariable(Token cause);
+        FERRIT_ERROR_PRETTY_NAME("undefined-variable");
+    };
+
+    /**
+     * Indicates that a variable was declared twice in the same scope.
+     */
+    class CompileError::Redeclaration final : public CompileError {
+    public:
+        explicit Redeclaration(Token cause);
+        FERRIT_ERROR_PRETTY_NAME("redeclaration");
+    };
+
+    /**
+     * Indicates that a variable declared with 'val' was reassigned.
+     */
+    class CompileError::ImmutableAssignment final : public CompileError {
+    public:
+        explicit ImmutableAssignment(Token cause, const std::string &name);
+        FERRIT_ERROR_PRETTY_NAME("immutable-assignment");
+    };
+
+    /**
+     * Indicates that more local variables are live at once than fit in a stack frame.
+     */
+    class CompileError::TooManyLocals final : public CompileError {
+    public:
+        explicit TooManyLocals(Token cause, int limit);
+        FERRIT_ERROR_PRETTY_NAME("too-many-locals");
+    };
+
+    /**
+     * Indicates that a function was called without being declared.
+     */
+    class CompileError::UndefinedFunction final : public CompileError {
+    public:
+        explicit UndefinedFunction(Token cause);
+        FERRIT_ERROR_PRETTY_NAME("undefined-function");
+    };
+
+    /**
+     * Indicates that a function was called with the wrong number of arguments.
+     */
+    class CompileError::ArgumentCount final : public CompileError {
+    public:
+        explicit ArgumentCount(Token cause, const std::string &function, int expected, int actual);
+        FERRIT_ERROR_PRETTY_NAME("argument-count");
+    };
+
+    /**
+     * Indicates that a function with a return type may finish without returning a value.
+     */
+    class CompileError::MissingReturn final : public CompileError {
+    public:
+        explicit MissingReturn(Token cause);
+        FERRIT_ERROR_PRETTY_NAME("missing-return");
+    };
+
+    /**
+     * Indicates that a return statement was used outside of a function.
+     */
+    class CompileError::ReturnOutsideFunction final : public CompileError {
+    public:
+        explicit ReturnOutsideFunction(Token cause);
+        FERRIT_ERROR_PRETTY_NAME("return-outside-function");
+    };
 }
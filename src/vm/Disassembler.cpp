@@ -16,6 +16,17 @@ namespace ferrit {
         }
     }
 
+    void Disassembler::disassembleProgram(const Program &program) {
+        bool isFirst = true;
+        for (const auto &function : program.functions()) {
+            if (!isFirst) {
+                m_output << "\n";
+            }
+            disassembleChunk(function.chunk, function.name);
+            isFirst = false;
+        }
+    }
+
     int Disassembler::disassembleInstruction(const Chunk &chunk, int offset) {
         m_output << std::format("${:04X} ", offset);
 
@@ -31,9 +42,17 @@ namespace ferrit {
         case OpCode::NoOp:
             return simpleInstruction("nop", offset);
         case OpCode::Constant:
-            return constantInstruction("const", chunk, offset);
+            return constantInstruction("const", chunk, offset, false);
+        case OpCode::ConstantLong:
+            return constantInstruction("const.l", chunk, offset, true);
+        case OpCode::String:
+            return stringInstruction("str", chunk, offset);
         case OpCode::Pop:
             return simpleInstruction("pop", offset);
+        case OpCode::GetLocal:
+            return byteInstruction("getlocal", chunk, offset);
+        case OpCode::SetLocal:
+            return byteInstruction("setlocal", chunk, offset);
         case OpCode::IAdd:
             return simpleInstruction("iadd", offset);
         case OpCode::ISubtract:
@@ -46,6 +65,18 @@ namespace ferrit {
             return simpleInstruction("imod", offset);
         case OpCode::INegate:
             return simpleInstruction("ineg", offset);
+        case OpCode::IEqual:
+            return simpleInstruction("ieq", offset);
+        case OpCode::INotEqual:
+            return simpleInstruction("ine", offset);
+        case OpCode::ILess:
+            return simpleInstruction("ilt", offset);
+        case OpCode::ILessEqual:
+            return simpleInstruction("ile", offset);
+        case OpCode::IGreater:
+            return simpleInstruction("igt", offset);
+        case OpCode::IGreaterEqual:
+            return simpleInstruction("ige", offset);
         case OpCode::FAdd:
             return simpleInstruction("fadd", offset);
         case OpCode::FSubtract:
@@ -58,6 +89,18 @@ namespace ferrit {
             return simpleInstruction("fmod", offset);
         case OpCode::FNegate:
             return simpleInstruction("fneg", offset);
+        case OpCode::FEqual:
+            return simpleInstruction("feq", offset);
+        case OpCode::FNotEqual:
+            return simpleInstruction("fne", offset);
+        case OpCode::FLess:
+            return simpleInstruction("flt", offset);
+        case OpCode::FLessEqual:
+            return simpleInstruction("fle", offset);
+        case OpCode::FGreater:
+            return simpleInstruction("fgt", offset);
+        case OpCode::FGreaterEqual:
+            return simpleInstruction("fge", offset);
         case OpCode::BAnd:
             return simpleInstruction("band", offset);
         case OpCode::BOr:
@@ -68,12 +111,116 @@ namespace ferrit {
             return simpleInstruction("beq", offset);
         case OpCode::BNotEqual:
             return simpleInstruction("bne", offset);
+        case OpCode::SConcat:
+            return simpleInstruction("sconcat", offset);
+        case OpCode::SEqual:
+            return simpleInstruction("seq", offset);
+        case OpCode::SNotEqual:
+            return simpleInstruction("sne", offset);
+        case OpCode::INewArray:
+            return simpleInstruction("inewarr", offset);
+        case OpCode::FNewArray:
+            return simpleInstruction("fnewarr", offset);
+        case OpCode::BNewArray:
+            return simpleInstruction("bnewarr", offset);
+        case OpCode::IArrayLiteral:
+            return shortInstruction("iarrlit", chunk, offset);
+        case OpCode::FArrayLiteral:
+            return shortInstruction("farrlit", chunk, offset);
+        case OpCode::BArrayLiteral:
+            return shortInstruction("barrlit", chunk, offset);
+        case OpCode::ArrayLength:
+            return simpleInstruction("arrlen", offset);
+        case OpCode::IIndexGet:
+            return simpleInstruction("iidxget", offset);
+        case OpCode::IIndexSet:
+            return simpleInstruction("iidxset", offset);
+        case OpCode::FIndexGet:
+            return simpleInstruction("fidxget", offset);
+        case OpCode::FIndexSet:
+            return simpleInstruction("fidxset", offset);
+        case OpCode::BIndexGet:
+            return simpleInstruction("bidxget", offset);
+        case OpCode::BIndexSet:
+            return simpleInstruction("bidxset", offset);
+        case OpCode::IIndexGetUnchecked:
+            return simpleInstruction("iidxget.u", offset);
+        case OpCode::IIndexSetUnchecked:
+            return simpleInstruction("iidxset.u", offset);
+        case OpCode::FIndexGetUnchecked:
+            return simpleInstruction("fidxget.u", offset);
+        case OpCode::FIndexSetUnchecked:
+            return simpleInstruction("fidxset.u", offset);
+        case OpCode::BIndexGetUnchecked:
+            return simpleInstruction("bidxget.u", offset);
+        case OpCode::BIndexSetUnchecked:
+            return simpleInstruction("bidxset.u", offset);
+        case OpCode::IArrayIntrinsic:
+            return intrinsicInstruction("iarrop", chunk, offset);
+        case OpCode::FArrayIntrinsic:
+            return intrinsicInstruction("farrop", chunk, offset);
         case OpCode::Return:
             return simpleInstruction("ret", offset);
+        case OpCode::Call:
+            return shortInstruction("call", chunk, offset);
+        case OpCode::TailCall:
+            return shortInstruction("tailcall", chunk, offset);
+        case OpCode::CallNative:
+            return shortInstruction("callnative", chunk, offset);
+        case OpCode::Print:
+            return simpleInstruction("print", offset);
+        case OpCode::Spawn:
+            return shortInstruction("spawn", chunk, offset);
+        case OpCode::Yield:
+            return simpleInstruction("yield", offset);
+        case OpCode::Resume:
+            return simpleInstruction("resume", offset);
+        case OpCode::Fork:
+            return shortInstruction("fork", chunk, offset);
+        case OpCode::Join:
+            return simpleInstruction("join", offset);
+        case OpCode::ParallelMap:
+            return shortInstruction("parmap", chunk, offset);
+        case OpCode::Io:
+            return ioInstruction("io", chunk, offset);
         case OpCode::Jump:
-            return jumpInstruction("jmp", chunk, offset);
+            return jumpInstruction("jmp", chunk, offset, false);
         case OpCode::JumpIfFalse:
-            return jumpInstruction("jmpfalse", chunk, offset);
+            return jumpInstruction("jmpfalse", chunk, offset, false);
+        case OpCode::JumpLong:
+            return jumpInstruction("jmp.l", chunk, offset, true);
+        case OpCode::JumpIfFalseLong:
+            return jumpInstruction("jmpfalse.l", chunk, offset, true);
+        case OpCode::IJumpIfEqual:
+            return jumpInstruction("jmpieq", chunk, offset, false);
+        case OpCode::IJumpIfNotEqual:
+            return jumpInstruction("jmpine", chunk, offset, false);
+        case OpCode::IJumpIfLess:
+            return jumpInstruction("jmpilt", chunk, offset, false);
+        case OpCode::IJumpIfLessEqual:
+            return jumpInstruction("jmpile", chunk, offset, false);
+        case OpCode::IJumpIfGreater:
+            return jumpInstruction("jmpigt", chunk, offset, false);
+        case OpCode::IJumpIfGreaterEqual:
+            return jumpInstruction("jmpige", chunk, offset, false);
+        case OpCode::Loop:
+            return loopInstruction("loop", chunk, offset, false);
+        case OpCode::ForRangeIntPrep:
+            return jumpInstruction("forprep", chunk, offset, false);
+        case OpCode::ForRangeIntInclusivePrep:
+            return jumpInstruction("forprepi", chunk, offset, false);
+        case OpCode::ForRangeInt:
+            return loopInstruction("forloop", chunk, offset, false);
+        case OpCode::VectorLoop:
+            return shortInstruction("vecloop", chunk, offset);
+        case OpCode::LoopLong:
+            return loopInstruction("loop.l", chunk, offset, true);
+        case OpCode::ForRangeIntPrepLong:
+            return jumpInstruction("forprep.l", chunk, offset, true);
+        case OpCode::ForRangeIntInclusivePrepLong:
+            return jumpInstruction("forprepi.l", chunk, offset, true);
+        case OpCode::ForRangeIntLong:
+            return loopInstruction("forloop.l", chunk, offset, true);
         default:
             m_output << std::format("Unknown opcode {}\n", instruction);
             return offset + 1;
@@ -85,21 +232,158 @@ namespace ferrit {
         return offset + 1;
     }
 
-    int Disassembler::constantInstruction(const std::string &name, const Chunk &chunk, int offset) {
-        std::uint8_t constantIdx = chunk.byteAt(offset + 1);
+    int Disassembler::constantInstruction(const std::string &name, const Chunk &chunk, int offset, bool isLong) {
+        std::uint16_t constantIdx = isLong ? chunk.shortAt(offset + 1) : chunk.byteAt(offset + 1);
         if (constantIdx >= chunk.constantPool().size()) {
             throw std::logic_error("constant index too big");
         }
 
         Value constant = chunk.constantPool()[constantIdx];
         m_output << std::format("{:11} {:4}  // Constant {}\n", name, constantIdx, constant);
+        return isLong ? offset + 3 : offset + 2;
+    }
+
+    int Disassembler::stringInstruction(const std::string &name, const Chunk &chunk, int offset) {
+        std::uint16_t stringIdx = chunk.shortAt(offset + 1);
+        if (stringIdx >= chunk.stringPool().size()) {
+            throw std::logic_error("string index too big");
+        }
+
+        m_output << std::format("{:11} {:4}  // String \"{}\"\n", name, stringIdx, chunk.stringPool()[stringIdx]);
+        return offset + 3;
+    }
+
+    int Disassembler::byteInstruction(const std::string &name, const Chunk &chunk, int offset) {
+        std::uint8_t operand = chunk.byteAt(offset + 1);
+        m_output << std::format("{:11} {:4}\n", name, operand);
+        return offset + 2;
+    }
+
+    int Disassembler::shortInstruction(const std::string &name, const Chunk &chunk, int offset) {
+        std::uint16_t operand = chunk.shortAt(offset + 1);
+        m_output << std::format("{:11} {:4}\n", name, operand);
+        return offset + 3;
+    }
+
+    int Disassembler::intrinsicInstruction(const std::string &name, const Chunk &chunk, int offset) {
+        std::uint8_t operand = chunk.byteAt(offset + 1);
+        std::string intrinsic;
+        switch (static_cast<ArrayIntrinsic>(operand)) {
+        case ArrayIntrinsic::Sum:
+            intrinsic = "sum";
+            break;
+        case ArrayIntrinsic::Min:
+            intrinsic = "min";
+            break;
+        case ArrayIntrinsic::Max:
+            intrinsic = "max";
+            break;
+        case ArrayIntrinsic::Dot:
+            intrinsic = "dot";
+            break;
+        case ArrayIntrinsic::Add:
+            intrinsic = "add";
+            break;
+        case ArrayIntrinsic::Subtract:
+            intrinsic = "subtract";
+            break;
+        case ArrayIntrinsic::Multiply:
+            intrinsic = "multiply";
+            break;
+        case ArrayIntrinsic::Divide:
+            intrinsic = "divide";
+            break;
+        case ArrayIntrinsic::Fill:
+            intrinsic = "fill";
+            break;
+        case ArrayIntrinsic::Copy:
+            intrinsic = "copy";
+            break;
+        case ArrayIntrinsic::IndexOf:
+            intrinsic = "indexOf";
+            break;
+        default:
+            intrinsic = "unknown";
+            break;
+        }
+        m_output << std::format("{:11} {:4}  // {}\n", name, operand, intrinsic);
+        return offset + 2;
+    }
+
+    int Disassembler::ioInstruction(const std::string &name, const Chunk &chunk, int offset) {
+        std::uint8_t operand = chunk.byteAt(offset + 1);
+        std::string operation;
+        switch (static_cast<IoOperation>(operand)) {
+        case IoOperation::OpenFile:
+            operation = "openFile";
+            break;
+        case IoOperation::CreateFile:
+            operation = "createFile";
+            break;
+        case IoOperation::ReadLine:
+            operation = "readLine";
+            break;
+        case IoOperation::IsAtEnd:
+            operation = "isAtEnd";
+            break;
+        case IoOperation::Write:
+            operation = "write";
+            break;
+        case IoOperation::Close:
+            operation = "close";
+            break;
+        case IoOperation::Sleep:
+            operation = "sleep";
+            break;
+        case IoOperation::ReadStandardInput:
+            operation = "readln";
+            break;
+        case IoOperation::MapFile:
+            operation = "mapFile";
+            break;
+        case IoOperation::HasNextLine:
+            operation = "hasNextLine";
+            break;
+        case IoOperation::NextLine:
+            operation = "nextLine";
+            break;
+        default:
+            operation = "unknown";
+            break;
+        }
+        m_output << std::format("{:11} {:4}  // {}\n", name, operand, operation);
         return offset + 2;
     }
 
-    int Disassembler::jumpInstruction(const std::string &name, const Chunk &chunk, int offset) {
+    int Disassembler::jumpInstruction(const std::string &name, const Chunk &chunk, int offset, bool isLong) {
+        // jumps are relative to the end of the jump instruction
+        if (isLong) {
+            std::uint32_t relativeOffset = chunk.intAt(offset + 1);
+            m_output << std::format("{:10} ${:08X}  // Absolute offset ${:04X}\n",
+                name, relativeOffset, offset + 5 + relativeOffset);
+            return offset + 5;
+        }
+
         int relativeOffset = chunk.shortAt(offset + 1);
         m_output << std::format("{:10} ${:04X}  // Absolute offset ${:04X}\n",
-            name, relativeOffset, offset + relativeOffset);
+            name, relativeOffset, offset + 3 + relativeOffset);
         return offset + 3;
     }
+
+    int Disassembler::loopInstruction(const std::string &name, const Chunk &chunk, int offset, bool isLong) {
+        // loops jump backwards from the end of the instruction
+        if (isLong) {
+            std::uint32_t relativeOffset = chunk.intAt(offset + 1);
+            int loopIndex = chunk.shortAt(offset + 5);
+            m_output << std::format("{:10} ${:08X}  // Absolute offset ${:04X}, loop #{}\n",
+                name, relativeOffset, offset + 7 - static_cast<int>(relativeOffset), loopIndex);
+            return offset + 7;
+        }
+
+        int relativeOffset = chunk.shortAt(offset + 1);
+        int loopIndex = chunk.shortAt(offset + 3);
+        m_output << std::format("{:10} ${:04X}  // Absolute offset ${:04X}, loop #{}\n",
+            name, relativeOffset, offset + 5 - relativeOffset, loopIndex);
+        return offset + 5;
+    }
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "Chunk.h"
+#include "Program.h"
 
 namespace ferrit {
     /**
@@ -26,6 +27,13 @@ namespace ferrit {
          */
         void disassembleChunk(const Chunk &chunk, const std::string &name);
 
+        /**
+         * Writes the disassembly of every function in the given program to the output stream.
+         *
+         * @param program the program
+         */
+        void disassembleProgram(const Program &program);
+
         /**
          * Writes the disassembled instruction at the given offset to the output stream.
          *
@@ -51,9 +59,60 @@ namespace ferrit {
          * @param name the name to display for the instruction
          * @param chunk the instruction's chunk
          * @param offset the instruction's offset in the chunk
+         * @param isLong whether the constant index is a short rather than a byte
+         * @return the next offset
+         */
+        int constantInstruction(const std::string &name, const Chunk &chunk, int offset, bool isLong);
+
+        /**
+         * Write an instruction that loads a literal from the chunk's string pool.
+         *
+         * @param name the name to display for the instruction
+         * @param chunk the instruction's chunk
+         * @param offset the instruction's offset in the chunk
+         * @return the next offset
+         */
+        int stringInstruction(const std::string &name, const Chunk &chunk, int offset);
+
+        /**
+         * Write an instruction that takes a single byte operand, such as a local's slot.
+         *
+         * @param name the name to display for the instruction
+         * @param chunk the instruction's chunk
+         * @param offset the instruction's offset in the chunk
+         * @return the next offset
+         */
+        int byteInstruction(const std::string &name, const Chunk &chunk, int offset);
+
+        /**
+         * Write an instruction that takes a single short operand, such as a function's index.
+         *
+         * @param name the name to display for the instruction
+         * @param chunk the instruction's chunk
+         * @param offset the instruction's offset in the chunk
+         * @return the next offset
+         */
+        int shortInstruction(const std::string &name, const Chunk &chunk, int offset);
+
+        /**
+         * Write an array intrinsic instruction, along with the name of the operation it runs.
+         *
+         * @param name the name to display for the instruction
+         * @param chunk the instruction's chunk
+         * @param offset the instruction's offset in the chunk
+         * @return the next offset
+         */
+        int intrinsicInstruction(const std::string &name, const Chunk &chunk, int offset);
+
+        /**
+         * Write an I/O instruction, along with the name of the operation it runs.
+         *
+         * @param name the name to display for the instruction
+         * @param chunk the instruction's chunk
+         * @param offset the instruction's offset in the chunk
          * @return the next offset
          */
-        int constantInstruction(const std::string &name, const Chunk &chunk, int offset);
+        int ioInstruction(const std::string &name, const Chunk &chunk, int offset);
 
         /**
          * Write a jump instruction.
@@ -61,9 +120,21 @@ namespace ferrit {
          * @param name the name to display for the instruction
          * @param chunk the instruction's chunk
          * @param offset the instruction's offset in the chunk
+         * @param isLong whether the jump has a 32-bit offset rather than a 16-bit one
+         * @return the next offset
+         */
+        int jumpInstruction(const std::string &name, const Chunk &chunk, int offset, bool isLong);
+
+        /**
+         * Write a backward jump instruction.
+         *
+         * @param name the name to display for the instruction
+         * @param chunk the instruction's chunk
+         * @param offset the instruction's offset in the chunk
+         * @param isLong whether the jump has a 32-bit offset rather than a 16-bit one
          * @return the next offset
          */
-        int jumpInstruction(const std::string &name, const Chunk &chunk, int offset);
+        int loopInstruction(const std::string &name, const Chunk &chunk, int offset, bool isLong);
 
     private:
         std::ostream &m_output;
@@ -0,0 +1,547 @@
+#include "EventLoop.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#define FERRIT_READ(descriptor, buffer, size) _read(descriptor, buffer, static_cast<unsigned>(size))
+#define FERRIT_WRITE(descriptor, buffer, size) _write(descriptor, buffer, static_cast<unsigned>(size))
+#else
+#include <unistd.h>
+#define FERRIT_READ(descriptor, buffer, size) ::read(descriptor, buffer, size)
+#define FERRIT_WRITE(descriptor, buffer, size) ::write(descriptor, buffer, size)
+#endif
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+
+namespace ferrit {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        EventLoop::Completion readNow(int descriptor, std::size_t size, std::uint64_t id) {
+            EventLoop::Completion completion{.id = id, .result = 0, .data = std::string(size, '\0')};
+            long count;
+            do {
+                count = static_cast<long>(FERRIT_READ(descriptor, completion.data.data(), size));
+            } while (count < 0 && errno == EINTR);
+            completion.result = count < 0 ? -errno : count;
+            completion.data.resize(count < 0 ? 0 : static_cast<std::size_t>(count));
+            return completion;
+        }
+
+        EventLoop::Completion writeNow(int descriptor, const std::string &data, std::uint64_t id) {
+            long count;
+            do {
+                count = static_cast<long>(FERRIT_WRITE(descriptor, data.data(), data.size()));
+            } while (count < 0 && errno == EINTR);
+            return EventLoop::Completion{.id = id, .result = count < 0 ? -errno : count, .data = {}};
+        }
+
+        /**
+         * The timers of the loops that wait for them in user space, ordered by when they expire.
+         */
+        class TimerQueue final {
+        public:
+            void start(std::chrono::nanoseconds delay, std::uint64_t id) {
+                m_deadlines.emplace(Clock::now() + delay, id);
+            }
+
+            /**
+             * Completes every timer that has expired.
+             */
+            void expire(std::vector<EventLoop::Completion> &completions) {
+                auto now = Clock::now();
+                while (!m_deadlines.empty() && m_deadlines.begin()->first <= now) {
+                    completions.push_back(EventLoop::Completion{.id = m_deadlines.begin()->second, .result = 0, .data = {}});
+                    m_deadlines.erase(m_deadlines.begin());
+                }
+            }
+
+            /**
+             * Returns how long it is until the next timer expires, or nothing if there are none.
+             */
+            [[nodiscard]] std::optional<std::chrono::nanoseconds> untilNext() const {
+                if (m_deadlines.empty()) {
+                    return {};
+                }
+                return std::max(std::chrono::nanoseconds{0}, m_deadlines.begin()->first - Clock::now());
+            }
+
+            [[nodiscard]] std::size_t size() const noexcept {
+                return m_deadlines.size();
+            }
+
+            void clear() noexcept {
+                m_deadlines.clear();
+            }
+
+        private:
+            std::multimap<Clock::time_point, std::uint64_t> m_deadlines{};
+        };
+
+        class BlockingEventLoop final : public EventLoop {
+        public:
+            [[nodiscard]] Backend backend() const noexcept override {
+                return Backend::Blocking;
+            }
+
+            void read(int descriptor, std::size_t size, std::uint64_t id) override {
+                m_finished.push_back(readNow(descriptor, size, id));
+            }
+
+            void write(int descriptor, std::string data, std::uint64_t id) override {
+                m_finished.push_back(writeNow(descriptor, data, id));
+            }
+
+            void startTimer(std::chrono::nanoseconds delay, std::uint64_t id) override {
+                m_timers.start(delay, id);
+            }
+
+            void poll(bool block, std::vector<Completion> &completions) override {
+                if (block && m_finished.empty()) {
+                    if (auto delay = m_timers.untilNext()) {
+                        std::this_thread::sleep_for(*delay);
+                    }
+                }
+                std::ranges::move(m_finished, std::back_inserter(completions));
+                m_finished.clear();
+                m_timers.expire(completions);
+            }
+
+            void cancelAll() override {
+                m_finished.clear();
+                m_timers.clear();
+            }
+
+            [[nodiscard]] std::size_t pendingCount() const noexcept override {
+                return m_finished.size() + m_timers.size();
+            }
+
+        private:
+            std::vector<Completion> m_finished{};
+            TimerQueue m_timers{};
+        };
+
+#ifdef __linux__
+        class EpollEventLoop final : public EventLoop {
+        public:
+            /**
+             * @return the loop, or null if epoll is not available
+             */
+            static std::unique_ptr<EventLoop> create() {
+                int epoll = epoll_create1(EPOLL_CLOEXEC);
+                if (epoll < 0) {
+                    return nullptr;
+                }
+                return std::unique_ptr<EventLoop>{new EpollEventLoop{epoll}};
+            }
+
+            ~EpollEventLoop() override {
+                close(m_epoll);
+            }
+
+            [[nodiscard]] Backend backend() const noexcept override {
+                return Backend::Epoll;
+            }
+
+            void read(int descriptor, std::size_t size, std::uint64_t id) override {
+                start(descriptor, Operation{.id = id, .isRead = true, .size = size, .data = {}});
+            }
+
+            void write(int descriptor, std::string data, std::uint64_t id) override {
+                start(descriptor, Operation{.id = id, .isRead = false, .size = data.size(), .data = std::move(data)});
+            }
+
+            void startTimer(std::chrono::nanoseconds delay, std::uint64_t id) override {
+                m_timers.start(delay, id);
+            }
+
+            void poll(bool block, std::vector<Completion> &completions) override {
+                std::ranges::move(m_finished, std::back_inserter(completions));
+                bool hasFinished = !m_finished.empty();
+                m_finished.clear();
+
+                int timeout = -1;
+                if (!block || hasFinished) {
+                    timeout = 0;
+                } else if (auto delay = m_timers.untilNext()) {
+                    // rounded up, so that the timer has expired once the wait is over
+                    timeout = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(*delay).count());
+                } else if (m_waitingCount == 0) {
+                    timeout = 0;
+                }
+
+                epoll_event events[MAX_EVENTS];
+                int count = epoll_wait(m_epoll, events, MAX_EVENTS, timeout);
+                for (int i = 0; i < count; i++) {
+                    int descriptor = events[i].data.fd;
+                    auto &waiting = m_waiting[descriptor];
+                    if (waiting.empty()) {
+                        continue;
+                    }
+                    // being ready means that the operation no longer blocks, so it is done right away
+                    Operation operation = std::move(waiting.front());
+                    waiting.pop_front();
+                    m_waitingCount--;
+                    completions.push_back(perform(descriptor, operation));
+                    if (!waiting.empty()) {
+                        arm(descriptor, waiting.front().isRead);
+                    }
+                }
+                m_timers.expire(completions);
+            }
+
+            void cancelAll() override {
+                for (auto &[descriptor, waiting] : m_waiting) {
+                    if (!waiting.empty()) {
+                        epoll_ctl(m_epoll, EPOLL_CTL_DEL, descriptor, nullptr);
+                    }
+                }
+                m_waiting.clear();
+                m_waitingCount = 0;
+                m_finished.clear();
+                m_timers.clear();
+            }
+
+            [[nodiscard]] std::size_t pendingCount() const noexcept override {
+                return m_waitingCount + m_finished.size() + m_timers.size();
+            }
+
+        private:
+            struct Operation {
+                std::uint64_t id;
+                bool isRead;
+                std::size_t size;
+                std::string data;
+            };
+
+            explicit EpollEventLoop(int epoll) noexcept :
+                m_epoll{epoll} {
+            }
+
+            void start(int descriptor, Operation operation) {
+                auto &waiting = m_waiting[descriptor];
+                waiting.push_back(std::move(operation));
+                m_waitingCount++;
+                // operations on the same file wait in line, and only the first one is waited for
+                if (waiting.size() == 1 && !arm(descriptor, waiting.front().isRead)) {
+                    // regular files cannot be waited for, since they are always ready
+                    m_finished.push_back(perform(descriptor, waiting.front()));
+                    waiting.pop_front();
+                    m_waitingCount--;
+                }
+            }
+
+            /**
+             * Waits for the file to become ready once, for reading or for writing.
+             *
+             * @return false if the file cannot be waited for
+             */
+            bool arm(int descriptor, bool isRead) {
+                epoll_event event{};
+                event.events = (isRead ? EPOLLIN : EPOLLOUT) | EPOLLONESHOT;
+                event.data.fd = descriptor;
+                // a file that was waited for before is still registered, unless it has been closed since
+                if (epoll_ctl(m_epoll, EPOLL_CTL_MOD, descriptor, &event) == 0) {
+                    return true;
+                }
+                return errno == ENOENT && epoll_ctl(m_epoll, EPOLL_CTL_ADD, descriptor, &event) == 0;
+            }
+
+            static Completion perform(int descriptor, const Operation &operation) {
+                return operation.isRead
+                    ? readNow(descriptor, operation.size, operation.id)
+                    : writeNow(descriptor, operation.data, operation.id);
+            }
+
+        private:
+            static constexpr int MAX_EVENTS = 64;
+
+            int m_epoll;
+            std::unordered_map<int, std::deque<Operation>> m_waiting{};
+            std::size_t m_waitingCount{0};
+            std::vector<Completion> m_finished{};
+            TimerQueue m_timers{};
+        };
+
+        class IoUringEventLoop final : public EventLoop {
+        public:
+            /**
+             * @return the loop, or null if io_uring is not available, or too old to read from the
+             *         current position of a file
+             */
+            static std::unique_ptr<EventLoop> create() {
+                io_uring_params params{};
+                int ring = static_cast<int>(syscall(__NR_io_uring_setup, ENTRIES, &params));
+                if (ring < 0) {
+                    return nullptr;
+                }
+                if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_RW_CUR_POS)) {
+                    close(ring);
+                    return nullptr;
+                }
+
+                // both queues share one mapping, and the submission entries have another
+                std::size_t ringSize = std::max(
+                    params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                    params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+                void *queues = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+                if (queues == MAP_FAILED) {
+                    close(ring);
+                    return nullptr;
+                }
+                std::size_t entriesSize = params.sq_entries * sizeof(io_uring_sqe);
+                void *entries = mmap(nullptr, entriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+                if (entries == MAP_FAILED) {
+                    munmap(queues, ringSize);
+                    close(ring);
+                    return nullptr;
+                }
+                return std::unique_ptr<EventLoop>{new IoUringEventLoop{ring, params, queues, ringSize, entries, entriesSize}};
+            }
+
+            ~IoUringEventLoop() override {
+                // the kernel may still be writing into the buffers of abandoned reads, so they are
+                // only freed once every operation has finished
+                cancelAll();
+                while (!m_operations.empty()) {
+                    enter(1);
+                    reap(nullptr);
+                }
+                munmap(m_entries, m_entriesSize);
+                munmap(m_queues, m_queuesSize);
+                close(m_ring);
+            }
+
+            [[nodiscard]] Backend backend() const noexcept override {
+                return Backend::IoUring;
+            }
+
+            void read(int descriptor, std::size_t size, std::uint64_t id) override {
+                Operation &operation = m_operations[id];
+                operation.isRead = true;
+                operation.data.resize(size);
+                io_uring_sqe &entry = nextEntry();
+                entry.opcode = IORING_OP_READ;
+                entry.fd = descriptor;
+                entry.addr = reinterpret_cast<std::uint64_t>(operation.data.data());
+                entry.len = static_cast<std::uint32_t>(size);
+                // an offset of -1 reads from the current position, and moves it along
+                entry.off = static_cast<std::uint64_t>(-1);
+                submit(entry, id);
+            }
+
+            void write(int descriptor, std::string data, std::uint64_t id) override {
+                Operation &operation = m_operations[id];
+                operation.data = std::move(data);
+                io_uring_sqe &entry = nextEntry();
+                entry.opcode = IORING_OP_WRITE;
+                entry.fd = descriptor;
+                entry.addr = reinterpret_cast<std::uint64_t>(operation.data.data());
+                entry.len = static_cast<std::uint32_t>(operation.data.size());
+                entry.off = static_cast<std::uint64_t>(-1);
+                submit(entry, id);
+            }
+
+            void startTimer(std::chrono::nanoseconds delay, std::uint64_t id) override {
+                Operation &operation = m_operations[id];
+                operation.isTimer = true;
+                operation.timeout.tv_sec = delay.count() / 1'000'000'000;
+                operation.timeout.tv_nsec = delay.count() % 1'000'000'000;
+                io_uring_sqe &entry = nextEntry();
+                entry.opcode = IORING_OP_TIMEOUT;
+                entry.fd = -1;
+                entry.addr = reinterpret_cast<std::uint64_t>(&operation.timeout);
+                entry.len = 1;
+                submit(entry, id);
+            }
+
+            void poll(bool block, std::vector<Completion> &completions) override {
+                std::size_t reported = completions.size();
+                // completions that are already waiting are reported without blocking
+                enter(0);
+                reap(&completions);
+                if (block && completions.size() == reported && pendingCount() > 0) {
+                    while (completions.size() == reported) {
+                        enter(1);
+                        reap(&completions);
+                    }
+                }
+            }
+
+            void cancelAll() override {
+                for (auto &[id, operation] : m_operations) {
+                    if (operation.isAbandoned) {
+                        continue;
+                    }
+                    operation.isAbandoned = true;
+                    io_uring_sqe &entry = nextEntry();
+                    entry.opcode = IORING_OP_ASYNC_CANCEL;
+                    entry.fd = -1;
+                    entry.addr = id;
+                    submit(entry, CANCEL_ID);
+                }
+                m_abandonedCount = m_operations.size();
+                enter(0);
+            }
+
+            [[nodiscard]] std::size_t pendingCount() const noexcept override {
+                return m_operations.size() - m_abandonedCount;
+            }
+
+        private:
+            struct Operation {
+                /** The buffer that the kernel reads into or writes from, which must stay put until it is done. */
+                std::string data{};
+                __kernel_timespec timeout{};
+                bool isRead{false};
+                bool isTimer{false};
+                bool isAbandoned{false};
+            };
+
+            IoUringEventLoop(int ring, const io_uring_params &params, void *queues, std::size_t queuesSize,
+                void *entries, std::size_t entriesSize) noexcept :
+                m_ring{ring}, m_queues{queues}, m_queuesSize{queuesSize},
+                m_entries{static_cast<io_uring_sqe *>(entries)}, m_entriesSize{entriesSize} {
+                auto *base = static_cast<char *>(queues);
+                m_submissionHead = reinterpret_cast<unsigned *>(base + params.sq_off.head);
+                m_submissionTail = reinterpret_cast<unsigned *>(base + params.sq_off.tail);
+                m_submissionMask = *reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+                m_submissionArray = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+                m_submissionCapacity = params.sq_entries;
+                m_completionHead = reinterpret_cast<unsigned *>(base + params.cq_off.head);
+                m_completionTail = reinterpret_cast<unsigned *>(base + params.cq_off.tail);
+                m_completionMask = *reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+                m_completions = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+            }
+
+            /**
+             * Returns a cleared submission entry at the tail of the queue, making room first if it is full.
+             */
+            io_uring_sqe &nextEntry() {
+                unsigned tail = *m_submissionTail;
+                while (tail - std::atomic_ref{*m_submissionHead}.load(std::memory_order_acquire) >= m_submissionCapacity) {
+                    enter(0);
+                }
+                io_uring_sqe &entry = m_entries[tail & m_submissionMask];
+                std::memset(&entry, 0, sizeof(entry));
+                return entry;
+            }
+
+            /**
+             * Publishes the entry returned by <tt>nextEntry</tt>. The kernel only sees it on the next enter.
+             */
+            void submit(io_uring_sqe &entry, std::uint64_t id) {
+                entry.user_data = id;
+                unsigned tail = *m_submissionTail;
+                m_submissionArray[tail & m_submissionMask] = tail & m_submissionMask;
+                std::atomic_ref{*m_submissionTail}.store(tail + 1, std::memory_order_release);
+                m_unsubmittedCount++;
+            }
+
+            /**
+             * Hands the queued entries to the kernel, and waits for the given number of completions.
+             */
+            void enter(unsigned minComplete) {
+                if (m_unsubmittedCount == 0 && minComplete == 0) {
+                    return;
+                }
+                unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+                long submitted = syscall(__NR_io_uring_enter, m_ring, m_unsubmittedCount, minComplete, flags, nullptr, 0);
+                if (submitted >= 0) {
+                    m_unsubmittedCount -= static_cast<unsigned>(submitted);
+                }
+                // a wait interrupted by a signal is retried by the caller, since it reaps nothing new
+            }
+
+            /**
+             * Takes every entry off the completion queue, and reports those that were not abandoned.
+             */
+            void reap(std::vector<Completion> *completions) {
+                unsigned head = *m_completionHead;
+                unsigned tail = std::atomic_ref{*m_completionTail}.load(std::memory_order_acquire);
+                for (; head != tail; head++) {
+                    const io_uring_cqe &entry = m_completions[head & m_completionMask];
+                    auto it = m_operations.find(entry.user_data);
+                    if (it == m_operations.end()) {
+                        // the completion of a cancellation
+                        continue;
+                    }
+                    if (it->second.isAbandoned) {
+                        m_abandonedCount--;
+                    } else if (completions) {
+                        Completion completion{.id = entry.user_data, .result = entry.res, .data = {}};
+                        if (it->second.isTimer) {
+                            // a timeout that expires reports that as an error
+                            completion.result = entry.res == -ETIME ? 0 : entry.res;
+                        } else if (it->second.isRead && entry.res > 0) {
+                            completion.data = std::move(it->second.data);
+                            completion.data.resize(static_cast<std::size_t>(entry.res));
+                        }
+                        completions->push_back(std::move(completion));
+                    }
+                    m_operations.erase(it);
+                }
+                std::atomic_ref{*m_completionHead}.store(head, std::memory_order_release);
+            }
+
+        private:
+            static constexpr unsigned ENTRIES = 256;
+            /** The id of cancellation requests, which no other operation uses. */
+            static constexpr std::uint64_t CANCEL_ID = ~std::uint64_t{0};
+
+            int m_ring;
+            void *m_queues;
+            std::size_t m_queuesSize;
+            io_uring_sqe *m_entries;
+            std::size_t m_entriesSize;
+            unsigned *m_submissionHead;
+            unsigned *m_submissionTail;
+            unsigned m_submissionMask;
+            unsigned *m_submissionArray;
+            unsigned m_submissionCapacity;
+            unsigned *m_completionHead;
+            unsigned *m_completionTail;
+            unsigned m_completionMask;
+            io_uring_cqe *m_completions;
+            unsigned m_unsubmittedCount{0};
+            /** Every operation that the kernel has not completed yet, by id. Its nodes never move. */
+            std::unordered_map<std::uint64_t, Operation> m_operations{};
+            std::size_t m_abandonedCount{0};
+        };
+#endif
+    }
+
+    std::unique_ptr<EventLoop> EventLoop::create(Backend preferred) {
+#ifdef __linux__
+        if (preferred == Backend::IoUring) {
+            if (auto loop = IoUringEventLoop::create()) {
+                return loop;
+            }
+        }
+        if (preferred == Backend::IoUring || preferred == Backend::Epoll) {
+            if (auto loop = EpollEventLoop::create()) {
+                return loop;
+            }
+        }
+#endif
+        return std::make_unique<BlockingEventLoop>();
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace ferrit {
+    /**
+     * Runs I/O and timers in the background on behalf of a VM, so that a fiber waiting for them
+     * can be suspended while others run, rather than blocking the thread.
+     *
+     * Every operation is started with an id, and reports that id in its completion once it is done.
+     * The loop owns the buffers that operations read into and write from, so an operation that has
+     * been abandoned can still finish safely after its caller has moved on.
+     *
+     * Reads and writes use the file's current position, so a file must not have more than one of
+     * them in flight at a time.
+     */
+    class EventLoop {
+    public:
+        enum class Backend : std::uint8_t {
+            // Linux's completion queue, which runs reads and writes of any file in the kernel.
+            IoUring,
+            // Linux's readiness notification. Pipes, terminals and sockets are waited for, but reads
+            // and writes of regular files, which are always ready, happen as soon as they start.
+            Epoll,
+            // Every operation happens as soon as it starts, so waiting for it blocks the thread.
+            // Only timers are waited for in the loop. This is what other systems fall back to.
+            Blocking,
+        };
+
+        struct Completion {
+            std::uint64_t id;
+            /** The number of bytes read or written, or a negated <tt>errno</tt> value if it failed. */
+            std::int64_t result;
+            /** The bytes that were read, if the operation was a successful read. */
+            std::string data;
+        };
+
+        virtual ~EventLoop() = default;
+
+        /**
+         * Creates a loop with the given backend, or with the next one down the list if that is not
+         * supported on this system. The blocking backend is always supported.
+         */
+        [[nodiscard]] static std::unique_ptr<EventLoop> create(Backend preferred = Backend::IoUring);
+
+        [[nodiscard]] virtual Backend backend() const noexcept = 0;
+
+        /**
+         * Starts reading up to the given number of bytes from a file. Reading nothing means the
+         * end of the file has been reached.
+         */
+        virtual void read(int descriptor, std::size_t size, std::uint64_t id) = 0;
+
+        /**
+         * Starts writing the given bytes to a file. Fewer bytes than were given may be written.
+         */
+        virtual void write(int descriptor, std::string data, std::uint64_t id) = 0;
+
+        /**
+         * Starts a timer that completes once the given time has passed.
+         */
+        virtual void startTimer(std::chrono::nanoseconds delay, std::uint64_t id) = 0;
+
+        /**
+         * Adds the operations that have finished since the last poll to the completions.
+         *
+         * @param block whether to wait until at least one operation has finished, if any are pending
+         */
+        virtual void poll(bool block, std::vector<Completion> &completions) = 0;
+
+        /**
+         * Abandons every pending operation. They are never reported, though they may still run.
+         */
+        virtual void cancelAll() = 0;
+
+        /**
+         * Returns the number of operations that have been started and not yet reported or abandoned.
+         */
+        [[nodiscard]] virtual std::size_t pendingCount() const noexcept = 0;
+
+    protected:
+        EventLoop() = default;
+        EventLoop(const EventLoop &) = default;
+        EventLoop &operator=(const EventLoop &) = default;
+    };
+}
@@ -0,0 +1,73 @@
+#include "Fiber.h"
+#include "Heap.h"
+
+
+namespace ferrit {
+    Fiber::Fiber(CallFrame entry) {
+        // stacks start out tiny, since most fibers never call deeply, and grow as needed
+        m_stack.reserve(INITIAL_STACK_SIZE);
+        m_frames.reserve(INITIAL_FRAME_COUNT);
+        m_frames.push_back(entry);
+    }
+
+    void Fiber::setArguments(Heap &heap, std::span<const Value> arguments) {
+        for (const Value &argument : arguments) {
+            heap.writeBarrier(this, Value{}, argument);
+            m_stack.push_back(argument);
+        }
+    }
+
+    void Fiber::trace(Heap &heap) {
+        for (Value &value : m_stack) {
+            heap.trace(value);
+        }
+        heap.trace(m_resumer);
+    }
+
+    RuntimeType Fiber::runtimeType() const {
+        return RuntimeType::FiberType;
+    }
+
+    std::string Fiber::toString() const {
+        return "<fiber>";
+    }
+
+    Fiber::State Fiber::state() const noexcept {
+        return m_state;
+    }
+
+    void Fiber::setState(State state) noexcept {
+        m_state = state;
+    }
+
+    void Fiber::swapStacks(Heap &heap, std::vector<Value> &stack, std::vector<CallFrame> &frames) {
+        for (const Value &value : m_stack) {
+            heap.writeBarrier(this, value, Value{});
+        }
+        m_stack.swap(stack);
+        m_frames.swap(frames);
+        for (const Value &value : m_stack) {
+            heap.writeBarrier(this, Value{}, value);
+        }
+    }
+
+    bool Fiber::hasResumer() const noexcept {
+        return m_hasResumer;
+    }
+
+    const Value &Fiber::resumer() const noexcept {
+        return m_resumer;
+    }
+
+    void Fiber::setResumer(Heap &heap, const Value &resumer) {
+        heap.writeBarrier(this, m_resumer, resumer);
+        m_resumer = resumer;
+        m_hasResumer = true;
+    }
+
+    void Fiber::clearResumer(Heap &heap) {
+        heap.writeBarrier(this, m_resumer, Value{});
+        m_resumer = Value{};
+        m_hasResumer = false;
+    }
+}
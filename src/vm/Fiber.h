@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Object.h"
+#include "Value.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+
+namespace ferrit {
+    class Chunk;
+
+    /**
+     * The state of a single function call.
+     */
+    struct CallFrame {
+        const Chunk *chunk;
+        int ip;
+        /** Index of the frame's first slot in the value stack. Locals are relative to it. */
+        int base;
+        std::uint64_t *loopHitCounts;
+        /** The interned strings for each entry in the chunk's string pool. */
+        const Value *stringLiterals;
+    };
+
+    /**
+     * A green thread: a function call with a value stack and call stack of its own, which runs
+     * until it yields and can later continue from where it left off. Fibers are scheduled
+     * cooperatively by the VM, all on the thread the VM runs on.
+     *
+     * While a fiber runs, its stacks are the VM's stacks, and the fiber itself holds nothing. They
+     * are swapped back into the fiber when it is suspended.
+     */
+    class Fiber final : public Object {
+    public:
+        enum class State : std::uint8_t {
+            // Created or yielded, and waiting to be resumed.
+            Suspended,
+            Running,
+            // Waiting for a fiber that it resumed to yield.
+            Resuming,
+            // Waiting for I/O or a timer to finish.
+            Waiting,
+            Finished,
+        };
+
+        /**
+         * Creates a suspended fiber that calls a function when it first runs. Its arguments are
+         * added once the fiber has been allocated, since allocating may move them.
+         *
+         * @param entry the frame of the call, whose base must be 0
+         */
+        explicit Fiber(CallFrame entry);
+
+        /**
+         * Sets the arguments of the fiber's entry call, which must not have run yet.
+         */
+        void setArguments(Heap &heap, std::span<const Value> arguments);
+
+        void trace(Heap &heap) override;
+        [[nodiscard]] RuntimeType runtimeType() const override;
+        [[nodiscard]] std::string toString() const override;
+
+        [[nodiscard]] State state() const noexcept;
+        void setState(State state) noexcept;
+
+        /**
+         * Exchanges the VM's stacks with the ones saved in this fiber. Since this replaces the
+         * fiber's references, it goes through the write barrier.
+         */
+        void swapStacks(Heap &heap, std::vector<Value> &stack, std::vector<CallFrame> &frames);
+
+        /**
+         * Returns whether the fiber was resumed by another fiber, rather than by the scheduler.
+         * Such a fiber returns to its resumer when it yields or finishes.
+         */
+        [[nodiscard]] bool hasResumer() const noexcept;
+
+        /**
+         * Returns the fiber that resumed this one, or null if that was the main fiber.
+         */
+        [[nodiscard]] const Value &resumer() const noexcept;
+
+        /**
+         * Sets the fiber that this one returns to, which is null for the main fiber.
+         */
+        void setResumer(Heap &heap, const Value &resumer);
+
+        /**
+         * Forgets the resumer, once control has returned to it.
+         */
+        void clearResumer(Heap &heap);
+
+    public:
+        /** The number of values a fiber's stack has room for before it first grows. */
+        static constexpr std::size_t INITIAL_STACK_SIZE = 8;
+        /** The number of frames a fiber's call stack has room for before it first grows. */
+        static constexpr std::size_t INITIAL_FRAME_COUNT = 2;
+
+    private:
+        std::vector<Value> m_stack{};
+        std::vector<CallFrame> m_frames{};
+        Value m_resumer{};
+        bool m_hasResumer{false};
+        State m_state{State::Suspended};
+    };
+}
@@ -0,0 +1,144 @@
+#include "File.h"
+#include "Heap.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#define FERRIT_OPEN(path, flags) _open(path, (flags) | _O_BINARY, _S_IREAD | _S_IWRITE)
+#define FERRIT_CLOSE(descriptor) _close(descriptor)
+#define FERRIT_CLOEXEC 0
+#else
+#include <unistd.h>
+#define FERRIT_OPEN(path, flags) ::open(path, flags, 0644)
+#define FERRIT_CLOSE(descriptor) ::close(descriptor)
+#define FERRIT_CLOEXEC O_CLOEXEC
+#endif
+
+
+namespace ferrit {
+    File::File(int descriptor, std::string path, bool isOwned) noexcept :
+        m_descriptor{descriptor}, m_path{std::move(path)}, m_isOwned{isOwned} {
+    }
+
+    std::optional<int> File::open(const std::string &path, bool isWrite) {
+        int flags = (isWrite ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY) | FERRIT_CLOEXEC;
+        int descriptor = FERRIT_OPEN(path.c_str(), flags);
+        if (descriptor < 0) {
+            return {};
+        }
+        return descriptor;
+    }
+
+    File::File(File &&other) noexcept :
+        Object{std::move(other)},
+        m_descriptor{std::exchange(other.m_descriptor, -1)},
+        m_path{std::move(other.m_path)},
+        m_isOwned{other.m_isOwned},
+        m_holder{other.m_holder},
+        m_isHeld{other.m_isHeld},
+        m_isAtEnd{other.m_isAtEnd},
+        m_error{other.m_error},
+        m_buffer{std::move(other.m_buffer)},
+        m_consumed{other.m_consumed} {
+    }
+
+    File::~File() {
+        // a file that is never closed by the program is closed once it is collected
+        close();
+    }
+
+    void File::trace(Heap &heap) {
+        heap.trace(m_holder);
+    }
+
+    RuntimeType File::runtimeType() const {
+        return RuntimeType::FileType;
+    }
+
+    std::string File::toString() const {
+        return "<file " + m_path + ">";
+    }
+
+    int File::descriptor() const noexcept {
+        return m_descriptor;
+    }
+
+    const std::string &File::path() const noexcept {
+        return m_path;
+    }
+
+    bool File::isOpen() const noexcept {
+        return m_descriptor >= 0;
+    }
+
+    void File::close() noexcept {
+        if (m_descriptor >= 0 && m_isOwned) {
+            FERRIT_CLOSE(m_descriptor);
+        }
+        m_descriptor = -1;
+    }
+
+    bool File::isHeld() const noexcept {
+        return m_isHeld;
+    }
+
+    bool File::isHeldBy(const Value &fiber) const noexcept {
+        return m_isHeld && m_holder == fiber;
+    }
+
+    void File::hold(Heap &heap, const Value &fiber) {
+        heap.writeBarrier(this, m_holder, fiber);
+        m_holder = fiber;
+        m_isHeld = true;
+    }
+
+    void File::release(Heap &heap) {
+        heap.writeBarrier(this, m_holder, Value{});
+        m_holder = Value{};
+        m_isHeld = false;
+    }
+
+    std::optional<std::string> File::takeLine() {
+        std::size_t end = m_buffer.find('\n', m_consumed);
+        if (end == std::string::npos) {
+            if (!m_isAtEnd || !hasBufferedData()) {
+                return {};
+            }
+            end = m_buffer.size();
+        }
+        std::string line = m_buffer.substr(m_consumed, end - m_consumed);
+        // the line break is consumed along with the line, unless this was the last line
+        m_consumed = std::min(end + 1, m_buffer.size());
+        return line;
+    }
+
+    bool File::hasBufferedData() const noexcept {
+        return m_consumed < m_buffer.size();
+    }
+
+    void File::append(const std::string &data) {
+        // drop what has been taken only when more arrives, so taking lines never moves the rest
+        m_buffer.erase(0, m_consumed);
+        m_consumed = 0;
+        m_buffer += data;
+    }
+
+    bool File::isAtEnd() const noexcept {
+        return m_isAtEnd;
+    }
+
+    void File::setAtEnd() noexcept {
+        m_isAtEnd = true;
+    }
+
+    int File::takeError() noexcept {
+        return std::exchange(m_error, 0);
+    }
+
+    void File::setError(int error) noexcept {
+        m_error = error;
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Object.h"
+#include "Value.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+
+namespace ferrit {
+    /**
+     * An open file, which Ferrit programs read and write through the VM's event loop.
+     *
+     * Reads fill a buffer that lines are taken from, so a file is read in large chunks however
+     * short its lines are. Since the loop reads and writes at the file's current position, only
+     * one fiber may use a file at a time. The fiber that starts an operation holds the file until
+     * it has picked up the result, and other fibers wait for it to let go.
+     */
+    class File final : public Object {
+    public:
+        /**
+         * @param descriptor the open file descriptor
+         * @param path the path the file was opened with, for error messages
+         * @param isOwned whether the file is closed along with this object. Standard input is not.
+         */
+        File(int descriptor, std::string path, bool isOwned) noexcept;
+
+        /**
+         * Opens a file for reading, or creates or truncates one for writing.
+         *
+         * @return the descriptor, or nothing if the file could not be opened, with <tt>errno</tt> set
+         */
+        [[nodiscard]] static std::optional<int> open(const std::string &path, bool isWrite);
+
+        // a file moves when it survives a collection, and only the moved object may close it
+        File(File &&other) noexcept;
+        File &operator=(File &&) = delete;
+        ~File() override;
+
+        void trace(Heap &heap) override;
+        [[nodiscard]] RuntimeType runtimeType() const override;
+        [[nodiscard]] std::string toString() const override;
+
+        [[nodiscard]] int descriptor() const noexcept;
+        [[nodiscard]] const std::string &path() const noexcept;
+        [[nodiscard]] bool isOpen() const noexcept;
+        void close() noexcept;
+
+        /**
+         * Returns whether a fiber has started an operation on the file and not picked up its result.
+         */
+        [[nodiscard]] bool isHeld() const noexcept;
+
+        /**
+         * Returns whether the given fiber holds the file.
+         *
+         * @param fiber the fiber, or null for the main fiber
+         */
+        [[nodiscard]] bool isHeldBy(const Value &fiber) const noexcept;
+
+        /**
+         * Makes the given fiber hold the file. Since the file refers to the fiber, this goes through
+         * the write barrier.
+         */
+        void hold(Heap &heap, const Value &fiber);
+        void release(Heap &heap);
+
+        /**
+         * Takes the next line out of the bytes that have been read, without its line break. Once the
+         * end of the file has been reached, the rest of the bytes count as a line.
+         *
+         * @return the line, or nothing if more has to be read to finish it, or if every line has been read
+         */
+        [[nodiscard]] std::optional<std::string> takeLine();
+
+        /**
+         * Returns whether any bytes that have been read are still waiting to be taken.
+         */
+        [[nodiscard]] bool hasBufferedData() const noexcept;
+
+        /**
+         * Adds the bytes of a finished read to the end of the buffer.
+         */
+        void append(const std::string &data);
+
+        /**
+         * Returns whether a read has reached the end of the file.
+         */
+        [[nodiscard]] bool isAtEnd() const noexcept;
+        void setAtEnd() noexcept;
+
+        /**
+         * Returns the <tt>errno</tt> value of the last operation that failed, or 0, and forgets it.
+         */
+        [[nodiscard]] int takeError() noexcept;
+        void setError(int error) noexcept;
+
+    public:
+        /** The number of bytes that each read asks for. */
+        static constexpr std::size_t READ_SIZE = 64 * 1024;
+
+    private:
+        int m_descriptor;
+        std::string m_path;
+        bool m_isOwned;
+        Value m_holder{};
+        bool m_isHeld{false};
+        bool m_isAtEnd{false};
+        int m_error{0};
+        std::string m_buffer{};
+        /** The number of bytes at the start of the buffer that have already been taken. */
+        std::size_t m_consumed{0};
+    };
+}
@@ -0,0 +1,297 @@
+#include "Heap.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+
+namespace ferrit {
+    void PauseHistogram::record(std::chrono::nanoseconds pause) noexcept {
+        auto micros = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(pause).count());
+        std::size_t bucket = micros == 0 ? 0 : static_cast<std::size_t>(std::bit_width(micros) - 1);
+        buckets[std::min(bucket, BUCKET_COUNT - 1)]++;
+        count++;
+        total += pause;
+        longest = std::max(longest, pause);
+    }
+
+    Heap::Heap(std::size_t nurserySize) :
+        m_nursery{std::make_unique<std::byte[]>(alignUp(nurserySize))},
+        m_nurserySize{alignUp(nurserySize)} {
+    }
+
+    Heap::~Heap() {
+        for (std::size_t offset = 0; offset < m_nurseryTop;) {
+            auto *object = reinterpret_cast<Object *>(&m_nursery[offset]);
+            offset += object->m_size;
+            object->~Object();
+        }
+        while (m_oldObjects) {
+            Object *object = std::exchange(m_oldObjects, m_oldObjects->m_next);
+            object->~Object();
+            ::operator delete(object);
+        }
+    }
+
+    void Heap::setRootScanner(RootScanner rootScanner) {
+        m_rootScanner = std::move(rootScanner);
+    }
+
+    void Heap::setPauseBudget(std::chrono::nanoseconds budget) noexcept {
+        m_pauseBudget = budget;
+    }
+
+    void Heap::trace(Value &value) {
+        if (value.isObject()) {
+            Object *object = value.asObjectUnchecked();
+            trace(object);
+            value = Value{object};
+        }
+    }
+
+    void Heap::trace(Object *&object) {
+        switch (m_traceMode) {
+        case TraceMode::Evacuate:
+            evacuate(object);
+            break;
+        case TraceMode::Mark:
+            shade(object);
+            break;
+        case TraceMode::None:
+            throw std::logic_error("objects may only be traced during a collection");
+        }
+    }
+
+    void Heap::collectNursery() {
+        auto start = Clock::now();
+        evacuateNursery();
+        if (m_state == CollectionState::Idle && m_oldSize >= m_majorThreshold) {
+            beginMarking();
+        }
+        // the minor collection counts towards the pause budget
+        stepUntil(start + m_pauseBudget);
+        m_pauses.record(Clock::now() - start);
+    }
+
+    void Heap::startCollection() {
+        auto start = Clock::now();
+        beginMarking();
+        m_pauses.record(Clock::now() - start);
+    }
+
+    void Heap::step() {
+        auto start = Clock::now();
+        stepUntil(start + m_pauseBudget);
+        m_pauses.record(Clock::now() - start);
+    }
+
+    void Heap::collectGarbage() {
+        auto start = Clock::now();
+        // a collection that is already running may miss garbage created since it started
+        if (m_state != CollectionState::Idle) {
+            stepUntil(Clock::time_point::max());
+        }
+        beginMarking();
+        stepUntil(Clock::time_point::max());
+        m_pauses.record(Clock::now() - start);
+    }
+
+    bool Heap::isCollecting() const noexcept {
+        return m_state != CollectionState::Idle;
+    }
+
+    std::size_t Heap::nurseryUsed() const noexcept {
+        return m_nurseryTop;
+    }
+
+    std::size_t Heap::oldGenerationSize() const noexcept {
+        return m_oldSize;
+    }
+
+    std::size_t Heap::minorCollections() const noexcept {
+        return m_minorCollections;
+    }
+
+    std::size_t Heap::majorCollections() const noexcept {
+        return m_majorCollections;
+    }
+
+    const PauseHistogram &Heap::pauseHistogram() const noexcept {
+        return m_pauses;
+    }
+
+    void *Heap::allocateYoung(std::size_t size) {
+        // a few young objects can own far more memory than the nursery holds, which is only
+        // released once they are collected
+        if (m_nurseryTop + size > m_nurserySize || m_nurseryExternalSize > m_nurserySize) {
+            collectNursery();
+        }
+        void *memory = &m_nursery[m_nurseryTop];
+        m_nurseryTop += size;
+        return memory;
+    }
+
+    void *Heap::allocateOld(std::size_t size) {
+        m_oldSize += size;
+        return ::operator new(size);
+    }
+
+    void Heap::releaseUnconstructed(void *memory, std::size_t size, bool isOld) noexcept {
+        if (isOld) {
+            m_oldSize -= size;
+            ::operator delete(memory);
+        } else {
+            // nothing can have been allocated after this object, since its constructor failed
+            m_nurseryTop -= size;
+        }
+    }
+
+    void Heap::addOldObject(Object *object) noexcept {
+        object->m_isOld = true;
+        object->m_isRemembered = false;
+        // objects created while marking are not part of the snapshot, so they must survive it
+        object->m_isMarked = m_state == CollectionState::Marking;
+        object->m_next = m_oldObjects;
+        // the sweeper must not see new objects, which are unmarked
+        if (m_sweepLink == &m_oldObjects) {
+            m_sweepLink = &object->m_next;
+        }
+        m_oldObjects = object;
+    }
+
+    void Heap::evacuateNursery() {
+        m_traceMode = TraceMode::Evacuate;
+        if (m_rootScanner) {
+            m_rootScanner(*this);
+        }
+
+        // remembered objects are old, so they are not moved, but anything young that they refer to is
+        for (Object *object : m_rememberedSet) {
+            object->m_isRemembered = false;
+            object->trace(*this);
+        }
+        m_rememberedSet.clear();
+        while (!m_promotedObjects.empty()) {
+            Object *object = m_promotedObjects.back();
+            m_promotedObjects.pop_back();
+            object->trace(*this);
+        }
+        m_traceMode = TraceMode::None;
+
+        // every survivor has been moved out, so whatever is left in the nursery can be destroyed
+        for (std::size_t offset = 0; offset < m_nurseryTop;) {
+            auto *object = reinterpret_cast<Object *>(&m_nursery[offset]);
+            offset += object->m_size;
+            object->~Object();
+        }
+        m_nurseryTop = 0;
+        m_nurseryExternalSize = 0;
+        m_minorCollections++;
+    }
+
+    void Heap::beginMarking() {
+        if (m_state != CollectionState::Idle) {
+            return;
+        }
+
+        // with an empty nursery, every object in the snapshot is old and will not move while it is marked
+        if (m_nurseryTop > 0) {
+            evacuateNursery();
+        }
+        m_state = CollectionState::Marking;
+        m_traceMode = TraceMode::Mark;
+        if (m_rootScanner) {
+            m_rootScanner(*this);
+        }
+        m_traceMode = TraceMode::None;
+    }
+
+    void Heap::rememberObject(Object *object) {
+        object->m_isRemembered = true;
+        m_rememberedSet.push_back(object);
+    }
+
+    void Heap::evacuate(Object *&object) {
+        if (object->m_isOld) {
+            return;
+        }
+        if (object->m_next) {
+            // already moved by an earlier reference
+            object = object->m_next;
+            return;
+        }
+
+        // survivors are promoted straight into the old generation
+        Object *moved = object->m_relocate(object, allocateOld(object->m_size));
+        moved->m_relocate = object->m_relocate;
+        moved->m_size = object->m_size;
+        addOldObject(moved);
+        m_oldSize += moved->externalSize();
+
+        object->m_next = moved;
+        object = moved;
+        m_promotedObjects.push_back(moved);
+    }
+
+    void Heap::shade(Object *object) {
+        // young objects are never swept, and any old object that they refer to is either
+        // part of the snapshot or newer than it, so neither needs to be marked
+        if (object->m_isOld && !object->m_isMarked) {
+            object->m_isMarked = true;
+            m_greyObjects.push_back(object);
+        }
+    }
+
+    void Heap::stepUntil(Clock::time_point deadline) {
+        // always make some progress, then keep going until the collection is done or out of time
+        do {
+            if (m_state == CollectionState::Marking) {
+                markSome();
+            } else if (m_state == CollectionState::Sweeping) {
+                sweepSome();
+            }
+        } while (m_state != CollectionState::Idle && Clock::now() < deadline);
+    }
+
+    void Heap::markSome() {
+        m_traceMode = TraceMode::Mark;
+        for (int i = 0; i < STEP_GRANULARITY && !m_greyObjects.empty(); i++) {
+            Object *object = m_greyObjects.back();
+            m_greyObjects.pop_back();
+            object->trace(*this);
+        }
+        m_traceMode = TraceMode::None;
+
+        if (m_greyObjects.empty()) {
+            m_state = CollectionState::Sweeping;
+            m_sweepLink = &m_oldObjects;
+        }
+    }
+
+    void Heap::sweepSome() {
+        for (int i = 0; i < STEP_GRANULARITY && *m_sweepLink; i++) {
+            Object *object = *m_sweepLink;
+            if (object->m_isMarked) {
+                object->m_isMarked = false;
+                m_sweepLink = &object->m_next;
+            } else {
+                *m_sweepLink = object->m_next;
+                m_oldSize -= object->m_size + object->externalSize();
+                object->~Object();
+                ::operator delete(object);
+            }
+        }
+
+        if (!*m_sweepLink) {
+            m_sweepLink = nullptr;
+            m_state = CollectionState::Idle;
+            m_majorCollections++;
+            m_majorThreshold = std::max(m_oldSize * 2, MIN_MAJOR_THRESHOLD);
+        }
+    }
+
+    std::size_t Heap::alignUp(std::size_t size) noexcept {
+        constexpr std::size_t alignment = alignof(std::max_align_t);
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+}
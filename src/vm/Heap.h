@@ -0,0 +1,254 @@
+#pragma once
+
+#include "Object.h"
+#include "Value.h"
+
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+namespace ferrit {
+    /**
+     * A histogram of garbage collection pause times. Pauses are counted in power-of-two buckets:
+     * bucket n holds the pauses that took at least 2^n and less than 2^(n+1) microseconds, except
+     * for bucket 0, which also holds every pause shorter than a microsecond.
+     */
+    struct PauseHistogram {
+        static constexpr std::size_t BUCKET_COUNT = 32;
+
+        std::array<std::uint64_t, BUCKET_COUNT> buckets{};
+        std::uint64_t count{0};
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds longest{0};
+
+        void record(std::chrono::nanoseconds pause) noexcept;
+    };
+
+    /**
+     * The garbage-collected heap.
+     *
+     * New objects are bump-allocated in a fixed-size nursery. When the nursery fills up, a minor
+     * collection moves every young object that is still reachable into the old generation and
+     * empties the nursery in one step, so objects that die young cost almost nothing to free.
+     *
+     * The old generation is collected with incremental mark-sweep once it has grown enough since
+     * its last collection. Marking and sweeping are done in small steps, each of which stops as
+     * soon as the pause budget is spent, so pauses do not grow with the size of the heap. A step
+     * is taken after every minor collection, which paces the collector with allocation.
+     *
+     * Marking follows the snapshot-at-the-beginning rule: every object that was reachable when
+     * marking started survives, as does every object created since. This only needs a barrier on
+     * stores into objects, and none on the value stack. Both this and the generational remembered
+     * set are maintained by <tt>writeBarrier</tt>.
+     *
+     * Memory that objects own outside of the heap, as reported by <tt>Object::externalSize</tt>,
+     * counts towards both generations: young objects holding more of it than the nursery's size
+     * force a minor collection, and promoted objects add it to the old generation's size.
+     *
+     * Roots are found precisely by the root scanner, which must call <tt>trace</tt> on every value
+     * that the program can still reach. Since collections move objects, a raw <tt>Object *</tt>
+     * held outside of the roots is only valid until the next allocation.
+     */
+    class Heap final {
+    public:
+        using RootScanner = std::function<void(Heap &)>;
+
+        explicit Heap(std::size_t nurserySize = DEFAULT_NURSERY_SIZE);
+        ~Heap();
+
+        Heap(const Heap &) = delete;
+        Heap &operator=(const Heap &) = delete;
+
+        /**
+         * Sets the function that finds the roots of the object graph.
+         */
+        void setRootScanner(RootScanner rootScanner);
+
+        /**
+         * Sets the longest time that a single incremental collection step may take. A step always
+         * does a small amount of work, so that the collector keeps up even with a budget of zero.
+         */
+        void setPauseBudget(std::chrono::nanoseconds budget) noexcept;
+
+        /**
+         * Allocates a new object, collecting garbage first if the nursery is full. Values passed to
+         * the constructor must not refer to young objects, unless those values are themselves roots.
+         *
+         * @return the new object
+         */
+        template <typename T, typename... Args>
+        requires std::derived_from<T, Object> && std::move_constructible<T>
+        T *allocate(Args&&... args);
+
+        /**
+         * Records that a value stored in an object has been replaced. This must be called on every
+         * store into an object.
+         *
+         * @param owner the object that was modified
+         * @param oldValue the value that was overwritten
+         * @param newValue the value that was stored in its place
+         */
+        void writeBarrier(Object *owner, const Value &oldValue, const Value &newValue);
+
+        /**
+         * Reports a reference to the collector. Must only be called while scanning roots or
+         * tracing an object. The reference is updated if the object it refers to was moved.
+         */
+        void trace(Value &value);
+        void trace(Object *&object);
+
+        /**
+         * Moves all live young objects into the old generation, then takes an incremental step
+         * if the old generation is being collected.
+         */
+        void collectNursery();
+
+        /**
+         * Starts an incremental collection of the old generation, unless one is already running.
+         */
+        void startCollection();
+
+        /**
+         * Does as much of the running incremental collection as fits in the pause budget.
+         */
+        void step();
+
+        /**
+         * Collects all garbage in both generations without stopping, finishing any incremental
+         * collection that is already running first.
+         */
+        void collectGarbage();
+
+        /**
+         * Checks if the object is in the nursery.
+         */
+        [[nodiscard]] static bool isYoung(const Object *object) noexcept;
+
+        [[nodiscard]] bool isCollecting() const noexcept;
+        [[nodiscard]] std::size_t nurseryUsed() const noexcept;
+        [[nodiscard]] std::size_t oldGenerationSize() const noexcept;
+        [[nodiscard]] std::size_t minorCollections() const noexcept;
+        [[nodiscard]] std::size_t majorCollections() const noexcept;
+        [[nodiscard]] const PauseHistogram &pauseHistogram() const noexcept;
+
+    public:
+        static constexpr std::size_t DEFAULT_NURSERY_SIZE = 256 * 1024;
+        /** The old generation is never collected before reaching this size. */
+        static constexpr std::size_t MIN_MAJOR_THRESHOLD = 1024 * 1024;
+        static constexpr std::chrono::nanoseconds DEFAULT_PAUSE_BUDGET = std::chrono::milliseconds{1};
+        /** The number of objects that a step marks or sweeps between checks of the clock. */
+        static constexpr int STEP_GRANULARITY = 64;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        /** How <tt>trace</tt> treats the references it is given. */
+        enum class TraceMode {
+            None,
+            Evacuate,
+            Mark,
+        };
+
+        /** The progress of the incremental collection of the old generation. */
+        enum class CollectionState {
+            Idle,
+            Marking,
+            Sweeping,
+        };
+
+        void *allocateYoung(std::size_t size);
+        void *allocateOld(std::size_t size);
+        void releaseUnconstructed(void *memory, std::size_t size, bool isOld) noexcept;
+        void addOldObject(Object *object) noexcept;
+        void evacuateNursery();
+        void beginMarking();
+        void rememberObject(Object *object);
+        void evacuate(Object *&object);
+        void shade(Object *object);
+        void stepUntil(Clock::time_point deadline);
+        void markSome();
+        void sweepSome();
+
+        static std::size_t alignUp(std::size_t size) noexcept;
+
+    private:
+        std::unique_ptr<std::byte[]> m_nursery;
+        std::size_t m_nurserySize;
+        std::size_t m_nurseryTop{0};
+        /** The memory that young objects own outside of the heap. */
+        std::size_t m_nurseryExternalSize{0};
+
+        /** Intrusive list of old objects, linked through <tt>Object::m_next</tt>. */
+        Object *m_oldObjects{nullptr};
+        std::size_t m_oldSize{0};
+        std::size_t m_majorThreshold{MIN_MAJOR_THRESHOLD};
+
+        /** Old objects that may refer to young objects. */
+        std::vector<Object *> m_rememberedSet{};
+        /** Objects promoted by the current minor collection, whose references have not been traced yet. */
+        std::vector<Object *> m_promotedObjects{};
+        /** Old objects that have been marked, but whose references have not been traced yet. */
+        std::vector<Object *> m_greyObjects{};
+        /** The link to the next object to be swept. */
+        Object **m_sweepLink{nullptr};
+
+        RootScanner m_rootScanner{};
+        TraceMode m_traceMode{TraceMode::None};
+        CollectionState m_state{CollectionState::Idle};
+        std::chrono::nanoseconds m_pauseBudget{DEFAULT_PAUSE_BUDGET};
+
+        std::size_t m_minorCollections{0};
+        std::size_t m_majorCollections{0};
+        PauseHistogram m_pauses{};
+    };
+
+    template <typename T, typename... Args>
+    requires std::derived_from<T, Object> && std::move_constructible<T>
+    T *Heap::allocate(Args&&... args) {
+        std::size_t size = alignUp(sizeof(T));
+        // objects too large for the nursery skip it entirely
+        bool isLarge = size > m_nurserySize / 4;
+        void *memory = isLarge ? allocateOld(size) : allocateYoung(size);
+
+        T *object;
+        try {
+            object = new (memory) T(std::forward<Args>(args)...);
+        } catch (...) {
+            releaseUnconstructed(memory, size, isLarge);
+            throw;
+        }
+        object->m_relocate = [](Object *from, void *to) -> Object * {
+            return new (to) T(std::move(*static_cast<T *>(from)));
+        };
+        object->m_size = static_cast<std::uint32_t>(size);
+        if (isLarge) {
+            addOldObject(object);
+            m_oldSize += object->externalSize();
+        } else {
+            m_nurseryExternalSize += object->externalSize();
+        }
+        return object;
+    }
+
+    inline void Heap::writeBarrier(Object *owner, const Value &oldValue, const Value &newValue) {
+        // the overwritten reference may have been the only path to an object that was reachable
+        // when marking started, so that object must still be marked
+        if (m_state == CollectionState::Marking && oldValue.isObject()) {
+            shade(oldValue.asObjectUnchecked());
+        }
+        if (owner->m_isOld && !owner->m_isRemembered && newValue.isObject() && !newValue.asObjectUnchecked()->m_isOld) {
+            rememberObject(owner);
+        }
+    }
+
+    inline bool Heap::isYoung(const Object *object) noexcept {
+        return !object->m_isOld;
+    }
+}
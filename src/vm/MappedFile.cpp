@@ -0,0 +1,185 @@
+#include "MappedFile.h"
+#include "Heap.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace ferrit {
+    namespace {
+        /**
+         * Maps a whole file read-only, leaving empty files unmapped.
+         *
+         * @return false if the file could not be opened or mapped, with <tt>errno</tt> set
+         */
+        bool mapFile(const std::string &path, const char *&data, std::size_t &size) {
+            data = nullptr;
+            size = 0;
+#ifdef _WIN32
+            HANDLE file = CreateFileA(
+                path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                DWORD error = GetLastError();
+                errno = error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND ? ENOENT : EACCES;
+                return false;
+            }
+            LARGE_INTEGER fileSize;
+            bool isMapped = GetFileSizeEx(file, &fileSize) != 0;
+            if (isMapped && fileSize.QuadPart > 0) {
+                // the view keeps the mapping alive by itself, so neither handle is needed once it exists
+                HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+                if (mapping) {
+                    CloseHandle(mapping);
+                }
+                isMapped = view != nullptr;
+                data = static_cast<const char *>(view);
+                size = static_cast<std::size_t>(fileSize.QuadPart);
+            }
+            CloseHandle(file);
+            if (!isMapped) {
+                errno = ENOMEM;
+            }
+            return isMapped;
+#else
+            int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (descriptor < 0) {
+                return false;
+            }
+            struct stat status{};
+            bool isMapped = fstat(descriptor, &status) == 0;
+            if (isMapped && status.st_size > 0) {
+                size = static_cast<std::size_t>(status.st_size);
+                void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                isMapped = mapping != MAP_FAILED;
+                if (isMapped) {
+                    data = static_cast<const char *>(mapping);
+                    // only a hint, so the file is read just the same if the kernel ignores it
+                    madvise(mapping, size, MADV_SEQUENTIAL);
+                }
+            }
+            // the mapping keeps the file open by itself
+            int error = errno;
+            ::close(descriptor);
+            errno = error;
+            return isMapped;
+#endif
+        }
+
+        void unmapFile(const char *data, std::size_t size) noexcept {
+            if (!data) {
+                return;
+            }
+#ifdef _WIN32
+            (void) size;
+            UnmapViewOfFile(data);
+#else
+            munmap(const_cast<char *>(data), size);
+#endif
+        }
+    }
+
+    LineIterator::LineIterator(std::string_view bytes) noexcept :
+        m_rest{bytes}, m_isAtEnd{bytes.empty()} {
+        findLine();
+    }
+
+    std::string_view LineIterator::operator*() const noexcept {
+        return m_line;
+    }
+
+    LineIterator &LineIterator::operator++() noexcept {
+        // the rest starts with the current line, followed by its line break, if it has one
+        m_rest.remove_prefix(std::min(m_line.size() + 1, m_rest.size()));
+        m_isAtEnd = m_rest.empty();
+        findLine();
+        return *this;
+    }
+
+    LineIterator LineIterator::operator++(int) noexcept {
+        LineIterator previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    void LineIterator::findLine() noexcept {
+        if (m_isAtEnd) {
+            return;
+        }
+        // memchr is vectorized by the C library, which makes it much faster than a loop over the bytes
+        const void *lineBreak = std::memchr(m_rest.data(), '\n', m_rest.size());
+        std::size_t length = lineBreak ? static_cast<std::size_t>(static_cast<const char *>(lineBreak) - m_rest.data())
+            : m_rest.size();
+        m_line = m_rest.substr(0, length);
+    }
+
+    std::optional<MappedFile> MappedFile::open(const std::string &path) {
+        const char *data;
+        std::size_t size;
+        if (!mapFile(path, data, size)) {
+            return {};
+        }
+        return MappedFile{path, data, size};
+    }
+
+    MappedFile::MappedFile(std::string path, const char *data, std::size_t size) noexcept :
+        m_path{std::move(path)}, m_data{data}, m_length{size}, m_position{bytes()} {
+    }
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept :
+        Object{std::move(other)},
+        m_path{std::move(other.m_path)},
+        m_data{std::exchange(other.m_data, nullptr)},
+        m_length{std::exchange(other.m_length, 0)},
+        m_position{other.m_position} {
+    }
+
+    MappedFile::~MappedFile() {
+        unmapFile(m_data, m_length);
+    }
+
+    void MappedFile::trace(Heap &) {
+        // a mapped file holds no values, so there is nothing to trace
+    }
+
+    RuntimeType MappedFile::runtimeType() const {
+        return RuntimeType::MappedFileType;
+    }
+
+    std::string MappedFile::toString() const {
+        return "<mapped file " + m_path + ">";
+    }
+
+    const std::string &MappedFile::path() const noexcept {
+        return m_path;
+    }
+
+    std::string_view MappedFile::bytes() const noexcept {
+        return {m_data, m_length};
+    }
+
+    std::ranges::subrange<LineIterator, std::default_sentinel_t> MappedFile::lines() const noexcept {
+        return {LineIterator{bytes()}, std::default_sentinel};
+    }
+
+    bool MappedFile::isAtEnd() const noexcept {
+        return m_position == std::default_sentinel;
+    }
+
+    std::string_view MappedFile::nextLine() noexcept {
+        return *m_position++;
+    }
+}
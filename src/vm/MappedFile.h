@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Object.h"
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+
+
+namespace ferrit {
+    /**
+     * Splits bytes into lines, without their line breaks. A line break at the very end does not
+     * start another, empty line. The lines are views into the bytes, which are never copied.
+     */
+    class LineIterator final {
+    public:
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+
+        LineIterator() noexcept = default;
+        explicit LineIterator(std::string_view bytes) noexcept;
+
+        [[nodiscard]] std::string_view operator*() const noexcept;
+        LineIterator &operator++() noexcept;
+        LineIterator operator++(int) noexcept;
+
+        friend bool operator==(const LineIterator &iterator, std::default_sentinel_t) noexcept {
+            return iterator.m_isAtEnd;
+        }
+
+    private:
+        /** Finds the end of the line that starts at the beginning of the rest. */
+        void findLine() noexcept;
+
+    private:
+        /** The bytes from the start of the current line onwards. */
+        std::string_view m_rest{};
+        std::string_view m_line{};
+        bool m_isAtEnd{true};
+    };
+
+    /**
+     * A file that is mapped into memory read-only, so that it can be read without copying it. The
+     * kernel is told that it will be read sequentially, so it reads ahead and drops pages that
+     * have been read, which lets files far larger than memory be read line by line.
+     *
+     * Ferrit programs read its lines in order, as strings that are slices of the mapping. Those
+     * strings keep the mapping alive for as long as they are reachable.
+     */
+    class MappedFile final : public Object {
+    public:
+        /**
+         * Maps a whole file.
+         *
+         * @return the file, or nothing if it could not be opened or mapped, with <tt>errno</tt> set
+         */
+        [[nodiscard]] static std::optional<MappedFile> open(const std::string &path);
+
+        // the mapping is unmapped once, by whichever object owns it last
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&) = delete;
+        ~MappedFile() override;
+
+        void trace(Heap &heap) override;
+        [[nodiscard]] RuntimeType runtimeType() const override;
+        [[nodiscard]] std::string toString() const override;
+
+        [[nodiscard]] const std::string &path() const noexcept;
+
+        /**
+         * Returns the contents of the file.
+         */
+        [[nodiscard]] std::string_view bytes() const noexcept;
+
+        /**
+         * Returns every line of the file, from the start, independently of the program's position.
+         */
+        [[nodiscard]] std::ranges::subrange<LineIterator, std::default_sentinel_t> lines() const noexcept;
+
+        /**
+         * Returns whether the program has read every line.
+         */
+        [[nodiscard]] bool isAtEnd() const noexcept;
+
+        /**
+         * Returns the line that the program reads next, and moves on to the one after it. Must not
+         * be called once every line has been read.
+         */
+        std::string_view nextLine() noexcept;
+
+    private:
+        MappedFile(std::string path, const char *data, std::size_t size) noexcept;
+
+    private:
+        std::string m_path;
+        /** The start of the mapping, or null if the file is empty, since empty files cannot be mapped. */
+        const char *m_data;
+        std::size_t m_length;
+        LineIterator m_position;
+    };
+}
@@ -1,9 +1,35 @@
 #include "NativeHandler.h"
 
+#include <cstdio>
+#include <format>
+#include <iterator>
+
+#ifdef _WIN32
+#include <io.h>
+#define FERRIT_ISATTY(descriptor) _isatty(descriptor)
+#define FERRIT_FILENO(file) _fileno(file)
+#else
+#include <unistd.h>
+#define FERRIT_ISATTY(descriptor) isatty(descriptor)
+#define FERRIT_FILENO(file) fileno(file)
+#endif
+
 
 namespace ferrit {
     NativeHandler::NativeHandler(std::ostream &output, std::ostream &errors, std::istream &input) noexcept :
-        m_output{&output}, m_errors{&errors}, m_input{&input} {
+        m_output{&output}, m_errors{&errors}, m_input{&input},
+        m_isLineBuffered{&output == &std::cout && FERRIT_ISATTY(FERRIT_FILENO(stdout))} {
+    }
+
+    NativeHandler::NativeHandler(const NativeHandler &other) noexcept :
+        m_output{other.m_output}, m_errors{other.m_errors}, m_input{other.m_input},
+        m_bufferSize{other.m_bufferSize}, m_isLineBuffered{other.m_isLineBuffered} {
+        // the buffer is not copied, so that each line is only ever written by one handler
+    }
+
+    NativeHandler::~NativeHandler() {
+        // there is nobody left to report a failure to
+        writeBuffer();
     }
 
     void NativeHandler::panic(const ExecutionContext &ctx, const std::string &msg) {
@@ -12,24 +38,98 @@ namespace ferrit {
     }
 
     void NativeHandler::println(const ExecutionContext &ctx, const std::string &msg) {
-        *m_output << msg << std::endl;
-        if (!(*m_errors)) {
-            panic(ctx, "could not write to standard output");
+        m_buffer += msg;
+        m_buffer += '\n';
+        lineWritten(ctx);
+    }
+
+    void NativeHandler::println(const ExecutionContext &ctx, const Value &value) {
+        if (value.isInteger() || value.isReal()) {
+            char number[MAX_NUMBER_LENGTH];
+            char *end = value.isInteger() ? formatInteger(value.asIntegerUnchecked(), number)
+                : formatReal(value.asRealUnchecked(), number);
+            m_buffer.append(number, end);
+            m_buffer += '\n';
+        } else {
+            std::format_to(std::back_inserter(m_buffer), "{}\n", value);
         }
+        lineWritten(ctx);
     }
 
     void NativeHandler::eprintln(const ExecutionContext &ctx, const std::string &msg) {
+        // a failure to write the output is not reported here, since that would mean panicking
+        // while printing a panic. the stream stays failed, so the next flush reports it instead
+        writeBuffer();
+        std::lock_guard lock{outputMutex()};
         *m_errors << msg << std::endl;
         if (!(*m_errors)) {
-            panic(ctx, "could not write to standard error");
+            // there is nowhere left to report this, so the program stops without a message, but the
+            // error still says where it happened, for whoever catches it
+            std::string reason = "could not write to standard error";
+            throw PanicError(ctx.line > 0 ? std::format("line {}: {}", ctx.line, reason) : reason);
         }
     }
 
     std::string NativeHandler::readln(const ExecutionContext &ctx) {
+        // a prompt printed before reading must be visible to whoever answers it
+        flush(ctx);
         std::string line;
-        if (!std::getline(*m_input, line)) {
+        bool isRead;
+        {
+            std::lock_guard lock{inputMutex()};
+            isRead = static_cast<bool>(std::getline(*m_input, line));
+        }
+        if (!isRead) {
             panic(ctx, "could not read from standard input");
         }
         return line;
     }
-}
\ No newline at end of file
+
+    bool NativeHandler::isStandardInput() const noexcept {
+        return m_input == &std::cin;
+    }
+
+    void NativeHandler::flush(const ExecutionContext &ctx) {
+        if (!writeBuffer()) {
+            panic(ctx, "could not write to standard output");
+        }
+    }
+
+    void NativeHandler::setBufferSize(std::size_t size) noexcept {
+        m_bufferSize = size;
+    }
+
+    void NativeHandler::setLineBuffered(bool isLineBuffered) noexcept {
+        m_isLineBuffered = isLineBuffered;
+    }
+
+    bool NativeHandler::writeBuffer() {
+        // an empty buffer does not need the stream, so a VM that prints nothing never takes the lock
+        if (m_buffer.empty()) {
+            return !m_hasOutputFailed;
+        }
+
+        std::lock_guard lock{outputMutex()};
+        m_output->write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_output->flush();
+        m_buffer.clear();
+        m_hasOutputFailed = !(*m_output);
+        return !m_hasOutputFailed;
+    }
+
+    void NativeHandler::lineWritten(const ExecutionContext &ctx) {
+        if (m_isLineBuffered || m_buffer.size() >= m_bufferSize) {
+            flush(ctx);
+        }
+    }
+
+    std::mutex &NativeHandler::outputMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::mutex &NativeHandler::inputMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+}
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "Value.h"
+
+#include <cstddef>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 
@@ -15,19 +19,95 @@ namespace ferrit {
         using std::runtime_error::runtime_error;
     };
 
+    /**
+     * The virtual machine's interface to the outside world.
+     *
+     * Standard output is buffered: printed lines collect in a buffer that is only written to the
+     * stream once it reaches its size limit, when <tt>flush</tt> is called, or when the handler is
+     * destroyed. Output to a terminal is line buffered instead, so that an interactive user sees
+     * each line as soon as it is printed. Before anything is written to standard error or read
+     * from standard input, the buffered output is flushed, so the streams stay in order.
+     *
+     * Handlers on different threads may share streams: every write and read holds a lock that all
+     * handlers share, so a buffer is always written in one piece and whole lines from different
+     * threads never interleave. A single handler must only be used by one thread at a time.
+     */
     class NativeHandler final {
     public:
+        /**
+         * Creates a handler for the given streams. Output is line buffered if it is standard
+         * output and that is a terminal.
+         */
         explicit NativeHandler(std::ostream &output, std::ostream &errors, std::istream &input) noexcept;
 
+        NativeHandler(const NativeHandler &other) noexcept;
+        NativeHandler &operator=(const NativeHandler &other) = delete;
+        ~NativeHandler();
+
         void panic(const ExecutionContext &ctx, const std::string &msg);
 
         void println(const ExecutionContext &ctx, const std::string &msg);
+
+        /**
+         * Prints a value, formatting it straight into the output buffer.
+         */
+        void println(const ExecutionContext &ctx, const Value &value);
+
         void eprintln(const ExecutionContext &ctx, const std::string &msg);
         std::string readln(const ExecutionContext &ctx);
 
+        /**
+         * Returns whether the input stream is standard input, which the VM can read through its
+         * event loop instead, so that reading it only blocks the fiber that is waiting for a line.
+         */
+        [[nodiscard]] bool isStandardInput() const noexcept;
+
+        /**
+         * Writes everything in the output buffer to the output stream.
+         */
+        void flush(const ExecutionContext &ctx);
+
+        /**
+         * Sets the number of bytes that the output buffer holds before it is flushed. Zero
+         * disables buffering entirely.
+         */
+        void setBufferSize(std::size_t size) noexcept;
+
+        /**
+         * Sets whether the output buffer is flushed after every line.
+         */
+        void setLineBuffered(bool isLineBuffered) noexcept;
+
+    public:
+        static constexpr std::size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+    private:
+        /**
+         * Writes the buffer to the output stream and empties it.
+         *
+         * @return false if the stream has failed
+         */
+        bool writeBuffer();
+
+        /**
+         * Returns the lock held while writing to the output or error streams. They are guarded by
+         * the same lock so that an error can never land in the middle of a buffer being written.
+         */
+        static std::mutex &outputMutex();
+        static std::mutex &inputMutex();
+
+        /**
+         * Flushes the buffer if it is full, or after every line if output is line buffered.
+         */
+        void lineWritten(const ExecutionContext &ctx);
+
     private:
         std::ostream *m_output{};
         std::ostream *m_errors{};
         std::istream *m_input{};
+        std::string m_buffer{};
+        std::size_t m_bufferSize{DEFAULT_BUFFER_SIZE};
+        bool m_isLineBuffered{false};
+        bool m_hasOutputFailed{false};
     };
 }
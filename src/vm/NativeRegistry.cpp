@@ -0,0 +1,110 @@
+#include "NativeRegistry.h"
+
+#include <format>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+
+namespace ferrit {
+    namespace {
+        /**
+         * Loads a shared library, which is unloaded once the last owner lets go of it.
+         *
+         * @throws std::runtime_error if the library cannot be loaded
+         */
+        std::shared_ptr<void> openLibrary(const std::string &path) {
+#ifdef _WIN32
+            HMODULE library = LoadLibraryA(path.c_str());
+            if (!library) {
+                throw std::runtime_error(std::format(
+                    "cannot load native library '{}': error {}", path, GetLastError()));
+            }
+            return {library, [](void *handle) { FreeLibrary(static_cast<HMODULE>(handle)); }};
+#else
+            // RTLD_NOW reports missing symbols here, rather than when a program first calls a function
+            void *library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+            if (!library) {
+                throw std::runtime_error(std::format("cannot load native library '{}': {}", path, dlerror()));
+            }
+            return {library, [](void *handle) { dlclose(handle); }};
+#endif
+        }
+
+        NativeRegistry::LibraryEntryPoint findEntryPoint(void *library) {
+#ifdef _WIN32
+            FARPROC symbol = GetProcAddress(static_cast<HMODULE>(library), NativeRegistry::LIBRARY_ENTRY_POINT);
+#else
+            void *symbol = dlsym(library, NativeRegistry::LIBRARY_ENTRY_POINT);
+#endif
+            // going through void (*)() keeps GCC from warning that the symbol's type is being cast away
+            return reinterpret_cast<NativeRegistry::LibraryEntryPoint>(reinterpret_cast<NativeFunction::Pointer>(symbol));
+        }
+    }
+
+    void NativeRegistry::loadLibrary(const std::string &path) {
+        std::shared_ptr<void> library = openLibrary(path);
+        LibraryEntryPoint entryPoint = findEntryPoint(library.get());
+        if (!entryPoint) {
+            throw std::runtime_error(std::format(
+                "native library '{}' does not export '{}'", path, LIBRARY_ENTRY_POINT));
+        }
+
+        // every function that the library registers shares ownership of it
+        m_loadingLibrary = std::move(library);
+        try {
+            entryPoint(*this);
+        } catch (...) {
+            m_loadingLibrary.reset();
+            throw;
+        }
+        m_loadingLibrary.reset();
+    }
+
+    const NativeFunction *NativeRegistry::find(std::string_view name) const {
+        auto it = m_functions.find(std::string{name});
+        return it != m_functions.end() ? &it->second : nullptr;
+    }
+
+    std::size_t NativeRegistry::size() const noexcept {
+        return m_functions.size();
+    }
+
+    std::optional<std::string_view> NativeRegistry::cppTypeOf(const RuntimeType &type, bool isResult) {
+        // the types that the trampolines convert, which must be kept in sync with NativeParameter and NativeResult
+        if (type == RuntimeType::NothingType) {
+            return isResult ? std::optional<std::string_view>{"void"} : std::nullopt;
+        } else if (type == RuntimeType::BoolType) {
+            return "bool";
+        } else if (type == RuntimeType::IntType) {
+            return "std::int64_t";
+        } else if (type == RuntimeType::RealType) {
+            return "double";
+        } else if (type == RuntimeType::StringType) {
+            return isResult ? "std::string" : "std::string_view";
+        } else if (isResult) {
+            return {};
+        } else if (type == RuntimeType::IntArrayType) {
+            return "std::span<std::int64_t>";
+        } else if (type == RuntimeType::RealArrayType) {
+            return "std::span<double>";
+        } else if (type == RuntimeType::BoolArrayType) {
+            return "std::span<bool>";
+        }
+        return {};
+    }
+
+    void NativeRegistry::insert(NativeFunction function) {
+        if (m_functions.contains(function.name)) {
+            throw std::invalid_argument(std::format("native function '{}' is already registered", function.name));
+        }
+        std::string name = function.name;
+        m_functions.emplace(std::move(name), std::move(function));
+    }
+}
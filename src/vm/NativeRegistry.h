@@ -0,0 +1,245 @@
+#pragma once
+
+#include "Array.h"
+#include "Heap.h"
+#include "RuntimeType.h"
+#include "String.h"
+#include "Value.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace ferrit {
+    /**
+     * The C++ types that a native function can take as parameters, and the runtime type that each
+     * one stands for. Strings are passed as views, and arrays as spans over their elements, which
+     * the function reads and writes in place. Both are only valid until the function returns.
+     */
+    template <typename T>
+    concept NativeParameter = std::is_same_v<T, bool> || std::is_same_v<T, std::int64_t> ||
+        std::is_same_v<T, double> || std::is_same_v<T, std::string_view> ||
+        std::is_same_v<T, std::span<std::int64_t>> || std::is_same_v<T, std::span<double>> ||
+        std::is_same_v<T, std::span<bool>>;
+
+    /**
+     * The C++ types that a native function can return. A function that returns nothing returns
+     * <tt>Unit</tt>, and a returned string is copied onto the heap.
+     */
+    template <typename T>
+    concept NativeResult = std::is_void_v<T> || std::is_same_v<T, bool> || std::is_same_v<T, std::int64_t> ||
+        std::is_same_v<T, double> || std::is_same_v<T, std::string>;
+
+    /**
+     * A C++ function that Ferrit programs can call by declaring it as <tt>native fun</tt>.
+     */
+    struct NativeFunction final {
+        /** The type that every function pointer is stored as, and cast back from by the trampoline. */
+        using Pointer = void (*)();
+
+        /**
+         * Calls a function with arguments read straight from the VM's stack, converting them and its
+         * result. Each trampoline is instantiated for one signature, so nothing is looked up per call.
+         */
+        using Trampoline = Value (*)(Pointer function, const Value *arguments, Heap &heap);
+
+        std::string name;
+        std::vector<RuntimeType> parameterTypes;
+        RuntimeType returnType;
+        Trampoline trampoline;
+        /** The function that the trampoline calls, or null if it calls one that it was instantiated for. */
+        Pointer function;
+        /** The shared library that the function lives in, which stays loaded while it can be called. */
+        std::shared_ptr<void> library;
+    };
+
+    /**
+     * The native functions that programs can be compiled against. A program's calls to native
+     * functions are resolved, and their signatures checked, when it is compiled, after which it
+     * calls each one through its trampoline without going through the registry again.
+     *
+     * Functions are registered either by the application that embeds Ferrit, or by a shared library
+     * that exports <tt>extern "C" void ferrit_register_natives(ferrit::NativeRegistry &)</tt>. Since
+     * forked tasks run in VMs on other threads, native functions must be safe to call concurrently.
+     */
+    class NativeRegistry final {
+    public:
+        /** A shared library's function that registers its native functions. */
+        using LibraryEntryPoint = void (*)(NativeRegistry &registry);
+
+        /**
+         * Registers a function that is known at compile time, such as
+         * <tt>registry.add<&distance>("distance")</tt>. Its trampoline calls it directly, so the
+         * C++ compiler may inline it.
+         *
+         * @throws std::invalid_argument if a function with the same name has already been registered
+         */
+        template <auto function>
+        void add(std::string name);
+
+        /**
+         * Registers a function through a pointer, which its trampoline calls indirectly.
+         *
+         * @throws std::invalid_argument if a function with the same name has already been registered
+         */
+        template <NativeResult Result, NativeParameter... Args>
+        void add(std::string name, Result (*function)(Args...));
+
+        /**
+         * Loads a shared library, and lets it register its functions by calling its entry point.
+         * The library stays loaded for as long as any of its functions can still be called.
+         *
+         * @throws std::runtime_error if the library cannot be loaded or has no entry point
+         */
+        void loadLibrary(const std::string &path);
+
+        /**
+         * Returns the function with the given name, or null if there is none.
+         */
+        [[nodiscard]] const NativeFunction *find(std::string_view name) const;
+
+        /**
+         * Returns the number of functions that have been registered.
+         */
+        [[nodiscard]] std::size_t size() const noexcept;
+
+        /**
+         * Returns the C++ type that a native function takes or returns for the given runtime type.
+         *
+         * @param isResult whether the type is returned, rather than taken as a parameter
+         * @return the type's name, or nothing if values of the type cannot be passed to native functions
+         */
+        [[nodiscard]] static std::optional<std::string_view> cppTypeOf(const RuntimeType &type, bool isResult);
+
+    public:
+        /** The name of the function that a shared library exports to register its native functions. */
+        static constexpr const char *LIBRARY_ENTRY_POINT = "ferrit_register_natives";
+
+    private:
+        template <auto function, NativeResult Result, NativeParameter... Args>
+        void addDirect(std::string name, Result (*)(Args...));
+
+        template <typename Callee, NativeResult Result, NativeParameter... Args, std::size_t... Is>
+        static Value invoke(Callee callee, const Value *arguments, Heap &heap, std::index_sequence<Is...>);
+
+        template <auto function, NativeResult Result, NativeParameter... Args>
+        static Value callDirect(NativeFunction::Pointer, const Value *arguments, Heap &heap);
+
+        template <NativeResult Result, NativeParameter... Args>
+        static Value callThrough(NativeFunction::Pointer function, const Value *arguments, Heap &heap);
+
+        template <NativeParameter T>
+        static T fromValue(const Value &value, Heap &heap);
+
+        template <typename T>
+        static const RuntimeType &runtimeTypeOf();
+
+        void insert(NativeFunction function);
+
+    private:
+        std::unordered_map<std::string, NativeFunction> m_functions{};
+        /** The library whose entry point is registering functions, if any. */
+        std::shared_ptr<void> m_loadingLibrary{};
+    };
+
+    template <auto function>
+    void NativeRegistry::add(std::string name) {
+        addDirect<function>(std::move(name), function);
+    }
+
+    template <NativeResult Result, NativeParameter... Args>
+    void NativeRegistry::add(std::string name, Result (*function)(Args...)) {
+        insert(NativeFunction{
+            .name = std::move(name),
+            .parameterTypes = {runtimeTypeOf<Args>()...},
+            .returnType = runtimeTypeOf<Result>(),
+            .trampoline = &callThrough<Result, Args...>,
+            .function = reinterpret_cast<NativeFunction::Pointer>(function),
+            .library = m_loadingLibrary});
+    }
+
+    template <auto function, NativeResult Result, NativeParameter... Args>
+    void NativeRegistry::addDirect(std::string name, Result (*)(Args...)) {
+        insert(NativeFunction{
+            .name = std::move(name),
+            .parameterTypes = {runtimeTypeOf<Args>()...},
+            .returnType = runtimeTypeOf<Result>(),
+            .trampoline = &callDirect<function, Result, Args...>,
+            .function = nullptr,
+            .library = m_loadingLibrary});
+    }
+
+    template <typename Callee, NativeResult Result, NativeParameter... Args, std::size_t... Is>
+    Value NativeRegistry::invoke(Callee callee, const Value *arguments, Heap &heap, std::index_sequence<Is...>) {
+        // the arguments are still on the stack while a returned string is allocated, so the
+        // collection that the allocation may start cannot free the strings that they view
+        if constexpr (std::is_void_v<Result>) {
+            callee(fromValue<Args>(arguments[Is], heap)...);
+            return Value{};
+        } else if constexpr (std::is_same_v<Result, std::string>) {
+            return Value{heap.allocate<String>(callee(fromValue<Args>(arguments[Is], heap)...))};
+        } else {
+            return Value{callee(fromValue<Args>(arguments[Is], heap)...)};
+        }
+    }
+
+    template <auto function, NativeResult Result, NativeParameter... Args>
+    Value NativeRegistry::callDirect(NativeFunction::Pointer, const Value *arguments, Heap &heap) {
+        return invoke<decltype(function), Result, Args...>(
+            function, arguments, heap, std::index_sequence_for<Args...>{});
+    }
+
+    template <NativeResult Result, NativeParameter... Args>
+    Value NativeRegistry::callThrough(NativeFunction::Pointer function, const Value *arguments, Heap &heap) {
+        return invoke<Result (*)(Args...), Result, Args...>(
+            reinterpret_cast<Result (*)(Args...)>(function), arguments, heap, std::index_sequence_for<Args...>{});
+    }
+
+    template <NativeParameter T>
+    T NativeRegistry::fromValue(const Value &value, Heap &heap) {
+        // the compiler has checked every argument's type against the function's signature
+        if constexpr (std::is_same_v<T, bool>) {
+            return value.asBooleanUnchecked();
+        } else if constexpr (std::is_same_v<T, std::int64_t>) {
+            return value.asIntegerUnchecked();
+        } else if constexpr (std::is_same_v<T, double>) {
+            return value.asRealUnchecked();
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            return static_cast<String *>(value.asObjectUnchecked())->view(heap);
+        } else {
+            // the elements live outside of the array object, so they stay put even if a collection moves it
+            auto *array = static_cast<PackedArray<typename T::element_type> *>(value.asObjectUnchecked());
+            return T{array->data(), array->length()};
+        }
+    }
+
+    template <typename T>
+    const RuntimeType &NativeRegistry::runtimeTypeOf() {
+        if constexpr (std::is_void_v<T>) {
+            return RuntimeType::NothingType;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            return RuntimeType::BoolType;
+        } else if constexpr (std::is_same_v<T, std::int64_t>) {
+            return RuntimeType::IntType;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return RuntimeType::RealType;
+        } else if constexpr (std::is_same_v<T, std::span<std::int64_t>>) {
+            return RuntimeType::IntArrayType;
+        } else if constexpr (std::is_same_v<T, std::span<double>>) {
+            return RuntimeType::RealArrayType;
+        } else if constexpr (std::is_same_v<T, std::span<bool>>) {
+            return RuntimeType::BoolArrayType;
+        } else {
+            return RuntimeType::StringType;
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "RuntimeType.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace ferrit {
+    class Heap;
+
+    /**
+     * Base class for all values that live on the garbage-collected heap.
+     *
+     * Objects are created with <tt>Heap::allocate</tt> and are never deleted directly.
+     * Since young objects are moved when they survive a collection, every object type
+     * must be move constructible, and must report all of its references in <tt>trace</tt>.
+     */
+    class Object {
+    public:
+        virtual ~Object() = default;
+
+        /**
+         * Reports every value and object that this object refers to by calling
+         * <tt>Heap::trace</tt> on it. The references may be updated in place.
+         *
+         * @param heap the heap that is collecting garbage
+         */
+        virtual void trace(Heap &heap) = 0;
+
+        [[nodiscard]] virtual RuntimeType runtimeType() const = 0;
+
+        /**
+         * Returns the string representation of this object, as printed by <tt>println</tt>.
+         */
+        [[nodiscard]] virtual std::string toString() const = 0;
+
+        /**
+         * Returns the number of bytes that this object owns outside of the heap, such as a buffer
+         * that it allocated itself. The heap counts them towards its collection triggers, so they
+         * must not change over the object's lifetime.
+         */
+        [[nodiscard]] virtual std::size_t externalSize() const noexcept {
+            return 0;
+        }
+
+    protected:
+        Object() noexcept = default;
+        Object(const Object &) noexcept = default;
+        Object(Object &&) noexcept = default;
+        Object &operator=(const Object &) noexcept = default;
+        Object &operator=(Object &&) noexcept = default;
+
+    private:
+        friend class Heap;
+
+        using Relocator = Object *(*)(Object *from, void *to);
+
+        /** Moves the object into new memory. Set by the heap, since only it knows the object's real type. */
+        Relocator m_relocate{nullptr};
+        /** The next object in the old generation, or the new location of a young object that was moved. */
+        Object *m_next{nullptr};
+        std::uint32_t m_size{0};
+        bool m_isOld{false};
+        bool m_isMarked{false};
+        bool m_isRemembered{false};
+    };
+}
@@ -0,0 +1,33 @@
+#include "Program.h"
+
+#include <stdexcept>
+
+namespace ferrit {
+    Program::Program(std::vector<Function> functions, std::vector<NativeFunction> nativeFunctions) noexcept :
+        m_functions{std::move(functions)}, m_nativeFunctions{std::move(nativeFunctions)} {
+    }
+
+    const Function &Program::script() const {
+        if (m_functions.empty()) {
+            throw std::logic_error("program has no script");
+        }
+        return m_functions[SCRIPT_INDEX];
+    }
+
+    const std::vector<Function> &Program::functions() const noexcept {
+        return m_functions;
+    }
+
+    const std::vector<NativeFunction> &Program::nativeFunctions() const noexcept {
+        return m_nativeFunctions;
+    }
+
+    std::optional<int> Program::findFunction(std::string_view name) const {
+        for (std::size_t i = SCRIPT_INDEX + 1; i < m_functions.size(); i++) {
+            if (m_functions[i].name == name) {
+                return static_cast<int>(i);
+            }
+        }
+        return {};
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Chunk.h"
+#include "NativeRegistry.h"
+#include "RuntimeType.h"
+
+
+namespace ferrit {
+    /**
+     * A compiled function.
+     */
+    struct Function final {
+        std::string name;
+        /** The number of parameters, which occupy the first slots of the function's frame. */
+        int arity{0};
+        std::vector<RuntimeType> parameterTypes{};
+        RuntimeType returnType{RuntimeType::NothingType};
+        Chunk chunk{};
+    };
+
+    /**
+     * A compiled program, consisting of the top-level script and every function it declares.
+     * Functions are referred to by their index, which <tt>OpCode::Call</tt> takes as its operand.
+     * The native functions that it calls are copied from the registry that it was compiled against,
+     * and are referred to by their index in the same way, by <tt>OpCode::CallNative</tt>.
+     *
+     * A program never changes once it has been compiled. Everything that changes while it runs,
+     * such as the stack, the heap and the loop counters, belongs to the VM running it, so any number
+     * of VMs on different threads can run the same program at once.
+     */
+    class Program final {
+    public:
+        explicit Program() = default;
+
+        /**
+         * Constructs a program.
+         *
+         * @param functions the program's functions. The first function is the top-level script.
+         * @param nativeFunctions the native functions that the program calls
+         */
+        explicit Program(std::vector<Function> functions, std::vector<NativeFunction> nativeFunctions = {}) noexcept;
+
+        /**
+         * Returns the top-level script, which is executed when the program is run.
+         */
+        [[nodiscard]] const Function &script() const;
+
+        /**
+         * Returns every function in the program, including the top-level script at index 0.
+         */
+        [[nodiscard]] const std::vector<Function> &functions() const noexcept;
+
+        /**
+         * Returns every native function that the program calls.
+         */
+        [[nodiscard]] const std::vector<NativeFunction> &nativeFunctions() const noexcept;
+
+        /**
+         * Returns the index of the function with the given name, or nothing if the program does not
+         * declare one. The top-level script cannot be found by name.
+         */
+        [[nodiscard]] std::optional<int> findFunction(std::string_view name) const;
+
+    public:
+        static constexpr int SCRIPT_INDEX = 0;
+
+    private:
+        std::vector<Function> m_functions{};
+        std::vector<NativeFunction> m_nativeFunctions{};
+    };
+}
@@ -12,4 +12,15 @@ const RuntimeType RuntimeType::NothingType{"ferrit.Nothing"};
 const RuntimeType RuntimeType::NullType{"ferrit.Null"};
 const RuntimeType RuntimeType::BoolType{"ferrit.Bool"};
 const RuntimeType RuntimeType::IntType{"ferrit.Int"};
-const RuntimeType RuntimeType::RealType{"ferrit.Real"};
\ No newline at end of file
+const RuntimeType RuntimeType::RealType{"ferrit.Real"};
+const RuntimeType RuntimeType::StringType{"ferrit.String"};
+const RuntimeType RuntimeType::IntArrayType{"ferrit.Array<ferrit.Int>"};
+const RuntimeType RuntimeType::RealArrayType{"ferrit.Array<ferrit.Real>"};
+const RuntimeType RuntimeType::BoolArrayType{"ferrit.Array<ferrit.Bool>"};
+const RuntimeType RuntimeType::FiberType{"ferrit.Fiber"};
+const RuntimeType RuntimeType::FileType{"ferrit.File"};
+const RuntimeType RuntimeType::MappedFileType{"ferrit.MappedFile"};
+const RuntimeType RuntimeType::IntTaskType{"ferrit.Task<ferrit.Int>"};
+const RuntimeType RuntimeType::RealTaskType{"ferrit.Task<ferrit.Real>"};
+const RuntimeType RuntimeType::BoolTaskType{"ferrit.Task<ferrit.Bool>"};
+const RuntimeType RuntimeType::NothingTaskType{"ferrit.Task<ferrit.Nothing>"};
@@ -16,6 +16,17 @@ public:
     static const RuntimeType BoolType;
     static const RuntimeType IntType;
     static const RuntimeType RealType;
+    static const RuntimeType StringType;
+    static const RuntimeType IntArrayType;
+    static const RuntimeType RealArrayType;
+    static const RuntimeType BoolArrayType;
+    static const RuntimeType FiberType;
+    static const RuntimeType FileType;
+    static const RuntimeType MappedFileType;
+    static const RuntimeType IntTaskType;
+    static const RuntimeType RealTaskType;
+    static const RuntimeType BoolTaskType;
+    static const RuntimeType NothingTaskType;
 
 private:
     std::string m_name;
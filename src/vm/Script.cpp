@@ -0,0 +1,38 @@
+#include "Script.h"
+#include "../Lexer.h"
+#include "../Parser.h"
+#include "BytecodeCompiler.h"
+
+
+namespace ferrit {
+    Script::Script(Program program) :
+        m_program{std::make_shared<const Program>(std::move(program))} {
+    }
+
+    std::optional<Script> Script::compile(const std::string &code, std::shared_ptr<const ErrorReporter> errorReporter,
+        const NativeRegistry *nativeRegistry) {
+        auto tokens = Lexer{errorReporter}.lex(code);
+        if (!tokens.has_value()) {
+            return {};
+        }
+
+        auto ast = Parser{errorReporter}.parse(tokens.value());
+        if (!ast.has_value()) {
+            return {};
+        }
+
+        auto program = BytecodeCompiler{errorReporter, nativeRegistry}.compile(ast.value());
+        if (!program.has_value()) {
+            return {};
+        }
+        return Script{std::move(program.value())};
+    }
+
+    void Script::run(VirtualMachine &vm) const {
+        vm.interpret(m_program);
+    }
+
+    const Program &Script::program() const noexcept {
+        return *m_program;
+    }
+}
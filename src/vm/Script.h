@@ -0,0 +1,173 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "../ErrorReporter.h"
+#include "Program.h"
+#include "Value.h"
+#include "VirtualMachine.h"
+
+
+namespace ferrit {
+    /**
+     * The C++ types that can be passed to and returned from Ferrit functions, and the runtime type
+     * that each one stands for. A <tt>Value</tt> stands for any type.
+     */
+    template <typename T>
+    concept ScriptType = std::is_same_v<T, bool> || std::is_same_v<T, std::int64_t> ||
+        std::is_same_v<T, double> || std::is_same_v<T, Value>;
+
+    template <typename Signature>
+    class EntryPoint;
+
+    /**
+     * A function of a compiled script that can be called from C++ with arguments and a result of
+     * the given C++ types, such as <tt>EntryPoint<double(std::int64_t, double)></tt>. Its signature
+     * is checked against the function's once, when it is looked up, rather than on every call.
+     *
+     * An entry point shares ownership of its script's program, so it stays valid on its own.
+     */
+    template <ScriptType Result, ScriptType... Args>
+    class EntryPoint<Result(Args...)> final {
+    public:
+        explicit EntryPoint(std::shared_ptr<const Program> program, int functionIndex) noexcept :
+            m_program{std::move(program)}, m_functionIndex{functionIndex} {
+        }
+
+        /**
+         * Calls the function on the given VM. Only one thread at a time may use a VM.
+         *
+         * @return the function's result, or nothing if it panicked
+         */
+        std::optional<Result> operator()(VirtualMachine &vm, Args... args) const {
+            std::array<Value, sizeof...(Args)> arguments{Value{args}...};
+            std::optional<Value> result = vm.invoke(m_program, m_functionIndex, arguments);
+            if (!result) {
+                return {};
+            } else if constexpr (std::is_same_v<Result, bool>) {
+                return result->asBooleanUnchecked();
+            } else if constexpr (std::is_same_v<Result, std::int64_t>) {
+                return result->asIntegerUnchecked();
+            } else if constexpr (std::is_same_v<Result, double>) {
+                return result->asRealUnchecked();
+            } else {
+                return *result;
+            }
+        }
+
+        /**
+         * Returns the index of the function in its program.
+         */
+        [[nodiscard]] int functionIndex() const noexcept {
+            return m_functionIndex;
+        }
+
+    private:
+        std::shared_ptr<const Program> m_program;
+        int m_functionIndex;
+    };
+
+    /**
+     * A Ferrit program that has been compiled once so that it can be run any number of times,
+     * for embedding Ferrit in another application. Running a script, or calling one of its
+     * functions, does no lexing, parsing or compiling.
+     *
+     * A script never changes once it is compiled, so it can be shared between threads, each of
+     * which runs it on a VM of its own (see <tt>VirtualMachinePool</tt>).
+     */
+    class Script final {
+    public:
+        /**
+         * Wraps an already compiled program.
+         */
+        explicit Script(Program program);
+
+        /**
+         * Compiles the given code.
+         *
+         * @param code the source code of the script
+         * @param errorReporter reports errors in the code, or null to not report them
+         * @param nativeRegistry the native functions that the script can call, or null if it calls none
+         * @return the script, or nothing if the code has errors
+         */
+        static std::optional<Script> compile(const std::string &code, std::shared_ptr<const ErrorReporter> errorReporter,
+            const NativeRegistry *nativeRegistry = nullptr);
+
+        /**
+         * Looks up a function that can be called with the given signature. Each parameter type, and
+         * the result type, must be the C++ type of the function's own, or <tt>Value</tt>. A function
+         * that returns nothing returns a null <tt>Value</tt>.
+         *
+         * @param name the name of a function that the script declares
+         * @return the entry point, or nothing if there is no such function or its signature does not match
+         */
+        template <typename Signature>
+        [[nodiscard]] std::optional<EntryPoint<Signature>> entryPoint(std::string_view name) const;
+
+        /**
+         * Runs the script's top-level code on the given VM. Only one thread at a time may use a VM.
+         */
+        void run(VirtualMachine &vm) const;
+
+        /**
+         * Returns the compiled program.
+         */
+        [[nodiscard]] const Program &program() const noexcept;
+
+    private:
+        template <ScriptType T>
+        static bool matches(const RuntimeType &type);
+
+        template <ScriptType Result, ScriptType... Args>
+        [[nodiscard]] std::optional<EntryPoint<Result(Args...)>> findEntryPoint(
+            std::string_view name, std::type_identity<Result(Args...)>) const;
+
+    private:
+        std::shared_ptr<const Program> m_program;
+    };
+
+    template <typename Signature>
+    std::optional<EntryPoint<Signature>> Script::entryPoint(std::string_view name) const {
+        return findEntryPoint(name, std::type_identity<Signature>{});
+    }
+
+    template <ScriptType T>
+    bool Script::matches(const RuntimeType &type) {
+        if constexpr (std::is_same_v<T, bool>) {
+            return type == RuntimeType::BoolType;
+        } else if constexpr (std::is_same_v<T, std::int64_t>) {
+            return type == RuntimeType::IntType;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return type == RuntimeType::RealType;
+        } else {
+            return true;
+        }
+    }
+
+    template <ScriptType Result, ScriptType... Args>
+    std::optional<EntryPoint<Result(Args...)>> Script::findEntryPoint(
+        std::string_view name, std::type_identity<Result(Args...)>) const {
+        std::optional<int> index = m_program->findFunction(name);
+        if (!index) {
+            return {};
+        }
+
+        const Function &function = m_program->functions()[*index];
+        if (function.parameterTypes.size() != sizeof...(Args) || !matches<Result>(function.returnType)) {
+            return {};
+        }
+        std::size_t i = 0;
+        bool parametersMatch = (matches<Args>(function.parameterTypes[i++]) && ...);
+        if (!parametersMatch) {
+            return {};
+        }
+        return EntryPoint<Result(Args...)>{m_program, *index};
+    }
+}
@@ -0,0 +1,156 @@
+#include "String.h"
+#include "Heap.h"
+
+#include <utility>
+#include <vector>
+
+
+namespace ferrit {
+    String::String(std::string characters, bool isInterned) :
+        m_characters{std::move(characters)},
+        m_rope{nullptr, nullptr},
+        m_length{m_characters.size()},
+        m_kind{Kind::Flat},
+        m_isInterned{isInterned} {
+    }
+
+    String::String(const Value &left, const Value &right) :
+        m_characters{},
+        m_rope{static_cast<String *>(left.asObjectUnchecked()), static_cast<String *>(right.asObjectUnchecked())},
+        m_length{m_rope.left->length() + m_rope.right->length()},
+        m_kind{Kind::Rope},
+        m_isInterned{false} {
+    }
+
+    String::String(const Value &owner, std::string_view characters) :
+        m_characters{},
+        m_slice{owner.asObjectUnchecked(), characters.data()},
+        m_length{characters.size()},
+        m_kind{Kind::Slice},
+        m_isInterned{false} {
+    }
+
+    void String::trace(Heap &heap) {
+        if (m_kind == Kind::Rope) {
+            Object *left = m_rope.left;
+            Object *right = m_rope.right;
+            heap.trace(left);
+            heap.trace(right);
+            m_rope.left = static_cast<String *>(left);
+            m_rope.right = static_cast<String *>(right);
+        } else if (m_kind == Kind::Slice) {
+            // the owner may move, but the characters it owns stay where they are
+            heap.trace(m_slice.owner);
+        }
+    }
+
+    RuntimeType String::runtimeType() const {
+        return RuntimeType::StringType;
+    }
+
+    std::string String::toString() const {
+        if (m_kind != Kind::Rope) {
+            return std::string{contiguous()};
+        }
+        std::string result;
+        result.reserve(m_length);
+        appendTo(result);
+        return result;
+    }
+
+    std::size_t String::length() const noexcept {
+        return m_length;
+    }
+
+    bool String::isFlat() const noexcept {
+        return m_kind == Kind::Flat;
+    }
+
+    bool String::isInterned() const noexcept {
+        return m_isInterned;
+    }
+
+    const std::string &String::flatten(Heap &heap) {
+        if (m_kind == Kind::Rope) {
+            m_characters.reserve(m_length);
+            appendTo(m_characters);
+            becomeFlat(heap);
+        } else if (m_kind == Kind::Slice) {
+            m_characters.assign(m_slice.characters, m_length);
+            becomeFlat(heap);
+        }
+        return m_characters;
+    }
+
+    std::string_view String::view(Heap &heap) {
+        if (m_kind == Kind::Rope) {
+            flatten(heap);
+        }
+        return contiguous();
+    }
+
+    bool String::equals(String &left, String &right, Heap &heap) {
+        if (&left == &right) {
+            return true;
+        } else if ((left.isInterned() && right.isInterned()) || left.length() != right.length()) {
+            return false;
+        }
+        return left.view(heap) == right.view(heap);
+    }
+
+    String *String::concatenate(Heap &heap, const Value &left, const Value &right) {
+        auto *leftString = static_cast<String *>(left.asObjectUnchecked());
+        auto *rightString = static_cast<String *>(right.asObjectUnchecked());
+        if (leftString->length() == 0) {
+            return rightString;
+        } else if (rightString->length() == 0) {
+            return leftString;
+        }
+
+        std::size_t length = leftString->length() + rightString->length();
+        if (length < MIN_ROPE_LENGTH) {
+            // both operands are shorter than a rope, so they cannot be ropes themselves
+            std::string characters;
+            characters.reserve(length);
+            characters += leftString->contiguous();
+            characters += rightString->contiguous();
+            return heap.allocate<String>(std::move(characters));
+        }
+        // allocating may move the operands, so the rope must read them from the roots afterwards
+        return heap.allocate<String>(left, right);
+    }
+
+    std::string_view String::contiguous() const noexcept {
+        if (m_kind == Kind::Slice) {
+            return {m_slice.characters, m_length};
+        }
+        return m_characters;
+    }
+
+    void String::appendTo(std::string &result) const {
+        // ropes built in a loop are as deep as they are long, so they are walked without recursion
+        std::vector<const String *> pending{this};
+        while (!pending.empty()) {
+            const String *string = pending.back();
+            pending.pop_back();
+            if (string->m_kind == Kind::Rope) {
+                pending.push_back(string->m_rope.right);
+                pending.push_back(string->m_rope.left);
+            } else {
+                result += string->contiguous();
+            }
+        }
+    }
+
+    void String::becomeFlat(Heap &heap) {
+        // whatever this string referred to is no longer referenced by it, which the collector must be told about
+        if (m_kind == Kind::Rope) {
+            heap.writeBarrier(this, Value{m_rope.left}, Value{});
+            heap.writeBarrier(this, Value{m_rope.right}, Value{});
+        } else if (m_kind == Kind::Slice) {
+            heap.writeBarrier(this, Value{m_slice.owner}, Value{});
+        }
+        m_rope = Rope{nullptr, nullptr};
+        m_kind = Kind::Flat;
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Object.h"
+#include "Value.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+namespace ferrit {
+    class Heap;
+
+    /**
+     * An immutable Ferrit string.
+     *
+     * A string is either flat, holding its characters directly, or a rope: the concatenation of two
+     * other strings. Ropes make concatenation take constant time no matter how long its operands
+     * are, so building a string piece by piece in a loop is linear rather than quadratic. A rope is
+     * flattened in place the first time that its characters are needed.
+     *
+     * A string can also be a slice of characters that another object owns, such as a line of a
+     * mapped file, which keeps that object alive. Slices are only copied if they are flattened.
+     *
+     * Flat strings store their characters in a <tt>std::string</tt>, whose small-string optimization
+     * keeps short strings inline in the object, without a second allocation.
+     */
+    class String final : public Object {
+    public:
+        /**
+         * Creates a flat string.
+         *
+         * @param characters the string's contents
+         * @param isInterned whether this is the only string with these contents that is marked as interned
+         */
+        explicit String(std::string characters, bool isInterned = false);
+
+        /**
+         * Creates a rope. Both values must refer to strings.
+         */
+        explicit String(const Value &left, const Value &right);
+
+        /**
+         * Creates a slice.
+         *
+         * @param owner value referring to the object that owns the characters
+         * @param characters the characters, which must stay put for as long as the owner lives
+         */
+        explicit String(const Value &owner, std::string_view characters);
+
+        void trace(Heap &heap) override;
+        [[nodiscard]] RuntimeType runtimeType() const override;
+        [[nodiscard]] std::string toString() const override;
+
+        [[nodiscard]] std::size_t length() const noexcept;
+        [[nodiscard]] bool isFlat() const noexcept;
+        [[nodiscard]] bool isInterned() const noexcept;
+
+        /**
+         * Returns the string's characters, turning it into a flat string first if it is a rope or slice.
+         *
+         * @param heap the heap that the string lives on
+         */
+        const std::string &flatten(Heap &heap);
+
+        /**
+         * Returns the string's characters, flattening ropes, but not copying slices.
+         *
+         * @param heap the heap that the string lives on
+         */
+        std::string_view view(Heap &heap);
+
+        /**
+         * Compares the contents of two strings. Interned strings are compared by identity.
+         */
+        [[nodiscard]] static bool equals(String &left, String &right, Heap &heap);
+
+        /**
+         * Concatenates two strings. Short results are copied into a new flat string, and long
+         * results become ropes. The operands must be reachable from the roots, since they are
+         * read again after the result is allocated.
+         *
+         * @param heap the heap to allocate the result on
+         * @param left value referring to the first string
+         * @param right value referring to the second string
+         * @return the concatenated string
+         */
+        [[nodiscard]] static String *concatenate(Heap &heap, const Value &left, const Value &right);
+
+    public:
+        /** Concatenations shorter than this are copied instead of becoming ropes. */
+        static constexpr std::size_t MIN_ROPE_LENGTH = 64;
+
+    private:
+        enum class Kind : std::uint8_t {
+            Flat,
+            Rope,
+            Slice,
+        };
+
+        struct Rope {
+            String *left;
+            String *right;
+        };
+
+        struct Slice {
+            Object *owner;
+            const char *characters;
+        };
+
+        /**
+         * Returns the characters of a string that is not a rope.
+         */
+        [[nodiscard]] std::string_view contiguous() const noexcept;
+
+        void appendTo(std::string &result) const;
+
+        /**
+         * Drops the rope's pieces or the slice's owner, once the characters have been copied.
+         */
+        void becomeFlat(Heap &heap);
+
+    private:
+        std::string m_characters;
+        /** The strings that a rope concatenates, or the characters that a slice views. */
+        union {
+            Rope m_rope;
+            Slice m_slice;
+        };
+        std::size_t m_length;
+        Kind m_kind;
+        bool m_isInterned;
+    };
+}
@@ -0,0 +1,60 @@
+#include "Task.h"
+#include "TaskScheduler.h"
+
+#include <array>
+#include <utility>
+
+
+namespace ferrit {
+    namespace {
+        struct TaskType {
+            const RuntimeType &resultType;
+            const RuntimeType &taskType;
+        };
+
+        const std::array<TaskType, 4> TASK_TYPES{{
+            {RuntimeType::IntType, RuntimeType::IntTaskType},
+            {RuntimeType::RealType, RuntimeType::RealTaskType},
+            {RuntimeType::BoolType, RuntimeType::BoolTaskType},
+            {RuntimeType::NothingType, RuntimeType::NothingTaskType},
+        }};
+    }
+
+    Task::Task(std::shared_ptr<Job> job, const RuntimeType &type) noexcept :
+        m_job{std::move(job)}, m_type{&type} {
+    }
+
+    void Task::trace(Heap &) {
+        // the task's arguments and result are primitives, so there is nothing to trace
+    }
+
+    RuntimeType Task::runtimeType() const {
+        return *m_type;
+    }
+
+    std::string Task::toString() const {
+        return "<task>";
+    }
+
+    Job &Task::job() const noexcept {
+        return *m_job;
+    }
+
+    const RuntimeType *Task::typeOf(const RuntimeType &resultType) noexcept {
+        for (const auto &type : TASK_TYPES) {
+            if (type.resultType == resultType) {
+                return &type.taskType;
+            }
+        }
+        return nullptr;
+    }
+
+    const RuntimeType *Task::resultTypeOf(const RuntimeType &taskType) noexcept {
+        for (const auto &type : TASK_TYPES) {
+            if (type.taskType == taskType) {
+                return &type.resultType;
+            }
+        }
+        return nullptr;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Object.h"
+
+#include <memory>
+#include <string>
+
+
+namespace ferrit {
+    class Job;
+
+    /**
+     * The handle to a function call that was forked to run in parallel, which <tt>join</tt> waits
+     * for. The call itself runs in another VM, on whichever thread of the task scheduler gets to it
+     * first, so only primitives are passed to it and returned from it.
+     */
+    class Task final : public Object {
+    public:
+        /**
+         * @param job the job that makes the call, which must already have been submitted
+         * @param type the type of the task, which says what its function returns
+         */
+        Task(std::shared_ptr<Job> job, const RuntimeType &type) noexcept;
+
+        void trace(Heap &heap) override;
+        [[nodiscard]] RuntimeType runtimeType() const override;
+        [[nodiscard]] std::string toString() const override;
+
+        [[nodiscard]] Job &job() const noexcept;
+
+        /**
+         * Returns the type of a task whose function returns the given type, or null if such a
+         * function cannot be forked.
+         */
+        [[nodiscard]] static const RuntimeType *typeOf(const RuntimeType &resultType) noexcept;
+
+        /**
+         * Returns what joining a task of the given type results in, or null if it is not a task type.
+         */
+        [[nodiscard]] static const RuntimeType *resultTypeOf(const RuntimeType &taskType) noexcept;
+
+    private:
+        std::shared_ptr<Job> m_job;
+        const RuntimeType *m_type;
+    };
+}
@@ -0,0 +1,182 @@
+#include "TaskScheduler.h"
+#include "VirtualMachine.h"
+
+#include <algorithm>
+#include <utility>
+
+
+namespace ferrit {
+    namespace {
+        /** The scheduler that the calling thread is a worker of, if any, and the worker's index in it. */
+        thread_local const TaskScheduler *currentScheduler = nullptr;
+        thread_local std::size_t currentWorkerIndex = 0;
+    }
+
+    Job::Job(Body body) :
+        m_body{std::move(body)} {
+    }
+
+    void Job::run(VirtualMachine &vm) {
+        m_result = m_body(vm);
+        // releasing the flag publishes the result to whoever acquires it
+        m_isDone.store(true, std::memory_order_release);
+        m_isDone.notify_all();
+    }
+
+    bool Job::isDone() const noexcept {
+        return m_isDone.load(std::memory_order_acquire);
+    }
+
+    void Job::waitUntilDone() const noexcept {
+        m_isDone.wait(false, std::memory_order_acquire);
+    }
+
+    const std::optional<Value> &Job::result() const noexcept {
+        return m_result;
+    }
+
+    TaskScheduler::TaskScheduler(NativeHandler natives, std::size_t workerCount) :
+        m_natives{std::move(natives)} {
+        // every worker exists before any of them starts, since they steal from each other
+        for (std::size_t i = 0; i < std::max<std::size_t>(workerCount, 1); i++) {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+        for (std::size_t i = 0; i < m_workers.size(); i++) {
+            m_workers[i]->thread = std::thread{[this, i] { work(i); }};
+        }
+    }
+
+    TaskScheduler::~TaskScheduler() {
+        {
+            std::lock_guard lock{m_sleepMutex};
+            m_isStopping = true;
+        }
+        m_wakeUp.notify_all();
+        for (auto &worker : m_workers) {
+            worker->thread.join();
+        }
+    }
+
+    void TaskScheduler::submit(std::shared_ptr<Job> job) {
+        std::optional<std::size_t> index = currentWorker();
+        if (!index) {
+            index = m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+        }
+        Worker &worker = *m_workers[*index];
+        {
+            std::lock_guard lock{worker.mutex};
+            worker.jobs.push_back(std::move(job));
+        }
+        m_queuedCount.fetch_add(1);
+        // a worker counts itself as sleeping before it checks the queued count, so either it sees
+        // this job, or this sees it sleeping. waking nobody is the common case while all are busy
+        if (m_sleepingCount.load() > 0) {
+            // taking the lock orders this with a worker that is between its check and its wait
+            {
+                std::lock_guard lock{m_sleepMutex};
+            }
+            m_wakeUp.notify_one();
+        }
+    }
+
+    void TaskScheduler::wait(const Job &job) {
+        std::optional<std::size_t> self = currentWorker();
+        std::unique_ptr<VirtualMachine> vm;
+        while (!job.isDone()) {
+            std::shared_ptr<Job> other = findJob(self);
+            if (!other) {
+                // whoever runs the job helps with whatever it waits for, so nothing is left to do here
+                job.waitUntilDone();
+                break;
+            }
+            // the VM that is waiting is in the middle of a call, so the other job needs one of its own
+            if (!vm) {
+                std::lock_guard lock{m_spareMutex};
+                if (!m_spareVirtualMachines.empty()) {
+                    vm = std::move(m_spareVirtualMachines.back());
+                    m_spareVirtualMachines.pop_back();
+                }
+            }
+            if (!vm) {
+                vm = makeVirtualMachine();
+            }
+            other->run(*vm);
+        }
+
+        if (vm) {
+            std::lock_guard lock{m_spareMutex};
+            m_spareVirtualMachines.push_back(std::move(vm));
+        }
+    }
+
+    std::size_t TaskScheduler::workerCount() const noexcept {
+        return m_workers.size();
+    }
+
+    std::size_t TaskScheduler::defaultWorkerCount() noexcept {
+        // the hardware concurrency is 0 if it is unknown
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    void TaskScheduler::work(std::size_t index) {
+        currentScheduler = this;
+        currentWorkerIndex = index;
+        // the worker's VM is created on its own thread, so the memory of its heap is first touched there
+        std::unique_ptr<VirtualMachine> vm = makeVirtualMachine();
+        while (true) {
+            if (std::shared_ptr<Job> job = findJob(index)) {
+                job->run(*vm);
+                continue;
+            }
+            std::unique_lock lock{m_sleepMutex};
+            m_sleepingCount.fetch_add(1);
+            m_wakeUp.wait(lock, [this] { return m_isStopping || m_queuedCount.load() > 0; });
+            m_sleepingCount.fetch_sub(1);
+            if (m_isStopping) {
+                break;
+            }
+        }
+        currentScheduler = nullptr;
+    }
+
+    std::shared_ptr<Job> TaskScheduler::findJob(std::optional<std::size_t> self) {
+        if (self) {
+            Worker &worker = *m_workers[*self];
+            std::lock_guard lock{worker.mutex};
+            if (!worker.jobs.empty()) {
+                std::shared_ptr<Job> job = std::move(worker.jobs.back());
+                worker.jobs.pop_back();
+                m_queuedCount.fetch_sub(1);
+                return job;
+            }
+        }
+
+        // victims are visited starting just after the thief, so that thieves spread out
+        std::size_t start = self ? *self + 1 : m_nextWorker.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < m_workers.size(); i++) {
+            Worker &victim = *m_workers[(start + i) % m_workers.size()];
+            std::lock_guard lock{victim.mutex};
+            if (!victim.jobs.empty()) {
+                std::shared_ptr<Job> job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                m_queuedCount.fetch_sub(1);
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    std::optional<std::size_t> TaskScheduler::currentWorker() const noexcept {
+        if (currentScheduler != this) {
+            return {};
+        }
+        return currentWorkerIndex;
+    }
+
+    std::unique_ptr<VirtualMachine> TaskScheduler::makeVirtualMachine() {
+        auto vm = std::make_unique<VirtualMachine>(m_natives);
+        // jobs that fork jobs of their own hand them to this scheduler, rather than starting another
+        vm->setScheduler(this);
+        return vm;
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "NativeHandler.h"
+#include "Value.h"
+
+
+namespace ferrit {
+    class VirtualMachine;
+
+    /**
+     * A piece of work for the task scheduler, which runs once in whichever VM picks it up.
+     */
+    class Job final {
+    public:
+        /**
+         * The work itself. It returns its result, which must not be an object, since that would
+         * belong to the heap of the VM it ran in, or nothing if it panicked.
+         */
+        using Body = std::function<std::optional<Value>(VirtualMachine &)>;
+
+        explicit Job(Body body);
+
+        /**
+         * Runs the job, then wakes up everyone waiting for it.
+         */
+        void run(VirtualMachine &vm);
+
+        [[nodiscard]] bool isDone() const noexcept;
+
+        /**
+         * Blocks until the job has run, without helping with any other work.
+         */
+        void waitUntilDone() const noexcept;
+
+        /**
+         * Returns the job's result, or nothing if it panicked. Only valid once it is done.
+         */
+        [[nodiscard]] const std::optional<Value> &result() const noexcept;
+
+    private:
+        Body m_body;
+        std::optional<Value> m_result{};
+        std::atomic<bool> m_isDone{false};
+    };
+
+    /**
+     * Runs jobs in parallel on a fixed set of worker threads, each of which has a VM, and so a heap
+     * to allocate in, of its own.
+     *
+     * Every worker has a deque of jobs. A worker pushes the jobs it submits onto the back of its own
+     * deque and takes its next job from the back as well, so nested jobs run depth-first and touch
+     * memory that is still in cache. Once its deque is empty, it steals the oldest job from the front
+     * of another worker's deque, which tends to be the largest piece of work left. Jobs submitted by
+     * other threads are spread over the workers in turn.
+     *
+     * A thread that waits for a job runs other jobs in the meantime, in a spare VM, rather than
+     * blocking. That keeps every thread busy while a job waits for the jobs it forked, and means that
+     * jobs which wait for each other cannot run out of threads.
+     */
+    class TaskScheduler final {
+    public:
+        /**
+         * Starts the worker threads.
+         *
+         * @param natives the native function api that every worker's VM gets a copy of. Its
+         *                streams are shared by all workers, so they must be safe to use from several
+         *                threads at once.
+         * @param workerCount the number of worker threads, which must be at least 1
+         */
+        explicit TaskScheduler(NativeHandler natives, std::size_t workerCount = defaultWorkerCount());
+
+        /**
+         * Stops the worker threads once they finish the jobs that they are running. Jobs that have
+         * not started yet are dropped.
+         */
+        ~TaskScheduler();
+
+        TaskScheduler(const TaskScheduler &) = delete;
+        TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+        /**
+         * Queues a job to run on one of the workers.
+         */
+        void submit(std::shared_ptr<Job> job);
+
+        /**
+         * Returns once the given job has run, running other jobs while it waits.
+         */
+        void wait(const Job &job);
+
+        [[nodiscard]] std::size_t workerCount() const noexcept;
+
+        /**
+         * Returns the number of threads the hardware can run at once, which is one worker per core.
+         */
+        [[nodiscard]] static std::size_t defaultWorkerCount() noexcept;
+
+    private:
+        struct Worker {
+            std::mutex mutex{};
+            std::deque<std::shared_ptr<Job>> jobs{};
+            std::thread thread{};
+        };
+
+        /**
+         * The main loop of a worker thread.
+         */
+        void work(std::size_t index);
+
+        /**
+         * Takes the next job from the given worker's own deque, or steals one from another worker.
+         *
+         * @param self the index of the calling worker, or nothing if it is not one of this scheduler's
+         * @return the job, or null if every deque was empty
+         */
+        std::shared_ptr<Job> findJob(std::optional<std::size_t> self);
+
+        /**
+         * Returns the index of the calling thread if it is one of this scheduler's workers.
+         */
+        [[nodiscard]] std::optional<std::size_t> currentWorker() const noexcept;
+
+        std::unique_ptr<VirtualMachine> makeVirtualMachine();
+
+    private:
+        NativeHandler m_natives;
+        std::vector<std::unique_ptr<Worker>> m_workers{};
+        /** The worker that the next job submitted from outside of the workers goes to. */
+        std::atomic<std::size_t> m_nextWorker{0};
+        /** The number of jobs in all deques, which workers check before going to sleep. */
+        std::atomic<std::size_t> m_queuedCount{0};
+        /** The number of workers that are waiting for a job to be queued. */
+        std::atomic<std::size_t> m_sleepingCount{0};
+        std::mutex m_sleepMutex{};
+        std::condition_variable m_wakeUp{};
+        bool m_isStopping{false};
+        /** The VMs that threads run jobs in while they wait for another job. */
+        std::mutex m_spareMutex{};
+        std::vector<std::unique_ptr<VirtualMachine>> m_spareVirtualMachines{};
+    };
+}
@@ -1,61 +1,40 @@
 #include "Value.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <stdexcept>
 
 namespace ferrit {
-    Value::Value() noexcept : m_data{nullptr} {
-    }
-
-    Value::Value(bool boolean) noexcept : m_data{boolean} {
-    }
-
-    Value::Value(std::int64_t integer) noexcept : m_data{integer} {
-    }
-
-    Value::Value(double real) noexcept : m_data{real} {
-    }
-
-    bool Value::isNull() const noexcept {
-        return std::holds_alternative<std::nullptr_t>(m_data);
-    }
-
-    bool Value::isBoolean() const noexcept {
-        return std::holds_alternative<bool>(m_data);
-    }
-
-    bool Value::isInteger() const noexcept {
-        return std::holds_alternative<std::int64_t>(m_data);
-    }
-
-    bool Value::isReal() const noexcept {
-        return std::holds_alternative<double>(m_data);
-    }
-
     bool Value::asBoolean() const {
-        try {
-            return std::get<bool>(m_data);
-        } catch (const std::bad_variant_access &e) {
-            throw std::logic_error(std::format("value not a boolean: {}", e.what()));
+        if (!isBoolean()) {
+            throw std::logic_error("value not a boolean");
         }
+        return m_boolean;
     }
 
     std::int64_t Value::asInteger() const {
-        try {
-            return std::get<std::int64_t>(m_data);
-        } catch (const std::bad_variant_access &e) {
-            throw std::logic_error(std::format("value not an integer: {}", e.what()));
+        if (!isInteger()) {
+            throw std::logic_error("value not an integer");
         }
+        return m_integer;
     }
 
     double Value::asReal() const {
-        try {
-            return std::get<double>(m_data);
-        } catch (const std::bad_variant_access &e) {
-            throw std::logic_error(std::format("value not a real: {}", e.what()));
+        if (!isReal()) {
+            throw std::logic_error("value not a real");
+        }
+        return m_real;
+    }
+
+    Object *Value::asObject() const {
+        if (!isObject()) {
+            throw std::logic_error("value not an object");
         }
+        return m_object;
     }
 
-    bool operator==(Value left, Value right) {
+    bool operator==(const Value &left, const Value &right) {
         if (left.isNull() && right.isNull()) {
             return true;
         } else if (left.isBoolean() && right.isBoolean()) {
@@ -64,6 +43,8 @@ namespace ferrit {
             return left.asInteger() == right.asInteger();
         } else if (left.isReal() && right.isReal()) {
             return left.asReal() == right.asReal();
+        } else if (left.isObject() && right.isObject()) {
+            return left.asObject() == right.asObject();
         } else {
             return false;
         }
@@ -78,6 +59,8 @@ namespace ferrit {
             return RuntimeType::IntType;
         } else if (isReal()) {
             return RuntimeType::RealType;
+        } else if (isObject()) {
+            return asObject()->runtimeType();
         } else {
             throw std::logic_error("unknown value variant");
         }
@@ -91,4 +74,25 @@ namespace ferrit {
         }
         return output;
     }
-}
\ No newline at end of file
+
+    char *formatInteger(std::int64_t value, char *buffer) noexcept {
+        return std::to_chars(buffer, buffer + MAX_NUMBER_LENGTH, value).ptr;
+    }
+
+    char *formatReal(double value, char *buffer) noexcept {
+        char *end = std::to_chars(buffer, buffer + MAX_NUMBER_LENGTH, value).ptr;
+        if (!std::isfinite(value)) {
+            return end;
+        }
+
+        // to_chars omits the fraction of whole numbers, so add one, before the exponent if there is one
+        char *exponent = std::find(buffer, end, 'e');
+        if (std::find(buffer, exponent, '.') == exponent) {
+            std::copy_backward(exponent, end, end + 2);
+            exponent[0] = '.';
+            exponent[1] = '0';
+            end += 2;
+        }
+        return end;
+    }
+}
@@ -1,56 +1,91 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <ostream>
 #include <sstream>
 #include <format>
-#include <variant>
+#include <string>
+#include <string_view>
+#include "Object.h"
 #include "RuntimeType.h"
 
 namespace ferrit {
     /**
      * The runtime representation of all values in the virtual machine.
+     *
+     * A value is a type tag next to an untagged 64-bit payload. The tag is only needed where a
+     * value's type is not known statically: printing, comparing values for equality, and finding
+     * the references that the garbage collector must trace. Instructions that the compiler has
+     * typed, such as <tt>IAdd</tt>, read the payload with the unchecked accessors instead, so
+     * that arithmetic never branches on a tag.
      */
     class Value final {
     public:
         /**
          * Initialize the value to null.
          */
-        explicit Value() noexcept;
+        explicit Value() noexcept : m_type{Type::Null}, m_object{nullptr} {
+        }
 
         /**
          * Initialize a boolean value.
          */
-        explicit Value(bool boolean) noexcept;
+        explicit Value(bool boolean) noexcept : m_type{Type::Boolean}, m_boolean{boolean} {
+        }
 
         /**
          * Initialize an integer value.
          */
-        explicit Value(std::int64_t integer) noexcept;
+        explicit Value(std::int64_t integer) noexcept : m_type{Type::Integer}, m_integer{integer} {
+        }
 
         /**
          * Initialize a real value.
          */
-        explicit Value(double real) noexcept;
+        explicit Value(double real) noexcept : m_type{Type::Real}, m_real{real} {
+        }
+
+        /**
+         * Initialize a reference to a heap object. The value does not own the object.
+         */
+        explicit Value(Object *object) noexcept : m_type{Type::Object}, m_object{object} {
+        }
 
         /**
          * Checks if this value contains a null pointer.
          */
-        [[nodiscard]] bool isNull() const noexcept;
+        [[nodiscard]] bool isNull() const noexcept {
+            return m_type == Type::Null;
+        }
 
         /**
          * Checks if this value contains a boolean.
          */
-        [[nodiscard]] bool isBoolean() const noexcept;
+        [[nodiscard]] bool isBoolean() const noexcept {
+            return m_type == Type::Boolean;
+        }
 
         /**
          * Checks if this value contains an integer.
          */
-        [[nodiscard]] bool isInteger() const noexcept;
+        [[nodiscard]] bool isInteger() const noexcept {
+            return m_type == Type::Integer;
+        }
 
         /**
          * Checks if this value contains a real.
          */
-        [[nodiscard]] bool isReal() const noexcept;
+        [[nodiscard]] bool isReal() const noexcept {
+            return m_type == Type::Real;
+        }
+
+        /**
+         * Checks if this value refers to a heap object.
+         */
+        [[nodiscard]] bool isObject() const noexcept {
+            return m_type == Type::Object;
+        }
 
         /**
          * Returns the value's data as a boolean.
@@ -76,10 +111,51 @@ namespace ferrit {
          */
         [[nodiscard]] double asReal() const;
 
+        /**
+         * Returns the heap object that this value refers to.
+         *
+         * @return the object
+         * @throws std::logic_error if the value is not an object
+         */
+        [[nodiscard]] Object *asObject() const;
+
+        // Unchecked accessors, for when the compiler has already proven the value's type.
+        // Reading a value as any other type than the one it holds is undefined.
+
+        [[nodiscard]] bool asBooleanUnchecked() const noexcept {
+            return m_boolean;
+        }
+
+        [[nodiscard]] std::int64_t asIntegerUnchecked() const noexcept {
+            return m_integer;
+        }
+
+        [[nodiscard]] double asRealUnchecked() const noexcept {
+            return m_real;
+        }
+
+        [[nodiscard]] Object *asObjectUnchecked() const noexcept {
+            return m_object;
+        }
+
         [[nodiscard]] RuntimeType runtimeType() const;
 
     private:
-        std::variant<std::nullptr_t, bool, std::int64_t, double> m_data;
+        enum class Type : std::uint8_t {
+            Null,
+            Boolean,
+            Integer,
+            Real,
+            Object,
+        };
+
+        Type m_type;
+        union {
+            bool m_boolean;
+            std::int64_t m_integer;
+            double m_real;
+            Object *m_object;
+        };
     };
 
     bool operator==(const Value &left, const Value &right);
@@ -88,31 +164,52 @@ namespace ferrit {
      * Outputs the value to the ostream. If the value cannot be formatted, the ostream's failbit is set.
      */
     std::ostream &operator<<(std::ostream &output, const Value &value);
+
+    /**
+     * The size of a buffer that can hold any Int or Real written by formatInteger or formatReal.
+     */
+    constexpr std::size_t MAX_NUMBER_LENGTH = 32;
+
+    /**
+     * Writes the decimal representation of an Int into the buffer, which must hold at least
+     * MAX_NUMBER_LENGTH characters.
+     *
+     * @return a pointer one past the last character written
+     */
+    char *formatInteger(std::int64_t value, char *buffer) noexcept;
+
+    /**
+     * Writes the shortest representation of a Real that reads back as the same value into the buffer,
+     * which must hold at least MAX_NUMBER_LENGTH characters. Finite reals always have digits on both
+     * sides of a period, so that they cannot be mistaken for Ints (eg '3.0' and '1.0e+20' rather than
+     * '3' and '1e+20').
+     *
+     * @return a pointer one past the last character written
+     */
+    char *formatReal(double value, char *buffer) noexcept;
 }
 
 template <>
-struct std::formatter<ferrit::Value> : std::formatter<std::string> {
+struct std::formatter<ferrit::Value> : std::formatter<std::string_view> {
     auto format(const ferrit::Value &value, std::format_context &ctx) {
-        std::string result;
+        // numbers are written into a buffer on the stack rather than a temporary string
+        char buffer[ferrit::MAX_NUMBER_LENGTH];
+        std::string objectString;
+        std::string_view result;
         if (value.isNull()) {
             result = "null";
         } else if (value.isBoolean()) {
-            result = value.asBoolean() ? "true" : "false";
+            result = value.asBooleanUnchecked() ? "true" : "false";
         } else if (value.isInteger()) {
-            result = std::format("{}", value.asInteger());
+            result = std::string_view{buffer, ferrit::formatInteger(value.asIntegerUnchecked(), buffer)};
         } else if (value.isReal()) {
-            result = std::format("{:#}", value.asReal());
-            // ensure that the formatted representation does not begin or end with a period
-            // (eg prefer '3.0' and '0.67' over '3', '3.' or '.67')
-            if (result.starts_with('.')) {
-                result.insert(0, ".");
-            }
-            if (result.ends_with('.')) {
-                result.append("0");
-            }
+            result = std::string_view{buffer, ferrit::formatReal(value.asRealUnchecked(), buffer)};
+        } else if (value.isObject()) {
+            objectString = value.asObjectUnchecked()->toString();
+            result = objectString;
         } else {
             throw std::format_error("unknown Value variant");
         }
-        return std::formatter<std::string>::format(result, ctx);
+        return std::formatter<std::string_view>::format(result, ctx);
     }
 };
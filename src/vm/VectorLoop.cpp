@@ -0,0 +1,112 @@
+#include "VectorLoop.h"
+#include "Array.h"
+#include "ArrayKernels.h"
+
+#include <algorithm>
+#include <numeric>
+
+
+namespace ferrit {
+    namespace {
+        template <typename T>
+        std::optional<std::int64_t> runBlocks(const VectorLoop &loop, Value *locals, std::int64_t start, std::int64_t last) {
+            // every index is checked here, once, instead of on every iteration
+            auto *target = static_cast<PackedArray<T> *>(locals[loop.targetSlot].asObjectUnchecked());
+            if (start < 0 || !target->isInBounds(last)) {
+                return {};
+            }
+
+            const auto &code = loop.code;
+            constexpr std::size_t BLOCK_SIZE = VectorLoop::BLOCK_SIZE;
+            // each operation gets a block of its own, and one more holds the -1s that negation multiplies by
+            std::vector<T> buffers((code.size() + 1) * BLOCK_SIZE);
+            T *minusOnes = buffers.data() + code.size() * BLOCK_SIZE;
+            std::fill_n(minusOnes, BLOCK_SIZE, T{-1});
+            std::vector<const T *> arrays(code.size());
+            for (std::size_t i = 0; i < code.size(); i++) {
+                T *buffer = buffers.data() + i * BLOCK_SIZE;
+                switch (code[i].op) {
+                case VectorOp::LoadElement: {
+                    auto *array = static_cast<PackedArray<T> *>(locals[code[i].slot].asObjectUnchecked());
+                    if (!array->isInBounds(last)) {
+                        return {};
+                    }
+                    arrays[i] = array->data();
+                    break;
+                }
+                // loop invariants are broadcast into their blocks once, rather than for every block
+                case VectorOp::LoadLocal:
+                    std::fill_n(buffer, BLOCK_SIZE, unbox<T>(locals[code[i].slot]));
+                    break;
+                case VectorOp::LoadConstant:
+                    std::fill_n(buffer, BLOCK_SIZE, unbox<T>(code[i].constant));
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            const ArrayKernels<T> &kernels = arrayKernels<T>();
+            T *targetData = target->data();
+            std::vector<const T *> operands;
+            operands.reserve(code.size());
+            for (std::int64_t position = start; position <= last; position += BLOCK_SIZE) {
+                auto offset = static_cast<std::size_t>(position);
+                std::size_t size = std::min(BLOCK_SIZE, static_cast<std::size_t>(last - position) + 1);
+                operands.clear();
+                for (std::size_t i = 0; i < code.size(); i++) {
+                    T *buffer = buffers.data() + i * BLOCK_SIZE;
+                    // the last operation stores straight into the target, which the kernels allow even
+                    // if one of its operands is the target itself
+                    T *result = i + 1 == code.size() ? targetData + offset : buffer;
+                    VectorOp op = code[i].op;
+                    switch (op) {
+                    case VectorOp::LoadElement:
+                        operands.push_back(arrays[i] + offset);
+                        break;
+                    case VectorOp::LoadLocal:
+                    case VectorOp::LoadConstant:
+                        operands.push_back(buffer);
+                        break;
+                    case VectorOp::LoadIndex:
+                        if constexpr (std::is_same_v<T, std::int64_t>) {
+                            std::iota(buffer, buffer + size, position);
+                        }
+                        operands.push_back(buffer);
+                        break;
+                    case VectorOp::Negate:
+                        // multiplying by -1 rather than subtracting from 0 keeps the sign of -0.0
+                        kernels.multiply(minusOnes, operands.back(), result, size);
+                        operands.back() = result;
+                        break;
+                    default: {
+                        const T *right = operands.back();
+                        operands.pop_back();
+                        auto kernel = op == VectorOp::Add ? kernels.add
+                            : op == VectorOp::Subtract ? kernels.subtract
+                            : op == VectorOp::Multiply ? kernels.multiply
+                            : kernels.divide;
+                        kernel(operands.back(), right, result, size);
+                        operands.back() = result;
+                        break;
+                    }
+                    }
+                }
+
+                // a body that is a single load, such as 'a[i] = b[i]', has not stored anything yet
+                if (operands.back() != targetData + offset) {
+                    std::copy_n(operands.back(), size, targetData + offset);
+                }
+            }
+            return last + 1;
+        }
+    }
+
+    std::optional<std::int64_t> VectorLoop::run(Value *locals, std::int64_t start, std::int64_t end) const {
+        if (start > end || (start == end && !isInclusive)) {
+            return {};
+        }
+        std::int64_t last = isInclusive ? end : end - 1;
+        return isReal ? runBlocks<double>(*this, locals, start, last) : runBlocks<std::int64_t>(*this, locals, start, last);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Value.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+
+namespace ferrit {
+    /**
+     * An operation in the body of a vectorized loop. Each one produces a block of elements, one
+     * per iteration, and the arithmetic operations consume the blocks of the operations before them.
+     */
+    enum class VectorOp : std::uint8_t {
+        // The element of the array in a local slot at the loop variable's index.
+        LoadElement,
+        // The value of a local slot, which stays the same for the whole loop.
+        LoadLocal,
+        LoadConstant,
+        // The loop variable itself.
+        LoadIndex,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Negate,
+    };
+
+    struct VectorInstruction {
+        VectorOp op;
+        /** The local slot that loads read from. */
+        std::uint8_t slot{0};
+        /** The value of a constant load. */
+        Value constant{};
+    };
+
+    /**
+     * A range loop whose body assigns one element of an Int or Real array per iteration, such as
+     * <tt>for (i in 0..n) out[i] = a[i] * k + b[i]</tt>.
+     *
+     * Such a loop is run a block of iterations at a time, evaluating each operation of its body over
+     * the whole block with the array kernels, rather than one iteration at a time in bytecode. This
+     * gives the same results because every array is only ever read and written at the loop
+     * variable's index, so no iteration can observe another's store.
+     *
+     * The bounds checks of the body are hoisted out of the loop: it only runs if every index is in
+     * bounds of every array. Otherwise, the compiled loop runs instead, and panics at the same
+     * iteration it always would.
+     */
+    struct VectorLoop {
+        bool isReal;
+        bool isInclusive;
+        /** The local slot of the array that the body assigns to. */
+        std::uint8_t targetSlot;
+        /** The body's right-hand side, in postfix order. */
+        std::vector<VectorInstruction> code;
+
+        /**
+         * Runs the loop over the given range, unless an index would be out of bounds or the
+         * range is empty.
+         *
+         * @param locals the first local slot of the frame that the loop runs in
+         * @param start the first value of the loop variable
+         * @param end the end of the range
+         * @return the value of the loop variable after the last iteration, or nothing if the loop did not run
+         */
+        [[nodiscard]] std::optional<std::int64_t> run(Value *locals, std::int64_t start, std::int64_t end) const;
+
+        /** The number of iterations that each operation is evaluated for at once. */
+        static constexpr std::size_t BLOCK_SIZE = 256;
+        /** The maximum number of operations in the body of a vectorized loop. */
+        static constexpr std::size_t MAX_OPERATIONS = 32;
+    };
+}
@@ -1,33 +1,141 @@
 #include "VirtualMachine.h"
+#include "Array.h"
+#include "ArrayKernels.h"
 #include "Disassembler.h"
+#include "File.h"
+#include "MappedFile.h"
+#include "String.h"
+#include "Task.h"
+#include "TaskScheduler.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <cmath>
+#include <memory>
 #include <stdexcept>
 #include <format>
+#include <system_error>
+#include <type_traits>
+#include <utility>
 
 namespace ferrit {
-    VirtualMachine::VirtualMachine(NativeHandler natives) noexcept :
-        m_natives{natives} {
+    VirtualMachine::VirtualMachine(NativeHandler natives) :
+        VirtualMachine{natives, nullptr} {
     }
 
-    VirtualMachine::VirtualMachine(NativeHandler natives, std::ostream *traceLog) noexcept :
+    VirtualMachine::VirtualMachine(NativeHandler natives, std::ostream *traceLog) :
         m_natives{natives}, m_traceLog{traceLog} {
+        m_heap.setRootScanner([this](Heap &heap) { traceRoots(heap); });
+        if (m_traceLog) {
+            // the trace is written straight to its stream, so printed lines must not lag behind it
+            m_natives.setLineBuffered(true);
+        }
     }
 
-    void VirtualMachine::init(const Chunk &chunk) {
-        m_chunk = chunk;
-        m_ip = 0;
+    VirtualMachine::~VirtualMachine() = default;
+
+    void VirtualMachine::load(std::shared_ptr<const Program> program) {
         m_stack.clear();
+        m_frames.clear();
+        m_frame = nullptr;
+        m_fiber = Value{};
+        m_mainStack.clear();
+        m_mainFrames.clear();
+        m_isMainFinished = false;
+        m_readyFibers.clear();
+        // I/O started by a run that panicked has nobody left to wait for it
+        if (m_eventLoop) {
+            m_eventLoop->cancelAll();
+        }
+        m_pendingIo.clear();
+        m_fileWaiters.clear();
+        if (!m_standardInput.isNull()) {
+            static_cast<File *>(m_standardInput.asObjectUnchecked())->release(m_heap);
+        }
+        if (program == m_program) {
+            // everything below only depends on the program, so running it again can reuse it all
+            return;
+        }
+        m_program = std::move(program);
+
+        m_loopHitCounts.clear();
+        for (const auto &function : m_program->functions()) {
+            m_loopHitCounts.emplace_back(function.chunk.loopHeaders().size(), 0);
+        }
+
+        // string literals become heap objects as soon as the program is loaded, interned so that
+        // every literal with the same contents is the same object
+        m_internedStrings.clear();
+        m_stringLiterals.clear();
+        m_stringLiterals.resize(m_program->functions().size());
+        for (std::size_t i = 0; i < m_program->functions().size(); i++) {
+            for (const auto &literal : m_program->functions()[i].chunk.stringPool()) {
+                Value string = intern(literal);
+                m_stringLiterals[i].push_back(string);
+            }
+        }
+
+        // m_loopHitCounts and m_stringLiterals are fully built, so the pointers into them stay valid
+        m_callTargets.clear();
+        for (std::size_t i = 0; i < m_program->functions().size(); i++) {
+            const Function &function = m_program->functions()[i];
+            m_callTargets.push_back(CallTarget{
+                .chunk = &function.chunk,
+                .arity = function.arity,
+                .loopHitCounts = m_loopHitCounts[i].data(),
+                .stringLiterals = m_stringLiterals[i].data()});
+        }
+
+        // reserving every frame of the main fiber up front means that its calls never allocate.
+        // other fibers start out small and grow, which is why call() looks up m_frame again
+        m_frames.reserve(MAX_CALL_DEPTH);
+    }
+
+    void VirtualMachine::interpret(const Program &program) {
+        interpret(std::make_shared<const Program>(program));
     }
 
-    void VirtualMachine::interpret(const Chunk &chunk) {
-        init(chunk);
+    void VirtualMachine::interpret(std::shared_ptr<const Program> program) {
+        load(std::move(program));
+        call(Program::SCRIPT_INDEX);
+        run();
+    }
+
+    std::optional<Value> VirtualMachine::invoke(
+        std::shared_ptr<const Program> program, int functionIndex, std::span<const Value> arguments) {
+        const Function &function = program->functions().at(functionIndex);
+        if (functionIndex == Program::SCRIPT_INDEX) {
+            throw std::invalid_argument("the top-level script cannot be invoked as a function");
+        } else if (arguments.size() != function.parameterTypes.size()) {
+            throw std::invalid_argument(std::format("'{}' takes {} arguments, but was given {}",
+                function.name, function.parameterTypes.size(), arguments.size()));
+        }
+        // typed instructions read their operands without checking them, so a mistyped argument
+        // must be caught before it reaches the function
+        for (std::size_t i = 0; i < arguments.size(); i++) {
+            if (arguments[i].runtimeType() != function.parameterTypes[i]) {
+                throw std::invalid_argument(std::format("argument {} of '{}' must be of type {}, not {}",
+                    i + 1, function.name, function.parameterTypes[i].name(), arguments[i].runtimeType().name()));
+            }
+        }
+
+        load(std::move(program));
+        m_stack.assign(arguments.begin(), arguments.end());
+        call(functionIndex);
+        if (!run()) {
+            return {};
+        }
+        return m_result;
+    }
 
+    bool VirtualMachine::run() {
         bool run = true;
+        bool panicked = false;
         while (run) {
             if (m_traceLog) {
                 Disassembler debug{*m_traceLog};
-                debug.disassembleInstruction(m_chunk, m_ip);
+                debug.disassembleInstruction(*m_frame->chunk, m_frame->ip);
             }
 
             auto instruction = static_cast<OpCode>(readByte());
@@ -35,6 +143,7 @@ namespace ferrit {
                 run = interpretInstruction(instruction);
             } catch (const PanicError &) {
                 run = false;
+                panicked = true;
             }
 
             if (m_traceLog) {
@@ -49,6 +158,15 @@ namespace ferrit {
                 *m_traceLog << ']' << std::endl;
             }
         }
+
+        // whoever runs the program expects to see all of its output once it finishes. if that
+        // fails, the panic has already reported it, just like a panic in the program itself
+        try {
+            m_natives.flush(ctx());
+        } catch (const PanicError &) {
+            panicked = true;
+        }
+        return !panicked;
     }
 
     bool VirtualMachine::interpretInstruction(OpCode instruction) {
@@ -56,32 +174,50 @@ namespace ferrit {
         case OpCode::NoOp:
             break;
         case OpCode::Constant:
-            push(readConstant());
+            push(readConstant(false));
+            break;
+        case OpCode::ConstantLong:
+            push(readConstant(true));
             break;
+        case OpCode::String: {
+            std::uint16_t index = readShort();
+            push(m_frame->stringLiterals[index]);
+            break;
+        }
         case OpCode::Pop:
             pop();
             break;
+        case OpCode::GetLocal: {
+            std::uint8_t slot = readByte();
+            push(local(slot));
+            break;
+        }
+        case OpCode::SetLocal: {
+            std::uint8_t slot = readByte();
+            local(slot) = peek(0);
+            break;
+        }
         case OpCode::IAdd: {
-            std::int64_t right = pop().asInteger();
-            std::int64_t left = pop().asInteger();
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
             push(Value{left + right});
             break;
         }
         case OpCode::ISubtract: {
-            std::int64_t right = pop().asInteger();
-            std::int64_t left = pop().asInteger();
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
             push(Value{left - right});
             break;
         }
         case OpCode::IMultiply: {
-            std::int64_t right = pop().asInteger();
-            std::int64_t left = pop().asInteger();
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
             push(Value{left * right});
             break;
         }
         case OpCode::IDivide: {
-            std::int64_t right = pop().asInteger();
-            std::int64_t left = pop().asInteger();
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
             if (right == 0) {
                 m_natives.panic(ctx(), "error: attempted divide by zero");
             }
@@ -89,8 +225,8 @@ namespace ferrit {
             break;
         }
         case OpCode::IModulus: {
-            std::int64_t right = pop().asInteger();
-            std::int64_t left = pop().asInteger();
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
             if (right == 0) {
                 m_natives.panic(ctx(), "error: attempted divide by zero");
             }
@@ -98,91 +234,406 @@ namespace ferrit {
             break;
         }
         case OpCode::INegate: {
-            std::int64_t argument = pop().asInteger();
+            std::int64_t argument = pop().asIntegerUnchecked();
             push(Value{-argument});
             break;
         }
+        case OpCode::IEqual: {
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            push(Value{left == right});
+            break;
+        }
+        case OpCode::INotEqual: {
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            push(Value{left != right});
+            break;
+        }
+        case OpCode::ILess: {
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            push(Value{left < right});
+            break;
+        }
+        case OpCode::ILessEqual: {
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            push(Value{left <= right});
+            break;
+        }
+        case OpCode::IGreater: {
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            push(Value{left > right});
+            break;
+        }
+        case OpCode::IGreaterEqual: {
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            push(Value{left >= right});
+            break;
+        }
         case OpCode::FAdd: {
-            double right = pop().asReal();
-            double left = pop().asReal();
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
             push(Value{left + right});
             break;
         }
         case OpCode::FSubtract: {
-            double right = pop().asReal();
-            double left = pop().asReal();
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
             push(Value{left - right});
             break;
         }
         case OpCode::FMultiply: {
-            double right = pop().asReal();
-            double left = pop().asReal();
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
             push(Value{left * right});
             break;
         }
         case OpCode::FDivide: {
-            double right = pop().asReal();
-            double left = pop().asReal();
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
             // note division by zero is allowed for reals
             push(Value{left / right});
             break;
         }
         case OpCode::FModulus: {
-            double right = pop().asReal();
-            double left = pop().asReal();
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
             push(Value{std::fmod(left, right)});
             break;
         }
         case OpCode::FNegate: {
-            double argument = pop().asReal();
+            double argument = pop().asRealUnchecked();
             push(Value{-argument});
             break;
         }
+        case OpCode::FEqual: {
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
+            push(Value{left == right});
+            break;
+        }
+        case OpCode::FNotEqual: {
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
+            push(Value{left != right});
+            break;
+        }
+        case OpCode::FLess: {
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
+            push(Value{left < right});
+            break;
+        }
+        case OpCode::FLessEqual: {
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
+            push(Value{left <= right});
+            break;
+        }
+        case OpCode::FGreater: {
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
+            push(Value{left > right});
+            break;
+        }
+        case OpCode::FGreaterEqual: {
+            double right = pop().asRealUnchecked();
+            double left = pop().asRealUnchecked();
+            push(Value{left >= right});
+            break;
+        }
         case OpCode::BAnd: {
-            bool right = pop().asBoolean();
-            bool left = pop().asBoolean();
+            bool right = pop().asBooleanUnchecked();
+            bool left = pop().asBooleanUnchecked();
             push(Value{left && right});
             break;
         }
         case OpCode::BOr: {
-            bool right = pop().asBoolean();
-            bool left = pop().asBoolean();
+            bool right = pop().asBooleanUnchecked();
+            bool left = pop().asBooleanUnchecked();
             push(Value{left || right});
             break;
         }
         case OpCode::BNot: {
-            bool argument = pop().asBoolean();
+            bool argument = pop().asBooleanUnchecked();
             push(Value{!argument});
             break;
         }
         case OpCode::BEqual: {
-            bool right = pop().asBoolean();
-            bool left = pop().asBoolean();
+            bool right = pop().asBooleanUnchecked();
+            bool left = pop().asBooleanUnchecked();
             push(Value{left == right});
             break;
         }
         case OpCode::BNotEqual: {
-            bool right = pop().asBoolean();
-            bool left = pop().asBoolean();
+            bool right = pop().asBooleanUnchecked();
+            bool left = pop().asBooleanUnchecked();
             push(Value{left != right});
             break;
         }
+        case OpCode::SConcat: {
+            // the operands stay on the stack until the result is allocated, since allocating may move them
+            Value result{String::concatenate(m_heap, peek(1), peek(0))};
+            pop();
+            peek(0) = result;
+            break;
+        }
+        case OpCode::SEqual:
+        case OpCode::SNotEqual: {
+            auto *right = static_cast<String *>(pop().asObjectUnchecked());
+            auto *left = static_cast<String *>(pop().asObjectUnchecked());
+            bool isEqual = String::equals(*left, *right, m_heap);
+            push(Value{instruction == OpCode::SEqual ? isEqual : !isEqual});
+            break;
+        }
+        case OpCode::INewArray:
+            newArray<std::int64_t>();
+            break;
+        case OpCode::FNewArray:
+            newArray<double>();
+            break;
+        case OpCode::BNewArray:
+            newArray<bool>();
+            break;
+        case OpCode::IArrayLiteral:
+            arrayLiteral<std::int64_t>(readShort());
+            break;
+        case OpCode::FArrayLiteral:
+            arrayLiteral<double>(readShort());
+            break;
+        case OpCode::BArrayLiteral:
+            arrayLiteral<bool>(readShort());
+            break;
+        case OpCode::ArrayLength: {
+            auto *array = static_cast<Array *>(pop().asObjectUnchecked());
+            push(Value{static_cast<std::int64_t>(array->length())});
+            break;
+        }
+        case OpCode::IIndexGet:
+            indexGet<std::int64_t, true>();
+            break;
+        case OpCode::IIndexSet:
+            indexSet<std::int64_t, true>();
+            break;
+        case OpCode::FIndexGet:
+            indexGet<double, true>();
+            break;
+        case OpCode::FIndexSet:
+            indexSet<double, true>();
+            break;
+        case OpCode::BIndexGet:
+            indexGet<bool, true>();
+            break;
+        case OpCode::BIndexSet:
+            indexSet<bool, true>();
+            break;
+        case OpCode::IIndexGetUnchecked:
+            indexGet<std::int64_t, false>();
+            break;
+        case OpCode::IIndexSetUnchecked:
+            indexSet<std::int64_t, false>();
+            break;
+        case OpCode::FIndexGetUnchecked:
+            indexGet<double, false>();
+            break;
+        case OpCode::FIndexSetUnchecked:
+            indexSet<double, false>();
+            break;
+        case OpCode::BIndexGetUnchecked:
+            indexGet<bool, false>();
+            break;
+        case OpCode::BIndexSetUnchecked:
+            indexSet<bool, false>();
+            break;
+        case OpCode::IArrayIntrinsic:
+            arrayIntrinsic<std::int64_t>(static_cast<ArrayIntrinsic>(readByte()));
+            break;
+        case OpCode::FArrayIntrinsic:
+            arrayIntrinsic<double>(static_cast<ArrayIntrinsic>(readByte()));
+            break;
         case OpCode::Return: {
-            if (!m_stack.empty()) {
-                m_natives.println(ctx(), std::format("{}", pop()));
+            if (m_frames.size() == 1) {
+                // returning from the outermost frame ends the fiber. the result of a spawned fiber is
+                // discarded, but the top-level script prints its value, if it has one, while a
+                // function invoked by the host hands its result back
+                if (m_fiber.isNull()) {
+                    if (m_frame->chunk != &m_program->script().chunk) {
+                        m_result = pop();
+                    } else if (!m_stack.empty()) {
+                        m_natives.println(ctx(), pop());
+                    }
+                }
+                return finishFiber();
             }
-            return false;
+
+            // discard the callee's arguments and locals, then replace them with the return value
+            Value result = pop();
+            m_stack.erase(m_stack.begin() + m_frame->base, m_stack.end());
+            m_frames.pop_back();
+            m_frame = &m_frames.back();
+            push(result);
+            break;
+        }
+        case OpCode::Call: {
+            std::uint16_t functionIndex = readShort();
+            call(functionIndex);
+            break;
         }
-        case OpCode::Jump: {
+        case OpCode::TailCall: {
+            std::uint16_t functionIndex = readShort();
+            tailCall(functionIndex);
+            break;
+        }
+        case OpCode::CallNative:
+            callNative(readShort());
+            break;
+        case OpCode::Spawn:
+            spawn(readShort());
+            break;
+        case OpCode::Yield:
+            yield();
+            break;
+        case OpCode::Resume:
+            resume();
+            break;
+        case OpCode::Fork:
+            fork(readShort());
+            break;
+        case OpCode::Join:
+            join();
+            break;
+        case OpCode::ParallelMap:
+            parallelMap(readShort());
+            break;
+        case OpCode::Io:
+            io(static_cast<IoOperation>(readByte()));
+            break;
+        case OpCode::Print: {
+            m_natives.println(ctx(), peek(0));
+            peek(0) = Value{};
+            break;
+        }
+        case OpCode::Jump:
+        case OpCode::JumpLong: {
+            std::uint32_t offset = instruction == OpCode::JumpLong ? readInt() : readShort();
+            m_frame->ip += offset;
+            break;
+        }
+        case OpCode::JumpIfFalse:
+        case OpCode::JumpIfFalseLong: {
+            std::uint32_t offset = instruction == OpCode::JumpIfFalseLong ? readInt() : readShort();
+            auto condition = pop().asBooleanUnchecked();
+            if (!condition) {
+                m_frame->ip += offset;
+            }
+            break;
+        }
+        case OpCode::IJumpIfEqual: {
             std::uint16_t offset = readShort();
-            m_ip += offset;
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            if (left == right) {
+                m_frame->ip += offset;
+            }
             break;
         }
-        case OpCode::JumpIfFalse: {
+        case OpCode::IJumpIfNotEqual: {
             std::uint16_t offset = readShort();
-            auto condition = pop().asBoolean();
-            if (!condition) {
-                m_ip += offset;
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            if (left != right) {
+                m_frame->ip += offset;
+            }
+            break;
+        }
+        case OpCode::IJumpIfLess: {
+            std::uint16_t offset = readShort();
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            if (left < right) {
+                m_frame->ip += offset;
+            }
+            break;
+        }
+        case OpCode::IJumpIfLessEqual: {
+            std::uint16_t offset = readShort();
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            if (left <= right) {
+                m_frame->ip += offset;
+            }
+            break;
+        }
+        case OpCode::IJumpIfGreater: {
+            std::uint16_t offset = readShort();
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            if (left > right) {
+                m_frame->ip += offset;
+            }
+            break;
+        }
+        case OpCode::IJumpIfGreaterEqual: {
+            std::uint16_t offset = readShort();
+            std::int64_t right = pop().asIntegerUnchecked();
+            std::int64_t left = pop().asIntegerUnchecked();
+            if (left >= right) {
+                m_frame->ip += offset;
+            }
+            break;
+        }
+        case OpCode::Loop:
+        case OpCode::LoopLong: {
+            std::uint32_t offset = instruction == OpCode::LoopLong ? readInt() : readShort();
+            std::uint16_t loopIndex = readShort();
+            loopBack(offset, loopIndex);
+            break;
+        }
+        case OpCode::ForRangeIntPrep:
+        case OpCode::ForRangeIntInclusivePrep:
+        case OpCode::ForRangeIntPrepLong:
+        case OpCode::ForRangeIntInclusivePrepLong: {
+            // Replaces the range's end with the number of iterations remaining after the first,
+            // or skips the loop entirely if the range is empty. The count is computed with
+            // unsigned arithmetic so that ranges spanning the entire Int domain do not overflow.
+            bool isLong = instruction == OpCode::ForRangeIntPrepLong ||
+                instruction == OpCode::ForRangeIntInclusivePrepLong;
+            bool isInclusive = instruction == OpCode::ForRangeIntInclusivePrep ||
+                instruction == OpCode::ForRangeIntInclusivePrepLong;
+            std::uint32_t offset = isLong ? readInt() : readShort();
+            std::int64_t end = peek(0).asIntegerUnchecked();
+            std::int64_t start = peek(1).asIntegerUnchecked();
+            if (start < end || (isInclusive && start == end)) {
+                auto remaining = static_cast<std::uint64_t>(end) - static_cast<std::uint64_t>(start);
+                if (!isInclusive) {
+                    remaining--;
+                }
+                peek(0) = Value{static_cast<std::int64_t>(remaining)};
+            } else {
+                m_frame->ip += offset;
+            }
+            break;
+        }
+        case OpCode::VectorLoop: {
+            const VectorLoop &loop = m_frame->chunk->vectorLoops()[readShort()];
+            if (auto next = loop.run(&m_stack[m_frame->base], peek(1).asIntegerUnchecked(), peek(0).asIntegerUnchecked())) {
+                peek(1) = Value{*next};
+            }
+            break;
+        }
+        case OpCode::ForRangeInt:
+        case OpCode::ForRangeIntLong: {
+            std::uint32_t offset = instruction == OpCode::ForRangeIntLong ? readInt() : readShort();
+            std::uint16_t loopIndex = readShort();
+            auto remaining = static_cast<std::uint64_t>(peek(0).asIntegerUnchecked());
+            if (remaining > 0) {
+                peek(0) = Value{static_cast<std::int64_t>(remaining - 1)};
+                peek(1) = Value{peek(1).asIntegerUnchecked() + 1};
+                loopBack(offset, loopIndex);
             }
             break;
         }
@@ -192,6 +643,149 @@ namespace ferrit {
         return true;
     }
 
+    template <typename T>
+    void VirtualMachine::newArray() {
+        T fill = unbox<T>(pop());
+        std::int64_t size = pop().asIntegerUnchecked();
+        if (size < 0) {
+            m_natives.panic(ctx(), std::format("error: negative array size {}", size));
+        }
+        push(Value{m_heap.allocate<PackedArray<T>>(static_cast<std::size_t>(size), fill)});
+    }
+
+    template <typename T>
+    void VirtualMachine::arrayLiteral(std::uint16_t count) {
+        if (m_stack.size() < count) {
+            throw std::runtime_error("attempted to pop value off empty stack");
+        }
+
+        // the elements are primitives, so they are not affected by the allocation collecting garbage
+        auto *array = m_heap.allocate<PackedArray<T>>(count, T{});
+        auto first = m_stack.end() - count;
+        for (std::uint16_t i = 0; i < count; i++) {
+            array->set(i, unbox<T>(first[i]));
+        }
+        m_stack.erase(first, m_stack.end());
+        push(Value{array});
+    }
+
+    template <typename T, bool checkBounds>
+    void VirtualMachine::indexGet() {
+        std::int64_t index = pop().asIntegerUnchecked();
+        auto *array = static_cast<PackedArray<T> *>(pop().asObjectUnchecked());
+        if constexpr (checkBounds) {
+            if (!array->isInBounds(index)) {
+                panicOutOfBounds(*array, index);
+            }
+        }
+        push(Value{array->get(index)});
+    }
+
+    template <typename T, bool checkBounds>
+    void VirtualMachine::indexSet() {
+        Value value = pop();
+        std::int64_t index = pop().asIntegerUnchecked();
+        auto *array = static_cast<PackedArray<T> *>(peek(0).asObjectUnchecked());
+        if constexpr (checkBounds) {
+            if (!array->isInBounds(index)) {
+                panicOutOfBounds(*array, index);
+            }
+        }
+        array->set(index, unbox<T>(value));
+        peek(0) = value;
+    }
+
+    void VirtualMachine::panicOutOfBounds(const Array &array, std::int64_t index) {
+        m_natives.panic(ctx(), std::format("error: index {} is out of bounds for an array of size {}", index, array.length()));
+    }
+
+    template <typename T>
+    void VirtualMachine::arrayIntrinsic(ArrayIntrinsic intrinsic) {
+        const ArrayKernels<T> &kernels = arrayKernels<T>();
+        switch (intrinsic) {
+        case ArrayIntrinsic::Sum:
+        case ArrayIntrinsic::Min:
+        case ArrayIntrinsic::Max: {
+            auto *array = static_cast<PackedArray<T> *>(pop().asObjectUnchecked());
+            if (intrinsic == ArrayIntrinsic::Sum) {
+                push(Value{kernels.sum(array->data(), array->length())});
+                break;
+            } else if (array->length() == 0) {
+                const char *extreme = intrinsic == ArrayIntrinsic::Min ? "minimum" : "maximum";
+                m_natives.panic(ctx(), std::format("error: cannot take the {} of an empty array", extreme));
+            }
+            auto kernel = intrinsic == ArrayIntrinsic::Min ? kernels.min : kernels.max;
+            push(Value{kernel(array->data(), array->length())});
+            break;
+        }
+        case ArrayIntrinsic::Dot: {
+            auto *right = static_cast<PackedArray<T> *>(pop().asObjectUnchecked());
+            auto *left = static_cast<PackedArray<T> *>(pop().asObjectUnchecked());
+            checkSameLength(*left, *right);
+            push(Value{kernels.dot(left->data(), right->data(), left->length())});
+            break;
+        }
+        case ArrayIntrinsic::Add:
+        case ArrayIntrinsic::Subtract:
+        case ArrayIntrinsic::Multiply:
+        case ArrayIntrinsic::Divide: {
+            // the operands stay on the stack until the result is allocated, since that may move them
+            std::size_t length = static_cast<Array *>(peek(1).asObjectUnchecked())->length();
+            checkSameLength(*static_cast<Array *>(peek(1).asObjectUnchecked()), *static_cast<Array *>(peek(0).asObjectUnchecked()));
+            if constexpr (std::is_same_v<T, std::int64_t>) {
+                auto *divisor = static_cast<PackedArray<T> *>(peek(0).asObjectUnchecked());
+                if (intrinsic == ArrayIntrinsic::Divide && kernels.indexOf(divisor->data(), length, 0) >= 0) {
+                    m_natives.panic(ctx(), "error: attempted divide by zero");
+                }
+            }
+            auto *result = m_heap.allocate<PackedArray<T>>(length, T{});
+            auto *right = static_cast<PackedArray<T> *>(pop().asObjectUnchecked());
+            auto *left = static_cast<PackedArray<T> *>(pop().asObjectUnchecked());
+            auto kernel = intrinsic == ArrayIntrinsic::Add ? kernels.add
+                : intrinsic == ArrayIntrinsic::Subtract ? kernels.subtract
+                : intrinsic == ArrayIntrinsic::Multiply ? kernels.multiply
+                : kernels.divide;
+            kernel(left->data(), right->data(), result->data(), length);
+            push(Value{result});
+            break;
+        }
+        case ArrayIntrinsic::Fill: {
+            T value = unbox<T>(pop());
+            auto *array = static_cast<PackedArray<T> *>(pop().asObjectUnchecked());
+            std::fill_n(array->data(), array->length(), value);
+            push(Value{});
+            break;
+        }
+        case ArrayIntrinsic::Copy: {
+            auto *into = static_cast<PackedArray<T> *>(pop().asObjectUnchecked());
+            auto *from = static_cast<PackedArray<T> *>(pop().asObjectUnchecked());
+            if (into->length() < from->length()) {
+                m_natives.panic(ctx(), std::format("error: cannot copy an array of size {} into an array of size {}",
+                    from->length(), into->length()));
+            }
+            if (from != into) {
+                std::copy_n(from->data(), from->length(), into->data());
+            }
+            push(Value{});
+            break;
+        }
+        case ArrayIntrinsic::IndexOf: {
+            T value = unbox<T>(pop());
+            auto *array = static_cast<PackedArray<T> *>(pop().asObjectUnchecked());
+            push(Value{kernels.indexOf(array->data(), array->length(), value)});
+            break;
+        }
+        default:
+            throw std::runtime_error(std::format("Unknown array intrinsic '{}'", static_cast<int>(intrinsic)));
+        }
+    }
+
+    void VirtualMachine::checkSameLength(const Array &left, const Array &right) {
+        if (left.length() != right.length()) {
+            m_natives.panic(ctx(), std::format("error: array sizes {} and {} do not match", left.length(), right.length()));
+        }
+    }
+
     void VirtualMachine::push(Value value) {
         m_stack.push_back(value);
     }
@@ -206,34 +800,642 @@ namespace ferrit {
         return result;
     }
 
+    Value &VirtualMachine::peek(int distance) {
+        if (distance >= static_cast<int>(m_stack.size())) {
+            throw std::runtime_error("attempted to peek past bottom of stack");
+        }
+        return m_stack[m_stack.size() - 1 - distance];
+    }
+
+    Value &VirtualMachine::local(int slot) {
+        int index = m_frame->base + slot;
+        if (index >= static_cast<int>(m_stack.size())) {
+            throw std::runtime_error(std::format("attempted to access invalid local slot '{}'", slot));
+        }
+        return m_stack[index];
+    }
+
+    void VirtualMachine::call(int functionIndex) {
+        if (m_frames.size() >= MAX_CALL_DEPTH) {
+            m_natives.panic(ctx(), "error: stack overflow");
+        }
+
+        const CallTarget &target = m_callTargets.at(functionIndex);
+        m_frames.push_back(CallFrame{
+            .chunk = target.chunk,
+            .ip = 0,
+            .base = static_cast<int>(m_stack.size()) - target.arity,
+            .loopHitCounts = target.loopHitCounts,
+            .stringLiterals = target.stringLiterals});
+        m_frame = &m_frames.back();
+    }
+
+    void VirtualMachine::callNative(int nativeIndex) {
+        const NativeFunction &native = m_program->nativeFunctions()[nativeIndex];
+        auto arguments = m_stack.end() - static_cast<std::ptrdiff_t>(native.parameterTypes.size());
+        Value result;
+        try {
+            result = native.trampoline(native.function, std::to_address(arguments), m_heap);
+        } catch (const std::exception &exception) {
+            m_natives.panic(ctx(), std::format("error: native function '{}' failed: {}", native.name, exception.what()));
+        }
+        m_stack.erase(arguments, m_stack.end());
+        push(result);
+    }
+
+    void VirtualMachine::spawn(int functionIndex) {
+        const CallTarget &target = m_callTargets.at(functionIndex);
+        auto *fiber = m_heap.allocate<Fiber>(CallFrame{
+            .chunk = target.chunk,
+            .ip = 0,
+            .base = 0,
+            .loopHitCounts = target.loopHitCounts,
+            .stringLiterals = target.stringLiterals});
+
+        // the arguments are only read once the fiber exists, since allocating it may have moved them
+        auto arguments = m_stack.end() - target.arity;
+        fiber->setArguments(m_heap, std::span{arguments, m_stack.end()});
+        m_stack.erase(arguments, m_stack.end());
+        m_readyFibers.emplace_back(fiber);
+        push(Value{fiber});
+    }
+
+    void VirtualMachine::yield() {
+        // the call to yield evaluates to null once the fiber continues
+        push(Value{});
+        // fibers whose I/O has finished get their turn before this one runs again
+        completeIo(false);
+        auto *fiber = static_cast<Fiber *>(m_fiber.isNull() ? nullptr : m_fiber.asObjectUnchecked());
+        if (fiber && fiber->hasResumer()) {
+            Value resumer = fiber->resumer();
+            fiber->clearResumer(m_heap);
+            fiber->setState(Fiber::State::Suspended);
+            switchTo(resumer);
+            push(Value{true});
+        } else if (!m_readyFibers.empty()) {
+            if (fiber) {
+                fiber->setState(Fiber::State::Suspended);
+            }
+            m_readyFibers.push_back(m_fiber);
+            runNextFiber();
+        }
+    }
+
+    void VirtualMachine::resume() {
+        auto *fiber = static_cast<Fiber *>(peek(0).asObjectUnchecked());
+        if (fiber->state() == Fiber::State::Finished) {
+            m_natives.panic(ctx(), "error: cannot resume a fiber that has finished");
+        } else if (fiber->state() == Fiber::State::Waiting) {
+            m_natives.panic(ctx(), "error: cannot resume a fiber that is waiting for I/O");
+        } else if (fiber->state() != Fiber::State::Suspended) {
+            m_natives.panic(ctx(), "error: cannot resume a fiber that is already running");
+        }
+
+        Value target = pop();
+        fiber->setResumer(m_heap, m_fiber);
+        if (!m_fiber.isNull()) {
+            static_cast<Fiber *>(m_fiber.asObjectUnchecked())->setState(Fiber::State::Resuming);
+        }
+        switchTo(target);
+    }
+
+    bool VirtualMachine::finishFiber() {
+        if (m_fiber.isNull()) {
+            m_isMainFinished = true;
+        } else {
+            auto *fiber = static_cast<Fiber *>(m_fiber.asObjectUnchecked());
+            fiber->setState(Fiber::State::Finished);
+            // a finished fiber keeps nothing alive
+            m_stack.clear();
+            m_frames.clear();
+            if (fiber->hasResumer()) {
+                Value resumer = fiber->resumer();
+                fiber->clearResumer(m_heap);
+                switchTo(resumer);
+                push(Value{false});
+                return true;
+            }
+        }
+
+        if (runNextFiber()) {
+            return true;
+        }
+        // once every fiber has finished, the main fiber's stacks are put back, just as if there had been no fibers
+        if (!m_fiber.isNull()) {
+            switchTo(Value{});
+        }
+        return false;
+    }
+
+    bool VirtualMachine::runNextFiber() {
+        while (true) {
+            while (!m_readyFibers.empty()) {
+                Value next = m_readyFibers.front();
+                m_readyFibers.pop_front();
+                // a fiber that was resumed directly may have finished while it waited in the queue
+                bool isRunnable = next.isNull()
+                    ? !m_isMainFinished
+                    : static_cast<Fiber *>(next.asObjectUnchecked())->state() == Fiber::State::Suspended;
+                if (isRunnable) {
+                    switchTo(next);
+                    return true;
+                }
+            }
+            // once every fiber is waiting, the thread sleeps until one of them can continue
+            if (m_pendingIo.empty()) {
+                return false;
+            }
+            completeIo(true);
+        }
+    }
+
+    void VirtualMachine::switchTo(const Value &fiber) {
+        Value target = fiber;
+        if (m_fiber.isNull()) {
+            m_mainStack.swap(m_stack);
+            m_mainFrames.swap(m_frames);
+        } else {
+            static_cast<Fiber *>(m_fiber.asObjectUnchecked())->swapStacks(m_heap, m_stack, m_frames);
+        }
+
+        if (target.isNull()) {
+            m_mainStack.swap(m_stack);
+            m_mainFrames.swap(m_frames);
+        } else {
+            auto *targetFiber = static_cast<Fiber *>(target.asObjectUnchecked());
+            targetFiber->swapStacks(m_heap, m_stack, m_frames);
+            targetFiber->setState(Fiber::State::Running);
+        }
+        m_fiber = target;
+        m_frame = &m_frames.back();
+    }
+
+    void VirtualMachine::fork(int functionIndex) {
+        const Function &function = m_program->functions()[functionIndex];
+        // the task may print before this VM flushes its output again, which would put its lines first
+        m_natives.flush(ctx());
+
+        // the compiler only lets primitives be passed to tasks, so the arguments can simply be copied
+        // out of this VM, into the one that makes the call
+        auto arguments = m_stack.end() - function.arity;
+        auto job = std::make_shared<Job>(
+            [program = m_program, functionIndex, arguments = std::vector<Value>{arguments, m_stack.end()}](VirtualMachine &vm) {
+                return vm.invoke(program, functionIndex, arguments);
+            });
+        m_stack.erase(arguments, m_stack.end());
+        scheduler().submit(job);
+        push(Value{m_heap.allocate<Task>(std::move(job), *Task::typeOf(function.returnType))});
+    }
+
+    void VirtualMachine::join() {
+        // nothing is allocated while waiting, so the task stays where it is
+        Job &job = static_cast<Task *>(peek(0).asObjectUnchecked())->job();
+        scheduler().wait(job);
+        if (!job.result()) {
+            // the task has already reported its own panic
+            m_natives.panic(ctx(), "error: a joined task panicked");
+        }
+        peek(0) = *job.result();
+    }
+
+    void VirtualMachine::parallelMap(int functionIndex) {
+        // the compiler only allows maps from and to primitives, whose arrays are all packed
+        const RuntimeType &resultType = m_program->functions()[functionIndex].returnType;
+        auto mapFrom = [&]<typename In>() {
+            if (resultType == RuntimeType::IntType) {
+                parallelMap<In, std::int64_t>(functionIndex);
+            } else if (resultType == RuntimeType::RealType) {
+                parallelMap<In, double>(functionIndex);
+            } else {
+                parallelMap<In, bool>(functionIndex);
+            }
+        };
+
+        RuntimeType arrayType = peek(0).asObjectUnchecked()->runtimeType();
+        if (arrayType == RuntimeType::IntArrayType) {
+            mapFrom.template operator()<std::int64_t>();
+        } else if (arrayType == RuntimeType::RealArrayType) {
+            mapFrom.template operator()<double>();
+        } else {
+            mapFrom.template operator()<bool>();
+        }
+    }
+
+    template <typename In, typename Out>
+    void VirtualMachine::parallelMap(int functionIndex) {
+        m_natives.flush(ctx());
+        std::size_t length = static_cast<Array *>(peek(0).asObjectUnchecked())->length();
+        auto *result = m_heap.allocate<PackedArray<Out>>(length, Out{});
+        // the elements live outside of the heap, so their addresses hold even if allocating moved the
+        // arrays. this VM does not run again until every chunk is done, so only the chunks touch them
+        const In *input = static_cast<PackedArray<In> *>(peek(0).asObjectUnchecked())->data();
+        Out *output = result->data();
+
+        TaskScheduler &scheduler = this->scheduler();
+        std::size_t chunkCount = std::min(length, scheduler.workerCount() * CHUNKS_PER_WORKER);
+        std::vector<std::shared_ptr<Job>> jobs;
+        jobs.reserve(chunkCount);
+        for (std::size_t chunk = 0; chunk < chunkCount; chunk++) {
+            std::size_t begin = length * chunk / chunkCount;
+            std::size_t end = length * (chunk + 1) / chunkCount;
+            jobs.push_back(std::make_shared<Job>(
+                [program = m_program, functionIndex, input, output, begin, end](VirtualMachine &vm) -> std::optional<Value> {
+                    for (std::size_t i = begin; i < end; i++) {
+                        Value argument{input[i]};
+                        std::optional<Value> element = vm.invoke(program, functionIndex, std::span{&argument, 1});
+                        if (!element) {
+                            return {};
+                        }
+                        output[i] = unbox<Out>(*element);
+                    }
+                    return Value{};
+                }));
+            scheduler.submit(jobs.back());
+        }
+
+        // every chunk has to finish before returning, even after one of them panicked, since they
+        // all write into the result
+        bool hasPanicked = false;
+        for (const auto &job : jobs) {
+            scheduler.wait(*job);
+            hasPanicked = hasPanicked || !job->result();
+        }
+        if (hasPanicked) {
+            m_natives.panic(ctx(), "error: a call in a parallel map panicked");
+        }
+        peek(0) = Value{result};
+    }
+
+    TaskScheduler &VirtualMachine::scheduler() {
+        if (!m_scheduler) {
+            m_ownScheduler = std::make_unique<TaskScheduler>(m_natives);
+            m_scheduler = m_ownScheduler.get();
+        }
+        return *m_scheduler;
+    }
+
+    void VirtualMachine::tailCall(int functionIndex) {
+        const CallTarget &target = m_callTargets.at(functionIndex);
+
+        // slide the new arguments down over the old frame, then restart it with the callee's code
+        auto arguments = m_stack.end() - target.arity;
+        std::move(arguments, m_stack.end(), m_stack.begin() + m_frame->base);
+        m_stack.erase(m_stack.begin() + m_frame->base + target.arity, m_stack.end());
+
+        m_frame->chunk = target.chunk;
+        m_frame->ip = 0;
+        m_frame->loopHitCounts = target.loopHitCounts;
+        m_frame->stringLiterals = target.stringLiterals;
+    }
+
     std::uint8_t VirtualMachine::readByte() {
-        m_ip++;
-        if (m_ip > m_chunk.size()) {
+        m_frame->ip++;
+        if (m_frame->ip > m_frame->chunk->size()) {
             throw std::runtime_error("attempted to read past end of bytecode");
         }
-        return m_chunk.byteAt(m_ip - 1);
+        return m_frame->chunk->byteAt(m_frame->ip - 1);
     }
 
     uint16_t VirtualMachine::readShort() {
-        m_ip += 2;
-        if (m_ip > m_chunk.size()) {
+        m_frame->ip += 2;
+        if (m_frame->ip > m_frame->chunk->size()) {
             throw std::runtime_error("attempted to read past end of bytecode");
         }
-        return m_chunk.shortAt(m_ip - 2);
+        return m_frame->chunk->shortAt(m_frame->ip - 2);
     }
 
-    Value VirtualMachine::readConstant() {
-        std::uint8_t constantIdx = readByte();
-        if (constantIdx >= m_chunk.constantPool().size()) {
+    std::uint32_t VirtualMachine::readInt() {
+        m_frame->ip += 4;
+        if (m_frame->ip > m_frame->chunk->size()) {
+            throw std::runtime_error("attempted to read past end of bytecode");
+        }
+        return m_frame->chunk->intAt(m_frame->ip - 4);
+    }
+
+    Value VirtualMachine::readConstant(bool isLong) {
+        std::uint16_t constantIdx = isLong ? readShort() : readByte();
+        if (constantIdx >= m_frame->chunk->constantPool().size()) {
             throw std::runtime_error(std::format("attempted to read invalid constant index '{}'", constantIdx));
         }
-        return m_chunk.constantPool().at(constantIdx);
+        return m_frame->chunk->constantPool().at(constantIdx);
+    }
+
+    void VirtualMachine::loopBack(std::uint32_t offset, std::uint16_t loopIndex) {
+        m_frame->loopHitCounts[loopIndex]++;
+        m_frame->ip -= offset;
+    }
+
+    const std::vector<std::uint64_t> &VirtualMachine::loopHitCounts() const {
+        return loopHitCounts(Program::SCRIPT_INDEX);
+    }
+
+    const std::vector<std::uint64_t> &VirtualMachine::loopHitCounts(int functionIndex) const {
+        return m_loopHitCounts.at(functionIndex);
+    }
+
+    Heap &VirtualMachine::heap() noexcept {
+        return m_heap;
+    }
+
+    void VirtualMachine::setScheduler(TaskScheduler *scheduler) noexcept {
+        m_scheduler = scheduler;
+    }
+
+    void VirtualMachine::io(IoOperation operation) {
+        switch (operation) {
+        case IoOperation::OpenFile:
+        case IoOperation::CreateFile: {
+            std::string path = static_cast<String *>(peek(0).asObjectUnchecked())->flatten(m_heap);
+            std::optional<int> descriptor = File::open(path, operation == IoOperation::CreateFile);
+            if (!descriptor) {
+                m_natives.panic(ctx(), std::format(
+                    "error: cannot open '{}': {}", path, std::generic_category().message(errno)));
+            }
+            peek(0) = Value{m_heap.allocate<File>(*descriptor, std::move(path), true)};
+            break;
+        }
+        case IoOperation::ReadLine: {
+            auto *file = static_cast<File *>(peek(0).asObjectUnchecked());
+            if (!useFile(*file, "read")) {
+                break;
+            }
+            if (std::optional<std::string> line = readLine(*file)) {
+                peek(0) = Value{m_heap.allocate<String>(std::move(*line))};
+            }
+            break;
+        }
+        case IoOperation::IsAtEnd: {
+            auto *file = static_cast<File *>(peek(0).asObjectUnchecked());
+            if (!useFile(*file, "read")) {
+                break;
+            }
+            // the end is only known once a read finds nothing more, so an empty buffer needs one
+            if (file->hasBufferedData() || file->isAtEnd()) {
+                peek(0) = Value{!file->hasBufferedData()};
+            } else {
+                readMore(*file);
+            }
+            break;
+        }
+        case IoOperation::Write: {
+            auto *file = static_cast<File *>(peek(1).asObjectUnchecked());
+            if (!useFile(*file, "write to")) {
+                break;
+            }
+            // the text is replaced with null once the write has started, so running the
+            // instruction again once it has finished only has to clean up
+            if (!peek(0).isNull()) {
+                const std::string &text = static_cast<String *>(peek(0).asObjectUnchecked())->flatten(m_heap);
+                if (!text.empty()) {
+                    m_frame->ip -= 2;
+                    eventLoop().write(file->descriptor(), text, startIo(file, text));
+                    peek(0) = Value{};
+                    waitForIo();
+                    break;
+                }
+            }
+            pop();
+            peek(0) = Value{};
+            break;
+        }
+        case IoOperation::Close: {
+            auto *file = static_cast<File *>(peek(0).asObjectUnchecked());
+            if (useFile(*file, "close")) {
+                file->close();
+                peek(0) = Value{};
+            }
+            break;
+        }
+        case IoOperation::Sleep: {
+            std::int64_t milliseconds = std::max<std::int64_t>(pop().asIntegerUnchecked(), 0);
+            push(Value{});
+            eventLoop().startTimer(std::chrono::milliseconds{milliseconds}, startIo(nullptr));
+            waitForIo();
+            break;
+        }
+        case IoOperation::ReadStandardInput: {
+            // only the process's own standard input can be waited for. any other stream, such as
+            // the one an embedder passed in, is read straight away
+            if (!m_natives.isStandardInput()) {
+                push(Value{m_heap.allocate<String>(m_natives.readln(ctx()))});
+                break;
+            }
+            if (m_standardInput.isNull()) {
+                m_standardInput = Value{m_heap.allocate<File>(0, "standard input", false)};
+            }
+            auto *input = static_cast<File *>(m_standardInput.asObjectUnchecked());
+            if (!useFile(*input, "read from")) {
+                break;
+            }
+            // a prompt printed before reading must be visible to whoever answers it
+            m_natives.flush(ctx());
+            if (std::optional<std::string> line = readLine(*input)) {
+                push(Value{m_heap.allocate<String>(std::move(*line))});
+            }
+            break;
+        }
+        case IoOperation::MapFile: {
+            std::string path = static_cast<String *>(peek(0).asObjectUnchecked())->flatten(m_heap);
+            std::optional<MappedFile> file = MappedFile::open(path);
+            if (!file) {
+                m_natives.panic(ctx(), std::format(
+                    "error: cannot map '{}': {}", path, std::generic_category().message(errno)));
+            }
+            peek(0) = Value{m_heap.allocate<MappedFile>(std::move(*file))};
+            break;
+        }
+        case IoOperation::HasNextLine:
+            peek(0) = Value{!static_cast<MappedFile *>(peek(0).asObjectUnchecked())->isAtEnd()};
+            break;
+        case IoOperation::NextLine: {
+            auto *file = static_cast<MappedFile *>(peek(0).asObjectUnchecked());
+            if (file->isAtEnd()) {
+                m_natives.panic(ctx(), std::format("error: cannot read past the end of '{}'", file->path()));
+            }
+            // the line is a slice of the mapping, so reading it copies nothing
+            std::string_view line = file->nextLine();
+            peek(0) = Value{m_heap.allocate<String>(peek(0), line)};
+            break;
+        }
+        default:
+            throw std::runtime_error(std::format("unknown I/O operation {}", static_cast<int>(operation)));
+        }
+    }
+
+    bool VirtualMachine::useFile(File &file, std::string_view action) {
+        if (!file.isOpen()) {
+            m_natives.panic(ctx(), std::format("error: cannot {} '{}' after it was closed", action, file.path()));
+        }
+        if (file.isHeld() && !file.isHeldBy(m_fiber)) {
+            // the other fiber is either waiting for its operation or has yet to pick up the result,
+            // so this fiber tries again once it has
+            m_frame->ip -= 2;
+            m_fileWaiters.push_back(m_fiber);
+            waitForIo();
+            return false;
+        }
+
+        if (file.isHeld()) {
+            file.release(m_heap);
+            for (Value &waiter : m_fileWaiters) {
+                if (!waiter.isNull()) {
+                    static_cast<Fiber *>(waiter.asObjectUnchecked())->setState(Fiber::State::Suspended);
+                }
+                m_readyFibers.push_back(waiter);
+            }
+            m_fileWaiters.clear();
+        }
+        if (int error = file.takeError()) {
+            m_natives.panic(ctx(), std::format(
+                "error: cannot {} '{}': {}", action, file.path(), std::generic_category().message(error)));
+        }
+        return true;
+    }
+
+    std::optional<std::string> VirtualMachine::readLine(File &file) {
+        std::optional<std::string> line = file.takeLine();
+        if (line) {
+            return line;
+        }
+        if (!file.isAtEnd()) {
+            readMore(file);
+            return {};
+        }
+        if (m_standardInput.isObject() && m_standardInput.asObjectUnchecked() == &file) {
+            m_natives.panic(ctx(), "could not read from standard input");
+        }
+        m_natives.panic(ctx(), std::format("error: cannot read past the end of '{}'", file.path()));
+        return {};
+    }
+
+    void VirtualMachine::readMore(File &file) {
+        m_frame->ip -= 2;
+        eventLoop().read(file.descriptor(), File::READ_SIZE, startIo(&file));
+        waitForIo();
+    }
+
+    std::uint64_t VirtualMachine::startIo(File *file, std::string data) {
+        std::uint64_t id = m_nextIoId++;
+        Value fileValue{};
+        if (file) {
+            file->hold(m_heap, m_fiber);
+            fileValue = Value{file};
+        }
+        m_pendingIo.emplace(id, PendingIo{.fiber = m_fiber, .file = fileValue, .data = std::move(data)});
+        return id;
+    }
+
+    void VirtualMachine::waitForIo() {
+        if (!m_fiber.isNull()) {
+            static_cast<Fiber *>(m_fiber.asObjectUnchecked())->setState(Fiber::State::Waiting);
+        }
+        // some I/O is pending, or a fiber that will release a file is, so some fiber is bound to run
+        runNextFiber();
+    }
+
+    void VirtualMachine::completeIo(bool block) {
+        if (m_pendingIo.empty()) {
+            return;
+        }
+        if (block) {
+            // the program's output so far should be visible while it waits, which may be for a
+            // while. the instruction that waits may have been rewound, so it has no context to give
+            m_natives.flush(ExecutionContext{});
+        }
+
+        m_completions.clear();
+        eventLoop().poll(block, m_completions);
+        for (EventLoop::Completion &completion : m_completions) {
+            auto it = m_pendingIo.find(completion.id);
+            PendingIo &pending = it->second;
+            if (!pending.file.isNull()) {
+                auto *file = static_cast<File *>(pending.file.asObjectUnchecked());
+                if (completion.result < 0) {
+                    file->setError(static_cast<int>(-completion.result));
+                } else if (!pending.data.empty()) {
+                    // a write that was cut short carries on with the rest before its fiber wakes up
+                    auto written = static_cast<std::size_t>(completion.result);
+                    if (written == 0) {
+                        file->setError(EIO);
+                    } else if (written < pending.data.size()) {
+                        pending.data.erase(0, written);
+                        eventLoop().write(file->descriptor(), pending.data, completion.id);
+                        continue;
+                    }
+                } else if (completion.result == 0) {
+                    file->setAtEnd();
+                } else {
+                    file->append(completion.data);
+                }
+            }
+
+            if (!pending.fiber.isNull()) {
+                static_cast<Fiber *>(pending.fiber.asObjectUnchecked())->setState(Fiber::State::Suspended);
+            }
+            m_readyFibers.push_back(pending.fiber);
+            m_pendingIo.erase(it);
+        }
+    }
+
+    EventLoop &VirtualMachine::eventLoop() {
+        if (!m_eventLoop) {
+            m_eventLoop = EventLoop::create();
+        }
+        return *m_eventLoop;
+    }
+
+    void VirtualMachine::setEventLoop(std::unique_ptr<EventLoop> eventLoop) {
+        m_eventLoop = std::move(eventLoop);
+    }
+
+    void VirtualMachine::traceRoots(Heap &heap) {
+        // call frames only refer to chunks, which the program owns, so every
+        // object the program can reach is referenced from the value stack
+        for (Value &value : m_stack) {
+            heap.trace(value);
+        }
+        // suspended fibers are reached through the fibers that refer to them, or the scheduler's queue
+        for (Value &value : m_mainStack) {
+            heap.trace(value);
+        }
+        for (Value &fiber : m_readyFibers) {
+            heap.trace(fiber);
+        }
+        heap.trace(m_fiber);
+        heap.trace(m_result);
+        // fibers that wait for I/O are only reachable through the I/O they wait for
+        for (auto &[id, pending] : m_pendingIo) {
+            heap.trace(pending.fiber);
+            heap.trace(pending.file);
+        }
+        for (Value &fiber : m_fileWaiters) {
+            heap.trace(fiber);
+        }
+        heap.trace(m_standardInput);
+        for (auto &literals : m_stringLiterals) {
+            for (Value &literal : literals) {
+                heap.trace(literal);
+            }
+        }
+        for (auto &[characters, string] : m_internedStrings) {
+            heap.trace(string);
+        }
+    }
+
+    Value VirtualMachine::intern(const std::string &characters) {
+        auto it = m_internedStrings.find(characters);
+        if (it != m_internedStrings.end()) {
+            return it->second;
+        }
+        Value string{m_heap.allocate<String>(characters, true)};
+        m_internedStrings.emplace(characters, string);
+        return string;
     }
 
     ExecutionContext VirtualMachine::ctx() const {
         // subtract 1 because we have already consumed the current instruction at this point
-        auto offset = m_ip - 1;
-        int line = m_chunk.getLineForOffset(offset);
+        auto offset = m_frame->ip - 1;
+        int line = m_frame->chunk->getLineForOffset(offset);
         return ExecutionContext{
             .line = line
         };
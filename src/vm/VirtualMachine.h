@@ -1,16 +1,32 @@
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <vector>
 #include <ostream>
 #include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 #include "Chunk.h"
+#include "EventLoop.h"
+#include "Fiber.h"
+#include "Heap.h"
 #include "NativeHandler.h"
+#include "Program.h"
 
 namespace ferrit {
+    class Array;
+    class File;
+    class TaskScheduler;
+
     /**
      * Executes compiled bytecode.
+     *
+     * A VM holds all of the state of a running program, and only reads the program itself. A VM
+     * must only be used by one thread at a time, but VMs on different threads can share a program.
      */
     class VirtualMachine final {
     public:
@@ -19,7 +35,7 @@ namespace ferrit {
          *
          * @param natives native function api
          */
-        explicit VirtualMachine(NativeHandler natives) noexcept;
+        explicit VirtualMachine(NativeHandler natives);
 
         /**
          * Constructs a new virtual machine with trace logging.
@@ -27,23 +43,154 @@ namespace ferrit {
          * @param natives native function api
          * @param traceLog optional ostream to print debug information to.
          */
-        explicit VirtualMachine(NativeHandler natives, std::ostream *traceLog) noexcept;
+        explicit VirtualMachine(NativeHandler natives, std::ostream *traceLog);
+
+        ~VirtualMachine();
+
+        // the heap refers back to the VM to find its roots
+        VirtualMachine(const VirtualMachine &) = delete;
+        VirtualMachine &operator=(const VirtualMachine &) = delete;
 
     private:
-        void init(const Chunk &chunk);
+        /**
+         * Prepares the VM to run the given program. Loading the program that is already loaded
+         * only resets the stack, so a program that is run many times is only set up once.
+         */
+        void load(std::shared_ptr<const Program> program);
+
+        /**
+         * Runs instructions until the outermost frame returns or the program panics.
+         *
+         * @return false if the program panicked
+         */
+        bool run();
 
     public:
         /**
-         * Interprets the given chunk.
+         * Interprets the given program, starting with its top-level script.
          *
-         * @param chunk the chunk to interpret
+         * @param program the program to interpret, which is copied
          * @throw if the VM attempts to perform an illegal operation
          */
-        void interpret(const Chunk &chunk);
+        void interpret(const Program &program);
+
+        /**
+         * Interprets the given program, starting with its top-level script. The program is shared
+         * rather than copied.
+         *
+         * @param program the program to interpret
+         * @throw if the VM attempts to perform an illegal operation
+         */
+        void interpret(std::shared_ptr<const Program> program);
+
+        /**
+         * Calls a function of the given program with the given arguments, without running the
+         * top-level script. Its loop counters keep counting across calls into the same program.
+         *
+         * An object that the function returns belongs to this VM's heap, so it is only valid until
+         * the VM runs again.
+         *
+         * @param program the program that declares the function
+         * @param functionIndex index of the function in <tt>Program::functions()</tt>
+         * @param arguments the arguments, which must match the function's parameter types
+         * @return the function's result, or nothing if it panicked
+         * @throw std::invalid_argument if the arguments do not match the function's parameters
+         */
+        std::optional<Value> invoke(std::shared_ptr<const Program> program, int functionIndex, std::span<const Value> arguments);
+
+        /**
+         * Returns the number of times each loop in the last interpreted script took its
+         * backward jump, indexed by the loop indices in <tt>Chunk::loopHeaders()</tt>.
+         * These counters are intended for profiling and for detecting hot loops.
+         */
+        [[nodiscard]] const std::vector<std::uint64_t> &loopHitCounts() const;
+
+        /**
+         * Returns the loop counters of the given function in the last interpreted program.
+         *
+         * @param functionIndex index of the function in <tt>Program::functions()</tt>
+         */
+        [[nodiscard]] const std::vector<std::uint64_t> &loopHitCounts(int functionIndex) const;
+
+        /**
+         * Returns the heap that the VM allocates objects on.
+         */
+        [[nodiscard]] Heap &heap() noexcept;
+
+        /**
+         * Makes the tasks that programs fork run on the given scheduler, which must outlive the VM.
+         * VMs that share a scheduler share its worker threads. A VM that is not given one starts its
+         * own the first time a task is forked, with a worker for every core.
+         */
+        void setScheduler(TaskScheduler *scheduler) noexcept;
+
+        /**
+         * Makes programs read, write and sleep through the given event loop. A VM that is not given
+         * one creates the best one this system supports the first time a program waits for I/O.
+         * Must not be called while a program is running.
+         */
+        void setEventLoop(std::unique_ptr<EventLoop> eventLoop);
+
+    public:
+        /** The maximum number of nested calls, including the top-level script. */
+        static constexpr std::size_t MAX_CALL_DEPTH = 4096;
+        /**
+         * The number of chunks per worker that a parallel map splits its array into. More chunks
+         * than workers lets the workers even out chunks that take longer than others.
+         */
+        static constexpr std::size_t CHUNKS_PER_WORKER = 4;
 
     private:
         bool interpretInstruction(OpCode instruction);
 
+        /**
+         * Reports every value the running program can reach to the garbage collector.
+         */
+        void traceRoots(Heap &heap);
+
+        /**
+         * Returns the interned string with the given contents, creating it if it does not exist yet.
+         */
+        Value intern(const std::string &characters);
+
+        /**
+         * Pops a size and a fill value, and pushes a new array with every element set to the value.
+         */
+        template <typename T>
+        void newArray();
+
+        /**
+         * Pops the given number of elements and pushes a new array holding them.
+         */
+        template <typename T>
+        void arrayLiteral(std::uint16_t count);
+
+        /**
+         * Pops an array and an index, and pushes the element at that index.
+         *
+         * @tparam checkBounds false if the compiler has proven that the index is in bounds
+         */
+        template <typename T, bool checkBounds>
+        void indexGet();
+
+        /**
+         * Pops an array, an index and a value, stores the value at that index, then pushes it back.
+         *
+         * @tparam checkBounds false if the compiler has proven that the index is in bounds
+         */
+        template <typename T, bool checkBounds>
+        void indexSet();
+
+        void panicOutOfBounds(const Array &array, std::int64_t index);
+
+        /**
+         * Runs a bulk operation on Int or Real arrays, using the fastest kernels this CPU supports.
+         */
+        template <typename T>
+        void arrayIntrinsic(ArrayIntrinsic intrinsic);
+
+        void checkSameLength(const Array &left, const Array &right);
+
         /**
          * Pushes a value to the stack.
          *
@@ -59,6 +206,169 @@ namespace ferrit {
          */
         Value pop();
 
+        /**
+         * Returns a reference to a value on the stack without popping it.
+         *
+         * @param distance how far down the stack to look. 0 = top of stack
+         * @return the value
+         * @throws std::runtime_error if the stack is not deep enough
+         */
+        Value &peek(int distance);
+
+        /**
+         * Returns a reference to the local variable in the given stack slot.
+         *
+         * @param slot the local's slot, as resolved by the compiler
+         * @return the value
+         * @throws std::runtime_error if the slot is not on the stack
+         */
+        Value &local(int slot);
+
+        /**
+         * Calls the given function. Its arguments must already be on the stack.
+         *
+         * @param functionIndex index of the function in the program
+         */
+        void call(int functionIndex);
+
+        /**
+         * Calls the given native function, replacing its arguments on the stack with its result.
+         * An exception that escapes the function makes the program panic.
+         *
+         * @param nativeIndex index of the native function in the program
+         */
+        void callNative(int nativeIndex);
+
+        /**
+         * Pops the arguments of the given function, and pushes a new fiber that will call it with
+         * them. The fiber is scheduled to run once the current fiber yields or finishes.
+         */
+        void spawn(int functionIndex);
+
+        /**
+         * Suspends the current fiber. A fiber that another fiber resumed returns to it; any other
+         * fiber goes to the back of the scheduler's queue, and the fiber at its front runs instead.
+         */
+        void yield();
+
+        /**
+         * Pops a fiber and runs it until it yields or finishes, after which the current fiber
+         * continues with whether it can be resumed again on its stack.
+         */
+        void resume();
+
+        /**
+         * Ends the current fiber, which has returned from its outermost frame.
+         *
+         * @return false if the program has finished, since no fiber is left to run
+         */
+        bool finishFiber();
+
+        /**
+         * Runs the next fiber in the scheduler's queue that has not finished yet.
+         *
+         * @return false if there was none
+         */
+        bool runNextFiber();
+
+        /**
+         * Makes the given fiber the running one, saving the stacks of the current fiber.
+         *
+         * @param fiber the fiber to run, or null for the main fiber
+         */
+        void switchTo(const Value &fiber);
+
+        /**
+         * Pops the arguments of the given function, and pushes a task that calls it with them in
+         * another VM. The call may start right away on another thread.
+         */
+        void fork(int functionIndex);
+
+        /**
+         * Pops a task and pushes its result once it has finished, panicking if it panicked. The
+         * thread runs other tasks while it waits, but every fiber of this VM is blocked until then.
+         */
+        void join();
+
+        /**
+         * Pops an array, and pushes a new array of the results of calling the given function on each
+         * of its elements. The array is split into chunks that run as tasks in parallel.
+         */
+        void parallelMap(int functionIndex);
+
+        template <typename In, typename Out>
+        void parallelMap(int functionIndex);
+
+        /**
+         * Returns the scheduler that forked tasks run on, starting one if there is none yet.
+         */
+        TaskScheduler &scheduler();
+
+        /**
+         * Runs an operation on a file or timer. An operation that has to wait for the event loop
+         * suspends the current fiber, and most run their instruction again once it is woken up.
+         */
+        void io(IoOperation operation);
+
+        /**
+         * Prepares a file for an operation by the current fiber, panicking if it has been closed or
+         * if the last operation that the fiber started on it failed.
+         *
+         * @param action what the operation does to the file, for error messages
+         * @return false if another fiber holds the file, in which case the current fiber has been
+         *         suspended to run the instruction again once that fiber is done with it
+         */
+        bool useFile(File &file, std::string_view action);
+
+        /**
+         * Takes the next line of a file, panicking if every line has been read.
+         *
+         * @return the line, or nothing if it has not been read yet, in which case the current fiber
+         *         has been suspended to read more and run the instruction again
+         */
+        std::optional<std::string> readLine(File &file);
+
+        /**
+         * Starts reading the next chunk of a file, suspending the current fiber to run the
+         * instruction again once it has been read.
+         */
+        void readMore(File &file);
+
+        /**
+         * Starts an operation on the event loop on behalf of the current fiber, which then waits
+         * for it while other fibers run.
+         *
+         * @param file the file the operation is on, which the fiber holds until it runs again,
+         *             or null for a timer
+         * @return the id to start the operation with
+         */
+        std::uint64_t startIo(File *file, std::string data = {});
+
+        /**
+         * Suspends the current fiber until the I/O it waits for finishes, and runs the next fiber.
+         */
+        void waitForIo();
+
+        /**
+         * Wakes up the fibers whose I/O has finished, putting them at the back of the queue.
+         *
+         * @param block whether to wait until some I/O finishes, if there is any in flight
+         */
+        void completeIo(bool block);
+
+        /**
+         * Returns the event loop, creating one if there is none yet.
+         */
+        EventLoop &eventLoop();
+
+        /**
+         * Calls the given function in place of the current one, reusing the current frame.
+         * The new arguments replace the current function's arguments and locals.
+         *
+         * @param functionIndex index of the function in the program
+         */
+        void tailCall(int functionIndex);
+
         /**
          * Reads the next byte from the bytecode and increments the instruction pointer.
          *
@@ -75,13 +385,30 @@ namespace ferrit {
          */
         std::uint16_t readShort();
 
+        /**
+         * Reads the next (big-endian) 32-bit integer from the bytecode, incrementing the instruction pointer as necessary.
+         *
+         * @return the integer
+         * @throws std::runtime_error if the end of the bytecode has been reached
+         */
+        std::uint32_t readInt();
+
         /**
          * Reads the constant specified by the instruction pointer and increments the pointer.
          *
+         * @param isLong whether the constant index is a short rather than a byte
          * @return the constant
          * @throws std::runtime_error if no such constant exists
          */
-        Value readConstant();
+        Value readConstant(bool isLong);
+
+        /**
+         * Jumps back to the start of the loop, counting the loop iteration.
+         *
+         * @param offset number of bytes to jump back
+         * @param loopIndex index of the loop in the chunk
+         */
+        void loopBack(std::uint32_t offset, std::uint16_t loopIndex);
 
         /**
          * Returns the current execution context
@@ -89,10 +416,66 @@ namespace ferrit {
         [[nodiscard]] ExecutionContext ctx() const;
 
     private:
+        /**
+         * Everything a call needs to know about its callee, resolved once when the program
+         * is loaded. Call sites are bound to a function index at compile time, so a call
+         * only has to index this table instead of going through the program and its counters.
+         */
+        struct CallTarget {
+            const Chunk *chunk;
+            int arity;
+            std::uint64_t *loopHitCounts;
+            const Value *stringLiterals;
+        };
+
         NativeHandler m_natives;
         std::ostream *m_traceLog{nullptr};
-        Chunk m_chunk{};
-        int m_ip{0};
+        std::shared_ptr<const Program> m_program{};
+        /** The value returned by the last invoked function. */
+        Value m_result{};
         std::vector<Value> m_stack{};
+        std::vector<CallFrame> m_frames{};
+        CallFrame *m_frame{nullptr};
+        /** The running fiber, or null while the main fiber, which runs the program's entry point, is running. */
+        Value m_fiber{};
+        /** The stacks of the main fiber while another fiber is running. */
+        std::vector<Value> m_mainStack{};
+        std::vector<CallFrame> m_mainFrames{};
+        bool m_isMainFinished{false};
+        /** The fibers waiting for the scheduler to run them, in order. Null stands for the main fiber. */
+        std::deque<Value> m_readyFibers{};
+        std::vector<std::vector<std::uint64_t>> m_loopHitCounts{};
+        std::vector<CallTarget> m_callTargets{};
+        std::unordered_map<std::string, Value> m_internedStrings{};
+        std::vector<std::vector<Value>> m_stringLiterals{};
+        TaskScheduler *m_scheduler{nullptr};
+        /** The scheduler that this VM started itself, if it was not given one. */
+        std::unique_ptr<TaskScheduler> m_ownScheduler{};
+
+        /**
+         * An operation that a fiber is waiting for. A write keeps the bytes that have not been
+         * written yet, so that it can carry on once the loop has written only some of them.
+         */
+        struct PendingIo {
+            Value fiber;
+            /** The file, or null for a timer. */
+            Value file;
+            /** The bytes left to write, which are never empty for a write. Empty for anything else. */
+            std::string data;
+        };
+
+        std::unique_ptr<EventLoop> m_eventLoop{};
+        std::unordered_map<std::uint64_t, PendingIo> m_pendingIo{};
+        std::uint64_t m_nextIoId{0};
+        std::vector<EventLoop::Completion> m_completions{};
+        /** The fibers waiting for another fiber to release a file, which all try again once it does. */
+        std::vector<Value> m_fileWaiters{};
+        /**
+         * Standard input, which is read through the event loop when the natives read from
+         * <tt>std::cin</tt>. It is created the first time it is read, and keeps any lines that
+         * were read ahead across runs.
+         */
+        Value m_standardInput{};
+        Heap m_heap{};
     };
 }
@@ -0,0 +1,57 @@
+#include "VirtualMachinePool.h"
+
+#include <utility>
+
+
+namespace ferrit {
+    VirtualMachinePool::Lease::Lease(VirtualMachinePool &pool, std::unique_ptr<VirtualMachine> vm) noexcept :
+        m_pool{&pool}, m_vm{std::move(vm)} {
+    }
+
+    VirtualMachinePool::Lease::Lease(Lease &&other) noexcept :
+        m_pool{other.m_pool}, m_vm{std::move(other.m_vm)} {
+    }
+
+    VirtualMachinePool::Lease::~Lease() {
+        if (m_vm) {
+            m_pool->release(std::move(m_vm));
+        }
+    }
+
+    VirtualMachine &VirtualMachinePool::Lease::operator*() const noexcept {
+        return *m_vm;
+    }
+
+    VirtualMachine *VirtualMachinePool::Lease::operator->() const noexcept {
+        return m_vm.get();
+    }
+
+    VirtualMachinePool::VirtualMachinePool(NativeHandler natives, std::size_t maxIdle) :
+        m_natives{std::move(natives)}, m_maxIdle{maxIdle} {
+    }
+
+    VirtualMachinePool::Lease VirtualMachinePool::acquire() {
+        {
+            std::lock_guard lock{m_mutex};
+            if (!m_idle.empty()) {
+                std::unique_ptr<VirtualMachine> vm = std::move(m_idle.back());
+                m_idle.pop_back();
+                return Lease{*this, std::move(vm)};
+            }
+        }
+        // creating a VM does not touch the pool, so it happens outside of the lock
+        return Lease{*this, std::make_unique<VirtualMachine>(m_natives)};
+    }
+
+    std::size_t VirtualMachinePool::idleCount() const {
+        std::lock_guard lock{m_mutex};
+        return m_idle.size();
+    }
+
+    void VirtualMachinePool::release(std::unique_ptr<VirtualMachine> vm) {
+        std::lock_guard lock{m_mutex};
+        if (m_idle.size() < m_maxIdle) {
+            m_idle.push_back(std::move(vm));
+        }
+    }
+}
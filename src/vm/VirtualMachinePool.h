@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "NativeHandler.h"
+#include "Script.h"
+#include "VirtualMachine.h"
+
+
+namespace ferrit {
+    /**
+     * A set of virtual machines that threads borrow to run scripts concurrently. Each VM keeps its
+     * heap and the state of the last program it loaded between uses, so calling into the same
+     * script again does not set it up again.
+     *
+     * Every VM writes to the streams of a copy of the same native handler, so those streams must be
+     * safe to use from several threads at once. The standard streams are.
+     */
+    class VirtualMachinePool final {
+    public:
+        /**
+         * A VM borrowed from the pool, which is given back when the lease is destroyed.
+         */
+        class Lease final {
+        public:
+            Lease(Lease &&other) noexcept;
+            Lease &operator=(Lease &&other) = delete;
+            ~Lease();
+
+            VirtualMachine &operator*() const noexcept;
+            VirtualMachine *operator->() const noexcept;
+
+        private:
+            friend class VirtualMachinePool;
+            explicit Lease(VirtualMachinePool &pool, std::unique_ptr<VirtualMachine> vm) noexcept;
+
+        private:
+            VirtualMachinePool *m_pool;
+            std::unique_ptr<VirtualMachine> m_vm;
+        };
+
+        /**
+         * Constructs an empty pool, which creates VMs as they are needed.
+         *
+         * @param natives the native function api that every VM gets a copy of
+         * @param maxIdle the number of returned VMs kept for reuse. Any more are destroyed.
+         */
+        explicit VirtualMachinePool(NativeHandler natives, std::size_t maxIdle = DEFAULT_MAX_IDLE);
+
+        VirtualMachinePool(const VirtualMachinePool &) = delete;
+        VirtualMachinePool &operator=(const VirtualMachinePool &) = delete;
+
+        /**
+         * Borrows an idle VM, or creates a new one if none are idle. The pool must outlive the lease.
+         */
+        [[nodiscard]] Lease acquire();
+
+        /**
+         * Calls an entry point on a borrowed VM. The result must not be an object, since the VM may
+         * collect it as soon as it is given back; use <tt>acquire</tt> to keep the VM for longer.
+         *
+         * @return the function's result, or nothing if it panicked
+         */
+        template <ScriptType Result, ScriptType... Args>
+        std::optional<Result> call(const EntryPoint<Result(Args...)> &entryPoint, std::type_identity_t<Args>... args) {
+            Lease vm = acquire();
+            return entryPoint(*vm, args...);
+        }
+
+        /**
+         * Returns the number of VMs that are waiting to be borrowed.
+         */
+        [[nodiscard]] std::size_t idleCount() const;
+
+    public:
+        static constexpr std::size_t DEFAULT_MAX_IDLE = 64;
+
+    private:
+        void release(std::unique_ptr<VirtualMachine> vm);
+
+    private:
+        NativeHandler m_natives;
+        std::size_t m_maxIdle;
+        mutable std::mutex m_mutex{};
+        std::vector<std::unique_ptr<VirtualMachine>> m_idle{};
+    };
+}
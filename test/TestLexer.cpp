@@ -32,6 +32,51 @@ namespace ferrit::tests {
             REQUIRE(tokens.value()[3] == Token{TokenType::EndOfFile, "", {1, 15}});
         }
 
+        SECTION("integer literals with suffixes") {
+            auto tokens = lexer.lex("10i 10L 10s 10b");
+            REQUIRE(tokens.has_value());
+            REQUIRE(tokens.value().size() == 5);
+            REQUIRE(tokens.value()[0] == Token{TokenType::IntegerLiteral, "10i", {1, 1}});
+            REQUIRE(tokens.value()[1] == Token{TokenType::IntegerLiteral, "10L", {1, 5}});
+            REQUIRE(tokens.value()[2] == Token{TokenType::IntegerLiteral, "10s", {1, 9}});
+            REQUIRE(tokens.value()[3] == Token{TokenType::IntegerLiteral, "10b", {1, 13}});
+            REQUIRE(tokens.value()[4] == Token{TokenType::EndOfFile, "", {1, 16}});
+        }
+
+        SECTION("integer literals with bases and separators") {
+            auto tokens = lexer.lex("0b1101_0010 0xB30C 0o17 1_000 0x7Fb 0b");
+            REQUIRE(tokens.has_value());
+            REQUIRE(tokens.value().size() == 7);
+            REQUIRE(tokens.value()[0] == Token{TokenType::IntegerLiteral, "0b1101_0010", {1, 1}});
+            REQUIRE(tokens.value()[1] == Token{TokenType::IntegerLiteral, "0xB30C", {1, 13}});
+            REQUIRE(tokens.value()[2] == Token{TokenType::IntegerLiteral, "0o17", {1, 20}});
+            REQUIRE(tokens.value()[3] == Token{TokenType::IntegerLiteral, "1_000", {1, 25}});
+            REQUIRE(tokens.value()[4] == Token{TokenType::IntegerLiteral, "0x7Fb", {1, 31}});
+            REQUIRE(tokens.value()[5] == Token{TokenType::IntegerLiteral, "0b", {1, 37}});
+            REQUIRE(tokens.value()[6] == Token{TokenType::EndOfFile, "", {1, 39}});
+        }
+
+        SECTION("integer literals with digits that their base does not allow") {
+            // these are only rejected once they are compiled
+            auto tokens = lexer.lex("0b102 0o79");
+            REQUIRE(tokens.has_value());
+            REQUIRE(tokens.value().size() == 3);
+            REQUIRE(tokens.value()[0] == Token{TokenType::IntegerLiteral, "0b102", {1, 1}});
+            REQUIRE(tokens.value()[1] == Token{TokenType::IntegerLiteral, "0o79", {1, 7}});
+        }
+
+        SECTION("float literals with exponents and suffixes") {
+            auto tokens = lexer.lex("6.022e23 1.0e-10 1.5e+3f 2.5d 1_000.000_1");
+            REQUIRE(tokens.has_value());
+            REQUIRE(tokens.value().size() == 6);
+            REQUIRE(tokens.value()[0] == Token{TokenType::FloatLiteral, "6.022e23", {1, 1}});
+            REQUIRE(tokens.value()[1] == Token{TokenType::FloatLiteral, "1.0e-10", {1, 10}});
+            REQUIRE(tokens.value()[2] == Token{TokenType::FloatLiteral, "1.5e+3f", {1, 18}});
+            REQUIRE(tokens.value()[3] == Token{TokenType::FloatLiteral, "2.5d", {1, 26}});
+            REQUIRE(tokens.value()[4] == Token{TokenType::FloatLiteral, "1_000.000_1", {1, 31}});
+            REQUIRE(tokens.value()[5] == Token{TokenType::EndOfFile, "", {1, 42}});
+        }
+
         SECTION("not float literals") {
             auto tokens = lexer.lex("100. .14");
             REQUIRE(tokens.has_value());
@@ -58,29 +103,30 @@ namespace ferrit::tests {
     TEST_CASE("invalid numeric literals", "[lexer]") {
         Lexer lexer;
 
-        SECTION("int literals with suffix") {
-            auto tokens = lexer.lex("10i");
-            REQUIRE(!tokens.has_value());
-            tokens = lexer.lex("10L");
+        SECTION("int literals with an unknown suffix") {
+            auto tokens = lexer.lex("10x");
             REQUIRE(!tokens.has_value());
-            tokens = lexer.lex("10s");
+            tokens = lexer.lex("10bs");
             REQUIRE(!tokens.has_value());
-            tokens = lexer.lex("10b");
+            tokens = lexer.lex("10Ls");
             REQUIRE(!tokens.has_value());
         }
 
-        SECTION("int literals with base") {
-            auto tokens = lexer.lex("0b1101_0010");
+        SECTION("int literals with a base but no digits") {
+            auto tokens = lexer.lex("0x");
+            REQUIRE(!tokens.has_value());
+            tokens = lexer.lex("0o");
             REQUIRE(!tokens.has_value());
-            tokens = lexer.lex("0xB30C");
+            tokens = lexer.lex("0xff");
             REQUIRE(!tokens.has_value());
         }
 
-        SECTION("float literals with exponent") {
-            auto tokens = lexer.lex("6.022e23");
+        SECTION("float literals with an incomplete exponent") {
+            auto tokens = lexer.lex("6.022e");
             REQUIRE(!tokens.has_value());
-
-            tokens = lexer.lex("1.0e-10");
+            tokens = lexer.lex("1.0e-");
+            REQUIRE(!tokens.has_value());
+            tokens = lexer.lex("1e10");
             REQUIRE(!tokens.has_value());
         }
 
@@ -0,0 +1,277 @@
+#include "TestUtil.h"
+#include "vm/BytecodeInterpreter.h"
+#include "vm/NativeRegistry.h"
+#include "vm/Script.h"
+#include "vm/TaskScheduler.h"
+#include "vm/VirtualMachinePool.h"
+#include "vm/VirtualMachine.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace ferrit::tests {
+    // Benchmarks are hidden from the default test run. Run them with `ferrit_tests [benchmark]`.
+    namespace {
+        std::int64_t mix(std::int64_t value, std::int64_t total) {
+            return (total ^ value) + 1;
+        }
+    }
+
+    TEST_CASE("Function call performance", "[.][benchmark]") {
+        // fib(25) makes 242,785 calls, so calls/sec = 242,785 / mean time.
+        std::string code =
+            "fun fib(n: Int) -> Int {\n"
+            "    if (n < 2) return n\n"
+            "    return fib(n - 1) + fib(n - 2)\n"
+            "}\n"
+            "fib(25)";
+
+        auto program = compileSource(code);
+        REQUIRE(program.has_value());
+
+        std::ostringstream output, errors;
+        std::istringstream input;
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+
+        BENCHMARK("fib(25)") {
+            vm.interpret(*program);
+        };
+    }
+
+    TEST_CASE("Bulk array operation performance", "[.][benchmark]") {
+        // both programs sum a million reals, which shows what the vectorized kernels save over bytecode
+        std::string setup = "val a: Array<Real> = Array(1000000, 0.5)\n";
+        auto loop = compileSource(setup +
+            "var total = 0.0\n"
+            "for (i in 0..a.size) total = total + a[i]\n"
+            "total");
+        auto intrinsic = compileSource(setup + "sum(a)");
+        REQUIRE(loop.has_value());
+        REQUIRE(intrinsic.has_value());
+
+        std::ostringstream output, errors;
+        std::istringstream input;
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+
+        BENCHMARK("sum loop") {
+            vm.interpret(*loop);
+        };
+
+        BENCHMARK("sum(a)") {
+            vm.interpret(*intrinsic);
+        };
+    }
+
+    TEST_CASE("Vector loop performance", "[.][benchmark]") {
+        // the same loop, once as a vector loop and once with a body that keeps it from being vectorized
+        std::string setup =
+            "val n = 1000000\n"
+            "val a: Array<Real> = Array(n, 1.5)\n"
+            "val b: Array<Real> = Array(n, 2.0)\n"
+            "val out: Array<Real> = Array(n, 0.0)\n"
+            "val k = 3.0\n";
+        auto vectorized = compileSource(setup + "for (i in 0..n) out[i] = a[i] * k + b[i]");
+        auto scalar = compileSource(setup + "for (i in 0..n) { out[i] = a[i] * k + b[i]; 0 }");
+        REQUIRE(vectorized.has_value());
+        REQUIRE(scalar.has_value());
+
+        std::ostringstream output, errors;
+        std::istringstream input;
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+
+        BENCHMARK("scalar loop") {
+            vm.interpret(*scalar);
+        };
+
+        BENCHMARK("vector loop") {
+            vm.interpret(*vectorized);
+        };
+    }
+
+    TEST_CASE("Embedded call performance", "[.][benchmark]") {
+        // the same small request handled by compiling the source every time, and by calling a compiled script
+        std::string code = "fun score(a: Int, b: Int) -> Int = a * 31 + b\n";
+
+        std::ostringstream output, errors;
+        std::istringstream input;
+        BytecodeInterpreter interpreter{InterpretOptions{.silent = true}, output, errors, input};
+        auto script = Script::compile(code, nullptr);
+        REQUIRE(script.has_value());
+        auto score = script->entryPoint<std::int64_t(std::int64_t, std::int64_t)>("score");
+        REQUIRE(score.has_value());
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+
+        BENCHMARK("compile and run") {
+            return interpreter.run(code + "score(7, 3)");
+        };
+
+        BENCHMARK("entry point") {
+            return (*score)(vm, 7, 3);
+        };
+    }
+
+    TEST_CASE("Concurrent execution performance", "[.][benchmark]") {
+        // every thread runs the same number of requests against one shared script, so if execution
+        // scales linearly, each benchmark takes as long as the single-threaded one, up to the number of cores
+        auto script = Script::compile(
+            "fun fib(n: Int) -> Int {\n"
+            "    if (n < 2) return n\n"
+            "    return fib(n - 1) + fib(n - 2)\n"
+            "}\n",
+            nullptr);
+        REQUIRE(script.has_value());
+        auto fib = script->entryPoint<std::int64_t(std::int64_t)>("fib");
+        REQUIRE(fib.has_value());
+
+        std::ostringstream output, errors;
+        std::istringstream input;
+        VirtualMachinePool pool{NativeHandler{output, errors, input}};
+
+        unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+        for (unsigned threadCount = 1; threadCount <= cores; threadCount *= 2) {
+            BENCHMARK(std::format("{} x fib(20)", threadCount)) {
+                // assertions are not thread-safe, so the threads only count wrong results
+                std::atomic<int> failures{0};
+                std::vector<std::thread> threads;
+                for (unsigned i = 0; i < threadCount; i++) {
+                    threads.emplace_back([&] {
+                        for (int request = 0; request < 10; request++) {
+                            if (pool.call(*fib, 20) != 6765) {
+                                failures++;
+                            }
+                        }
+                    });
+                }
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+                REQUIRE(failures == 0);
+            };
+        }
+    }
+
+    TEST_CASE("Parallel task performance", "[.][benchmark]") {
+        // both programs compute fib(27), one of them by forking a task at every level down to fib(15).
+        // with one worker per core, the parallel version should approach the serial time divided by the cores
+        std::string fib =
+            "fun fib(n: Int) -> Int {\n"
+            "    if (n < 2) return n\n"
+            "    return fib(n - 1) + fib(n - 2)\n"
+            "}\n";
+        auto serial = compileSource(fib + "fib(27)");
+        auto parallel = compileSource(fib +
+            "fun parallelFib(n: Int) -> Int {\n"
+            "    if (n < 15) return fib(n)\n"
+            "    val left: Task<Int> = fork(parallelFib(n - 1))\n"
+            "    val right = parallelFib(n - 2)\n"
+            "    return join(left) + right\n"
+            "}\n"
+            "parallelFib(27)");
+        REQUIRE(serial.has_value());
+        REQUIRE(parallel.has_value());
+
+        std::ostringstream output, errors;
+        std::istringstream input;
+        NativeHandler natives{output, errors, input};
+        TaskScheduler scheduler{natives};
+        VirtualMachine vm{natives};
+        vm.setScheduler(&scheduler);
+
+        BENCHMARK("serial fib(27)") {
+            vm.interpret(*serial);
+        };
+        BENCHMARK(std::format("parallel fib(27) on {} workers", scheduler.workerCount())) {
+            vm.interpret(*parallel);
+        };
+    }
+
+    TEST_CASE("Line reading performance", "[.][benchmark]") {
+        // a mapped file hands out its lines as slices, while a read file copies each one into a string
+        std::string path = (std::filesystem::temp_directory_path() / "ferrit_bench_lines.txt").generic_string();
+        {
+            std::ofstream file{path};
+            for (int i = 0; i < 200'000; i++) {
+                file << "2024-01-01T00:00:00 worker-" << i % 16 << " handled request " << i << '\n';
+            }
+        }
+        auto read = compileSource(
+            "val file = openFile(\"" + path + "\")\n"
+            "var lines = 0\n"
+            "while (isAtEnd(file) == false) {\n"
+            "    readLine(file)\n"
+            "    lines = lines + 1\n"
+            "}\n"
+            "close(file)\n");
+        auto mapped = compileSource(
+            "val file = mapFile(\"" + path + "\")\n"
+            "var lines = 0\n"
+            "while (hasNextLine(file)) {\n"
+            "    nextLine(file)\n"
+            "    lines = lines + 1\n"
+            "}\n");
+        REQUIRE(read.has_value());
+        REQUIRE(mapped.has_value());
+
+        std::ostringstream output, errors;
+        std::istringstream input;
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+
+        BENCHMARK("readLine, 200,000 lines") {
+            vm.interpret(*read);
+        };
+        BENCHMARK("nextLine, 200,000 lines") {
+            vm.interpret(*mapped);
+        };
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("Native call performance", "[.][benchmark]") {
+        // each program makes 1,000,000 calls, so the difference to the empty loop is the cost of the calls
+        NativeRegistry registry;
+        registry.add<&mix>("mix");
+        registry.add("mixThrough", &mix);
+        std::string loop = "var total = 0\nfor (i in 0..1000000) total = ";
+        auto empty = compileSource(loop + "total + i\n");
+        auto ferrit = compileSource(
+            "fun mixFerrit(value: Int, total: Int) -> Int {\n"
+            "    return total + value + 1\n"
+            "}\n" + loop + "mixFerrit(i, total)\n");
+        auto direct = compileSource(
+            "native fun mix(value: Int, total: Int) -> Int\n" + loop + "mix(i, total)\n", &registry);
+        auto through = compileSource(
+            "native fun mixThrough(value: Int, total: Int) -> Int\n" + loop + "mixThrough(i, total)\n", &registry);
+        REQUIRE(empty.has_value());
+        REQUIRE(ferrit.has_value());
+        REQUIRE(direct.has_value());
+        REQUIRE(through.has_value());
+
+        std::ostringstream output, errors;
+        std::istringstream input;
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+
+        BENCHMARK("empty loop") {
+            vm.interpret(*empty);
+        };
+        BENCHMARK("Ferrit function") {
+            vm.interpret(*ferrit);
+        };
+        BENCHMARK("native function") {
+            vm.interpret(*direct);
+        };
+        BENCHMARK("native function pointer") {
+            vm.interpret(*through);
+        };
+    }
+}
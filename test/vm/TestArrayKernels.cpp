@@ -0,0 +1,91 @@
+#include "vm/ArrayKernels.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ferrit::tests {
+    namespace {
+        /**
+         * Returns the kernels for every instruction set that this CPU can run.
+         */
+        template <typename T>
+        std::vector<const ArrayKernels<T> *> supportedKernels() {
+            std::vector<const ArrayKernels<T> *> result;
+            InstructionSet best = detectInstructionSet();
+            for (auto instructionSet : {InstructionSet::Scalar, InstructionSet::Sse2, InstructionSet::Avx2, InstructionSet::Neon}) {
+                const auto *kernels = arrayKernels<T>(instructionSet);
+                bool isSupported = instructionSet == InstructionSet::Scalar ||
+                    instructionSet == best || (instructionSet == InstructionSet::Sse2 && best == InstructionSet::Avx2);
+                if (kernels && isSupported) {
+                    result.push_back(kernels);
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Checks that the kernels agree with the scalar ones on every size up to a few vectors long,
+         * so that both the vector loops and the scalar tails are covered. The elements are small
+         * integers, which reals represent exactly, so the order of the additions does not matter.
+         */
+        template <typename T>
+        void checkAgainstScalar() {
+            const auto &scalar = *arrayKernels<T>(InstructionSet::Scalar);
+            for (const auto *kernels : supportedKernels<T>()) {
+                for (std::size_t size = 0; size < 38; size++) {
+                    std::vector<T> left, right, expected(size), actual(size);
+                    for (std::size_t i = 0; i < size; i++) {
+                        left.push_back(static_cast<T>((i * 7) % 23) - 11);
+                        right.push_back(static_cast<T>((i * 5) % 13) + 1);
+                    }
+
+                    REQUIRE(kernels->sum(left.data(), size) == scalar.sum(left.data(), size));
+                    REQUIRE(kernels->dot(left.data(), right.data(), size) == scalar.dot(left.data(), right.data(), size));
+                    if (size > 0) {
+                        REQUIRE(kernels->min(left.data(), size) == scalar.min(left.data(), size));
+                        REQUIRE(kernels->max(left.data(), size) == scalar.max(left.data(), size));
+                        REQUIRE(kernels->indexOf(left.data(), size, left.back()) == scalar.indexOf(left.data(), size, left.back()));
+                    }
+                    REQUIRE(kernels->indexOf(left.data(), size, T{100}) == -1);
+
+                    for (auto kernel : {&ArrayKernels<T>::add, &ArrayKernels<T>::subtract, &ArrayKernels<T>::multiply, &ArrayKernels<T>::divide}) {
+                        (scalar.*kernel)(left.data(), right.data(), expected.data(), size);
+                        (kernels->*kernel)(left.data(), right.data(), actual.data(), size);
+                        REQUIRE(actual == expected);
+                    }
+                }
+            }
+        }
+    }
+
+    SCENARIO("Array kernels", "[arrays]") {
+        GIVEN("the kernels for every instruction set the CPU supports") {
+            THEN("Int kernels agree with the scalar ones") {
+                checkAgainstScalar<std::int64_t>();
+            }
+
+            THEN("Real kernels agree with the scalar ones") {
+                checkAgainstScalar<double>();
+            }
+
+            THEN("the best kernels are the ones that were detected") {
+                REQUIRE(arrayKernels<std::int64_t>().instructionSet == detectInstructionSet());
+                REQUIRE(arrayKernels<double>().instructionSet == detectInstructionSet());
+            }
+        }
+
+        GIVEN("an array with its smallest element in the middle of a vector") {
+            std::vector<std::int64_t> data{5, 4, 3, 2, -7, 8, 9, 10, 11};
+
+            THEN("min, max and indexOf find it") {
+                const auto &kernels = arrayKernels<std::int64_t>();
+                REQUIRE(kernels.min(data.data(), data.size()) == -7);
+                REQUIRE(kernels.max(data.data(), data.size()) == 11);
+                REQUIRE(kernels.indexOf(data.data(), data.size(), -7) == 4);
+            }
+        }
+    }
+}
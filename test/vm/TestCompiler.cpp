@@ -0,0 +1,984 @@
+#include "TestUtil.h"
+#include "vm/BytecodeCompiler.h"
+#include "vm/Disassembler.h"
+#include "vm/VirtualMachine.h"
+
+#include <catch2/catch.hpp>
+
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace ferrit::tests {
+    namespace {
+        std::string disassemble(const Program &program) {
+            std::ostringstream stream;
+            Disassembler{stream}.disassembleChunk(program.script().chunk, "test");
+            return stream.str();
+        }
+
+        /** Returns a block whose bytecode is too large to be jumped over with a 16-bit offset. */
+        std::string makeHugeBlock() {
+            std::string block = "{ 1";
+            for (int i = 1; i < 22'000; i++) {
+                block += "; 1";
+            }
+            return block + " }\n";
+        }
+    }
+
+    SCENARIO("Compiling arithmetic", "[compiler]") {
+        GIVEN("remainders of integers and reals") {
+            auto program = compileSource("println(17 % 5)\nprintln(7.5 % 2.0)");
+            REQUIRE(program.has_value());
+
+            THEN("typed modulus instructions are emitted") {
+                std::string code = disassemble(*program);
+                REQUIRE(code.find("imod") != std::string::npos);
+                REQUIRE(code.find("fmod") != std::string::npos);
+                REQUIRE(code.find("add") == std::string::npos);
+            }
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the remainders are printed") {
+                    REQUIRE(output.str() == "2\n1.5\n");
+                }
+            }
+        }
+    }
+
+    SCENARIO("Compiling comparisons", "[compiler]") {
+        GIVEN("a comparison between two integers") {
+            auto program = compileSource("3 <= 4");
+
+            THEN("a typed integer comparison is emitted") {
+                REQUIRE(program.has_value());
+                REQUIRE(disassemble(*program) ==
+                    "=== test ===\n"
+                    "$0000    1 const          0  // Constant 3\n"
+                    "$0002    | const          1  // Constant 4\n"
+                    "$0004    | ile\n"
+                    "$0005    | pop\n"
+                    "$0006    | ret\n");
+            }
+        }
+
+        GIVEN("a comparison between two reals") {
+            auto program = compileSource("1.5 != 2.5");
+
+            THEN("a typed real comparison is emitted") {
+                REQUIRE(program.has_value());
+                REQUIRE(disassemble(*program) ==
+                    "=== test ===\n"
+                    "$0000    1 const          0  // Constant 1.5\n"
+                    "$0002    | const          1  // Constant 2.5\n"
+                    "$0004    | fne\n"
+                    "$0005    | pop\n"
+                    "$0006    | ret\n");
+            }
+        }
+
+        GIVEN("a comparison between incompatible types") {
+            auto program = compileSource("1 < 2.0");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        GIVEN("an ordering comparison between booleans") {
+            auto program = compileSource("true < false");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+    }
+
+    SCENARIO("Compiling conditions", "[compiler]") {
+        GIVEN("an if statement guarded by an integer comparison") {
+            auto program = compileSource("if (1 < 2) 3 else 4");
+
+            THEN("the comparison is fused with the branch") {
+                REQUIRE(program.has_value());
+                REQUIRE(disassemble(*program) ==
+                    "=== test ===\n"
+                    "$0000    1 const          0  // Constant 1\n"
+                    "$0002    | const          1  // Constant 2\n"
+                    "$0004    | jmpige     $0006  // Absolute offset $000D\n"
+                    "$0007    | const          2  // Constant 3\n"
+                    "$0009    | pop\n"
+                    "$000A    | jmp        $0003  // Absolute offset $0010\n"
+                    "$000D    | const          3  // Constant 4\n"
+                    "$000F    | pop\n"
+                    "$0010    | ret\n");
+            }
+
+            WHEN("the chunk is executed") {
+                std::ostringstream output, errors, traceLog;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}, &traceLog};
+                vm.interpret(*program);
+
+                THEN("only the if branch is taken") {
+                    REQUIRE(traceLog.str().find("// Constant 3") != std::string::npos);
+                    REQUIRE(traceLog.str().find("// Constant 4") == std::string::npos);
+                }
+            }
+        }
+
+        GIVEN("an if statement guarded by a real comparison") {
+            auto program = compileSource("if (1.0 > 2.0) 3");
+
+            THEN("the comparison is followed by a conditional jump") {
+                REQUIRE(program.has_value());
+                REQUIRE(disassemble(*program) ==
+                    "=== test ===\n"
+                    "$0000    1 const          0  // Constant 1.0\n"
+                    "$0002    | const          1  // Constant 2.0\n"
+                    "$0004    | fgt\n"
+                    "$0005    | jmpfalse   $0003  // Absolute offset $000B\n"
+                    "$0008    | const          2  // Constant 3\n"
+                    "$000A    | pop\n"
+                    "$000B    | ret\n");
+            }
+        }
+    }
+
+    SCENARIO("Compiling loops", "[compiler]") {
+        GIVEN("a for loop over an integer range") {
+            auto program = compileSource("for (i in 0..3) 1");
+
+            THEN("the range is not materialized") {
+                REQUIRE(program.has_value());
+                REQUIRE(disassemble(*program) ==
+                    "=== test ===\n"
+                    "$0000    1 const          0  // Constant 0\n"
+                    "$0002    | const          1  // Constant 3\n"
+                    "$0004    | forprep    $0008  // Absolute offset $000F\n"
+                    "$0007    | const          2  // Constant 1\n"
+                    "$0009    | pop\n"
+                    "$000A    | forloop    $0008  // Absolute offset $0007, loop #0\n"
+                    "$000F    | pop\n"
+                    "$0010    | pop\n"
+                    "$0011    | ret\n");
+                REQUIRE(program->script().chunk.loopHeaders() == std::vector{0x0007});
+            }
+
+            WHEN("the chunk is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the loop's back edge is taken once per additional iteration") {
+                    REQUIRE(vm.loopHitCounts() == std::vector<std::uint64_t>{2});
+                }
+            }
+        }
+
+        GIVEN("for loops over empty and single-element ranges") {
+            auto program = compileSource("for (i in 5..5) 1\nfor (i in 5...5) 2");
+            REQUIRE(program.has_value());
+
+            WHEN("the chunk is executed") {
+                std::ostringstream output, errors, traceLog;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}, &traceLog};
+                vm.interpret(*program);
+
+                THEN("only the inclusive range runs its body") {
+                    REQUIRE(traceLog.str().find("// Constant 1\n") == std::string::npos);
+                    REQUIRE(traceLog.str().find("// Constant 2\n") != std::string::npos);
+                    REQUIRE(vm.loopHitCounts() == std::vector<std::uint64_t>{0, 0});
+                }
+            }
+        }
+
+        GIVEN("a while loop and a do-while loop") {
+            auto program = compileSource("while (1 > 2) 3\ndo 4 while (false)");
+
+            THEN("both loops jump backward to their header") {
+                REQUIRE(program.has_value());
+                REQUIRE(disassemble(*program) ==
+                    "=== test ===\n"
+                    "$0000    1 const          0  // Constant 1\n"
+                    "$0002    | const          1  // Constant 2\n"
+                    "$0004    | jmpile     $0008  // Absolute offset $000F\n"
+                    "$0007    | const          2  // Constant 3\n"
+                    "$0009    | pop\n"
+                    "$000A    | loop       $000F  // Absolute offset $0000, loop #0\n"
+                    "$000F    2 const          3  // Constant 4\n"
+                    "$0011    | pop\n"
+                    "$0012    | const          4  // Constant false\n"
+                    "$0014    | jmpfalse   $0005  // Absolute offset $001C\n"
+                    "$0017    | loop       $000D  // Absolute offset $000F, loop #1\n"
+                    "$001C    | ret\n");
+            }
+        }
+
+        GIVEN("a for loop over a range of reals") {
+            auto program = compileSource("for (x in 0.0..1.0) 1");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+    }
+
+    SCENARIO("Compiling large chunks", "[compiler]") {
+        GIVEN("an if statement with a body too large for a short jump") {
+            auto program = compileSource(
+                "if (true) " + makeHugeBlock() +
+                "if (2 < 1) " + makeHugeBlock() +
+                "for (i in 0..3) 2");
+
+            THEN("only the out-of-range jumps are widened") {
+                REQUIRE(program.has_value());
+                std::string disassembly = disassemble(*program);
+                REQUIRE(disassembly.starts_with(
+                    "=== test ===\n"
+                    "$0000    1 const          0  // Constant true\n"
+                    "$0002    | jmpfalse.l $000156C1  // Absolute offset $156C8\n"));
+                REQUIRE(disassembly.find(
+                    "$156CE    | jmpilt     $0005  // Absolute offset $156D6\n"
+                    "$156D1    | jmp.l      $000157C0  // Absolute offset $2AE96\n") != std::string::npos);
+                REQUIRE(disassembly.find("forprep    $0009") != std::string::npos);
+            }
+
+            WHEN("the chunk is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the widened jumps land on the following statement") {
+                    REQUIRE(vm.loopHitCounts() == std::vector<std::uint64_t>{2});
+                }
+            }
+        }
+
+        GIVEN("a for loop with a body too large for a short jump") {
+            auto program = compileSource("for (i in 0..2) " + makeHugeBlock());
+
+            THEN("both the loop's entry and its back edge are widened") {
+                REQUIRE(program.has_value());
+                std::string disassembly = disassemble(*program);
+                REQUIRE(disassembly.find("forprep.l  $000156C9") != std::string::npos);
+                REQUIRE(disassembly.find("forloop.l  $000156C9  // Absolute offset $0009, loop #0") != std::string::npos);
+                REQUIRE(program->script().chunk.loopHeaders() == std::vector{0x0009});
+            }
+
+            WHEN("the chunk is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the long back edge is taken") {
+                    REQUIRE(vm.loopHitCounts() == std::vector<std::uint64_t>{1});
+                }
+            }
+        }
+
+        GIVEN("more constants than fit in a single byte") {
+            std::string code;
+            for (int i = 0; i < 300; i++) {
+                code += std::to_string(i) + "\n";
+            }
+            auto program = compileSource(code);
+
+            THEN("the remaining constants use the long form") {
+                REQUIRE(program.has_value());
+                REQUIRE(disassemble(*program).find("const.l      299  // Constant 299\n") != std::string::npos);
+            }
+        }
+    }
+
+    SCENARIO("Compiling local variables", "[compiler]") {
+        GIVEN("variables declared in sibling scopes") {
+            auto program = compileSource("if (true) { val a = 1\na } else { val b = 2.0\nb }");
+
+            THEN("both variables share the same stack slot") {
+                REQUIRE(program.has_value());
+                REQUIRE(disassemble(*program) ==
+                    "=== test ===\n"
+                    "$0000    1 const          0  // Constant true\n"
+                    "$0002    | jmpfalse   $0009  // Absolute offset $000E\n"
+                    "$0005    | const          1  // Constant 1\n"
+                    "$0007    2 getlocal       0\n"
+                    "$0009    | pop\n"
+                    "$000A    1 pop\n"
+                    "$000B    2 jmp        $0006  // Absolute offset $0014\n"
+                    "$000E    | const          2  // Constant 2.0\n"
+                    "$0010    3 getlocal       0\n"
+                    "$0012    | pop\n"
+                    "$0013    2 pop\n"
+                    "$0014    1 ret\n");
+            }
+        }
+
+        GIVEN("mutable variables updated in loops") {
+            auto program = compileSource(
+                "var sum = 0\n"
+                "for (i in 0..4) sum = sum + i\n"
+                "while (sum > 0) sum = sum - 1");
+            REQUIRE(program.has_value());
+
+            WHEN("the chunk is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the updates are visible to later statements") {
+                    // 0 + 1 + 2 + 3 = 6, so the while loop counts down six times
+                    REQUIRE(vm.loopHitCounts() == std::vector<std::uint64_t>{3, 6});
+                }
+            }
+        }
+
+        GIVEN("a variable shadowed in an inner scope") {
+            auto program = compileSource("val x = 1\nif (x == 1) { val x = true\nx }");
+
+            THEN("compilation succeeds") {
+                REQUIRE(program.has_value());
+            }
+        }
+
+        GIVEN("an assignment to an immutable variable") {
+            auto program = compileSource("val x = 1\nx = 2");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        GIVEN("an assignment of the wrong type") {
+            auto program = compileSource("var x = 1\nx = 2.0");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        GIVEN("a variable declared twice in the same scope") {
+            auto program = compileSource("val x = 1\nval x = 2");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        GIVEN("a variable used outside of its scope") {
+            auto program = compileSource("if (true) { val x = 1 }\nx");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+    }
+
+    SCENARIO("Compiling functions", "[compiler]") {
+        GIVEN("a recursive function") {
+            auto program = compileSource(
+                "fun fib(n: Int) -> Int {\n"
+                "    if (n < 2) return n\n"
+                "    return fib(n - 1) + fib(n - 2)\n"
+                "}\n"
+                "println(fib(20))");
+
+            THEN("the function is compiled to its own chunk") {
+                REQUIRE(program.has_value());
+                REQUIRE(program->functions().size() == 2);
+                REQUIRE(program->functions()[1].name == "fib");
+                REQUIRE(program->functions()[1].arity == 1);
+            }
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the result is printed") {
+                    REQUIRE(output.str() == "6765\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("mutually recursive functions that are called before they are declared") {
+            auto program = compileSource(
+                "println(half(10.0, 4))\n"
+                "fun half(x: Real, times: Int) -> Real {\n"
+                "    if (times == 0) return x\n"
+                "    return halve(x / 2.0, times)\n"
+                "}\n"
+                "fun halve(x: Real, times: Int) -> Real = half(x, times - 1)\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("each call returns to its caller") {
+                    REQUIRE(output.str() == "0.625\n");
+                }
+            }
+        }
+
+        GIVEN("unbounded recursion") {
+            auto program = compileSource("fun forever(n: Int) -> Int = 1 + forever(n + 1)\nforever(0)");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the VM panics instead of crashing") {
+                    REQUIRE(errors.str() == "error: stack overflow\n");
+                }
+            }
+        }
+
+        GIVEN("a call in tail position") {
+            auto program = compileSource(
+                "fun count(n: Int, total: Int) -> Int {\n"
+                "    if (n == 0) return total\n"
+                "    return count(n - 1, total + 1)\n"
+                "}\n"
+                "println(count(100000, 0))");
+            REQUIRE(program.has_value());
+
+            THEN("it is compiled to a tail call") {
+                std::ostringstream listing;
+                Disassembler{listing}.disassembleProgram(*program);
+                REQUIRE(listing.str().find("tailcall") != std::string::npos);
+            }
+
+            WHEN("the program recurses deeper than the call stack") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("it runs in constant stack space") {
+                    REQUIRE(output.str() == "100000\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("mutually recursive functions in tail position") {
+            auto program = compileSource(
+                "fun isEven(n: Int) -> Bool {\n"
+                "    if (n == 0) return true\n"
+                "    return isOdd(n - 1)\n"
+                "}\n"
+                "fun isOdd(n: Int) -> Bool {\n"
+                "    if (n == 0) return false\n"
+                "    return isEven(n - 1)\n"
+                "}\n"
+                "println(isEven(10001))");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("neither function overflows the call stack") {
+                    REQUIRE(output.str() == "false\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a small leaf function") {
+            auto program = compileSource(
+                "fun square(x: Int) -> Int = x * x\n"
+                "val x = 2\n"
+                "val y = square(x + 1)\n"
+                "println(x + y)");
+            REQUIRE(program.has_value());
+
+            THEN("calls to it are inlined") {
+                REQUIRE(disassemble(*program).find("call") == std::string::npos);
+            }
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the caller's locals are left intact") {
+                    REQUIRE(output.str() == "11\n");
+                }
+            }
+        }
+
+        GIVEN("a small leaf function called while other values are on the stack") {
+            auto program = compileSource(
+                "fun sq(x: Int) -> Int = x * x\n"
+                "fun add(a: Int, b: Int) -> Int {\n"
+                "    if (a < 0) return 0\n"
+                "    return a + b\n"
+                "}\n"
+                "val a = 3\n"
+                "val b = 4\n"
+                "println(1 + sq(2))\n"
+                "println(sq(2) + sq(3))\n"
+                "println(sq(a) + sq(b))\n"
+                "println(add(sq(a), sq(b)))\n"
+                "println(add(1, 2 * sq(b)))\n"
+                "val values = [sq(1), sq(2), sq(3)]\n"
+                "println(values[sq(1) + 1])\n"
+                "values[sq(1)] = 1 + sq(2)\n"
+                "println(values[1])\n"                "var total = 0\n"
+                "for (i in sq(1)..sq(2)) total = total + i\n"
+                "println(total)");
+            REQUIRE(program.has_value());
+
+            THEN("the calls to it are still inlined, leaving only the calls to the other function") {
+                std::string code = disassemble(*program);
+                std::size_t calls = 0;
+                for (auto pos = code.find("call"); pos != std::string::npos; pos = code.find("call", pos + 1)) {
+                    calls++;
+                }
+                REQUIRE(calls == 2);
+            }
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("its parameters and result do not overwrite the pending values") {
+                    REQUIRE(output.str() == "5\n13\n25\n25\n33\n9\n5\n6\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("an open function") {
+            auto program = compileSource("open fun square(x: Int) -> Int = x * x\nprintln(square(3))");
+            REQUIRE(program.has_value());
+
+            THEN("calls to it are not inlined") {
+                REQUIRE(disassemble(*program).find("call") != std::string::npos);
+            }
+        }
+
+        GIVEN("a call with the wrong number of arguments") {
+            auto program = compileSource("fun f(a: Int, b: Int) -> Int = a + b\nf(1)");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        GIVEN("a call with an argument of the wrong type") {
+            auto program = compileSource("fun f(a: Int) -> Int = a\nf(true)");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        GIVEN("a function that does not return on every path") {
+            auto program = compileSource("fun f(a: Int) -> Int {\nif (a > 0) return a\n}");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        GIVEN("a return statement outside of a function") {
+            auto program = compileSource("return 1");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+    }
+
+    SCENARIO("Compiling numeric literals", "[compiler]") {
+        GIVEN("integer and real literals at the edges of their ranges") {
+            auto program = compileSource(
+                "println(9223372036854775807)\n"
+                "println(0 - 9223372036854775807)\n"
+                "println(0.1)\n"
+                "println(3.0)\n"
+                "println(1.0 / 3.0)\n"
+                "println(100000000000000000000.0)\n"
+                "println(0.0 - 0.0000001)\n"
+                "println(0.0 - 0.0)\n"
+                "println(1.0 / 0.0)");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("every number is printed in its shortest form, and reals keep their period") {
+                    REQUIRE(output.str() ==
+                        "9223372036854775807\n"
+                        "-9223372036854775807\n"
+                        "0.1\n"
+                        "3.0\n"
+                        "0.3333333333333333\n"
+                        "1.0e+20\n"
+                        "-1.0e-07\n"
+                        "0.0\n"
+                        "inf\n");
+                }
+            }
+        }
+
+        GIVEN("numeric literals with prefixes, separators, exponents and suffixes") {
+            auto program = compileSource(
+                "println(0b1101_0010)\n"
+                "println(0o17)\n"
+                "println(0xB30C)\n"
+                "println(0x7Fb)\n"
+                "println(0b101s)\n"
+                "println(0b)\n"
+                "println(12L)\n"
+                "println(1_000.5)\n"
+                "println(15.0e-1)\n"
+                "println(1.0e3d)");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("each digit is read in the literal's base") {
+                    REQUIRE(output.str() == "210\n15\n45836\n127\n5\n0\n12\n1000.5\n1.5\n1000.0\n");
+                }
+            }
+        }
+
+        GIVEN("integer literals with digits that their base does not allow") {
+            THEN("they do not compile") {
+                REQUIRE_FALSE(compileSource("println(0b102)").has_value());
+                REQUIRE_FALSE(compileSource("println(0o79)").has_value());
+                REQUIRE_FALSE(compileSource("println(0o8)").has_value());
+            }
+        }
+
+        GIVEN("integer literals that do not fit their suffix's type") {
+            THEN("they do not compile") {
+                REQUIRE_FALSE(compileSource("println(0x80b)").has_value());
+                REQUIRE_FALSE(compileSource("println(32768s)").has_value());
+                REQUIRE(compileSource("println(0x7FFFs)").has_value());
+            }
+        }
+    }
+
+    SCENARIO("Compiling strings", "[compiler]") {
+        GIVEN("string literals with escape sequences") {
+            auto program = compileSource("println(\"tab\\there\")\nprintln(\"tab\\there\")");
+
+            THEN("identical literals share one entry in the string pool") {
+                REQUIRE(program.has_value());
+                REQUIRE(program->script().chunk.stringPool() == std::vector<std::string>{"tab\there"});
+            }
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the escape sequences are replaced") {
+                    REQUIRE(output.str() == "tab\there\ntab\there\n");
+                }
+            }
+        }
+
+        GIVEN("strings that are concatenated in a loop") {
+            auto program = compileSource(
+                "var a = \"\"\n"
+                "var b = \"\"\n"
+                "for (i in 0..200) { a = a ~ \"xy\"; b = b ~ \"x\" ~ \"y\" }\n"
+                "println(a == b)\n"
+                "println(a != b ~ \"z\")\n"
+                "println(\"interned\" == \"interned\")\n"
+                "println(a)");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the strings are compared by their contents") {
+                    std::string expected = "true\ntrue\ntrue\n";
+                    for (int i = 0; i < 200; i++) {
+                        expected += "xy";
+                    }
+                    REQUIRE(output.str() == expected + "\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a string concatenated with a number") {
+            auto program = compileSource("\"a\" ~ 1");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+    }
+
+    SCENARIO("Compiling arrays", "[compiler]") {
+        GIVEN("a loop that fills an array up to its size") {
+            auto program = compileSource(
+                "val squares: Array<Int> = Array(5, 0)\n"
+                "for (i in 0..squares.size) squares[i] = i * i\n"
+                "val reals = [0.5, 1.5]\n"
+                "reals[1] = reals[0] + reals[1]\n"
+                "println(squares)\n"
+                "println(reals)\n"
+                "println([true, false][1])");
+            REQUIRE(program.has_value());
+
+            THEN("the bounds check inside the loop is removed") {
+                std::string listing = disassemble(*program);
+                REQUIRE(listing.find("iidxset.u") != std::string::npos);
+                REQUIRE(listing.find("fidxset\n") != std::string::npos);
+            }
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the elements are stored and read back") {
+                    REQUIRE(output.str() == "[0, 1, 4, 9, 16]\n[0.5, 2.0]\nfalse\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a loop whose range is not bounded by the array's size") {
+            auto program = compileSource(
+                "val a = [1, 2, 3]\n"
+                "var total = 0\n"
+                "for (i in 0...a.size) total = total + a[i]\n"
+                "println(total)");
+            REQUIRE(program.has_value());
+
+            THEN("the bounds check is kept") {
+                REQUIRE(disassemble(*program).find("iidxget.u") == std::string::npos);
+            }
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("indexing past the end panics") {
+                    REQUIRE(output.str().empty());
+                    REQUIRE(errors.str() == "error: index 3 is out of bounds for an array of size 3\n");
+                }
+            }
+        }
+
+        GIVEN("an array literal with elements of different types") {
+            auto program = compileSource("[1, 2.0]");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+    }
+
+    SCENARIO("Compiling bulk array operations", "[compiler]") {
+        GIVEN("operations on Int and Real arrays") {
+            auto program = compileSource(
+                "val a = [3, 1, 4, 1, 5, 9, 2, 6, 5]\n"
+                "val b: Array<Int> = Array(a.size, 2)\n"
+                "println(sum(a))\n"
+                "println(min(a))\n"
+                "println(max(a))\n"
+                "println(dot(a, b))\n"
+                "println(divide(multiply(add(a, b), b), b))\n"
+                "println(indexOf(a, 5))\n"
+                "val reals = [0.5, 1.5, 2.0]\n"
+                "fill(reals, 0.25)\n"
+                "val copied: Array<Real> = Array(4, 1.0)\n"
+                "copy(reals, copied)\n"
+                "println(subtract(copied, [1.0, 1.0, 1.0, 1.0]))");
+            REQUIRE(program.has_value());
+
+            THEN("each operation is a single instruction") {
+                std::string listing = disassemble(*program);
+                REQUIRE(listing.find("// sum") != std::string::npos);
+                REQUIRE(listing.find("farrop") != std::string::npos);
+            }
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the results are printed") {
+                    REQUIRE(output.str() ==
+                        "36\n1\n9\n72\n[5, 3, 6, 3, 7, 11, 4, 8, 7]\n4\n[-0.75, -0.75, -0.75, 0.0]\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("an integer division by an array containing zero") {
+            auto program = compileSource("println(divide([1, 2], [1, 0]))");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("it panics") {
+                    REQUIRE(output.str().empty());
+                    REQUIRE(errors.str() == "error: attempted divide by zero\n");
+                }
+            }
+        }
+
+        GIVEN("arrays of different sizes") {
+            auto program = compileSource("println(dot([1.0, 2.0], [3.0]))");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("it panics") {
+                    REQUIRE(errors.str() == "error: array sizes 2 and 1 do not match\n");
+                }
+            }
+        }
+
+        GIVEN("an operation on a Bool array") {
+            auto program = compileSource("sum([true, false])");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        GIVEN("an element of the wrong type") {
+            auto program = compileSource("indexOf([1, 2], 2.0)");
+
+            THEN("compilation fails") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+    }
+
+    SCENARIO("Vectorizing loops", "[compiler]") {
+        GIVEN("loops that assign one array element per iteration") {
+            auto program = compileSource(
+                "val n = 600\n"
+                "val a: Array<Real> = Array(n, 1.5)\n"
+                "val b: Array<Real> = Array(n, 2.0)\n"
+                "val out: Array<Real> = Array(n, 0.0)\n"
+                "val k = 3.0\n"
+                "for (i in 0..n) out[i] = a[i] * k + b[i]\n"
+                "println(sum(out))\n"
+                "val squares: Array<Int> = Array(6, 0)\n"
+                "for (i in 1..squares.size) squares[i] = -(i * i)\n"
+                "for (i in 0...4) { squares[i] = squares[i] + squares[i + 1] }\n"
+                "println(squares)");
+            REQUIRE(program.has_value());
+
+            THEN("element-wise loops become vector loops") {
+                std::string listing = disassemble(*program);
+                REQUIRE(listing.find("vecloop        0") != std::string::npos);
+                REQUIRE(listing.find("vecloop        1") != std::string::npos);
+                REQUIRE(listing.find("vecloop        2") == std::string::npos);
+            }
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("the results match running one iteration at a time") {
+                    REQUIRE(output.str() == "3900.0\n[-1, -5, -13, -25, -41, -25]\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a vectorized loop that runs past the end of its array") {
+            auto program = compileSource(
+                "val a = [1, 2, 3]\n"
+                "for (i in 1..5) a[i] = 0\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                vm.interpret(*program);
+
+                THEN("it panics at the first index out of bounds") {
+                    REQUIRE(errors.str() == "error: index 3 is out of bounds for an array of size 3\n");
+                }
+            }
+        }
+
+        GIVEN("a loop that divides integers") {
+            auto tokens = Lexer{}.lex(
+                "val a = [2, 4]\n"
+                "for (i in 0..a.size) a[i] = a[i] / 2\n"
+                "for (i in 0..a.size) a[i] = a[i] * 2");
+            REQUIRE(tokens.has_value());
+            auto ast = Parser{}.parse(tokens.value());
+            REQUIRE(ast.has_value());
+            BytecodeCompiler compiler{nullptr};
+            REQUIRE(compiler.compile(ast.value()).has_value());
+
+            THEN("the remarks say why it was not vectorized") {
+                const auto &remarks = compiler.vectorizationRemarks();
+                REQUIRE(remarks.size() == 2);
+                REQUIRE(remarks[0].line == 2);
+                REQUIRE(remarks[0].missedReason == "integer division");
+                REQUIRE(remarks[1].line == 3);
+                REQUIRE_FALSE(remarks[1].missedReason.has_value());
+            }
+        }
+    }
+}
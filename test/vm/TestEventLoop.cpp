@@ -0,0 +1,270 @@
+#include "TestUtil.h"
+#include "vm/EventLoop.h"
+#include "vm/File.h"
+#include "vm/VirtualMachine.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace ferrit::tests {
+    namespace {
+        std::vector<EventLoop::Completion> waitForAll(EventLoop &loop) {
+            std::vector<EventLoop::Completion> completions;
+            while (loop.pendingCount() > 0) {
+                loop.poll(true, completions);
+            }
+            return completions;
+        }
+    }
+
+    SCENARIO("Running an event loop", "[io]") {
+        auto preferred = GENERATE(EventLoop::Backend::IoUring, EventLoop::Backend::Epoll, EventLoop::Backend::Blocking);
+        auto loop = EventLoop::create(preferred);
+        // a backend that this system does not support falls back to one further down the list
+        REQUIRE(loop->backend() >= preferred);
+        std::string path = (std::filesystem::temp_directory_path() / "ferrit_event_loop.txt").string();
+
+        GIVEN("a file written through the loop") {
+            std::optional<int> output = File::open(path, true);
+            REQUIRE(output.has_value());
+            File file{*output, path, true};
+            loop->write(file.descriptor(), "first\nsecond\n", 1);
+            auto completions = waitForAll(*loop);
+            file.close();
+
+            THEN("every byte was written") {
+                REQUIRE(completions.size() == 1);
+                REQUIRE(completions[0].id == 1);
+                REQUIRE(completions[0].result == 13);
+            }
+
+            WHEN("it is read back in small pieces") {
+                std::optional<int> input = File::open(path, false);
+                REQUIRE(input.has_value());
+                File reader{*input, path, true};
+                std::string contents;
+                while (true) {
+                    loop->read(reader.descriptor(), 4, 2);
+                    auto reads = waitForAll(*loop);
+                    REQUIRE(reads.size() == 1);
+                    REQUIRE(reads[0].result >= 0);
+                    if (reads[0].result == 0) {
+                        break;
+                    }
+                    contents += reads[0].data;
+                }
+
+                THEN("each read continues where the last one stopped") {
+                    REQUIRE(contents == "first\nsecond\n");
+                }
+            }
+        }
+
+        GIVEN("timers that are started out of order") {
+            loop->startTimer(std::chrono::milliseconds{30}, 30);
+            loop->startTimer(std::chrono::milliseconds{10}, 10);
+            loop->startTimer(std::chrono::milliseconds{20}, 20);
+            auto start = std::chrono::steady_clock::now();
+            auto completions = waitForAll(*loop);
+
+            THEN("they finish in the order of their delays, once those have passed") {
+                REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds{30});
+                REQUIRE(completions.size() == 3);
+                REQUIRE(completions[0].id == 10);
+                REQUIRE(completions[1].id == 20);
+                REQUIRE(completions[2].id == 30);
+            }
+        }
+
+        GIVEN("a file that does not exist") {
+            std::optional<int> descriptor = File::open(path + ".missing", false);
+
+            THEN("it cannot be opened") {
+                REQUIRE_FALSE(descriptor.has_value());
+            }
+        }
+
+        GIVEN("operations that are abandoned") {
+            loop->startTimer(std::chrono::hours{1}, 1);
+            loop->cancelAll();
+
+            THEN("they are no longer pending") {
+                REQUIRE(loop->pendingCount() == 0);
+            }
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    SCENARIO("Waiting for I/O in fibers", "[io]") {
+        auto backend = GENERATE(EventLoop::Backend::IoUring, EventLoop::Backend::Epoll, EventLoop::Backend::Blocking);
+        std::ostringstream output, errors;
+        std::istringstream input{"answer\n"};
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+        vm.setEventLoop(EventLoop::create(backend));
+        std::string path = (std::filesystem::temp_directory_path() / "ferrit_fiber_io.txt").generic_string();
+
+        GIVEN("fibers that write a file and read it back") {
+            auto program = compileSource(
+                "fun fill(path: String, lines: Int) -> Unit {\n"
+                "    val file = createFile(path)\n"
+                "    for (i in 0..lines) write(file, \"line\\n\")\n"
+                "    close(file)\n"
+                "}\n"
+                "fun count(path: String) -> Int {\n"
+                "    val file = openFile(path)\n"
+                "    var lines = 0\n"
+                "    while (isAtEnd(file) == false) {\n"
+                "        if (readLine(file) != \"line\") return -1\n"
+                "        lines = lines + 1\n"
+                "    }\n"
+                "    close(file)\n"
+                "    return lines\n"
+                "}\n"
+                "fun ticker(ticks: Int) -> Unit {\n"
+                "    for (i in 0..ticks) yield()\n"
+                "    println(\"ticked\")\n"
+                "}\n"
+                "spawn(ticker(3))\n"
+                "fill(\"" + path + "\", 20000)\n"
+                "println(count(\"" + path + "\"))\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("every line comes back, with enough of them to take several reads") {
+                    REQUIRE(output.str().ends_with("20000\n"));
+                    REQUIRE(output.str().find("ticked\n") != std::string::npos);
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("fibers that sleep for different times") {
+            auto program = compileSource(
+                "fun sleeper(ms: Int) -> Unit {\n"
+                "    sleep(ms)\n"
+                "    println(ms)\n"
+                "}\n"
+                "spawn(sleeper(30))\n"
+                "spawn(sleeper(10))\n"
+                "spawn(sleeper(20))\n"
+                "println(0)\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                auto start = std::chrono::steady_clock::now();
+                vm.interpret(*program);
+
+                THEN("they sleep at the same time, and wake up in the order of their delays") {
+                    REQUIRE(output.str() == "0\n10\n20\n30\n");
+                    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds{60});
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("fibers that share a file") {
+            auto program = compileSource(
+                "fun writer(file: File, text: String) -> Unit {\n"
+                "    for (i in 0..100) write(file, text)\n"
+                "}\n"
+                "val file = createFile(\"" + path + "\")\n"
+                "spawn(writer(file, \"a\\n\"))\n"
+                "spawn(writer(file, \"b\\n\"))\n"
+                "writer(file, \"c\\n\")\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+                std::ifstream written{path};
+                std::string contents{std::istreambuf_iterator<char>{written}, std::istreambuf_iterator<char>{}};
+
+                THEN("they take turns instead of writing over each other") {
+                    REQUIRE(contents.size() == 600);
+                    REQUIRE(std::ranges::count(contents, 'a') == 100);
+                    REQUIRE(std::ranges::count(contents, 'b') == 100);
+                    REQUIRE(std::ranges::count(contents, 'c') == 100);
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a program that reads a line from an input stream other than standard input") {
+            auto program = compileSource("println(readln())\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("it reads straight from the stream") {
+                    REQUIRE(output.str() == "answer\n");
+                }
+            }
+        }
+
+        GIVEN("a program that reads past the end of a file") {
+            auto program = compileSource(
+                "close(createFile(\"" + path + "\"))\n"
+                "readLine(openFile(\"" + path + "\"))\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("it panics") {
+                    REQUIRE(errors.str() == "error: cannot read past the end of '" + path + "'\n");
+                }
+            }
+        }
+
+        GIVEN("a program that uses a file after closing it") {
+            auto program = compileSource(
+                "val file = createFile(\"" + path + "\")\n"
+                "close(file)\n"
+                "write(file, \"late\")\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("it panics") {
+                    REQUIRE(errors.str() == "error: cannot write to '" + path + "' after it was closed\n");
+                }
+            }
+        }
+
+        GIVEN("a program that opens a file that does not exist") {
+            auto program = compileSource("openFile(\"" + path + ".missing\")\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("it panics with the reason") {
+                    REQUIRE(errors.str().starts_with("error: cannot open '" + path + ".missing': "));
+                }
+            }
+        }
+
+        GIVEN("a program that passes the wrong type to a file operation") {
+            auto program = compileSource("readLine(\"" + path + "\")\n");
+
+            THEN("it does not compile") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        std::filesystem::remove(path);
+    }
+}
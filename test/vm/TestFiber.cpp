@@ -0,0 +1,124 @@
+#include "TestUtil.h"
+#include "vm/VirtualMachine.h"
+
+#include <catch2/catch.hpp>
+
+#include <optional>
+#include <sstream>
+#include <string>
+
+
+namespace ferrit::tests {
+    SCENARIO("Running fibers", "[fiber]") {
+        std::ostringstream output, errors;
+        std::istringstream input;
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+
+        GIVEN("fibers that yield to the scheduler") {
+            auto program = compileSource(
+                "fun worker(id: Int, steps: Int) -> Int {\n"
+                "    for (i in 0..steps) {\n"
+                "        println(id * 100 + i)\n"
+                "        yield()\n"
+                "    }\n"
+                "    return id\n"
+                "}\n"
+                "spawn(worker(1, 3))\n"
+                "spawn(worker(2, 2))\n"
+                "println(0)\n"
+                "yield()\n"
+                "println(-1)\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("they take turns, and the ones left over run after the script") {
+                    REQUIRE(output.str() == "0\n100\n200\n-1\n101\n201\n102\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a fiber that is resumed directly") {
+            auto program = compileSource(
+                "fun counter(n: Int) -> Int {\n"
+                "    for (i in 0..n) yield()\n"
+                "    return n\n"
+                "}\n"
+                "val c: Fiber = spawn(counter(2))\n"
+                "println(resume(c))\n"
+                "println(resume(c))\n"
+                "println(resume(c))\n"
+                "println(c)\n"
+                "resume(c)\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("resume says whether it yielded, and panics once it has finished") {
+                    REQUIRE(output.str() == "true\ntrue\nfalse\n<fiber>\n");
+                    REQUIRE(errors.str() == "error: cannot resume a fiber that has finished\n");
+                }
+            }
+        }
+
+        GIVEN("a fiber that yields from deep recursion") {
+            auto program = compileSource(
+                "fun deep(n: Int) -> Int {\n"
+                "    if (n == 0) { yield(); return 0 }\n"
+                "    return 1 + deep(n - 1)\n"
+                "}\n"
+                "val f: Fiber = spawn(deep(3000))\n"
+                "println(resume(f))\n"
+                "println(resume(f))\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("its stacks grow as needed") {
+                    REQUIRE(output.str() == "true\nfalse\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("many fibers that keep strings alive while the main fiber allocates") {
+            auto program = compileSource(
+                "fun holder(tag: String, n: Int) -> Int {\n"
+                "    var s = tag\n"
+                "    for (i in 0..n) {\n"
+                "        s = s ~ \".\"\n"
+                "        yield()\n"
+                "    }\n"
+                "    if (s != tag ~ \"..........\") println(s)\n"
+                "    return n\n"
+                "}\n"
+                "for (i in 0..10000) spawn(holder(\"t\" ~ \"ag\", 10))\n"
+                "var junk = \"\"\n"
+                "for (round in 0..12) {\n"
+                "    for (k in 0..2000) junk = \"x\" ~ \"yyyyyyyyyyyyyyyyyyyyyyyyyyyyyy\"\n"
+                "    yield()\n"
+                "}\n"
+                "println(\"done\")\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("every fiber's locals survive collection across its yields") {
+                    REQUIRE(output.str() == "done\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a spawn of something other than a call") {
+            THEN("it does not compile") {
+                REQUIRE(!compileSource("val x = 1\nspawn(x)\n").has_value());
+            }
+        }
+    }
+}
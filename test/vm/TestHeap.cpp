@@ -0,0 +1,271 @@
+#include "vm/Heap.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ferrit::tests {
+    namespace {
+        int liveCells = 0;
+
+        /**
+         * A heap object holding a single value, which counts how many cells are alive.
+         */
+        class Cell final : public Object {
+        public:
+            explicit Cell(Value value) noexcept : m_value{value} {
+                liveCells++;
+            }
+
+            Cell(Cell &&other) noexcept : Object{std::move(other)}, m_value{other.m_value} {
+                liveCells++;
+            }
+
+            ~Cell() override {
+                liveCells--;
+            }
+
+            void trace(Heap &heap) override {
+                heap.trace(m_value);
+            }
+
+            [[nodiscard]] RuntimeType runtimeType() const override {
+                return RuntimeType{"Cell"};
+            }
+
+            [[nodiscard]] std::string toString() const override {
+                return std::format("Cell({})", m_value);
+            }
+
+            [[nodiscard]] const Value &get() const noexcept {
+                return m_value;
+            }
+
+            void set(Heap &heap, Value value) {
+                Value oldValue = std::exchange(m_value, value);
+                heap.writeBarrier(this, oldValue, value);
+            }
+
+        private:
+            Value m_value;
+        };
+
+        std::size_t liveBlobBytes = 0;
+
+        /**
+         * A heap object that owns a buffer outside of the heap, which counts how many bytes of
+         * buffers are alive.
+         */
+        class Blob final : public Object {
+        public:
+            explicit Blob(std::size_t size) : m_bytes{std::make_unique<std::byte[]>(size)}, m_byteCount{size} {
+                liveBlobBytes += m_byteCount;
+            }
+
+            Blob(Blob &&other) noexcept :
+                Object{std::move(other)}, m_bytes{std::move(other.m_bytes)}, m_byteCount{std::exchange(other.m_byteCount, 0)} {
+            }
+
+            ~Blob() override {
+                liveBlobBytes -= m_byteCount;
+            }
+
+            void trace(Heap &) override {
+            }
+
+            [[nodiscard]] RuntimeType runtimeType() const override {
+                return RuntimeType{"Blob"};
+            }
+
+            [[nodiscard]] std::string toString() const override {
+                return std::format("Blob({})", m_byteCount);
+            }
+
+            [[nodiscard]] std::size_t externalSize() const noexcept override {
+                return m_byteCount;
+            }
+
+        private:
+            std::unique_ptr<std::byte[]> m_bytes;
+            std::size_t m_byteCount;
+        };
+
+        Cell *asCell(const Value &value) {
+            return static_cast<Cell *>(value.asObject());
+        }
+    }
+
+    SCENARIO("Generational garbage collection", "[heap]") {
+        GIVEN("a heap whose roots are a list of values") {
+            liveCells = 0;
+            std::vector<Value> roots;
+            {
+                Heap heap{4096};
+                heap.setRootScanner([&](Heap &h) {
+                    for (auto &root : roots) {
+                        h.trace(root);
+                    }
+                });
+
+                WHEN("unreachable objects are allocated") {
+                    for (int i = 0; i < 10; i++) {
+                        heap.allocate<Cell>(Value{std::int64_t{i}});
+                    }
+                    REQUIRE(liveCells == 10);
+                    REQUIRE(heap.nurseryUsed() > 0);
+
+                    heap.collectNursery();
+
+                    THEN("a minor collection frees them without promoting them") {
+                        REQUIRE(liveCells == 0);
+                        REQUIRE(heap.nurseryUsed() == 0);
+                        REQUIRE(heap.oldGenerationSize() == 0);
+                    }
+                }
+
+                WHEN("a reachable object survives a minor collection") {
+                    Cell *leaf = heap.allocate<Cell>(Value{std::int64_t{42}});
+                    roots.emplace_back(heap.allocate<Cell>(Value{leaf}));
+                    REQUIRE(Heap::isYoung(roots[0].asObject()));
+
+                    heap.collectNursery();
+
+                    THEN("it and everything it refers to are moved into the old generation") {
+                        REQUIRE(liveCells == 2);
+                        REQUIRE_FALSE(Heap::isYoung(roots[0].asObject()));
+                        REQUIRE(std::format("{}", roots[0]) == "Cell(Cell(42))");
+                        REQUIRE_FALSE(Heap::isYoung(asCell(roots[0])->get().asObject()));
+                    }
+                }
+
+                WHEN("an old object is modified to refer to a young object") {
+                    roots.emplace_back(heap.allocate<Cell>(Value{}));
+                    heap.collectNursery();
+                    asCell(roots[0])->set(heap, Value{heap.allocate<Cell>(Value{true})});
+
+                    heap.collectNursery();
+
+                    THEN("the write barrier keeps the young object alive") {
+                        REQUIRE(liveCells == 2);
+                        REQUIRE(std::format("{}", roots[0]) == "Cell(Cell(true))");
+                    }
+                }
+
+                WHEN("old objects become unreachable") {
+                    roots.emplace_back(heap.allocate<Cell>(Value{}));
+                    roots.emplace_back(heap.allocate<Cell>(Value{}));
+                    heap.collectNursery();
+                    REQUIRE(liveCells == 2);
+
+                    roots.pop_back();
+                    heap.collectGarbage();
+
+                    THEN("a major collection frees them") {
+                        REQUIRE(liveCells == 1);
+                        REQUIRE(heap.majorCollections() == 1);
+                    }
+                }
+
+                WHEN("more objects are allocated than fit in the nursery") {
+                    roots.emplace_back(heap.allocate<Cell>(Value{std::int64_t{7}}));
+                    for (int i = 0; i < 1000; i++) {
+                        heap.allocate<Cell>(Value{std::int64_t{i}});
+                    }
+
+                    THEN("the nursery is collected automatically") {
+                        REQUIRE(heap.minorCollections() > 0);
+                        REQUIRE(liveCells < 1000);
+                        REQUIRE(std::format("{}", roots[0]) == "Cell(7)");
+                    }
+                }
+
+                WHEN("small objects that own large buffers are allocated one after another") {
+                    constexpr std::size_t blobSize = 1024 * 1024;
+                    std::size_t peakBytes = 0;
+                    roots.emplace_back();
+                    for (int i = 0; i < 100; i++) {
+                        // only the newest blob is reachable
+                        roots[0] = Value{heap.allocate<Blob>(blobSize)};
+                        peakBytes = std::max(peakBytes, liveBlobBytes);
+                    }
+
+                    THEN("the buffers count towards collections, so memory stays bounded") {
+                        REQUIRE(heap.nurseryUsed() < 4096);
+                        REQUIRE(heap.majorCollections() > 0);
+                        REQUIRE(peakBytes <= 8 * blobSize);
+                        REQUIRE(heap.oldGenerationSize() >= blobSize);
+                    }
+                }
+
+                WHEN("a long list of old objects becomes unreachable while the pause budget is zero") {
+                    heap.setPauseBudget(std::chrono::nanoseconds{0});
+                    roots.emplace_back();
+                    for (int i = 0; i < 1000; i++) {
+                        roots[0] = Value{heap.allocate<Cell>(roots[0])};
+                    }
+                    heap.collectNursery();
+                    REQUIRE(liveCells == 1000);
+
+                    roots.clear();
+                    heap.startCollection();
+                    heap.step();
+
+                    THEN("each step only does part of the collection") {
+                        REQUIRE(heap.isCollecting());
+                        REQUIRE(liveCells == 1000);
+
+                        while (heap.isCollecting()) {
+                            heap.step();
+                        }
+                        REQUIRE(liveCells == 0);
+                        REQUIRE(heap.majorCollections() == 1);
+                        REQUIRE(heap.pauseHistogram().count > 2);
+                    }
+                }
+
+                WHEN("a reference is moved out of an object while it is being marked") {
+                    heap.setPauseBudget(std::chrono::nanoseconds{0});
+                    Cell *inner = heap.allocate<Cell>(Value{std::int64_t{1}});
+                    roots.emplace_back(heap.allocate<Cell>(Value{inner}));
+                    heap.collectNursery();
+                    heap.startCollection();
+
+                    // the inner cell is now only reachable from the stack, which has already been scanned
+                    roots.push_back(asCell(roots[0])->get());
+                    asCell(roots[0])->set(heap, Value{});
+                    while (heap.isCollecting()) {
+                        heap.step();
+                    }
+
+                    THEN("the snapshot barrier keeps it alive") {
+                        REQUIRE(liveCells == 2);
+                        REQUIRE(std::format("{}", roots[1]) == "Cell(1)");
+                    }
+                }
+
+                WHEN("objects are created while the heap is being marked") {
+                    roots.emplace_back(heap.allocate<Cell>(Value{}));
+                    heap.collectNursery();
+                    heap.startCollection();
+                    roots.emplace_back(heap.allocate<Cell>(Value{false}));
+                    heap.collectNursery();
+                    while (heap.isCollecting()) {
+                        heap.step();
+                    }
+
+                    THEN("they survive the collection") {
+                        REQUIRE(liveCells == 2);
+                        REQUIRE(std::format("{}", roots[1]) == "Cell(false)");
+                    }
+                }
+            }
+
+            // destroying the heap destroys every object, reachable or not
+            REQUIRE(liveCells == 0);
+            REQUIRE(liveBlobBytes == 0);
+        }
+    }
+}
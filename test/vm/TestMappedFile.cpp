@@ -0,0 +1,201 @@
+#include "TestUtil.h"
+#include "vm/MappedFile.h"
+#include "vm/VirtualMachine.h"
+
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace ferrit::tests {
+    namespace {
+        std::vector<std::string_view> splitLines(std::string_view bytes) {
+            std::vector<std::string_view> lines;
+            for (LineIterator it{bytes}; it != std::default_sentinel; ++it) {
+                lines.push_back(*it);
+            }
+            return lines;
+        }
+
+        void writeFile(const std::string &path, const std::string &contents) {
+            std::ofstream file{path, std::ios::binary};
+            file << contents;
+        }
+    }
+
+    SCENARIO("Splitting bytes into lines", "[mapped]") {
+        GIVEN("bytes that end with a line break") {
+            THEN("the break does not start another line") {
+                REQUIRE(splitLines("one\ntwo\n") == std::vector<std::string_view>{"one", "two"});
+            }
+        }
+
+        GIVEN("bytes whose last line has no line break") {
+            THEN("the last line is still a line") {
+                REQUIRE(splitLines("one\ntwo") == std::vector<std::string_view>{"one", "two"});
+            }
+        }
+
+        GIVEN("bytes with empty lines") {
+            THEN("every one of them is a line") {
+                REQUIRE(splitLines("\n\none\n\n") == std::vector<std::string_view>{"", "", "one", ""});
+            }
+        }
+
+        GIVEN("no bytes at all") {
+            THEN("there are no lines") {
+                REQUIRE(splitLines("").empty());
+            }
+        }
+
+        GIVEN("some bytes") {
+            std::string_view bytes = "first\nsecond";
+
+            THEN("the lines point into them rather than being copies") {
+                auto lines = splitLines(bytes);
+                REQUIRE(lines[0].data() == bytes.data());
+                REQUIRE(lines[1].data() == bytes.data() + 6);
+            }
+        }
+    }
+
+    SCENARIO("Reading mapped files", "[mapped]") {
+        std::string path = (std::filesystem::temp_directory_path() / "ferrit_mapped_file.txt").generic_string();
+
+        GIVEN("a file on disk") {
+            writeFile(path, "alpha\nbeta\ngamma\n");
+
+            WHEN("it is mapped") {
+                std::optional<MappedFile> file = MappedFile::open(path);
+                REQUIRE(file.has_value());
+
+                THEN("its bytes and lines can be read, without moving the program's position") {
+                    REQUIRE(file->bytes() == "alpha\nbeta\ngamma\n");
+                    std::vector<std::string_view> lines;
+                    for (std::string_view line : file->lines()) {
+                        lines.push_back(line);
+                    }
+                    REQUIRE(lines == std::vector<std::string_view>{"alpha", "beta", "gamma"});
+                    REQUIRE(file->nextLine() == "alpha");
+                }
+            }
+        }
+
+        GIVEN("an empty file") {
+            writeFile(path, "");
+
+            WHEN("it is mapped") {
+                std::optional<MappedFile> file = MappedFile::open(path);
+
+                THEN("it has no bytes and no lines") {
+                    REQUIRE(file.has_value());
+                    REQUIRE(file->bytes().empty());
+                    REQUIRE(file->isAtEnd());
+                }
+            }
+        }
+
+        GIVEN("a file that does not exist") {
+            THEN("it cannot be mapped") {
+                REQUIRE_FALSE(MappedFile::open(path + ".missing").has_value());
+            }
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    SCENARIO("Reading mapped files in programs", "[mapped]") {
+        std::ostringstream output, errors;
+        std::istringstream input;
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+        std::string path = (std::filesystem::temp_directory_path() / "ferrit_mapped_program.txt").generic_string();
+
+        GIVEN("a program that counts the lines of a file that match one of its own") {
+            std::string contents;
+            for (int i = 0; i < 30000; i++) {
+                contents += i % 3 == 0 ? "match\n" : "other line\n";
+            }
+            writeFile(path, contents);
+            auto program = compileSource(
+                "fun count(path: String) -> Int {\n"
+                "    val file = mapFile(path)\n"
+                "    var matches = 0\n"
+                "    while (hasNextLine(file)) {\n"
+                "        if (nextLine(file) == \"match\") matches = matches + 1\n"
+                "    }\n"
+                "    return matches\n"
+                "}\n"
+                "println(count(\"" + path + "\"))\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("every line is compared") {
+                    REQUIRE(output.str() == "10000\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a program that keeps a line after dropping its file") {
+            writeFile(path, "kept\n");
+            auto program = compileSource(
+                "fun first(path: String) -> String {\n"
+                "    return nextLine(mapFile(path))\n"
+                "}\n"
+                "val line = first(\"" + path + "\")\n"
+                "var garbage = \"\"\n"
+                "for (i in 0..100000) garbage = \"x\" ~ \"y\"\n"
+                "println(line ~ \"!\")\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed, collecting garbage along the way") {
+                vm.interpret(*program);
+
+                THEN("the line keeps the mapping alive") {
+                    REQUIRE(output.str() == "kept!\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a program that reads past the last line") {
+            writeFile(path, "only\n");
+            auto program = compileSource(
+                "val file = mapFile(\"" + path + "\")\n"
+                "nextLine(file)\n"
+                "nextLine(file)\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("it panics") {
+                    REQUIRE(errors.str() == "error: cannot read past the end of '" + path + "'\n");
+                }
+            }
+        }
+
+        GIVEN("a program that maps a file that does not exist") {
+            auto program = compileSource("mapFile(\"" + path + ".missing\")\n");
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("it panics with the reason") {
+                    REQUIRE(errors.str().starts_with("error: cannot map '" + path + ".missing': "));
+                }
+            }
+        }
+
+        std::filesystem::remove(path);
+    }
+}
@@ -0,0 +1,100 @@
+#include "vm/NativeHandler.h"
+
+#include <catch2/catch.hpp>
+
+#include <format>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ferrit::tests {
+    SCENARIO("Buffering output", "[natives]") {
+        std::ostringstream output, errors;
+        std::istringstream input{"answer\n"};
+        NativeHandler natives{output, errors, input};
+        ExecutionContext ctx{};
+
+        GIVEN("a few printed lines") {
+            natives.println(ctx, "one");
+            natives.println(ctx, Value{std::int64_t{2}});
+
+            THEN("nothing is written until the output is flushed") {
+                REQUIRE(output.str().empty());
+                natives.flush(ctx);
+                REQUIRE(output.str() == "one\n2\n");
+            }
+
+            THEN("they are written before an error") {
+                natives.eprintln(ctx, "error: oops");
+                REQUIRE(output.str() == "one\n2\n");
+                REQUIRE(errors.str() == "error: oops\n");
+            }
+
+            THEN("they are written before reading input") {
+                REQUIRE(natives.readln(ctx) == "answer");
+                REQUIRE(output.str() == "one\n2\n");
+            }
+        }
+
+        GIVEN("a buffer smaller than the printed lines") {
+            natives.setBufferSize(8);
+            natives.println(ctx, "1234");
+
+            THEN("the output is written once the buffer is full") {
+                REQUIRE(output.str().empty());
+                natives.println(ctx, "5678");
+                REQUIRE(output.str() == "1234\n5678\n");
+            }
+        }
+
+        GIVEN("line buffered output") {
+            natives.setLineBuffered(true);
+            natives.println(ctx, Value{0.5});
+
+            THEN("every line is written immediately") {
+                REQUIRE(output.str() == "0.5\n");
+            }
+        }
+    }
+
+    SCENARIO("Sharing streams between threads", "[natives]") {
+        GIVEN("copies of a handler printing on several threads") {
+            std::ostringstream output, errors;
+            std::istringstream input;
+            NativeHandler natives{output, errors, input};
+            natives.setBufferSize(64);
+
+            constexpr int THREADS = 4;
+            constexpr int LINES = 2000;
+            std::vector<std::thread> threads;
+            for (int t = 0; t < THREADS; t++) {
+                threads.emplace_back([natives, t]() mutable {
+                    ExecutionContext ctx{};
+                    for (int i = 0; i < LINES; i++) {
+                        natives.println(ctx, std::format("thread {} line {}", t, i));
+                    }
+                    natives.flush(ctx);
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+
+            THEN("every line is written whole") {
+                std::istringstream lines{output.str()};
+                std::vector<int> nextLine(THREADS);
+                std::string line;
+                int count = 0;
+                bool isInOrder = true;
+                while (std::getline(lines, line)) {
+                    int t = line[7] - '0';
+                    isInOrder = isInOrder && line == std::format("thread {} line {}", t, nextLine[t]++);
+                    count++;
+                }
+                REQUIRE(isInOrder);
+                REQUIRE(count == THREADS * LINES);
+            }
+        }
+    }
+}
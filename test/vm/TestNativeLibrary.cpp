@@ -0,0 +1,28 @@
+#include "vm/NativeRegistry.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+// a shared library of native functions, which the tests load at runtime
+namespace {
+    std::int64_t triple(std::int64_t value) {
+        return 3 * value;
+    }
+
+    std::string shout(std::string_view text) {
+        std::string result{text};
+        for (char &c : result) {
+            if (c >= 'a' && c <= 'z') {
+                c = static_cast<char>(c - 'a' + 'A');
+            }
+        }
+        return result + "!";
+    }
+}
+
+extern "C" void ferrit_register_natives(ferrit::NativeRegistry &registry) {
+    registry.add<&triple>("triple");
+    registry.add("shout", &shout);
+}
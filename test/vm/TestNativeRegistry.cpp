@@ -0,0 +1,357 @@
+#include "TestUtil.h"
+#include "vm/BytecodeCompiler.h"
+#include "vm/BytecodeInterpreter.h"
+#include "vm/NativeRegistry.h"
+#include "vm/Script.h"
+#include "vm/VirtualMachine.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+
+namespace ferrit::tests {
+    namespace {
+        std::int64_t add(std::int64_t left, std::int64_t right) {
+            return left + right;
+        }
+
+        double scale(double value, double factor) {
+            return value * factor;
+        }
+
+        bool isEven(std::int64_t value) {
+            return value % 2 == 0;
+        }
+
+        std::string repeat(std::string_view text, std::int64_t count) {
+            std::string result;
+            for (std::int64_t i = 0; i < count; i++) {
+                result += text;
+            }
+            return result;
+        }
+
+        std::int64_t measure(std::string_view text) {
+            return static_cast<std::int64_t>(text.size());
+        }
+
+        std::int64_t checkedDivide(std::int64_t left, std::int64_t right) {
+            if (right == 0) {
+                throw std::domain_error("division by zero");
+            }
+            return left / right;
+        }
+
+        double hypotenuse(double x, double y) {
+            return std::sqrt(x * x + y * y);
+        }
+
+        void scaleAll(std::span<double> values, double factor) {
+            for (double &value : values) {
+                value *= factor;
+            }
+        }
+
+        std::int64_t countTrue(std::span<bool> flags) {
+            return static_cast<std::int64_t>(std::ranges::count(flags, true));
+        }
+
+        std::int64_t counter = 0;
+
+        void increment() {
+            counter++;
+        }
+    }
+
+    SCENARIO("Registering native functions", "[native]") {
+        GIVEN("a registry with functions of several signatures") {
+            NativeRegistry registry;
+            registry.add<&add>("add");
+            registry.add("scale", &scale);
+            registry.add<&increment>("increment");
+
+            THEN("they can be found by name, with the runtime types of their signatures") {
+                REQUIRE(registry.size() == 3);
+                const NativeFunction *native = registry.find("add");
+                REQUIRE(native);
+                REQUIRE(native->parameterTypes == std::vector{RuntimeType::IntType, RuntimeType::IntType});
+                REQUIRE(native->returnType == RuntimeType::IntType);
+                REQUIRE(registry.find("scale")->parameterTypes == std::vector{RuntimeType::RealType, RuntimeType::RealType});
+                REQUIRE(registry.find("increment")->returnType == RuntimeType::NothingType);
+            }
+
+            THEN("functions that were not registered cannot be found") {
+                REQUIRE_FALSE(registry.find("subtract"));
+            }
+
+            THEN("a name cannot be registered twice") {
+                REQUIRE_THROWS_AS(registry.add<&scale>("add"), std::invalid_argument);
+            }
+        }
+
+        GIVEN("a library that does not exist") {
+            NativeRegistry registry;
+
+            THEN("it cannot be loaded") {
+                REQUIRE_THROWS_AS(registry.loadLibrary("ferrit_missing_natives.so"), std::runtime_error);
+                REQUIRE(registry.size() == 0);
+            }
+        }
+    }
+
+    SCENARIO("Calling native functions in programs", "[native]") {
+        std::ostringstream output, errors;
+        std::istringstream input;
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+        NativeRegistry registry;
+        registry.add<&add>("add");
+        registry.add("scale", &scale);
+        registry.add<&isEven>("isEven");
+        registry.add<&repeat>("repeat");
+        registry.add<&measure>("measure");
+        registry.add<&checkedDivide>("checkedDivide");
+        registry.add<&increment>("increment");
+
+        GIVEN("a program that declares and calls native functions of every type") {
+            auto program = compileSource(
+                "native fun add(left: Int, right: Int) -> Int\n"
+                "native fun scale(value: Real, factor: Real) -> Real\n"
+                "native fun isEven(value: Int) -> Bool\n"
+                "native fun repeat(text: String, count: Int) -> String\n"
+                "native fun measure(text: String) -> Int\n"
+                "println(add(40, 2))\n"
+                "println(scale(1.5, 3.0))\n"
+                "println(isEven(add(1, 2)))\n"
+                "println(repeat(\"ab\", 3))\n"
+                "println(measure(\"ab\" ~ \"cde\"))\n", &registry);
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("the arguments and results are converted") {
+                    REQUIRE(output.str() == "42\n4.5\nfalse\nababab\n5\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a program that passes arrays to native functions") {
+            registry.add<&scaleAll>("scaleAll");
+            registry.add<&countTrue>("countTrue");
+            auto program = compileSource(
+                "native fun scaleAll(values: Array<Real>, factor: Real)\n"
+                "native fun countTrue(flags: Array<Bool>) -> Int\n"
+                "val values = Array(3, 1.5)\n"
+                "values[1] = 2.0\n"
+                "scaleAll(values, 2.0)\n"
+                "println(values[0] + values[1] + values[2])\n"
+                "val flags = Array(4, false)\n"
+                "flags[0] = true\n"
+                "flags[3] = true\n"
+                "println(countTrue(flags))\n", &registry);
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("the functions work on the arrays' elements in place") {
+                    REQUIRE(output.str() == "10.0\n2\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a program that calls a native function that returns nothing") {
+            counter = 0;
+            auto program = compileSource(
+                "native fun increment()\n"
+                "for (i in 0..10) increment()\n", &registry);
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("it is called every time") {
+                    REQUIRE(counter == 10);
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a program that keeps the strings that a native function returns while collecting garbage") {
+            auto program = compileSource(
+                "native fun repeat(text: String, count: Int) -> String\n"
+                "native fun measure(text: String) -> Int\n"
+                "val kept = repeat(\"k\", 2)\n"
+                "var total = 0\n"
+                "for (i in 0..50000) total = total + measure(repeat(\"x\" ~ \"y\", 2))\n"
+                "println(total)\n"
+                "println(kept)\n", &registry);
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("every result is a string on the heap") {
+                    REQUIRE(output.str() == "200000\nkk\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+
+        GIVEN("a program that calls a native function that throws") {
+            auto program = compileSource(
+                "native fun checkedDivide(left: Int, right: Int) -> Int\n"
+                "println(checkedDivide(6, 3))\n"
+                "println(checkedDivide(1, 0))\n", &registry);
+            REQUIRE(program.has_value());
+
+            WHEN("the program is executed") {
+                vm.interpret(*program);
+
+                THEN("it panics with the exception's message") {
+                    REQUIRE(output.str() == "2\n");
+                    REQUIRE(errors.str() == "error: native function 'checkedDivide' failed: division by zero\n");
+                }
+            }
+        }
+
+        GIVEN("a program that declares a native function with a different signature") {
+            auto program = compileSource(
+                "native fun add(left: Int, right: Real) -> Int\n"
+                "println(add(1, 2.0))\n", &registry);
+
+            THEN("it does not compile") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        GIVEN("a program that declares a native function that was not registered") {
+            auto program = compileSource(
+                "native fun subtract(left: Int, right: Int) -> Int\n"
+                "println(subtract(2, 1))\n", &registry);
+
+            THEN("it does not compile") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+
+        GIVEN("a program that calls a native function it did not declare") {
+            auto program = compileSource("println(add(1, 2))\n", &registry);
+
+            THEN("it does not compile") {
+                REQUIRE_FALSE(program.has_value());
+            }
+        }
+    }
+
+    SCENARIO("Calling native functions from embedded scripts", "[native]") {
+        GIVEN("a script compiled against a registry") {
+            NativeRegistry registry;
+            registry.add<&hypotenuse>("hypot");
+            auto script = Script::compile(
+                "native fun hypot(x: Real, y: Real) -> Real\n"
+                "fun length(x: Real, y: Real) -> Real = hypot(x, y)\n", nullptr, &registry);
+            REQUIRE(script.has_value());
+
+            WHEN("one of its functions calls a native function") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                VirtualMachine vm{NativeHandler{output, errors, input}};
+                auto length = script->entryPoint<double(double, double)>("length");
+                REQUIRE(length.has_value());
+
+                THEN("the native function's result is returned") {
+                    REQUIRE((*length)(vm, 3.0, 4.0) == 5.0);
+                }
+            }
+        }
+    }
+
+    SCENARIO("Emitting headers for native functions", "[native]") {
+        GIVEN("a program that declares native functions") {
+            std::string code =
+                "native fun add(left: Int, right: Int) -> Int\n"
+                "native fun scaleAll(values: Array<Real>, factor: Real)\n"
+                "native fun describe(name: String, flags: Array<Bool>) -> String\n"
+                "fun twice(value: Int) -> Int = add(value, value)\n";
+
+            WHEN("a header is emitted for it") {
+                std::ostringstream output, errors;
+                std::istringstream input;
+                BytecodeInterpreter interpreter{InterpretOptions{.emitNativeHeaders = true}, output, errors, input};
+                InterpretResult result = interpreter.run(code);
+
+                THEN("it declares each native function with the C++ types that it is registered with") {
+                    REQUIRE(result == InterpretResult::Ok);
+                    REQUIRE(output.str().find("#include <span>\n") != std::string::npos);
+                    REQUIRE(output.str().ends_with(
+                        "std::int64_t add(std::int64_t left, std::int64_t right);\n"
+                        "void scaleAll(std::span<double> values, double factor);\n"
+                        "std::string describe(std::string_view name, std::span<bool> flags);\n"));
+                }
+
+                THEN("the declarations match the functions that can be registered") {
+                    NativeRegistry registry;
+                    registry.add<&add>("add");
+                    registry.add<&scaleAll>("scaleAll");
+                    REQUIRE(registry.find("scaleAll")->parameterTypes ==
+                        std::vector{RuntimeType::RealArrayType, RuntimeType::RealType});
+                }
+            }
+        }
+
+        GIVEN("a program that declares a native function that takes a file") {
+            auto tokens = Lexer{}.lex("native fun size(file: File) -> Int\n");
+            REQUIRE(tokens.has_value());
+            auto ast = Parser{}.parse(tokens.value());
+            REQUIRE(ast.has_value());
+
+            THEN("no header can be emitted for it") {
+                REQUIRE_FALSE(BytecodeCompiler{nullptr}.emitNativeHeader(ast.value()).has_value());
+            }
+        }
+    }
+
+#ifdef FERRIT_TEST_NATIVE_LIBRARY
+    SCENARIO("Loading native functions from a shared library", "[native]") {
+        std::ostringstream output, errors;
+        std::istringstream input;
+        VirtualMachine vm{NativeHandler{output, errors, input}};
+
+        GIVEN("a registry that has loaded a library") {
+            std::optional<Program> program;
+            {
+                NativeRegistry registry;
+                registry.loadLibrary(FERRIT_TEST_NATIVE_LIBRARY);
+                REQUIRE(registry.size() == 2);
+                program = compileSource(
+                    "native fun triple(value: Int) -> Int\n"
+                    "native fun shout(text: String) -> String\n"
+                    "println(triple(14))\n"
+                    "println(shout(\"hello\"))\n", &registry);
+                REQUIRE(program.has_value());
+            }
+
+            WHEN("a program compiled against it is executed after the registry is gone") {
+                vm.interpret(*program);
+
+                THEN("the program keeps the library loaded, and calls its functions") {
+                    REQUIRE(output.str() == "42\nHELLO!\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+        }
+    }
+#endif
+}
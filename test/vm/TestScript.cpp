@@ -0,0 +1,124 @@
+#include "vm/Script.h"
+#include "vm/VirtualMachinePool.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ferrit::tests {
+    SCENARIO("Embedding scripts", "[embedding]") {
+        std::ostringstream output, errors;
+        std::istringstream input;
+
+        GIVEN("a compiled script with functions") {
+            auto script = Script::compile(
+                "fun fib(n: Int) -> Int {\n"
+                "    if (n < 2) return n\n"
+                "    return fib(n - 1) + fib(n - 2)\n"
+                "}\n"
+                "fun pick(x: Real, y: Int, first: Bool) -> Real {\n"
+                "    if (first) return x\n"
+                "    return 0.5\n"
+                "}\n"
+                "fun isEven(n: Int) -> Bool = n % 2 == 0\n"
+                "fun greet(name: String) -> String = \"hello \" ~ name\n"
+                "fun fail(n: Int) -> Int = n / 0\n"
+                "println(\"script\")\n",
+                nullptr);
+            REQUIRE(script.has_value());
+            VirtualMachine vm{NativeHandler{output, errors, input}};
+
+            THEN("entry points can be called without running the script") {
+                auto fib = script->entryPoint<std::int64_t(std::int64_t)>("fib");
+                REQUIRE(fib.has_value());
+                REQUIRE((*fib)(vm, 20) == 6765);
+                REQUIRE((*fib)(vm, 10) == 55);
+
+                auto pick = script->entryPoint<double(double, std::int64_t, bool)>("pick");
+                REQUIRE(pick.has_value());
+                REQUIRE((*pick)(vm, 1.5, 4, true) == 1.5);
+                REQUIRE((*pick)(vm, 1.5, 4, false) == 0.5);
+
+                auto isEven = script->entryPoint<bool(std::int64_t)>("isEven");
+                REQUIRE(isEven.has_value());
+                REQUIRE((*isEven)(vm, 7) == false);
+                REQUIRE(output.str().empty());
+            }
+
+            THEN("the script can be run repeatedly") {
+                script->run(vm);
+                script->run(vm);
+                REQUIRE(output.str() == "script\nscript\n");
+            }
+
+            THEN("entry points with the wrong signature are not found") {
+                REQUIRE(!script->entryPoint<double(std::int64_t)>("fib").has_value());
+                REQUIRE(!script->entryPoint<std::int64_t(std::int64_t, std::int64_t)>("fib").has_value());
+                REQUIRE(!script->entryPoint<std::int64_t()>("missing").has_value());
+            }
+
+            THEN("objects can be passed and returned as values") {
+                auto greet = script->entryPoint<Value(Value)>("greet");
+                REQUIRE(greet.has_value());
+
+                auto fib = script->entryPoint<Value(Value)>("fib");
+                REQUIRE_THROWS_AS(vm.invoke(std::make_shared<const Program>(script->program()), fib->functionIndex(),
+                    std::vector<Value>{Value{true}}), std::invalid_argument);
+                REQUIRE((*fib)(vm, Value{std::int64_t{6}}) == Value{std::int64_t{8}});
+            }
+
+            THEN("a panicking function returns nothing, and the VM can be used again") {
+                auto fail = script->entryPoint<std::int64_t(std::int64_t)>("fail");
+                REQUIRE(fail.has_value());
+                REQUIRE(!(*fail)(vm, 1).has_value());
+                REQUIRE(errors.str() == "error: attempted divide by zero\n");
+
+                auto fib = script->entryPoint<std::int64_t(std::int64_t)>("fib");
+                REQUIRE((*fib)(vm, 12) == 144);
+            }
+        }
+
+        GIVEN("code with an error") {
+            THEN("it does not compile") {
+                REQUIRE(!Script::compile("println(1 + true)\n", nullptr).has_value());
+            }
+        }
+
+        GIVEN("a pool of VMs shared by several threads") {
+            auto script = Script::compile("fun square(n: Int) -> Int = n * n\n", nullptr);
+            REQUIRE(script.has_value());
+            auto square = script->entryPoint<std::int64_t(std::int64_t)>("square");
+            REQUIRE(square.has_value());
+            VirtualMachinePool pool{NativeHandler{output, errors, input}};
+
+            WHEN("every thread calls into the same script") {
+                constexpr int THREADS = 4;
+                constexpr int CALLS = 1000;
+                std::vector<std::int64_t> sums(THREADS);
+                std::vector<std::thread> threads;
+                for (int t = 0; t < THREADS; t++) {
+                    threads.emplace_back([&, t] {
+                        for (int i = 0; i < CALLS; i++) {
+                            sums[t] += pool.call(*square, i).value_or(-1);
+                        }
+                    });
+                }
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+
+                THEN("each gets the right results, and the VMs are kept for reuse") {
+                    for (std::int64_t sum : sums) {
+                        REQUIRE(sum == std::int64_t{CALLS - 1} * CALLS * (2 * CALLS - 1) / 6);
+                    }
+                    REQUIRE(pool.idleCount() >= 1);
+                    REQUIRE(pool.idleCount() <= THREADS);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include "TestUtil.h"
+#include "vm/TaskScheduler.h"
+#include "vm/VirtualMachine.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace ferrit::tests {
+    SCENARIO("Running tasks in parallel", "[task]") {
+        std::ostringstream output, errors;
+        std::istringstream input;
+        NativeHandler natives{output, errors, input};
+
+        GIVEN("a scheduler with several workers") {
+            // more workers than this machine may have cores, so that stealing happens either way
+            TaskScheduler scheduler{natives, 4};
+
+            WHEN("jobs are submitted from outside of the workers") {
+                constexpr int JOBS = 1000;
+                std::atomic<int> runs{0};
+                std::vector<std::shared_ptr<Job>> jobs;
+                for (int i = 0; i < JOBS; i++) {
+                    jobs.push_back(std::make_shared<Job>([&runs, i](VirtualMachine &) {
+                        runs++;
+                        return std::optional{Value{std::int64_t{i}}};
+                    }));
+                    scheduler.submit(jobs.back());
+                }
+                for (const auto &job : jobs) {
+                    scheduler.wait(*job);
+                }
+
+                THEN("each runs exactly once") {
+                    REQUIRE(runs == JOBS);
+                    for (int i = 0; i < JOBS; i++) {
+                        REQUIRE(jobs[i]->result() == Value{std::int64_t{i}});
+                    }
+                }
+            }
+
+            WHEN("a program forks tasks that fork tasks of their own") {
+                auto program = compileSource(
+                    "fun fib(n: Int) -> Int {\n"
+                    "    if (n < 2) return n\n"
+                    "    return fib(n - 1) + fib(n - 2)\n"
+                    "}\n"
+                    "fun parallelFib(n: Int) -> Int {\n"
+                    "    if (n < 15) return fib(n)\n"
+                    "    val left: Task<Int> = fork(parallelFib(n - 1))\n"
+                    "    val right = parallelFib(n - 2)\n"
+                    "    return join(left) + right\n"
+                    "}\n"
+                    "println(parallelFib(24))\n");
+                REQUIRE(program.has_value());
+                VirtualMachine vm{natives};
+                vm.setScheduler(&scheduler);
+                vm.interpret(*program);
+
+                THEN("every join gets its task's result") {
+                    REQUIRE(output.str() == "46368\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+
+            WHEN("a program maps functions over arrays in parallel") {
+                auto program = compileSource(
+                    "fun square(x: Int) -> Int = x * x\n"
+                    "fun isBig(x: Real) -> Bool = x > 2.0\n"
+                    "val numbers: Array<Int> = Array(10000, 3)\n"
+                    "for (i in 0..numbers.size) numbers[i] = i\n"
+                    "println(sum(parallelMap(numbers, square)))\n"
+                    "println(parallelMap([0.5, 2.5, 1.0, 3.0], isBig))\n"
+                    "println(parallelMap(Array(0, 1), square))\n");
+                REQUIRE(program.has_value());
+                VirtualMachine vm{natives};
+                vm.setScheduler(&scheduler);
+                vm.interpret(*program);
+
+                THEN("the results are in the order of the elements") {
+                    REQUIRE(output.str() == "333283335000\n[false, true, false, true]\n[]\n");
+                    REQUIRE(errors.str().empty());
+                }
+            }
+
+            WHEN("a forked task panics") {
+                auto program = compileSource(
+                    "fun divide(x: Int) -> Int = 10 / x\n"
+                    "val task = fork(divide(0))\n"
+                    "println(join(task))\n");
+                REQUIRE(program.has_value());
+                VirtualMachine vm{natives};
+                vm.setScheduler(&scheduler);
+                vm.interpret(*program);
+
+                THEN("joining it panics too") {
+                    REQUIRE(output.str().empty());
+                    REQUIRE(errors.str() == "error: attempted divide by zero\nerror: a joined task panicked\n");
+                }
+            }
+        }
+
+        GIVEN("a VM without a scheduler") {
+            auto program = compileSource(
+                "fun greet(n: Int) -> Unit { println(n) }\n"
+                "println(0)\n"
+                "join(fork(greet(1)))\n"
+                "println(2)\n");
+            REQUIRE(program.has_value());
+            VirtualMachine vm{natives};
+            vm.interpret(*program);
+
+            THEN("it starts its own, and output keeps its order") {
+                REQUIRE(output.str() == "0\n1\n2\n");
+            }
+        }
+
+        GIVEN("tasks that would pass objects between heaps") {
+            THEN("they do not compile") {
+                REQUIRE(!compileSource("fun f(s: String) -> Int = 1\nfork(f(\"a\"))\n").has_value());
+                REQUIRE(!compileSource("fun f(n: Int) -> String = \"a\"\nfork(f(1))\n").has_value());
+                REQUIRE(!compileSource("fun f(n: Real) -> Int = 1\nparallelMap([1, 2], f)\n").has_value());
+                REQUIRE(!compileSource("val x = 1\njoin(x)\n").has_value());
+            }
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Lexer.h"
+#include "Parser.h"
+#include "vm/BytecodeCompiler.h"
+#include "vm/NativeRegistry.h"
+
+#include <catch2/catch.hpp>
+
+#include <optional>
+#include <string>
+
+
+namespace ferrit::tests {
+    /**
+     * Lexes, parses and compiles a program, failing the test if it cannot be lexed or parsed.
+     *
+     * @param code the source code of the program
+     * @param nativeRegistry the native functions that the program may call, if any
+     * @return the compiled program, or an empty optional if it has compile errors
+     */
+    inline std::optional<Program> compileSource(const std::string &code, const NativeRegistry *nativeRegistry = nullptr) {
+        auto tokens = Lexer{}.lex(code);
+        REQUIRE(tokens.has_value());
+        auto ast = Parser{}.parse(tokens.value());
+        REQUIRE(ast.has_value());
+        return BytecodeCompiler{nullptr, nativeRegistry}.compile(ast.value());
+    }
+}